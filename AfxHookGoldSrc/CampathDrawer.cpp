@@ -210,19 +210,22 @@ void CCampathDrawer::Draw(float width, float height, float origin[3], float angl
 				CamPathIterator it = last;
 
 				TempPoint* pts = new TempPoint[c_CameraTrajectoryMaxPointsPerInterval];
+				double* ptsX = new double[c_CameraTrajectoryMaxPointsPerInterval];
+				double* ptsY = new double[c_CameraTrajectoryMaxPointsPerInterval];
+				double* ptsZ = new double[c_CameraTrajectoryMaxPointsPerInterval];
 
 				for (++it; it != camPath->GetEnd(); ++it)
 				{
 					double delta = it.GetTime() - last.GetTime();
 
+					camPath->EvalRange(last.GetTime(), delta / (c_CameraTrajectoryMaxPointsPerInterval - 1), c_CameraTrajectoryMaxPointsPerInterval, ptsX, ptsY, ptsZ);
+
 					for (size_t i = 0; i < c_CameraTrajectoryMaxPointsPerInterval; i++)
 					{
 						double t = last.GetTime() + delta * ((double)i / (c_CameraTrajectoryMaxPointsPerInterval - 1));
 
-						CamPathValue cpv = camPath->Eval(t);
-
 						pts[i].t = t;
-						pts[i].y = Vector3(cpv.X, cpv.Y, cpv.Z);
+						pts[i].y = Vector3(ptsX[i], ptsY[i], ptsZ[i]);
 						pts[i].nextPt = i + 1 < c_CameraTrajectoryMaxPointsPerInterval ? &(pts[i + 1]) : 0;
 					}
 
@@ -240,6 +243,9 @@ void CCampathDrawer::Draw(float width, float height, float origin[3], float angl
 				// add last point:
 				m_TrajectoryPoints.push_back(pts[c_CameraTrajectoryMaxPointsPerInterval - 1].t);
 
+				delete[] ptsZ;
+				delete[] ptsY;
+				delete[] ptsX;
 				delete[] pts;
 
 				m_RebuildDrawing = false;
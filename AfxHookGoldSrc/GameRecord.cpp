@@ -12,6 +12,7 @@
 
 #include <shared/StringTools.h>
 #include <shared/AfxMath.h>
+#include <shared/BoneTransforms.h>
 
 #include <string>
 #include <cmath>
@@ -190,7 +191,7 @@ bool CGameRecord::StartRecording(const char* fileName)
 		return false;
 	}
 
-	if (!m_AfxGameRecord.StartRecording(strFileName.c_str(), 6))
+	if (!m_AfxGameRecord.StartRecording(strFileName.c_str(), 6, Compact ? &CompactSettings : nullptr))
 	{
 		pEngfuncs->Con_Printf("AfxError: could not start recording to \"%s\".\n", fileName);
 		return false;
@@ -320,106 +321,6 @@ void CGameRecord::RecordCurrentEntity()
 	}
 }
 
-bool InvertMatrix(const float matrix[3][4], float out_matrix[3][4]) {
-
-	double b0[4] = { 1, 0, 0, 0 };
-	double b1[4] = { 0, 1, 0, 0 };
-	double b2[4] = { 0, 0, 1, 0 };
-	double b3[4] = { 0, 0, 0, 1 };
-
-	double M[4][4] = {
-		matrix[0][0], matrix[0][1], matrix[0][2],  matrix[0][3],
-		matrix[1][0], matrix[1][1], matrix[1][2],  matrix[1][3],
-		matrix[2][0], matrix[2][1], matrix[2][2],  matrix[2][3],
-		0, 0, 0, 1
-	};
-
-	unsigned char P[4];
-	unsigned char Q[4];
-
-	double L[4][4];
-	double U[4][4];
-
-	if (!Afx::Math::LUdecomposition(M, P, Q, L, U))
-		return false;
-
-	double inv0[4] = { 1,0,0,0 };
-	double inv1[4] = { 0,1,0,0 };
-	double inv2[4] = { 0,0,1,0 };
-	double inv3[4] = { 0,0,0,1 };
-
-	Afx::Math::SolveWithLU(L, U, P, Q, b0, inv0);
-	Afx::Math::SolveWithLU(L, U, P, Q, b1, inv1);
-	Afx::Math::SolveWithLU(L, U, P, Q, b2, inv2);
-	Afx::Math::SolveWithLU(L, U, P, Q, b3, inv3);
-
-	out_matrix[0][0] = (float)inv0[0];
-	out_matrix[0][1] = (float)inv1[0];
-	out_matrix[0][2] = (float)inv2[0];
-	out_matrix[0][3] = (float)inv3[0];
-
-	out_matrix[1][0] = (float)inv0[1];
-	out_matrix[1][1] = (float)inv1[1];
-	out_matrix[1][2] = (float)inv2[1];
-	out_matrix[1][3] = (float)inv3[1];
-
-	out_matrix[2][0] = (float)inv0[2];
-	out_matrix[2][1] = (float)inv1[2];
-	out_matrix[2][2] = (float)inv2[2];
-	out_matrix[2][3] = (float)inv3[2];
-
-	//pEngfuncs->Con_Printf("(%f, %f, %f, %f)\n", inv0[3], inv1[3], inv2[3], inv3[3]);
-
-	return true;
-}
-
-void ToVecQuat(float bones[3][4], float out_vec[3], float out_quat[4]) {
-
-	out_vec[0] = bones[0][3];
-	out_vec[1] = bones[1][3];
-	out_vec[2] = bones[2][3];
-
-	// https://www.euclideanspace.com/maths/geometry/rotations/conversions/matrixToQuaternion/index.htm
-
-	float qw = 1.0f;
-	float qx = 0.0f;
-	float qy = 0.0f;
-	float qz = 0.0f;
-
-	float tr = bones[0][0] + bones[1][1] + bones[2][2];
-
-	if (tr > 0) { 
-	float S = sqrt(tr+1.0) * 2; // S=4*qw 
-	qw = 0.25 * S;
-	qx = (bones[2][1] - bones[1][2]) / S;
-	qy = (bones[0][2] - bones[2][0]) / S; 
-	qz = (bones[1][0] - bones[0][1]) / S; 
-	} else if ((bones[0][0] > bones[1][1])&&(bones[0][0] > bones[2][2])) { 
-	float S = sqrt(1.0 + bones[0][0] - bones[1][1] - bones[2][2]) * 2; // S=4*qx 
-	qw = (bones[2][1] - bones[1][2]) / S;
-	qx = 0.25 * S;
-	qy = (bones[0][1] + bones[1][0]) / S; 
-	qz = (bones[0][2] + bones[2][0]) / S; 
-	} else if (bones[1][1] > bones[2][2]) { 
-	float S = sqrt(1.0 + bones[1][1] - bones[0][0] - bones[2][2]) * 2; // S=4*qy
-	qw = (bones[0][2] - bones[2][0]) / S;
-	qx = (bones[0][1] + bones[1][0]) / S; 
-	qy = 0.25 * S;
-	qz = (bones[1][2] + bones[2][1]) / S; 
-	} else { 
-	float S = sqrt(1.0 + bones[2][2] - bones[0][0] - bones[1][1]) * 2; // S=4*qz
-	qw = (bones[1][0] - bones[0][1]) / S;
-	qx = (bones[0][2] + bones[2][0]) / S;
-	qy = (bones[1][2] + bones[2][1]) / S;
-	qz = 0.25 * S;
-	}
-
-	out_quat[0] = qx;
-	out_quat[1] = qy;
-	out_quat[2] = qz;
-	out_quat[3] = qw;
-}
-
 void CGameRecord::RecordModel(cl_entity_t* ent, struct model_s* model, void* v_header)
 {
 	struct engine_studio_api_s* pstudio = (struct engine_studio_api_s*)HL_ADDR_GET(hw_HUD_GetStudioModelInterface_pStudio);
@@ -455,10 +356,10 @@ void CGameRecord::RecordModel(cl_entity_t* ent, struct model_s* model, void* v_h
 
 		if (0 < numbones && pBoneM && pRotM)
 		{
-			float bones[3][4];
-			float tmp[3][4];
-			float rootMatrix[3][4];
+			float bones[MAXSTUDIOBONES][3][4];
+			int parents[MAXSTUDIOBONES];
 
+			m_AfxGameRecord.BeginEntity(index);
 			m_AfxGameRecord.WriteDictionary("entity_state");
 			m_AfxGameRecord.Write((int)index);
 
@@ -475,26 +376,27 @@ void CGameRecord::RecordModel(cl_entity_t* ent, struct model_s* model, void* v_h
 			//Write((int)pBaseAnimatingRs->m_nSequence);
 			m_AfxGameRecord.Write((bool)true);
 
-			m_AfxGameRecord.Write((int)header->numbones);
-
+			if (MAXSTUDIOBONES < numbones) numbones = MAXSTUDIOBONES;
 
-			for (int i = 0; i < header->numbones; ++i)
+			for (int i = 0; i < numbones; ++i)
 			{
-				bool bRoot = pbones[i].parent == -1;
-
-				if (!InvertMatrix(bRoot ? (*pRotM) : (*pBoneM)[pbones[i].parent], tmp))
-					pEngfuncs->Con_Printf("AFXERROR: parent matrix inversion failed for bone %i (model \"%s\").\n", i, model->name);
+				parents[i] = pbones[i].parent;
+			}
 
-				R_ConcatTransforms(tmp, (*pBoneM)[i], bones);
+			// All bones at once (SIMD):
+			int failedBone;
+			if (!advancedfx::BoneTransforms::ToParentSpace(numbones, parents, *pRotM, *pBoneM, bones, &failedBone))
+				pEngfuncs->Con_Printf("AFXERROR: parent matrix inversion failed for bone %i (model \"%s\").\n", failedBone, model->name);
 
-				WriteMatrix3x4(bones);
-			}
+			m_AfxGameRecord.WriteBones(numbones, bones);
 
 			m_AfxGameRecord.WriteDictionary("/");
 
 			bool viewModel = false;
 
 			m_AfxGameRecord.Write((bool)viewModel);
+
+			m_AfxGameRecord.EndEntity();
 		}
 	}
 }
@@ -597,11 +499,49 @@ REGISTER_CMD_FUNC(agr)
 			);
 			return;
 		}
+		else if (!_stricmp(cmd1, "compact"))
+		{
+			if (3 <= argc)
+			{
+				g_GameRecord.Compact = 0 != atoi(pEngfuncs->Cmd_Argv(2));
+				return;
+			}
+
+			pEngfuncs->Con_Printf(
+				"%s compact 0|1 - Enable (1) / Disable (0) the compact encoding (afxGameRecord2: quantized, delta encoded bones, unchanged entities left out) for new recordings. Needs an importer that supports it!\n"
+				"Current value: %i.\n"
+				, prefix
+				, g_GameRecord.Compact ? 1 : 0
+			);
+			return;
+		}
+		else if (!_stricmp(cmd1, "compactPrecision"))
+		{
+			if (4 <= argc)
+			{
+				g_GameRecord.CompactSettings.PositionStep = (float)atof(pEngfuncs->Cmd_Argv(2));
+				g_GameRecord.CompactSettings.RotationBits = atoi(pEngfuncs->Cmd_Argv(3));
+				return;
+			}
+
+			pEngfuncs->Con_Printf(
+				"%s compactPrecision <fPositionStep> <iRotationBits> - Bone position quantization step (game units) and bits per quaternion component (2 to 30) for the compact encoding.\n"
+				"Current value: %f %i.\n"
+				, prefix
+				, g_GameRecord.CompactSettings.PositionStep
+				, g_GameRecord.CompactSettings.RotationBits
+			);
+			return;
+		}
 	}
 
 	pEngfuncs->Con_Printf(
 		"%s start <sFilePath> - Start recording to file <sFilePath>, you should set a low FPS before (i.e. using host_framerate 0.04 (1/25 FPS = 0.04 seconds per frame)) and give the \".agr\" file extension.\n"
 		"%s stop - Stop recording.\n"
+		"%s compact [...]\n"
+		"%s compactPrecision [...]\n"
+		, prefix
+		, prefix
 		, prefix
 		, prefix
 	);
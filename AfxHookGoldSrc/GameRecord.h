@@ -12,6 +12,10 @@ class CGameRecord
 public:
 	bool RecordCamera = true;
 
+	/// <summary>Use the compact encoding (afxGameRecord2) for new recordings.</summary>
+	bool Compact = false;
+	advancedfx::CAfxGameRecord::CompactSettings_s CompactSettings;
+
 	bool HooksValid();
 
 	bool GetRecording();
@@ -821,9 +821,24 @@ CAfxRecordStream::~CAfxRecordStream()
 	m_Settings->Release();
 }
 
-void CAfxRecordStream::CaptureEnd()
+void CAfxRecordStream::WriteCapture(advancedfx::IImageBufferThreadSafe * buffer)
 {
-	m_CapturesLeft--;
+	if (nullptr == buffer) return;
+
+	if (nullptr == m_OutVideoStream)
+	{
+		//TODO: This is currently safe due to mutexes and locks elsewhere, but not nice:
+		m_OutVideoStream = m_Settings->CreateOutVideoStreamCreator(g_AfxStreams, *this, g_AfxStreams.GetStartHostFrameRate(), "")->CreateOutVideoStream(*buffer->GetImageBufferFormat());
+		if (nullptr == m_OutVideoStream)
+		{
+			Tier0_Warning("AFXERROR: Failed to create image stream for %s.\n", this->StreamName_get());
+		}
+	}
+
+	if (nullptr != m_OutVideoStream && !m_OutVideoStream->SupplyImageBuffer(this, buffer))
+	{
+		Tier0_Warning("AFXERROR: Failed writing image for stream %s.\n", this->StreamName_get());
+	}
 }
 
 bool CAfxRecordStream::Record_get(void)
@@ -842,6 +857,17 @@ void CAfxRecordStream::RecordStart()
 	{
 		m_Recording = true;
 		m_FirstCapture = true;
+
+		// 3 frames: while one is written the next ones are transformed.
+		m_Pipeline = new advancedfx::CFramePipeline(GetThreadPool(), 3);
+		m_Pipeline->AddParallelStage([this](advancedfx::CFramePipeline::CFrame* frame) {
+			CCaptureFrame* captureFrame = static_cast<CCaptureFrame*>(frame);
+			captureFrame->Buffer = TransformCaptures(*captureFrame->Captures);
+		});
+		m_Pipeline->AddSerialStage([this](advancedfx::CFramePipeline::CFrame* frame) {
+			WriteCapture(static_cast<CCaptureFrame*>(frame)->Buffer);
+		});
+
 		m_ProcessingThread = std::thread(&CAfxRecordStream::ProcessingThreadFunc, this);
 	}
 }
@@ -853,9 +879,13 @@ void CAfxRecordStream::RecordEnd()
 			std::unique_lock<std::mutex> lock(m_ProcessingThreadMutex);
 			m_Recording = false;
 			m_ProcessingThreadCv.notify_one();
+			m_InCv.notify_all();
 		}
 		m_ProcessingThread.join();
 
+		delete m_Pipeline;
+		m_Pipeline = nullptr;
+
 		for (size_t i = 0; i < m_CaptureNodes.size(); ++i) {
 			if (class CCaptureNode*& nodeRef = m_CaptureNodes[i]) {
 				nodeRef->CpuQueueGpuRelease();
@@ -889,6 +919,8 @@ void CAfxRecordStream::OnCapture(size_t index, IAfxD3D9CaptureBuffer* capture)
 	if (capture) capture->AddRef();
 	std::unique_lock<std::mutex> lock(m_ProcessingThreadMutex);
 	if(index == 0) {
+		// Stall the capture rather than queueing up frames while the processing is behind:
+		while (m_Recording && 2 <= m_In.size()) m_InCv.wait(lock);
 		m_In.push_back(new CCaptures(m_Streams.size()));
 	}
 	(*m_In.rbegin())->SetAt(index, capture);
@@ -992,6 +1024,10 @@ advancedfx::CGrowingBufferPoolThreadSafe * CAfxRecordStream::GetImageBufferPool(
 	return g_AfxStreams.GetImageBufferPool();
 }
 
+advancedfx::CThreadPool * CAfxRecordStream::GetThreadPool() const {
+	return g_AfxStreams.GetThreadPool();
+}
+
 bool CAfxRecordStream::GetFormatBmpNotTga() const {
 	return g_AfxStreams.GetFormatBmpNotTga();
 }
@@ -1025,9 +1061,9 @@ void CAfxSingleStream::CaptureStart(bool bFirstCapture, const AfxViewportData_t&
 	}
 }
 
-void CAfxSingleStream::CaptureEnd()
+advancedfx::IImageBufferThreadSafe * CAfxSingleStream::TransformCaptures(const CCaptures & captures)
 {
-	advancedfx::IImageBufferThreadSafe * buffer = CaptureToBuffer( m_Task->GetAt(0) );
+	advancedfx::IImageBufferThreadSafe * buffer = CaptureToBuffer( captures.GetAt(0) );
 	if (buffer)
 	{
 		advancedfx::StreamCaptureType streamCaptureType = m_Streams[0]->StreamCaptureType_get();
@@ -1064,25 +1100,7 @@ void CAfxSingleStream::CaptureEnd()
 			buffer = outBuffer;
 		}
 
-		if (buffer) {
-			if (nullptr == m_OutVideoStream)
-			{
-				//TODO: This is currently safe due to mutexes and locks elsewhere, but not nice:
-				m_OutVideoStream = m_Settings->CreateOutVideoStreamCreator(g_AfxStreams, *this, g_AfxStreams.GetStartHostFrameRate(), "")->CreateOutVideoStream(*buffer->GetImageBufferFormat());
-				if (nullptr == m_OutVideoStream)
-				{
-					Tier0_Warning("AFXERROR: Failed to create image stream for %s.\n", this->StreamName_get());
-				}
-			}
-
-			if (nullptr != m_OutVideoStream && !m_OutVideoStream->SupplyImageBuffer(this, buffer))
-			{
-				Tier0_Warning("AFXERROR: Failed writing image for stream %s.\n", this->StreamName_get());
-			}
-
-			buffer->Release();
-		}
-		else {
+		if (nullptr == buffer) {
 			Tier0_Warning("AFXERROR: Could not transform buffer for stream %s.\n", this->StreamName_get());
 		}	
 	}
@@ -1090,7 +1108,7 @@ void CAfxSingleStream::CaptureEnd()
 		Tier0_Warning("AFXERROR: No buffer captured for stream %s.\n", this->StreamName_get());
 	}	
 
-	CAfxRecordStream::CaptureEnd();
+	return buffer;
 }
 
 advancedfx::StreamCaptureType CAfxSingleStream::GetCaptureType() const
@@ -1165,10 +1183,10 @@ void CAfxTwinStream::CaptureStart(bool bFirstCapture, const AfxViewportData_t& v
 	}
 }
 
-void CAfxTwinStream::CaptureEnd()
+advancedfx::IImageBufferThreadSafe * CAfxTwinStream::TransformCaptures(const CCaptures & captures)
 {
-	advancedfx::IImageBufferThreadSafe * bufferA =CaptureToBuffer( m_Task->GetAt(0) );
-	IImageBufferThreadSafe * bufferB =CaptureToBuffer( m_Task->GetAt(1) );
+	advancedfx::IImageBufferThreadSafe * bufferA =CaptureToBuffer( captures.GetAt(0) );
+	IImageBufferThreadSafe * bufferB =CaptureToBuffer( captures.GetAt(1) );
 
 	advancedfx::IImageBufferThreadSafe* outBuffer = nullptr;
 
@@ -1184,29 +1202,11 @@ void CAfxTwinStream::CaptureEnd()
 	if (bufferA) bufferA->Release();
 	if (bufferB) bufferB->Release();
 
-	if (outBuffer) {
-		if (nullptr == m_OutVideoStream)
-		{
-			//TODO: This is currently safe due to mutexes and locks elsewhere, but not nice:
-			m_OutVideoStream = m_Settings->CreateOutVideoStreamCreator(g_AfxStreams, *this, g_AfxStreams.GetStartHostFrameRate(), "")->CreateOutVideoStream(*outBuffer->GetImageBufferFormat());
-			if (nullptr == m_OutVideoStream)
-			{
-				Tier0_Warning("AFXERROR: Failed to create image stream for %s.\n", this->StreamName_get());
-			}
-		}
-
-		if (nullptr != m_OutVideoStream && !m_OutVideoStream->SupplyImageBuffer(this, outBuffer))
-		{
-			Tier0_Warning("AFXERROR: Failed writing image for stream %s.\n", this->StreamName_get());
-		}
-
-		outBuffer->Release();
-	}
-	else {
-		Tier0_Warning("CAfxTwinStream::CaptureEnd: Combining sub-streams for stream %s, failed.\n", this->StreamName_get());
+	if (nullptr == outBuffer) {
+		Tier0_Warning("CAfxTwinStream::TransformCaptures: Combining sub-streams for stream %s, failed.\n", this->StreamName_get());
 	}
 
-	CAfxRecordStream::CaptureEnd();
+	return outBuffer;
 }
 
 bool CAfxTwinStream::Console_Edit_Head(IWrpCommandArgs * args)
@@ -1448,38 +1448,21 @@ void CAfxMatteStream::CaptureStart(bool bFirstCapture, const AfxViewportData_t&
 }
 
 
-void CAfxMatteStream::CaptureEnd()
+advancedfx::IImageBufferThreadSafe * CAfxMatteStream::TransformCaptures(const CCaptures & captures)
 {
-	advancedfx::IImageBufferThreadSafe * bufferA = CaptureToBuffer( m_Task->GetAt(0) );
-	advancedfx::IImageBufferThreadSafe * bufferB = CaptureToBuffer( m_Task->GetAt(1) );
+	advancedfx::IImageBufferThreadSafe * bufferA = CaptureToBuffer( captures.GetAt(0) );
+	advancedfx::IImageBufferThreadSafe * bufferB = CaptureToBuffer( captures.GetAt(1) );
 
 	advancedfx::IImageBufferThreadSafe* outBuffer = advancedfx::ImageTransformer::Matte(g_pThreadPool,&g_ImageBufferPoolThreadSafe,bufferA, bufferB);
 
 	if (bufferA) bufferA->Release();
 	if (bufferB) bufferB->Release();
 
-	if(outBuffer) {
-		if (nullptr == m_OutVideoStream)
-		{
-			//TODO: This is currently safe due to mutexes and locks elsewhere, but not nice:
-			m_OutVideoStream = m_Settings->CreateOutVideoStreamCreator(g_AfxStreams, *this, g_AfxStreams.GetStartHostFrameRate(), "")->CreateOutVideoStream(*outBuffer->GetImageBufferFormat());
-			if (nullptr == m_OutVideoStream)
-			{
-				Tier0_Warning("AFXERROR: Failed to create image stream for %s.\n", this->StreamName_get());
-			}
-		}
-
-		if (nullptr != m_OutVideoStream && !m_OutVideoStream->SupplyImageBuffer(this, outBuffer))
-		{
-			Tier0_Warning("AFXERROR: Failed writing image for stream %s.\n", this->StreamName_get());
-		}
-
-		outBuffer->Release();
-	} else {
-		Tier0_Warning("CAfxMatteStream::CaptureEnd: Combining sub-streams for stream %s, failed.\n", this->StreamName_get());
+	if(nullptr == outBuffer) {
+		Tier0_Warning("CAfxMatteStream::TransformCaptures: Combining sub-streams for stream %s, failed.\n", this->StreamName_get());
 	}
 
-	CAfxRecordStream::CaptureEnd();
+	return outBuffer;
 }
 
 // CAfxBaseFxStream ////////////////////////////////////////////////////////////
@@ -5896,6 +5879,10 @@ CAfxStreams::~CAfxStreams()
 	ShutDown();
 }
 
+advancedfx::CThreadPool * CAfxStreams::GetThreadPool() const {
+	return g_pThreadPool;
+}
+
 
 #ifndef _WIN64
 void CAfxStreams::OnClientEntityCreated(SOURCESDK::C_BaseEntity_csgo* ent) {
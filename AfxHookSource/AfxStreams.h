@@ -971,6 +971,8 @@ public:
 
 	virtual advancedfx::CGrowingBufferPoolThreadSafe * GetImageBufferPool() const;
 
+	virtual advancedfx::CThreadPool * GetThreadPool() const;
+
 	virtual bool GetFormatBmpNotTga() const;
 
 	size_t GetStreamCount() const {
@@ -1031,7 +1033,6 @@ protected:
 	};
 
 	std::vector<CAfxRenderViewStream *> m_Streams;
-	class CCaptures* m_Task = nullptr;
 	std::vector<class CCaptureNode*> m_CaptureNodes;
 
 	void SetCaptureNode(size_t index, class CCaptureNode* node) {
@@ -1056,7 +1057,10 @@ protected:
 	{
 	}
 
-	virtual void CaptureEnd();
+	/// <summary>Turns the captures of a frame into the image to write.</summary>
+	/// <remarks>Runs on the thread pool, for several frames at the same time.</remarks>
+	/// <returns>The image (released by the caller) or nullptr on failure (already reported).</returns>
+	virtual advancedfx::IImageBufferThreadSafe * TransformCaptures(const CCaptures & captures) = 0;
 
 	advancedfx::IImageBufferThreadSafe * CaptureToBuffer(IAfxD3D9CaptureBuffer * capture) {
 		if(capture) {
@@ -1082,6 +1086,25 @@ private:
 		size_t m_Index;
 	};
 
+	class CCaptureFrame
+		: public advancedfx::CFramePipeline::CFrame
+	{
+	public:
+		CCaptureFrame(class CCaptures * captures)
+			: Captures(captures)
+			, Buffer(nullptr)
+		{
+		}
+
+		virtual ~CCaptureFrame() override {
+			if (Buffer) Buffer->Release();
+			delete Captures;
+		}
+
+		class CCaptures * Captures;
+		advancedfx::IImageBufferThreadSafe * Buffer;
+	};
+
 	std::string m_StreamName;
 	bool m_Record;
 	
@@ -1093,7 +1116,12 @@ private:
 	bool m_Recording = false;
 	bool m_FirstCapture = false;
 
+	/// <summary>Captures waiting for the processing thread, OnCapture blocks while there are 2 already.</summary>
 	std::list<class CCaptures*> m_In;
+	std::condition_variable m_InCv;
+
+	/// <summary>Transforms the captures in parallel and writes them in order, set while recording.</summary>
+	advancedfx::CFramePipeline * m_Pipeline = nullptr;
 
 	void ProcessingThreadFunc() {
 		std::unique_lock<std::mutex> lock(m_ProcessingThreadMutex);
@@ -1101,12 +1129,12 @@ private:
 			if (!m_In.empty()) {
 				class CCaptures* captures = m_In.front();
 				if(captures->GetSize() >= m_Streams.size()) {
-					m_Task = captures;
 					m_In.pop_front();
+					m_InCv.notify_one();
 					lock.unlock();
-					CaptureEnd();
-					delete m_Task;
-					m_Task = nullptr;
+					// Blocks while the pipeline is full, so a slow writer stalls the capture through m_In:
+					m_Pipeline->Push(new CCaptureFrame(captures));
+					m_CapturesLeft--;
 					lock.lock();
 				} else {
 					m_ProcessingThreadCv.wait(lock);
@@ -1115,8 +1143,14 @@ private:
 				m_ProcessingThreadCv.wait(lock);
 			}
 		}
+		lock.unlock();
+
+		m_Pipeline->Flush();
 	}
 
+	/// <remarks>Serial pipeline stage, gets the frames in capture order.</remarks>
+	void WriteCapture(advancedfx::IImageBufferThreadSafe * buffer);
+
 	/**
 	 * @remarks On GPU thread.
 	 */
@@ -1140,7 +1174,7 @@ public:
 
 protected:
 	virtual void CaptureStart(bool bFirstCapture, const AfxViewportData_t& viewport) override;
-	virtual void CaptureEnd() override;
+	virtual advancedfx::IImageBufferThreadSafe * TransformCaptures(const CCaptures & captures) override;
 
 private:
 
@@ -1169,7 +1203,7 @@ public:
 
 protected:
 	virtual void CaptureStart(bool bFirstCapture, const AfxViewportData_t& viewport) override;
-	virtual void CaptureEnd() override;
+	virtual advancedfx::IImageBufferThreadSafe * TransformCaptures(const CCaptures & captures) override;
 
 private:
 	StreamCombineType m_StreamCombineType;
@@ -2917,7 +2951,7 @@ protected:
 	virtual ~CAfxMatteStream();
 
 	virtual void CaptureStart(bool bFirstCapture, const AfxViewportData_t& viewport) override;
-	virtual void CaptureEnd() override;
+	virtual advancedfx::IImageBufferThreadSafe * TransformCaptures(const CCaptures & captures) override;
 
 private:
 	std::vector<IAfxBasefxStreamModifier *> m_Modifiers;
@@ -3543,6 +3577,8 @@ public:
 		return &g_ImageBufferPoolThreadSafe;
 	}
 
+	virtual advancedfx::CThreadPool * GetThreadPool() const;
+
 	virtual bool GetFormatBmpNotTga() const {
 		return m_FormatBmpAndNotTga;
 	}
@@ -66,7 +66,7 @@ bool CClientTools::GetRecording(void)
 
 void CClientTools::StartRecording(wchar_t const * fileName)
 {
-	if(m_AfxGameRecord.StartRecording(fileName, GetAgrVersion()))
+	if(m_AfxGameRecord.StartRecording(fileName, GetAgrVersion(), m_Compact ? &m_CompactSettings : nullptr))
 	{
 		if (!EnableRecordingMode_get() && !SuppotsAutoEnableRecordingMode()) {
 			Tier0_Warning(
@@ -129,7 +129,7 @@ void CClientTools::WriteMatrix3x4(SOURCESDK::matrix3x4_t const &value)
 void CClientTools::WriteBones(bool hasBones, const SOURCESDK::matrix3x4_t & parentTransform) {
 	m_AfxGameRecord.Write((bool)hasBones);
 	if(hasBones) {
-		m_AfxGameRecord.Write((int)m_BoneState.size());
+		m_BoneTransforms.resize(12 * m_BoneState.size());
 		SOURCESDK::matrix3x4_t bones;
 		SOURCESDK::matrix3x4_t tmp;
 		SOURCESDK::matrix3x4_t parentInverse;
@@ -158,8 +158,15 @@ void CClientTools::WriteBones(bool hasBones, const SOURCESDK::matrix3x4_t & pare
 
 			}
 
-			WriteMatrix3x4(bones);
+			float * pTransform = &m_BoneTransforms[12 * i];
+			for (int j = 0; j < 3; j++) {
+				for (int k = 0; k < 4; k++) {
+					pTransform[4 * j + k] = bones[j][k];
+				}
+			}
 		}
+
+		m_AfxGameRecord.WriteBones((int)m_BoneState.size(), (float const (*)[3][4])m_BoneTransforms.data());
 	} 
 }
 
@@ -404,6 +411,42 @@ bool ClientTools_Console_Cfg(IWrpCommandArgs * args)
 			);
 			return true;
 		}
+		else if (0 == _stricmp("compact", cmd1))
+		{
+			if (3 <= argc)
+			{
+				char const * cmd2 = args->ArgV(2);
+
+				clientTools->Compact_set(0 != atoi(cmd2));
+				return true;
+			}
+
+			Tier0_Msg(
+				"%s compact 0|1 - Enable (1) / Disable (0) the compact encoding (afxGameRecord2: quantized, delta encoded bones, unchanged entities left out) for new recordings. Needs an importer that supports it!\n"
+				"Current value: %i.\n"
+				, prefix
+				, clientTools->Compact_get() ? 1 : 0
+			);
+			return true;
+		}
+		else if (0 == _stricmp("compactPrecision", cmd1))
+		{
+			if (4 <= argc)
+			{
+				clientTools->CompactSettings().PositionStep = (float)atof(args->ArgV(2));
+				clientTools->CompactSettings().RotationBits = atoi(args->ArgV(3));
+				return true;
+			}
+
+			Tier0_Msg(
+				"%s compactPrecision <fPositionStep> <iRotationBits> - Bone position quantization step (game units) and bits per quaternion component (2 to 30) for the compact encoding.\n"
+				"Current value: %f %i.\n"
+				, prefix
+				, clientTools->CompactSettings().PositionStep
+				, clientTools->CompactSettings().RotationBits
+			);
+			return true;
+		}
 		else if (0 == _stricmp("debug", cmd1))
 		{
 			if (3 <= argc)
@@ -452,9 +495,13 @@ bool ClientTools_Console_Cfg(IWrpCommandArgs * args)
 	}
 	Tier0_Msg(
 		"%s recordInvisible [...] - (not recommended)\n"
+		"%s compact [...]\n"
+		"%s compactPrecision [...]\n"
 		"%s debug [...]\n"
 		, prefix
 		, prefix
+		, prefix
+		, prefix
 	);
 
 	return false;
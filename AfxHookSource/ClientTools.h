@@ -133,6 +133,22 @@ public:
 		m_RecordPlayerCameras = value;
 	}
 
+	/// <summary>Use the compact encoding (afxGameRecord2) for new recordings.</summary>
+	bool Compact_get(void)
+	{
+		return m_Compact;
+	}
+
+	void Compact_set(bool value)
+	{
+		m_Compact = value;
+	}
+
+	advancedfx::CAfxGameRecord::CompactSettings_s & CompactSettings(void)
+	{
+		return m_CompactSettings;
+	}
+
 	virtual bool SupportsRecordPlayerCameras() {
 		return false;
 	}
@@ -170,6 +186,18 @@ protected:
 		m_AfxGameRecord.MarkHidden(value);
 	}
 
+	void BeginEntity(int key) {
+		m_AfxGameRecord.BeginEntity(key);
+	}
+
+	void EndEntity() {
+		m_AfxGameRecord.EndEntity();
+	}
+
+	void ForgetEntity(int key) {
+		m_AfxGameRecord.ForgetEntity(key);
+	}
+
 private:
 	static CClientTools * m_Instance;
 
@@ -185,6 +213,8 @@ private:
 	bool m_RecordProjectiles = true;
 	int m_RecordViewModels = 0;
 	bool m_RecordInvisible = false;
+	bool m_Compact = false;
+	advancedfx::CAfxGameRecord::CompactSettings_s m_CompactSettings;
 	
 	struct BoneState_s {
 		SOURCESDK::matrix3x4_t Matrix;
@@ -193,6 +223,9 @@ private:
 	};
 
 	std::vector<BoneState_s> m_BoneState;
+
+	// 12 floats (matrix3x4) per bone.
+	std::vector<float> m_BoneTransforms;
 };
 
 bool ClientTools_Console_Cfg(IWrpCommandArgs * args);
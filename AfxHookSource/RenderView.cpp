@@ -41,6 +41,8 @@ BvhExport * g_BvhExport = NULL;
 
 BvhImport g_BvhImport;
 
+extern class advancedfx::CThreadPool* g_pThreadPool;
+
 // Create singelton instance:
 Hook_VClient_RenderView g_Hook_VClient_RenderView;
 
@@ -185,7 +187,7 @@ bool Hook_VClient_RenderView::ImportBegin(wchar_t const *fileName)
 {
 	ImportEnd();
 
-	m_Import = g_BvhImport.LoadMotionFile(fileName);
+	m_Import = g_BvhImport.LoadMotionFile(fileName, g_pThreadPool);
 
 	return m_Import;
 }
@@ -527,6 +529,9 @@ bool Hook_VClient_RenderView::ImportToCamPath(bool adjustInterp, double fov)
 	if(!m_Import)
 		return false;
 
+	// One undo step for the import and the interpolation changes:
+	m_CamPath.UndoCheckpoint();
+
 	bool bOk = g_BvhImport.CopyToCampath(m_ImportBaseTime, fov, m_CamPath);
 
 	if(bOk)
@@ -543,6 +548,8 @@ bool Hook_VClient_RenderView::ImportToCamPath(bool adjustInterp, double fov)
 		m_CamPath.Enabled_set(true);
 	}
 
+	m_CamPath.UndoCheckpointEnd();
+
 	return bOk;
 }
 
@@ -389,6 +389,7 @@ void CClientToolsCsgo::OnPostToolMessageCsgo(SOURCESDK::CSGO::HTOOLHANDLE hEntit
 				bool hasParentTransform = false;
 				SOURCESDK::matrix3x4_t parentTransform;				
 
+				BeginEntity((int)hEntity);
 				WriteDictionary("entity_state");
 				Write((int)hEntity);
 				{
@@ -440,6 +441,8 @@ void CClientToolsCsgo::OnPostToolMessageCsgo(SOURCESDK::CSGO::HTOOLHANDLE hEntit
 				bool viewModel = msg->GetBool("viewmodel");
 
 				Write((bool)viewModel);
+
+				EndEntity();
 			}
 		}
 	}
@@ -452,6 +455,7 @@ void CClientToolsCsgo::OnPostToolMessageCsgo(SOURCESDK::CSGO::HTOOLHANDLE hEntit
 			{
 				WriteDictionary("deleted");
 				Write((int)(it->first));
+				ForgetEntity((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
@@ -167,6 +167,7 @@ void CClientToolsCss::OnPostToolMessageCss(SOURCESDK::CSS::HTOOLHANDLE hEntity,
 				bool hasParentTransform = false;
 				SOURCESDK::matrix3x4_t parentTransform;				
 
+				BeginEntity((int)hEntity);
 				WriteDictionary("entity_state");
 				Write((int)hEntity);
 				{
@@ -205,6 +206,8 @@ void CClientToolsCss::OnPostToolMessageCss(SOURCESDK::CSS::HTOOLHANDLE hEntity,
 				bool viewModel = 0 != msg->GetInt("viewmodel");
 
 				Write((bool)viewModel);
+
+				EndEntity();
 			}
 		}
 	}
@@ -217,6 +220,7 @@ void CClientToolsCss::OnPostToolMessageCss(SOURCESDK::CSS::HTOOLHANDLE hEntity,
 			{
 				WriteDictionary("deleted");
 				Write((int)(it->first));
+				ForgetEntity((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
@@ -169,6 +169,7 @@ void CClientToolsCssV34::OnPostToolMessageCssV34(SOURCESDK::CSSV34::HTOOLHANDLE
 				bool hasParentTransform = false;
 				SOURCESDK::matrix3x4_t parentTransform;				
 
+				BeginEntity((int)hEntity);
 				WriteDictionary("entity_state");
 				Write((int)hEntity);
 				{
@@ -207,6 +208,8 @@ void CClientToolsCssV34::OnPostToolMessageCssV34(SOURCESDK::CSSV34::HTOOLHANDLE
 				bool viewModel = 0 != msg->GetInt("viewmodel");
 
 				Write((bool)viewModel);
+
+				EndEntity();
 			}
 		}
 	}
@@ -219,6 +222,7 @@ void CClientToolsCssV34::OnPostToolMessageCssV34(SOURCESDK::CSSV34::HTOOLHANDLE
 			{
 				WriteDictionary("deleted");
 				Write((int)(it->first));
+				ForgetEntity((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
@@ -177,6 +177,7 @@ void CClientToolsGarrysmod::OnPostToolMessageGarrysmod(SOURCESDK::GARRYSMOD::HTO
 				bool hasParentTransform = false;
 				SOURCESDK::matrix3x4_t parentTransform;				
 
+				BeginEntity((int)hEntity);
 				WriteDictionary("entity_state");
 				Write((int)hEntity);
 				{
@@ -215,6 +216,8 @@ void CClientToolsGarrysmod::OnPostToolMessageGarrysmod(SOURCESDK::GARRYSMOD::HTO
 				bool viewModel = 0 != msg->GetInt("viewmodel");
 
 				Write((bool)viewModel);
+
+				EndEntity();
 			}
 		}
 	}
@@ -227,6 +230,7 @@ void CClientToolsGarrysmod::OnPostToolMessageGarrysmod(SOURCESDK::GARRYSMOD::HTO
 			{
 				WriteDictionary("deleted");
 				Write((int)(it->first));
+				ForgetEntity((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
@@ -118,6 +118,7 @@ void CClientToolsMom::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 
 				bool wasVisible = false;
 
+				BeginEntity((int)hEntity);
 				WriteDictionary("entity_state");
 				Write((int)hEntity);
 				{
@@ -158,6 +159,8 @@ void CClientToolsMom::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 				bool viewModel = msg->GetBool("viewmodel");
 
 				Write((bool)viewModel);
+
+				EndEntity();
 			}
 		}
 	}
@@ -170,6 +173,7 @@ void CClientToolsMom::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 			{
 				WriteDictionary("deleted");
 				Write((int)(it->first));
+				ForgetEntity((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
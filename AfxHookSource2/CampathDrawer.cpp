@@ -729,19 +729,22 @@ CCampathDrawer::CLessDynamicProperties::CLessDynamicProperties(CCampathDrawer *
 		auto it = last;
 
 		TempPoint * pts = new TempPoint[c_CameraTrajectoryMaxPointsPerInterval];
+		double * ptsX = new double[c_CameraTrajectoryMaxPointsPerInterval];
+		double * ptsY = new double[c_CameraTrajectoryMaxPointsPerInterval];
+		double * ptsZ = new double[c_CameraTrajectoryMaxPointsPerInterval];
 
 		for(++it; it != g_CamPath.GetEnd(); ++it)
 		{
 			double delta = it.GetTime() - last.GetTime();
 
+			g_CamPath.EvalRange(last.GetTime(), delta / (c_CameraTrajectoryMaxPointsPerInterval-1), c_CameraTrajectoryMaxPointsPerInterval, ptsX, ptsY, ptsZ);
+
 			for(size_t i = 0; i<c_CameraTrajectoryMaxPointsPerInterval; i++)
 			{
 				double t = last.GetTime() + delta*((double)i/(c_CameraTrajectoryMaxPointsPerInterval-1));
 
-				CamPathValue cpv = g_CamPath.Eval(t);
-
 				pts[i].t = t;
-				pts[i].y = Vector3(cpv.X, cpv.Y, cpv.Z);
+				pts[i].y = Vector3(ptsX[i], ptsY[i], ptsZ[i]);
 				pts[i].nextPt = i+1 <c_CameraTrajectoryMaxPointsPerInterval ? &(pts[i+1]) : 0;
 			}
 
@@ -763,6 +766,9 @@ CCampathDrawer::CLessDynamicProperties::CLessDynamicProperties(CCampathDrawer *
 			pts[c_CameraTrajectoryMaxPointsPerInterval-1].t,
 			g_CamPath.Eval(pts[c_CameraTrajectoryMaxPointsPerInterval-1].t));
 
+		delete[] ptsZ;
+		delete[] ptsY;
+		delete[] ptsX;
 		delete[] pts;
 	}
 }
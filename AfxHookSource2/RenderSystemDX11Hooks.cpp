@@ -3040,6 +3040,10 @@ public:
         return &g_ImageBufferPool;
     }
 
+    virtual advancedfx::CThreadPool * GetThreadPool() const {
+        return g_pThreadPool;
+    }
+
     virtual bool GetFormatBmpNotTga() const {        
         return m_FormatBmpAndNotTga;
     }
@@ -3241,6 +3245,10 @@ private:
             return &g_ImageBufferPool;
         }
 
+        virtual advancedfx::CThreadPool * GetThreadPool() const {
+            return g_pThreadPool;
+        }
+
         virtual bool GetFormatBmpNotTga() const {
             return m_Streams->GetFormatBmpNotTga();
         }
@@ -945,7 +945,10 @@ CON_COMMAND(mirv_sfm, "Source Filmmaker helpers (import)")
                 return;
             }
             size_t count = 0;
-            if (!ImportSfmCamKeyframes_S2(data, g_CamPath, count))
+            g_CamPath.UndoCheckpoint();
+            bool bOk = ImportSfmCamKeyframes_S2(data, g_CamPath, count);
+            g_CamPath.UndoCheckpointEnd();
+            if (!bOk)
             {
                 advancedfx::Warning("Error: Parse failed or no keyframes found.\n");
                 return;
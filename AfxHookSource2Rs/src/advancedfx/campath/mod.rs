@@ -192,6 +192,10 @@ unsafe extern "C" {
 
     fn advancedfx_campath_set_hold(ptr: * mut CampathType, value: bool);
 
+    fn advancedfx_campath_get_constant_speed(ptr: * const CampathType) -> bool;
+
+    fn advancedfx_campath_set_constant_speed(ptr: * mut CampathType, value: bool);
+
     fn advancedfx_campath_position_interp_get(ptr: * const CampathType) -> u8;
 
     fn advancedfx_campath_position_interp_set(ptr: * mut CampathType, value: u8);
@@ -235,10 +239,18 @@ unsafe extern "C" {
       */    
     fn advancedfx_campath_eval(ptr: * const CampathType, time: f64) -> Value;
 
+    /***
+      * @remarks Must not be called if CanEval() returns false!
+      * Any of the output pointers may be null in order to skip that channel.
+      */
+    fn advancedfx_campath_eval_range(ptr: * const CampathType, t0: f64, dt: f64, n: usize, out_x: * mut f64, out_y: * mut f64, out_z: * mut f64, out_r: * mut advancedfx::math::Quaternion, out_fov: * mut f64);
+
     fn advancedfx_campath_load(ptr: * const CampathType, file_name: *const c_char) -> bool;
 
     fn advancedfx_campath_save(ptr: * const CampathType, file_name: *const c_char) -> bool;
 
+    fn advancedfx_campath_save_binary(ptr: * const CampathType, file_name: *const c_char) -> bool;
+
     /***
       * @remarks In the current implementation if points happen to fall on the same time value, then the last point's value will be used (no interpolation).
       * @param relative If t is an relative offset (true), or absolute value (false).
@@ -400,6 +412,18 @@ impl Campath {
         }   
     }
 
+    pub fn get_constant_speed(&self) -> bool {
+        unsafe {
+            advancedfx_campath_get_constant_speed(self.ptr)
+        }   
+    }
+
+    pub fn set_constant_speed(&mut self, value: bool) {
+        unsafe {
+            advancedfx_campath_set_constant_speed(self.ptr, value)
+        }   
+    }
+
     pub fn get_position_interp(&self) -> DoubleInterp {
         unsafe { u8_to_double_interp( advancedfx_campath_position_interp_get(self.ptr) ) }
     }
@@ -510,6 +534,19 @@ impl Campath {
         }   
     }
 
+    /***
+      * Evaluates n = x.len() samples at t0 + i * dt.
+      * @remarks Must not be called if CanEval() returns false! dt must not be negative.
+      */
+    pub fn eval_range(&self, t0: f64, dt: f64, x: &mut [f64], y: &mut [f64], z: &mut [f64], r: &mut [advancedfx::math::Quaternion], fov: &mut [f64]) {
+        assert!(self.can_eval());
+        let n = x.len();
+        assert!(y.len() == n && z.len() == n && r.len() == n && fov.len() == n);
+        unsafe {
+            advancedfx_campath_eval_range(self.ptr, t0, dt, n, x.as_mut_ptr(), y.as_mut_ptr(), z.as_mut_ptr(), r.as_mut_ptr(), fov.as_mut_ptr())
+        }
+    }
+
     pub fn load(&mut self, file_name: String ) -> bool {
         let c_string_file_name = std::ffi::CString::new(file_name).unwrap();
         unsafe {
@@ -524,6 +561,13 @@ impl Campath {
         }
     }
 
+    pub fn save_binary(&mut self, file_name: String ) -> bool {
+        let c_string_file_name = std::ffi::CString::new(file_name).unwrap();
+        unsafe {
+            advancedfx_campath_save_binary(self.ptr,c_string_file_name.as_ptr())
+        }
+    }
+
     /***
       * @remarks In the current implementation if points happen to fall on the same time value, then the last point's value will be used (no interpolation).
       * @param relative If t is an relative offset (true), or absolute value (false).
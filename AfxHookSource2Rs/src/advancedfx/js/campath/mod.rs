@@ -485,6 +485,20 @@ impl Campath {
         Err(advancedfx::js::errors::error_arguments(context).into())
     }
 
+    fn get_constant_speed(this: &JsValue, _args: &[JsValue], context: &mut Context) -> JsResult<JsValue> {
+        Ok(js_value!(Self::inner_from_this(this,context)?.borrow().data().native.get_constant_speed()))
+    }
+
+    fn set_constant_speed(this: &JsValue, args: &[JsValue], context: &mut Context) -> JsResult<JsValue> {
+        if 1 == args.len() {
+            if let Some(value) = args[0].as_boolean() {
+                Self::inner_from_this(this,context)?.borrow_mut().data_mut().native.set_constant_speed(value);
+                return Ok(JsValue::undefined());
+            }
+        }
+        Err(advancedfx::js::errors::error_arguments(context).into())
+    }
+
     fn get_position_interp(this: &JsValue, _args: &[JsValue], context: &mut Context) -> JsResult<JsValue> {
         Ok(js_value!(Self::inner_from_this(this,context)?.borrow().data().native.get_position_interp() as u8))
     }
@@ -636,6 +650,17 @@ impl Campath {
         Err(advancedfx::js::errors::error_arguments(context).into())
     }
 
+    fn save_binary(this: &JsValue, args: &[JsValue], context: &mut Context) -> JsResult<JsValue> {
+        if 1 == args.len() {
+            if let Some(js_file_path) = args[0].as_string() {
+                if let Ok(str_file_path) = js_file_path.to_std_string() {
+                    return Ok(JsValue::from(Self::inner_from_this(this,context)?.borrow_mut().data_mut().native.save_binary(str_file_path)));
+                }
+            }
+        }
+        Err(advancedfx::js::errors::error_arguments(context).into())
+    }
+
     fn set_start(this: &JsValue, args: &[JsValue], context: &mut Context) -> JsResult<JsValue> {
         if 1 <= args.len() {
             if let Some(time) = args[0].as_number() {
@@ -989,6 +1014,12 @@ impl Class for Campath {
                 Some(NativeFunction::from_fn_ptr(Campath::set_hold).to_js_function(&realm)),
                 Attribute::all()
             )        
+            .accessor(
+                js_string!("constantSpeed"),
+                Some(NativeFunction::from_fn_ptr(Campath::get_constant_speed).to_js_function(&realm)),
+                Some(NativeFunction::from_fn_ptr(Campath::set_constant_speed).to_js_function(&realm)),
+                Attribute::all()
+            )        
             .accessor(
                 js_string!("positionInterp"),
                 Some(NativeFunction::from_fn_ptr(Campath::get_position_interp).to_js_function(&realm)),
@@ -1067,6 +1098,11 @@ impl Class for Campath {
                 1,
                 NativeFunction::from_fn_ptr(Campath::save)
             )
+            .method(
+                js_string!("saveBinary"),
+                1,
+                NativeFunction::from_fn_ptr(Campath::save_binary)
+            )
             .method(
                 js_string!("setStart"),
                 2,
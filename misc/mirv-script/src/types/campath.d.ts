@@ -65,6 +65,11 @@ declare class AdvancedfxCampath {
 
 	hold: boolean;
 
+	/**
+	 * Move along the position curve at constant speed (keyframe times then only determine start and end).
+	 */
+	constantSpeed: boolean;
+
 	positionInterp: AdvancedfxCampath.DoubleInterp;
 
 	rotationInterp: AdvancedfxCampath.QuaternionInterp;
@@ -116,10 +121,18 @@ declare class AdvancedfxCampath {
 
 	eval(time: number): AdvancedfxCampathValue | undefined;
 
+	/**
+	 * Loads XML or binary campath files.
+	 */
 	load(filePath: string): boolean;
 
 	save(filePath: string): boolean;
 
+	/**
+	 * Saves in binary format, which is much faster to load for big paths.
+	 */
+	saveBinary(filePath: string): boolean;
+
 	/**
 	 * @remarks
 	 * If keyframes happen to fall on same time, the last one wins.
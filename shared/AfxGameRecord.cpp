@@ -1,18 +1,105 @@
 #include "stdafx.h"
 
 #include "AfxGameRecord.h"
+#include "BoneTransforms.h"
 
 #include <string>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+
+// Compact encoding (afxGameRecord2)
+//
+// Same as afxGameRecord, except:
+// - The header is "afxGameRecord2\0", int version, float PositionStep, int RotationBits, int KeyFrameInterval.
+// - Bones (after the int bone count) are quantized:
+//   position: round(value / PositionStep),
+//   rotation: quaternion as smallest three (largest component made positive and left out),
+//   round(component * sqrt(2) * (2^(RotationBits-1) -1)).
+//   Each bone is a byte (bits 0-1: index of the left out component (x, y, z, w),
+//   bits 2-7: which of position x, y, z, rotation a, b, c follow), followed by the flagged values
+//   as zig-zag varints of the difference to the previous value of that entity's bone.
+//   The previous values are 0, if the entity had no bones with the same count yet
+//   or was marked hidden or deleted since.
+// - An entity_state that is the same as the last one written for that entity is left out,
+//   readers keep the last state then.
+// - Every KeyFrameInterval-th frame (starting with the first) is a key frame:
+//   all previous values are 0 and no entity_state is left out, so reading can start there.
+// - After the last frame there's a footer (unless recording was not ended properly):
+//   dictionary "afxFooter", int frame count, per frame the uint64 file offset of its "afxFrame",
+//   int dictionary size, the dictionary strings in index order,
+//   uint64 file offset of the "afxFooter" and the 8 bytes "afxFoot\0" as the last bytes of the file.
 
 namespace advancedfx {
 
+static int AfxGameRecord_Quantize(double value, double scale, int maxValue)
+{
+	double q = floor(value * scale + 0.5);
+	if (q < -maxValue) return -maxValue;
+	if (q > maxValue) return maxValue;
+	return (int)q;
+}
+
+/// <param name="quaternion">Normalized rotation of matrix (x, y, z, w).</param>
+/// <param name="outValues">c_BoneValues ints: position x, y, z, largest index, smallest three a, b, c.</param>
+static void AfxGameRecord_QuantizeBone(float const matrix[3][4], float const quaternion[4], double positionScale, int rotationMax, int * outValues)
+{
+	for (int i = 0; i < 3; ++i) {
+		outValues[i] = AfxGameRecord_Quantize(matrix[i][3], positionScale, INT_MAX);
+	}
+
+	double q[4] = { quaternion[0], quaternion[1], quaternion[2], quaternion[3] };
+
+	int largest = 0;
+	for (int i = 1; i < 4; ++i) {
+		if (fabs(q[largest]) < fabs(q[i])) largest = i;
+	}
+	double sign = q[largest] < 0 ? -1 : 1;
+
+	outValues[3] = largest;
+
+	double rotationScale = sqrt(2.0) * rotationMax;
+	for (int i = 0, j = 4; i < 4; ++i) {
+		if (i == largest) continue;
+		outValues[j++] = AfxGameRecord_Quantize(sign * q[i], rotationScale, rotationMax);
+	}
+}
+
+class CAfxGameRecord::CWriteTask : public CThreadPool::CTask
+{
+public:
+	CWriteTask(CAfxGameRecord * gameRecord, Buffer_t * buffer)
+	: m_GameRecord(gameRecord)
+	, m_Buffer(buffer) {
+	}
+
+	virtual void Execute() override {
+		fwrite(m_Buffer->data(), 1, m_Buffer->size(), m_GameRecord->m_File);
+		m_GameRecord->ReleaseBuffer(m_Buffer);
+	}
+
+private:
+	CAfxGameRecord * m_GameRecord;
+	Buffer_t * m_Buffer;
+};
+
 CAfxGameRecord::CAfxGameRecord()
-: m_Recording(false) {
+: m_Recording(false)
+, m_File(0)
+, m_Compact(false)
+, m_Entity(0)
+, m_FileOffset(0)
+, m_Buffer(0) {
 
 }
 
 CAfxGameRecord::~CAfxGameRecord() {
     EndRecording();
+
+	while (!m_FreeBuffers.empty()) {
+		delete m_FreeBuffers.top();
+		m_FreeBuffers.pop();
+	}
 }
 
 bool CAfxGameRecord::GetRecording(void)
@@ -20,7 +107,7 @@ bool CAfxGameRecord::GetRecording(void)
 	return m_Recording;
 }
 
-bool CAfxGameRecord::StartRecording(wchar_t const * fileName, int version)
+bool CAfxGameRecord::StartRecording(wchar_t const * fileName, int version, CompactSettings_s const * compact)
 {
 	EndRecording();
 
@@ -29,17 +116,37 @@ bool CAfxGameRecord::StartRecording(wchar_t const * fileName, int version)
 	Dictionary_Clear();
 	m_File = 0;
 
-	m_HiddenFileOffset = 0;
+	m_HiddenBufferOffset = 0;
 	m_Hidden.clear();
 
+	m_Compact = nullptr != compact;
+	if (m_Compact) {
+		m_CompactSettings = *compact;
+		if (!(0 < m_CompactSettings.PositionStep)) m_CompactSettings.PositionStep = CompactSettings_s().PositionStep;
+		if (m_CompactSettings.RotationBits < 2) m_CompactSettings.RotationBits = 2;
+		else if (30 < m_CompactSettings.RotationBits) m_CompactSettings.RotationBits = 30;
+		if (m_CompactSettings.KeyFrameInterval < 1) m_CompactSettings.KeyFrameInterval = 1;
+	}
+	m_Entities.clear();
+	m_Entity = 0;
+
+	m_FileOffset = 0;
+	m_FrameOffsets.clear();
+
 	_wfopen_s(&m_File, fileName, L"wb");
 
 	if (m_File)
 	{
-		fputs("afxGameRecord", m_File);
-		fputc('\0', m_File);
-
-		fwrite(&version, sizeof(version), 1, m_File);
+		m_Buffer = AquireBuffer();
+		m_WriterThread.reset(new CThreadPool(1));
+
+		Write(m_Compact ? "afxGameRecord2" : "afxGameRecord");
+		Write(version);
+		if (m_Compact) {
+			Write(m_CompactSettings.PositionStep);
+			Write(m_CompactSettings.RotationBits);
+			Write(m_CompactSettings.KeyFrameInterval);
+		}
         return true;
 	}
 	else      
@@ -56,11 +163,27 @@ void CAfxGameRecord::EndRecording()
 
 	if (m_File)
 	{
+		if (m_Compact) WriteFooter();
+
+		SubmitBuffer();
+
+		// Waits for all buffers to be written.
+		m_WriterThread.reset();
+
+		ReleaseBuffer(m_Buffer);
+		m_Buffer = 0;
+
 		fclose(m_File);
+		m_File = 0;
 	}
 
 	Dictionary_Clear();
 
+	m_Entities.clear();
+	m_Entity = 0;
+
+	m_FrameOffsets.clear();
+
 	m_Recording = false;
 }
 
@@ -68,9 +191,17 @@ void CAfxGameRecord::BeginFrame(float frameTime)
 {
     if (!m_Recording) return;
 
+	if (m_Compact)
+	{
+		if (0 == m_FrameOffsets.size() % m_CompactSettings.KeyFrameInterval)
+			m_Entities.clear(); // Key frame.
+
+		m_FrameOffsets.push_back(m_FileOffset + m_Buffer->size());
+	}
+
     WriteDictionary("afxFrame");
 	Write((float)frameTime);
-	m_HiddenFileOffset = ftell(m_File);
+	m_HiddenBufferOffset = m_Buffer->size();
 	Write((int)0);
 }
 
@@ -78,30 +209,34 @@ void CAfxGameRecord::EndFrame()
 {
     if (!m_Recording) return;
 
-	if (m_File && m_HiddenFileOffset && 0 < m_Hidden.size())
+	if (m_File && m_HiddenBufferOffset && 0 < m_Hidden.size())
 	{
 		WriteDictionary("afxHidden");
 
-		size_t curOffset = ftell(m_File);
+		size_t curOffset = m_Buffer->size();
 
-		int offset = (int)(curOffset - m_HiddenFileOffset);
+		int offset = (int)(curOffset - m_HiddenBufferOffset);
 
-		fseek(m_File, m_HiddenFileOffset, SEEK_SET);
-		Write((int)offset);
-		fseek(m_File, curOffset, SEEK_SET);
+		// Patch in memory, the frame has not been submitted yet:
+		memcpy(m_Buffer->data() + m_HiddenBufferOffset, &offset, sizeof(offset));
 
 		Write((int)m_Hidden.size());
 
 		for (std::set<int>::iterator it = m_Hidden.begin(); it != m_Hidden.end(); ++it)
 		{
 			Write((int)(*it));
+
+			// Readers forget the entity here, so do we:
+			ForgetEntity(*it);
 		}
 
 		m_Hidden.clear();
-		m_HiddenFileOffset = 0;
+		m_HiddenBufferOffset = 0;
 	}
 
 	WriteDictionary("afxFrameEnd");
+
+	if (m_File) SubmitBuffer();
 }
 
 void CAfxGameRecord::WriteDictionary(char const * value)
@@ -122,36 +257,130 @@ void CAfxGameRecord::Write(bool value)
 
 	unsigned char ucValue = value ? 1 : 0;
 
-	fwrite(&ucValue, sizeof(ucValue), 1, m_File);
+	WriteBytes(&ucValue, sizeof(ucValue));
 }
 
 void CAfxGameRecord::Write(int value)
 {
 	if (!m_File) return;
 
-	fwrite(&value, sizeof(value), 1, m_File);
+	WriteBytes(&value, sizeof(value));
 }
 
 void CAfxGameRecord::Write(float value)
 {
 	if (!m_File) return;
 
-	fwrite(&value, sizeof(value), 1, m_File);
+	WriteBytes(&value, sizeof(value));
 }
 
 void CAfxGameRecord::Write(double value)
 {
 	if (!m_File) return;
 
-	fwrite(&value, sizeof(value), 1, m_File);
+	WriteBytes(&value, sizeof(value));
 }
 
 void CAfxGameRecord::Write(char const * value)
 {
 	if (!m_File) return;
 
-	fputs(value, m_File);
-	fputc('\0', m_File);
+	WriteBytes(value, strlen(value) + 1);
+}
+
+void CAfxGameRecord::WriteBones(int numBones, float const (*bones)[3][4])
+{
+	if (!m_File) return;
+
+	Write(numBones);
+
+	if (!m_Compact) {
+		for (int i = 0; i < numBones; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				for (int k = 0; k < 4; ++k) {
+					Write(bones[i][j][k]);
+				}
+			}
+		}
+		return;
+	}
+
+	std::vector<int> * pPrevBones = m_Entity ? &m_Entity->Bones : nullptr;
+	bool bReset = nullptr == pPrevBones || pPrevBones->size() != (size_t)numBones * c_BoneValues;
+
+	std::vector<int> newBones((size_t)numBones * c_BoneValues);
+
+	m_BoneQuaternions.resize((size_t)numBones * 4);
+	BoneTransforms::ToQuaternions(numBones, bones, (float (*)[4])m_BoneQuaternions.data());
+
+	double positionScale = 1.0 / m_CompactSettings.PositionStep;
+	int rotationMax = (1 << (m_CompactSettings.RotationBits - 1)) - 1;
+
+	for (int i = 0; i < numBones; ++i) {
+		int * values = &newBones[(size_t)i * c_BoneValues];
+		int const * prevValues = bReset ? nullptr : &(*pPrevBones)[(size_t)i * c_BoneValues];
+
+		AfxGameRecord_QuantizeBone(bones[i], &m_BoneQuaternions[(size_t)i * 4], positionScale, rotationMax, values);
+
+		int deltas[6];
+		unsigned char flags = (unsigned char)values[3];
+		for (int j = 0; j < 6; ++j) {
+			int index = j < 3 ? j : j + 1;
+			deltas[j] = (int)((unsigned int)values[index] - (unsigned int)(prevValues ? prevValues[index] : 0));
+			if (deltas[j]) flags |= 1 << (2 + j);
+		}
+		if (prevValues && values[3] != prevValues[3]) m_EntityBonesChanged = true;
+		if (flags & 0xfc) m_EntityBonesChanged = true;
+
+		WriteBytes(&flags, sizeof(flags));
+		for (int j = 0; j < 6; ++j) {
+			if (deltas[j]) WriteVarInt(deltas[j]);
+		}
+	}
+
+	if (bReset) m_EntityBonesChanged = true;
+
+	if (pPrevBones) pPrevBones->swap(newBones);
+}
+
+void CAfxGameRecord::BeginEntity(int key)
+{
+	if (!m_File || !m_Compact) return;
+
+	m_Entity = &m_Entities[key];
+	m_EntityOffset = m_Buffer->size();
+	m_EntityBonesChanged = false;
+}
+
+void CAfxGameRecord::EndEntity()
+{
+	if (!m_Entity) return;
+
+	unsigned char const * pState = m_Buffer->data() + m_EntityOffset;
+	size_t stateSize = m_Buffer->size() - m_EntityOffset;
+
+	if (!m_EntityBonesChanged
+		&& stateSize == m_Entity->LastState.size()
+		&& 0 == memcmp(pState, m_Entity->LastState.data(), stateSize))
+	{
+		// Unchanged, leave it out:
+		m_Buffer->resize(m_EntityOffset);
+	}
+	else
+	{
+		m_Entity->LastState.assign(pState, pState + stateSize);
+	}
+
+	m_Entity = 0;
+}
+
+void CAfxGameRecord::ForgetEntity(int key)
+{
+	std::map<int, EntityState_s>::iterator it = m_Entities.find(key);
+	if (it == m_Entities.end()) return;
+
+	if (m_Entity == &it->second) m_Entity = 0;
+	m_Entities.erase(it);
 }
 
 void CAfxGameRecord::MarkHidden(int value)
@@ -159,8 +388,82 @@ void CAfxGameRecord::MarkHidden(int value)
 	m_Hidden.insert(value);
 }
 
-FILE * CAfxGameRecord::GetFile() {
-    return m_File;
+void CAfxGameRecord::WriteVarInt(int value)
+{
+	// zig-zag:
+	unsigned int uValue = ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+
+	unsigned char bytes[5];
+	size_t count = 0;
+	do {
+		unsigned char byte = uValue & 0x7f;
+		uValue >>= 7;
+		if (uValue) byte |= 0x80;
+		bytes[count++] = byte;
+	} while (uValue);
+
+	WriteBytes(bytes, count);
+}
+
+void CAfxGameRecord::WriteBytes(void const * data, size_t size)
+{
+	unsigned char const * pData = (unsigned char const *)data;
+	m_Buffer->insert(m_Buffer->end(), pData, pData + size);
+}
+
+void CAfxGameRecord::WriteFooter()
+{
+	uint64_t footerOffset = m_FileOffset + m_Buffer->size();
+
+	WriteDictionary("afxFooter");
+
+	Write((int)m_FrameOffsets.size());
+	WriteBytes(m_FrameOffsets.data(), m_FrameOffsets.size() * sizeof(uint64_t));
+
+	std::vector<char const *> dictionary(m_Dictionary.size());
+	for (std::map<std::string, int>::iterator it = m_Dictionary.begin(); it != m_Dictionary.end(); ++it)
+	{
+		dictionary[it->second] = it->first.c_str();
+	}
+
+	Write((int)dictionary.size());
+	for (size_t i = 0; i < dictionary.size(); ++i)
+	{
+		Write(dictionary[i]);
+	}
+
+	WriteBytes(&footerOffset, sizeof(footerOffset));
+	WriteBytes("afxFoot", 8);
+}
+
+void CAfxGameRecord::SubmitBuffer()
+{
+	if (m_Buffer->empty()) return;
+
+	m_FileOffset += m_Buffer->size();
+	m_WriterThread->QueueTask(new CWriteTask(this, m_Buffer));
+	m_Buffer = AquireBuffer();
+}
+
+CAfxGameRecord::Buffer_t * CAfxGameRecord::AquireBuffer()
+{
+	std::unique_lock<std::mutex> lock(m_FreeBuffersMutex);
+	if (m_FreeBuffers.empty()) {
+		lock.unlock();
+		return new Buffer_t();
+	}
+
+	Buffer_t * result = m_FreeBuffers.top();
+	m_FreeBuffers.pop();
+	return result;
+}
+
+void CAfxGameRecord::ReleaseBuffer(Buffer_t * buffer)
+{
+	buffer->clear(); // Keeps the capacity.
+
+	std::unique_lock<std::mutex> lock(m_FreeBuffersMutex);
+	m_FreeBuffers.push(buffer);
 }
 
 void CAfxGameRecord::Dictionary_Clear()
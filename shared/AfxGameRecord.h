@@ -1,22 +1,46 @@
 #pragma once
 
+#include "ThreadPool.h"
+
 #include <stdio.h>
 
 #include <string>
 #include <set>
 #include <map>
+#include <memory>
+#include <stdint.h>
+#include <mutex>
+#include <stack>
+#include <vector>
 
 namespace advancedfx {
 
+/// <remarks>
+/// Writes go into an in-memory frame buffer, EndFrame hands it to a writer thread as one block,
+/// so recording never blocks on disk.<br />
+/// The compact encoding (afxGameRecord2) is described in AfxGameRecord.cpp.
+/// </remarks>
 class CAfxGameRecord
 {
 public:
+	struct CompactSettings_s {
+		/// <summary>Bone positions are quantized to multiples of this (game units).</summary>
+		float PositionStep = 1.0f / 1024;
+
+		/// <summary>Bits per quantized quaternion component (2 to 30).</summary>
+		int RotationBits = 16;
+
+		/// <summary>Frames between key frames (where reading can start).</summary>
+		int KeyFrameInterval = 128;
+	};
+
 	CAfxGameRecord();
 	~CAfxGameRecord();
 
 	bool GetRecording(void);
 
-	bool StartRecording(wchar_t const * fileName, int version);
+	/// <param name="compact">If not null, the compact encoding is used with these settings.</param>
+	bool StartRecording(wchar_t const * fileName, int version, CompactSettings_s const * compact = nullptr);
 
 	void EndRecording();
 
@@ -32,19 +56,76 @@ public:
 	void Write(double value);
 	void Write(char const * value); // Consider using WriteDictionary instead (if string is long enough and likely to repeat often).
 
-	void MarkHidden(int value);
+	/// <summary>Writes the bone count and the bone transforms (relative to their parent).</summary>
+	/// <remarks>Compact encoding: quantized and delta encoded against the entity's previous bones, if between BeginEntity / EndEntity.</remarks>
+	void WriteBones(int numBones, float const (*bones)[3][4]);
+
+	/// <summary>Call before writing an entity's "entity_state".</summary>
+	void BeginEntity(int key);
 
-	FILE * GetFile();
+	/// <summary>Call after writing an entity's state.</summary>
+	/// <remarks>Compact encoding: drops the state if it's the same as the entity's previous one.</remarks>
+	void EndEntity();
+
+	/// <summary>Call when an entity got deleted.</summary>
+	void ForgetEntity(int key);
+
+	/// <remarks>The entity is forgotten at the end of the frame.</remarks>
+	void MarkHidden(int value);
 
 private:
+	typedef std::vector<unsigned char> Buffer_t;
+
+	class CWriteTask;
+
 	std::map<std::string, int> m_Dictionary;
 
-	size_t m_HiddenFileOffset;
+	size_t m_HiddenBufferOffset;
 	std::set<int> m_Hidden;
 
 	bool m_Recording;
 	FILE * m_File;
 
+	bool m_Compact;
+	CompactSettings_s m_CompactSettings;
+
+	struct EntityState_s {
+		// Quantized bones, c_BoneValues per bone.
+		std::vector<int> Bones;
+		std::vector<unsigned char> LastState;
+	};
+
+	static const int c_BoneValues = 7;
+
+	std::map<int, EntityState_s> m_Entities;
+	EntityState_s * m_Entity;
+	size_t m_EntityOffset;
+	bool m_EntityBonesChanged;
+
+	std::vector<float> m_BoneQuaternions;
+
+	// Bytes handed to the writer thread so far.
+	uint64_t m_FileOffset;
+	std::vector<uint64_t> m_FrameOffsets;
+
+	void WriteVarInt(int value);
+
+	void WriteFooter();
+
+	Buffer_t * m_Buffer;
+	std::unique_ptr<CThreadPool> m_WriterThread;
+
+	std::mutex m_FreeBuffersMutex;
+	std::stack<Buffer_t *> m_FreeBuffers;
+
+	void WriteBytes(void const * data, size_t size);
+
+	/// <summary>Queues the current buffer for writing and starts a new one.</summary>
+	void SubmitBuffer();
+
+	Buffer_t * AquireBuffer();
+	void ReleaseBuffer(Buffer_t * buffer);
+
 	void Dictionary_Clear();
 
 	int Dictionary_Get(char const * value);
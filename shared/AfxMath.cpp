@@ -195,6 +195,88 @@ void spline(double x[], double y[], int n, bool y1Natural, double yp1, bool ynNa
 	delete u;
 }
 
+// Same system as spline, but only re-solves y2[lo..hi] (tridiagonal / Thomas algorithm),
+// using the current y2[lo-1] and y2[hi+1] as fixed boundary values where they exist.
+void spline_window(double x[], double y[], int n, bool y1Natural, double yp1, bool ynNatural, double ypn, double y2[], int lo, int hi)
+{
+	int m = hi - lo + 1;
+	if (m < 1) return;
+
+	double *c = new double[m];
+	double *d = new double[m];
+	double *b = new double[m];
+
+	for (int j = 0; j < m; j++)
+	{
+		int i = lo + j;
+		double ai, bi, ci, di;
+
+		if (0 == i)
+		{
+			ai = 0.0;
+			if (y1Natural)
+			{
+				bi = 1.0; ci = 0.0; di = 0.0;
+			}
+			else
+			{
+				double h = x[1] - x[0];
+				bi = 2.0 * h; ci = h; di = 6.0 * ((y[1] - y[0]) / h - yp1);
+			}
+		}
+		else if (n - 1 == i)
+		{
+			ci = 0.0;
+			if (ynNatural)
+			{
+				ai = 0.0; bi = 1.0; di = 0.0;
+			}
+			else
+			{
+				double h = x[n - 1] - x[n - 2];
+				ai = h; bi = 2.0 * h; di = 6.0 * (ypn - (y[n - 1] - y[n - 2]) / h);
+			}
+		}
+		else
+		{
+			double h0 = x[i] - x[i - 1];
+			double h1 = x[i + 1] - x[i];
+			ai = h0; bi = 2.0 * (h0 + h1); ci = h1;
+			di = 6.0 * ((y[i + 1] - y[i]) / h1 - (y[i] - y[i - 1]) / h0);
+		}
+
+		if (0 == j && 0 < i)
+		{
+			di -= ai * y2[i - 1];
+			ai = 0.0;
+		}
+		if (m - 1 == j && i < n - 1)
+		{
+			di -= ci * y2[i + 1];
+			ci = 0.0;
+		}
+
+		if (0 < j)
+		{
+			double f = ai / b[j - 1];
+			bi -= f * c[j - 1];
+			di -= f * d[j - 1];
+		}
+
+		b[j] = bi;
+		c[j] = ci;
+		d[j] = di;
+	}
+
+	y2[hi] = d[m - 1] / b[m - 1];
+	for (int j = m - 2; j >= 0; j--)
+		y2[lo + j] = (d[j] - c[j] * y2[lo + j + 1]) / b[j];
+
+	delete[] b;
+	delete[] d;
+	delete[] c;
+}
+
 // NUMERICAL RECIPES IN C: THE ART OF SCIENTIFIC COMPUTING (ISBN 0-521-43108-5)
 void splint(double xa[], double ya[], double y2a[], int n, double x, double *y)
 {
@@ -216,6 +298,39 @@ void splint(double xa[], double ya[], double y2a[], int n, double x, double *y)
     *y = a * ya[klo] + b * ya[khi] + ((a * a * a - a) * y2a[klo] + (b * b * b - b) * y2a[khi]) * (h * h) / 6.0f;
 }
 
+// Based on splint, but evaluates count values at x0, x0 +dx, ..., x0 +(count-1)*dx
+// and walks the intervals monotonically instead of doing a bisection per value.
+void splint_range(double xa[], double ya[], double y2a[], int n, double x0, double dx, size_t count, double y[])
+{
+	if (0 == count) return;
+
+	int klo, khi, k;
+	double h, b, a;
+
+	klo = 0;
+	khi = n - 1;
+	while (khi - klo > 1)
+	{
+		k = (khi + klo) >> 1;
+		if (xa[k] > x0) khi = k;
+		else klo = k;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		double x = x0 + i * dx;
+
+		while (klo + 2 < n && xa[klo + 1] <= x) ++klo;
+		khi = klo + 1;
+
+		h = xa[khi] - xa[klo];
+		if (h == 0.0) throw "splint_range: Bad xa input.";
+		a = (xa[khi] - x) / h;
+		b = (x - xa[klo]) / h;
+		y[i] = a * ya[klo] + b * ya[khi] + ((a * a * a - a) * y2a[klo] + (b * b * b - b) * y2a[khi]) * (h * h) / 6.0f;
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #define DZERO (double **)0
@@ -237,12 +352,23 @@ void rf(
 	double e[], double dtheta, double win[], double rhs[]
 );
 
+/// <summary>Per call coefficients shared between slew3_init and slew3 (used to be static globals).</summary>
+struct slew3_coeffs_s
+{
+	double a[3][3];
+	double b[3][3];
+	double c[2][3];
+	double d[3];
+};
+
 void slew3_init(
+	double a[3][3], double b[3][3], double c[2][3], double d[3],
 	double dt, double dtheta, double e[], double wi[], double ai[],
 	double wf[], double af[]
 );
 
 void slew3(
+	double a[3][3], double b[3][3], double c[2][3], double d[3],
 	double t, double dt, double qi[], double q[],
 	double omega[], double alpha[], double jerk[]
 );
@@ -309,9 +435,57 @@ void qspline_init(
   delete [] wprev;
 }
 
+/// <summary>Updates the output of qspline_init after the quaternions y[first..last] changed (times unchanged).</summary>
+/// <remarks>Recomputes the rotation angles / axes of the affected segments and re-solves
+/// the angular rates in a window of the given number of points around them,
+/// keeping the rates at the window boundaries fixed.</remarks>
+void qspline_update(
+	int n, int maxit, double tol, int first, int last, int window,
+	double [], double y[][4],
+	double h[], double dtheta[], double e[][3], double w[][3]
+)
+{
+  int i, j, lo, hi, m;
+  double *a, *b, *c, (*wprev)[3], wi[3], wf[3];
+
+  if(n < 4) throw "qspline_update: insufficient input data.\n";
+
+  for(i = first > 0 ? first - 1 : 0;i <= last && i < n - 1;i++)
+    dtheta[i] = getang(y[i],y[i + 1],e[i]);
+
+  lo = first - 1 - window; if(lo < 0) lo = 0;
+  hi = last + 1 + window; if(hi > n - 1) hi = n - 1;
+  m = hi - lo + 1;
+
+  if(m < 3) return;
+
+  for(j = 0;j < 3;j++)
+  {
+    wi[j] = w[lo][j];
+    wf[j] = w[hi][j];
+  }
+
+  /* like qspline_init start with zero rates in the window. */
+
+  for(i = lo + 1;i < hi;i++)
+    for(j = 0;j < 3;j++)
+      w[i][j] = 0.0;
+
+  wprev = new double[m][3];
+  a = new double[m-1];
+  b = new double[m-1];
+  c = new double[m-1];
+
+  rates(m,maxit,tol,wi,wf,h + lo,a,b,c,dtheta + lo,e + lo,w + lo,wprev);
+
+  delete[] c;
+  delete[] b;
+  delete[] a;
+  delete [] wprev;
+}
+
 // Note: This function is based on the qspline CC0 project by James McEnnan:
 // http://sourceforge.net/projects/qspline-cc0
-// Todo: if used in a class it could reduce calls to slew3_init.
 //
 /// <summary>Interpolates a quaternion value.</summary>
 /// <param name="n">number of input points (n>=4)</param>
@@ -332,6 +506,7 @@ void qspline_interp(
 )
 {
 	double dum1[3], dum2[3];
+	slew3_coeffs_s coeffs;
 	
 	int klo, khi, k;
 
@@ -346,9 +521,52 @@ void qspline_interp(
 
 	/* interpolate and output results. */
 
-	slew3_init(h[klo],dtheta[klo],e[klo],w[klo],dum1,w[klo+1],dum2);
+	slew3_init(coeffs.a,coeffs.b,coeffs.c,coeffs.d,h[klo],dtheta[klo],e[klo],w[klo],dum1,w[klo+1],dum2);
 
-    slew3(xi - x[klo],h[klo],y[klo],q,omega,alpha,dum1);
+    slew3(coeffs.a,coeffs.b,coeffs.c,coeffs.d,xi - x[klo],h[klo],y[klo],q,omega,alpha,dum1);
+}
+
+/// <summary>Interpolates count quaternion values at x0, x0 +dx, ..., x0 +(count-1)*dx.</summary>
+/// <remarks>Same as calling qspline_interp for each value, but the intervals are walked
+/// monotonically and slew3_init is only called when the interval changes.</remarks>
+/// <param name="q">out: count interpolated quaternion values.</param>
+void qspline_interp_range(
+	int n, double x0, double dx, size_t count, double x[], double y[][4],
+	double h[], double dtheta[], double e[][3], double w[][3],
+	double q[][4]
+)
+{
+	if (0 == count) return;
+
+	double dum1[3], dum2[3], omega[3], alpha[3];
+	slew3_coeffs_s coeffs;
+
+	int klo, khi, k;
+
+	klo = 0;
+	khi = n - 1;
+	while (khi - klo > 1)
+	{
+		k = (khi + klo) >> 1;
+		if (x[k] > x0) khi = k;
+		else klo = k;
+	}
+
+	slew3_init(coeffs.a,coeffs.b,coeffs.c,coeffs.d,h[klo],dtheta[klo],e[klo],w[klo],dum1,w[klo+1],dum2);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		double xi = x0 + i * dx;
+
+		if (klo + 2 < n && x[klo + 1] <= xi)
+		{
+			do ++klo; while (klo + 2 < n && x[klo + 1] <= xi);
+
+			slew3_init(coeffs.a,coeffs.b,coeffs.c,coeffs.d,h[klo],dtheta[klo],e[klo],w[klo],dum1,w[klo+1],dum2);
+		}
+
+		slew3(coeffs.a,coeffs.b,coeffs.c,coeffs.d,xi - x[klo],h[klo],y[klo],q[i],omega,alpha,dum1);
+	}
 }
 
 // Note: This function has been slighlty modified from it's original (definition only).
@@ -736,10 +954,10 @@ COPYRIGHT (C) 2003 by James McEnnan
   }
 }
 
-static double a[3][3], b[3][3], c[2][3], d[3];
-
-// Note: This function has been slighlty modified from it's original (definition only).
+// Note: This function has been slighlty modified from it's original (definition only,
+// the coefficients are passed in instead of being static globals).
 void slew3_init(
+	double a[3][3], double b[3][3], double c[2][3], double d[3],
 	double dt, double dtheta, double e[], double wi[], double ai[],
 	double wf[], double af[]
 )
@@ -848,8 +1066,10 @@ COPYRIGHT (C) 2003 by James McEnnan
   }
 }
 
-// Note: This function has been slighlty modified from it's original (definition only).
+// Note: This function has been slighlty modified from it's original (definition only,
+// the coefficients are passed in instead of being static globals).
 void slew3(
+	double a[3][3], double b[3][3], double c[2][3], double d[3],
 	double t, double dt, double qi[], double q[],
 	double omega[], double alpha[], double jerk[]
 )
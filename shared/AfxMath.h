@@ -35,10 +35,12 @@ u x v = (u_1 X + u_2 Y + u_3 Z) x (v_1 X + v_2 Y + v_3 Z)
 
 */
 
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <atomic>
 #include <mutex>
+#include <memory>
 
 namespace Afx {
 namespace Math {
@@ -46,6 +48,9 @@ namespace Math {
 
 #define AFX_MATH_EPS 1.0e-6
 
+// Number of neighbouring keys that are re-solved around changed keys by local spline updates.
+#define AFX_MATH_LOCAL_UPDATE_WINDOW 32
+
 double AngleModDeg(double x);
 
 /// <summary>Make vectors from angles in degrees in right-hand-grip rule.</summary>
@@ -67,20 +72,42 @@ void SolveWithLUEx(const double ** L, const double **U, const unsigned char *P,
 
 void spline(double x[], double y[], int n, bool y1Natural, double yp1, bool ynNatural, double ypn, double y2[]);
 
+/// <summary>Like spline, but only re-solves y2[lo..hi], keeping y2 outside of the window fixed.</summary>
+/// <remarks>Used for local updates after y values in the window changed.
+/// Unless the window spans all n points this is an approximation,
+/// but the error decays exponentially with the distance of the changed values to the window bounds.</remarks>
+void spline_window(double x[], double y[], int n, bool y1Natural, double yp1, bool ynNatural, double ypn, double y2[], int lo, int hi);
+
 void splint(double xa[], double ya[], double y2a[], int n, double x, double *y);
 
+/// <summary>Like splint, but evaluates count values at x0 +i*dx (dx &gt;= 0) in one monotonic pass.</summary>
+void splint_range(double xa[], double ya[], double y2a[], int n, double x0, double dx, size_t count, double y[]);
+
 void qspline_init(
 	int n, int maxit, double tol, double wi[], double wf[],
 	double x[], double y[][4],
 	double h[], double dtheta[], double e[][3], double w[][3]
 );
 
+/// <summary>Local update of qspline_init output after y[first..last] changed, see spline_window.</summary>
+void qspline_update(
+	int n, int maxit, double tol, int first, int last, int window,
+	double x[], double y[][4],
+	double h[], double dtheta[], double e[][3], double w[][3]
+);
+
 void qspline_interp(
 	int n, double xi, double x[], double y[][4],
 	double h[], double dtheta[], double e[][3], double w[][3], 
 	double q[4], double omega[3], double alpha[3]
 );
 
+void qspline_interp_range(
+	int n, double x0, double dx, size_t count, double x[], double y[][4],
+	double h[], double dtheta[], double e[][3], double w[][3],
+	double q[][4]
+);
+
 double getang(double qi[], double qf[], double e[]);
 
 // Vector3 /////////////////////////////////////////////////////////////////////
@@ -202,10 +229,168 @@ struct Quaternion
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/// <summary>
+/// Sorted keyframe container with a std::map like interface, stored flat in a vector.
+/// </summary>
+/// <remarks>
+/// Unlike std::map inserting or erasing invalidates iterators and
+/// the key must not be modified through an iterator.<br />
+/// The segment found by the last cursor_upper_bound call is remembered,
+/// so that monotonic lookups (playback) resolve in O(1), while random seeks stay O(log n).
+/// </remarks>
 template<class T>
 class CInterpolationMap
-: public std::map<double, T>
 {
+public:
+	typedef double key_type;
+	typedef T mapped_type;
+	typedef std::pair<double, T> value_type;
+	typedef typename std::vector<value_type>::iterator iterator;
+	typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+	CInterpolationMap()
+	: m_Cursor(0)
+	{
+	}
+
+	CInterpolationMap(CInterpolationMap const & other)
+	: m_Values(other.m_Values)
+	, m_Cursor(0)
+	{
+	}
+
+	CInterpolationMap & operator = (CInterpolationMap const & other)
+	{
+		m_Values = other.m_Values;
+		m_Cursor.store(0, std::memory_order_relaxed);
+		return *this;
+	}
+
+	T & operator [] (double key)
+	{
+		// Appending in order is the common case (recording, loading).
+		if(m_Values.empty() || m_Values.back().first < key)
+		{
+			m_Values.emplace_back(key, T());
+			return m_Values.back().second;
+		}
+
+		iterator it = lower_bound(key);
+		if(it == m_Values.end() || key < it->first)
+			it = m_Values.emplace(it, key, T());
+
+		return it->second;
+	}
+
+	/// <remarks>Like std::map does not overwrite an existing key.</remarks>
+	std::pair<iterator, bool> insert(value_type const & value)
+	{
+		iterator it = lower_bound(value.first);
+		if(it != m_Values.end() && !(value.first < it->first))
+			return std::pair<iterator, bool>(it, false);
+
+		return std::pair<iterator, bool>(m_Values.insert(it, value), true);
+	}
+
+	iterator find(double key)
+	{
+		iterator it = lower_bound(key);
+		return it != m_Values.end() && !(key < it->first) ? it : m_Values.end();
+	}
+
+	const_iterator find(double key) const
+	{
+		const_iterator it = lower_bound(key);
+		return it != m_Values.end() && !(key < it->first) ? it : m_Values.end();
+	}
+
+	size_t erase(double key)
+	{
+		iterator it = find(key);
+		if(it == m_Values.end())
+			return 0;
+
+		m_Values.erase(it);
+		return 1;
+	}
+
+	iterator erase(const_iterator it)
+	{
+		return m_Values.erase(it);
+	}
+
+	iterator lower_bound(double key)
+	{
+		return std::lower_bound(m_Values.begin(), m_Values.end(), key, KeyLess);
+	}
+
+	const_iterator lower_bound(double key) const
+	{
+		return std::lower_bound(m_Values.begin(), m_Values.end(), key, KeyLess);
+	}
+
+	iterator upper_bound(double key)
+	{
+		return std::upper_bound(m_Values.begin(), m_Values.end(), key, LessKey);
+	}
+
+	const_iterator upper_bound(double key) const
+	{
+		return std::upper_bound(m_Values.begin(), m_Values.end(), key, LessKey);
+	}
+
+	/// <summary>Same result as upper_bound, but tries the remembered segment and its successor first.</summary>
+	const_iterator cursor_upper_bound(double key) const
+	{
+		size_t size = m_Values.size();
+		size_t cursor = m_Cursor.load(std::memory_order_relaxed);
+
+		for(size_t i = cursor; i < size && i <= cursor + 1; ++i)
+		{
+			if((0 == i || !(key < m_Values[i - 1].first)) && key < m_Values[i].first)
+			{
+				if(i != cursor) m_Cursor.store(i, std::memory_order_relaxed);
+				return m_Values.begin() + i;
+			}
+		}
+
+		const_iterator result = upper_bound(key);
+		m_Cursor.store((size_t)(result - m_Values.begin()), std::memory_order_relaxed);
+		return result;
+	}
+
+	iterator begin() { return m_Values.begin(); }
+	const_iterator begin() const { return m_Values.begin(); }
+	const_iterator cbegin() const { return m_Values.cbegin(); }
+
+	iterator end() { return m_Values.end(); }
+	const_iterator end() const { return m_Values.end(); }
+	const_iterator cend() const { return m_Values.cend(); }
+
+	size_t size() const { return m_Values.size(); }
+	bool empty() const { return m_Values.empty(); }
+
+	void reserve(size_t count) { m_Values.reserve(count); }
+
+	void clear()
+	{
+		m_Values.clear();
+		m_Cursor.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	std::vector<value_type> m_Values;
+	mutable std::atomic<size_t> m_Cursor;
+
+	static bool KeyLess(value_type const & value, double key)
+	{
+		return value.first < key;
+	}
+
+	static bool LessKey(double key, value_type const & value)
+	{
+		return key < value.first;
+	}
 };
 
 template<class TMap, class T>
@@ -290,6 +475,12 @@ public:
 		return m_Map->size();
 	}
 
+	/// <remarks>index must be less than GetSize().</remarks>
+	CInterpolationMapViewIterator<TMap, T> GetAt(size_t index)
+	{
+		return CInterpolationMapViewIterator<TMap, T>(m_Map->begin() + index, m_Selector);
+	}
+
 	void GetNearestInterval(double time, CInterpolationMapViewIterator<TMap, T> & outLower, CInterpolationMapViewIterator<TMap, T> & outUpper)
 	{
 		size_t size = m_Map->size();
@@ -305,7 +496,7 @@ public:
 
 			CInterpolationMapViewIterator<TMap, T> end = GetEnd();
 
-			outUpper = CInterpolationMapViewIterator<TMap, T>(m_Map->upper_bound(time), m_Selector);
+			outUpper = CInterpolationMapViewIterator<TMap, T>(m_Map->cursor_upper_bound(time), m_Selector);
 
 			if(end == outUpper)
 			{
@@ -333,11 +524,64 @@ public:
 		}
 	}
 
+	/// <summary>
+	/// Moves an interval retrieved by GetNearestInterval forward, so that it is the nearest interval for time.
+	/// </summary>
+	/// <remarks>time must not be less than the time the interval was retrieved for.</remarks>
+	void AdvanceInterval(double time, CInterpolationMapViewIterator<TMap, T> & inOutLower, CInterpolationMapViewIterator<TMap, T> & inOutUpper)
+	{
+		if(inOutLower == inOutUpper)
+			return;
+
+		CInterpolationMapViewIterator<TMap, T> end = GetEnd();
+
+		while(inOutUpper.GetTime() <= time)
+		{
+			CInterpolationMapViewIterator<TMap, T> next = inOutUpper;
+			++next;
+
+			if(end == next)
+				break;
+
+			inOutLower = inOutUpper;
+			inOutUpper = next;
+		}
+	}
+
 private:
 	CInterpolationMap<TMap> * m_Map;
 	T (* m_Selector)(TMap const & value);
 };
 
+/// <summary>Accumulates the range of key indices with changed values for local updates.</summary>
+struct CInterpolationDirtyRange
+{
+	size_t First = (size_t)-1;
+	size_t Last = 0;
+
+	bool IsEmpty() const
+	{
+		return Last < First;
+	}
+
+	void Add(size_t first, size_t last)
+	{
+		if(first < First) First = first;
+		if(Last < last) Last = last;
+	}
+
+	void Add(size_t index)
+	{
+		Add(index, index);
+	}
+
+	void Clear()
+	{
+		First = (size_t)-1;
+		Last = 0;
+	}
+};
+
 template<class T>
 class CInterpolation abstract
 {
@@ -352,12 +596,145 @@ public:
 
 	virtual void InterpolationMapChanged(void) = 0;
 
+	/// <summary>Called instead of InterpolationMapChanged if only the values of the keys first..last (by index) changed.</summary>
+	/// <remarks>The number of keys and their times must be unchanged.
+	/// Implementations may use this to update their cached data only locally, the default does a full InterpolationMapChanged.</remarks>
+	virtual void InterpolationMapValuesChanged(size_t, size_t)
+	{
+		InterpolationMapChanged();
+	}
+
 	virtual bool CanEval(void) const = 0;
 
 	/// <remarks>
 	/// Must not be called if CanEval() returns false!<br />
 	/// </remarks>
 	virtual T Eval(double t) = 0;
+
+	/// <summary>Evaluates n values at t0, t0 +dt, ..., t0 +(n-1)*dt into out.</summary>
+	/// <remarks>
+	/// Must not be called if CanEval() returns false!<br />
+	/// dt must not be negative, implementations walk the intervals monotonically.
+	/// </remarks>
+	virtual void EvalRange(double t0, double dt, size_t n, T * out)
+	{
+		for(size_t i = 0; i < n; ++i)
+		{
+			out[i] = Eval(t0 + i * dt);
+		}
+	}
+};
+
+/// <summary>Immutable per-segment cubic polynomial table, as published by the Hermite interpolations.</summary>
+/// <remarks>
+/// Segment k covers [T[k], T[k+1]) and evaluates channel c as ((C3 * u + C2) * u + C1) * u + C0
+/// with u = (t - T[k]) * InvH[k], C0..C3 being stored at C[(k * TChannels + c) * 4].<br />
+/// A table is not modified anymore once published, so it can be evaluated without locking.
+/// </remarks>
+template<int TChannels>
+struct CHermiteSegmentTable
+{
+	/// <summary>Change version of the interpolation this table was built for.</summary>
+	unsigned int Version = 0;
+
+	std::vector<double> T;
+	std::vector<double> InvH;
+	std::vector<double> V;
+	std::vector<double> C;
+
+	int GetSize() const
+	{
+		return (int)T.size();
+	}
+
+	void Resize(int n)
+	{
+		T.resize(n);
+		InvH.resize(n);
+		V.resize(n * TChannels);
+		C.resize(n * TChannels * 4);
+	}
+
+	void SetKey(int k, double t, int c, double v)
+	{
+		T[k] = t;
+		V[k * TChannels + c] = v;
+	}
+
+	/// <summary>Sets channel c of segment k from the values, effective slopes and weights of its keys.</summary>
+	/// <remarks>T must already be set for the keys k and k+1.</remarks>
+	void SetSegment(int k, int c, double v0, double v1, double m0, double m1, double w0, double w1)
+	{
+		double h = T[k + 1] - T[k];
+		double * coeffs = &C[(k * TChannels + c) * 4];
+
+		if (h <= 0.0) // guard
+		{
+			InvH[k] = 0.0;
+			coeffs[0] = v0; coeffs[1] = 0.0; coeffs[2] = 0.0; coeffs[3] = 0.0;
+			return;
+		}
+
+		double a = w0 * h * m0;
+		double b = w1 * h * m1;
+
+		InvH[k] = 1.0 / h;
+		coeffs[0] = v0;
+		coeffs[1] = a;
+		coeffs[2] = 3.0 * (v1 - v0) - 2.0 * a - b;
+		coeffs[3] = 2.0 * (v0 - v1) + a + b;
+	}
+
+	/// <summary>Finds the segment containing t.</summary>
+	/// <remarks>Requires T[0] &lt; t &lt; T[n-1].</remarks>
+	int Find(double t) const
+	{
+		return (int)(std::upper_bound(T.begin(), T.end(), t) - T.begin()) - 1;
+	}
+
+	void GetKey(int k, double * out) const
+	{
+		for (int c = 0; c < TChannels; ++c) out[c] = V[k * TChannels + c];
+	}
+
+	/// <remarks>Requires T[klo] &lt;= t &lt; T[klo+1].</remarks>
+	void EvalSegment(int klo, double t, double * out) const
+	{
+		double u = (t - T[klo]) * InvH[klo];
+		const double * coeffs = &C[klo * TChannels * 4];
+		for (int c = 0; c < TChannels; ++c, coeffs += 4)
+		{
+			out[c] = ((coeffs[3] * u + coeffs[2]) * u + coeffs[1]) * u + coeffs[0];
+		}
+	}
+
+	/// <summary>Evaluates all channels at t, clamping outside the range (no extrapolation).</summary>
+	void Eval(double t, double * out) const
+	{
+		int n = GetSize();
+		if (t <= T[0]) { GetKey(0, out); return; }
+		if (t >= T[n - 1]) { GetKey(n - 1, out); return; }
+		EvalSegment(Find(t), t, out);
+	}
+
+	/// <summary>Segment to start EvalForward at for t, clamped to the table's range.</summary>
+	int FindStart(double t) const
+	{
+		int n = GetSize();
+		if (t <= T[0]) return 0;
+		if (t >= T[n - 1]) return n - 2;
+		return Find(t);
+	}
+
+	/// <summary>Like Eval, but searches forward from segment klo, for monotonically increasing t.</summary>
+	void EvalForward(double t, int & klo, double * out) const
+	{
+		int n = GetSize();
+		if (t <= T[0]) { GetKey(0, out); return; }
+		if (t >= T[n - 1]) { GetKey(n - 1, out); return; }
+		while (T[klo + 1] <= t) ++klo;
+		EvalSegment(klo, t, out);
+	}
 };
 
 // Hermite (per-key slope) interpolation for doubles.
@@ -421,6 +798,22 @@ public:
     virtual void InterpolationMapChanged(void)
     {
         m_Rebuild.store(true, std::memory_order_relaxed);
+        m_Version.fetch_add(1, std::memory_order_release);
+    }
+
+    virtual void InterpolationMapValuesChanged(size_t first, size_t last)
+    {
+        {
+            std::lock_guard<std::mutex> _lock(m_Lock);
+            if (!m_Rebuild.load(std::memory_order_relaxed))
+            {
+                if ((size_t)m_Build.n != m_Map->size() || (size_t)m_Build.n <= last)
+                    m_Rebuild.store(true, std::memory_order_relaxed);
+                else
+                    m_Dirty.Add(first, last);
+            }
+        }
+        m_Version.fetch_add(1, std::memory_order_release);
     }
 
     virtual bool CanEval(void) const
@@ -430,165 +823,26 @@ public:
 
     virtual double Eval(double t)
     {
-        std::lock_guard<std::mutex> _lock(m_Lock);
         size_t n = m_Map->size();
         if (n < 2) throw "CHermiteDoubleInterpolation::Eval requires at least 2 points.";
 
-        if (m_Rebuild.load(std::memory_order_relaxed))
-        {
-            m_Rebuild.store(false, std::memory_order_relaxed);
-
-            Free();
-
-            m_Build.n = (int)n;
-            m_Build.T = new double[n];
-            m_Build.V = new double[n];
-            m_Build.MIn = new double[n];
-            m_Build.MOut = new double[n];
-			m_Build.WIn  = new double[n];
-			m_Build.WOut = new double[n];
-            m_Build.Has = true;
-
-            // Copy values
-            size_t i = 0;
-            for (typename CInterpolationMap<TMap>::const_iterator it = m_Map->begin(); it != m_Map->end(); ++it)
-            {
-                m_Build.T[i] = it->first;
-                const TMap& val = it->second;
-                m_Build.V[i] = m_ValueSelector(val);
-                // Raw user-provided tangents (only used for Free mode)
-                double rawIn = m_TanInSelector(val);
-                double rawOut = m_TanOutSelector(val);
-                unsigned char modeIn = m_ModeInSelector(val);
-                unsigned char modeOut = m_ModeOutSelector(val);
-                // Initialize; actual resolution below (needs neighbors)
-                m_Build.MIn[i] = (modeIn == 3 /*Free*/) ? rawIn : 0.0;
-                m_Build.MOut[i] = (modeOut == 3 /*Free*/) ? rawOut : 0.0;
-                ++i;
-            }
-			for (int k = 0; k < (int)n; ++k)
-			{
-				const TMap& val = m_Map->find(m_Build.T[k])->second;
-				unsigned char modeIn  = m_ModeInSelector(val);
-				unsigned char modeOut = m_ModeOutSelector(val);
-				m_Build.WIn[k]  = (modeIn  == 3 /*Free*/) ? m_WInSelector(val)  : 1.0;
-				m_Build.WOut[k] = (modeOut == 3 /*Free*/) ? m_WOutSelector(val) : 1.0;
-				if (m_Build.WIn[k]  < 0.0) m_Build.WIn[k]  = 0.0;
-				if (m_Build.WOut[k] < 0.0) m_Build.WOut[k] = 0.0;
-			}
-
-            // Compute natural cubic-spline (clamped with endpoint derivatives 0.0) second derivatives
-            // to match CCubicDoubleInterpolation's default behavior for Auto mode.
-            double* y2 = new double[n];
-            spline(m_Build.T, m_Build.V, (int)n, false, 0.0, false, 0.0, y2);
-
-            // Precompute auto in/out slopes per key from y2
-            std::vector<double> autoIn(n, 0.0), autoOut(n, 0.0);
-            for (size_t i = 0; i + 1 < n; ++i)
-            {
-                double h = m_Build.T[i + 1] - m_Build.T[i];
-                if (h <= 0.0) continue;
-                double sec = (m_Build.V[i + 1] - m_Build.V[i]) / h;
-                double d_i_right = sec - h * (2.0 * y2[i] + y2[i + 1]) / 6.0;       // derivative at x_i (segment i)
-                double d_ip1_left = sec + h * (2.0 * y2[i + 1] + y2[i]) / 6.0;      // derivative at x_{i+1} (segment i)
-                autoOut[i] = d_i_right;
-                autoIn[i + 1] = d_ip1_left;
-            }
-
-            // Resolve modes to effective slopes.
-            for (size_t k = 0; k < n; ++k)
-            {
-                // neighbors
-                bool hasPrev = k > 0;
-                bool hasNext = k + 1 < n;
-                double ti = m_Build.T[k];
-                double vi = m_Build.V[k];
-                double tim1 = hasPrev ? m_Build.T[k - 1] : ti;
-                double tip1 = hasNext ? m_Build.T[k + 1] : ti;
-                double vim1 = hasPrev ? m_Build.V[k - 1] : vi;
-                double vip1 = hasNext ? m_Build.V[k + 1] : vi;
-
-                const TMap& val = m_Map->find(m_Build.T[k])->second;
-                unsigned char modeIn = m_ModeInSelector(val);
-                unsigned char modeOut = m_ModeOutSelector(val);
-
-                // In slope
-                if (modeIn == 1 /*Flat*/)
-                {
-                    m_Build.MIn[k] = 0.0;
-                }
-                else if (modeIn == 2 /*Linear*/)
-                {
-                    if (hasPrev)
-                        m_Build.MIn[k] = (vi - vim1) / (ti - tim1);
-                    else if (hasNext)
-                        m_Build.MIn[k] = (vip1 - vi) / (tip1 - ti);
-                    else
-                        m_Build.MIn[k] = 0.0;
-                }
-                else if (modeIn == 0 /*Auto*/)
-                {
-                    m_Build.MIn[k] = autoIn[k];
-                }
-                // else Free already set from raw
-
-                // Out slope
-                if (modeOut == 1 /*Flat*/)
-                {
-                    m_Build.MOut[k] = 0.0;
-                }
-                else if (modeOut == 2 /*Linear*/)
-                {
-                    if (hasNext)
-                        m_Build.MOut[k] = (vip1 - vi) / (tip1 - ti);
-                    else if (hasPrev)
-                        m_Build.MOut[k] = (vi - vim1) / (ti - tim1);
-                    else
-                        m_Build.MOut[k] = 0.0;
-                }
-                else if (modeOut == 0 /*Auto*/)
-                {
-                    m_Build.MOut[k] = autoOut[k];
-                }
-                // else Free already set from raw
-            }
+        double result;
+        GetTable(n)->Eval(t, &result);
+        return result;
+    }
 
-            delete[] y2;
-        }
+    virtual void EvalRange(double t0, double dt, size_t count, double * out)
+    {
+        size_t n = m_Map->size();
+        if (n < 2) throw "CHermiteDoubleInterpolation::EvalRange requires at least 2 points.";
 
-        // Clamp for no extrapolation
-        if (t <= m_Build.T[0]) return m_Build.V[0];
-        if (t >= m_Build.T[m_Build.n - 1]) return m_Build.V[m_Build.n - 1];
+        std::shared_ptr<const Table_t> table = GetTable(n);
 
-        // Binary search for interval
-        int klo = 0, khi = m_Build.n - 1;
-        while (khi - klo > 1)
+        int klo = table->FindStart(t0);
+        for (size_t i = 0; i < count; ++i)
         {
-            int k = (khi + klo) >> 1;
-            if (m_Build.T[k] > t) khi = k; else klo = k;
+            table->EvalForward(t0 + i * dt, klo, &out[i]);
         }
-
-        double t0 = m_Build.T[klo];
-        double t1 = m_Build.T[khi];
-        double v0 = m_Build.V[klo];
-        double v1 = m_Build.V[khi];
-        double m0 = m_Build.MOut[klo];
-        double m1 = m_Build.MIn[khi];
-        double h = t1 - t0;
-        if (h <= 0.0) return v0; // guard
-
-        double u = (t - t0) / h; // 0..1
-        double u2 = u * u;
-        double u3 = u2 * u;
-        double h00 = 2.0*u3 - 3.0*u2 + 1.0;
-        double h10 = u3 - 2.0*u2 + u;
-        double h01 = -2.0*u3 + 3.0*u2;
-        double h11 = u3 - u2;
-
-		double w0 = m_Build.WOut[klo]; // OUT weight of left key
-		double w1 = m_Build.WIn[khi];  // IN weight of right key
-		return h00 * v0 + (w0 * h * h10 * m0) + h01 * v1 + (w1 * h * h11 * m1);
-
     }
 
 private:
@@ -612,113 +866,312 @@ private:
         double* MOut = 0;
 		double* WIn = 0;
 		double* WOut = 0;
+        double* Y2 = 0; // spline second derivatives for Auto slopes
     } m_Build;
 
+    typedef CHermiteSegmentTable<1> Table_t;
+
+    // Build state is only touched with m_Lock held, Eval only reads the published m_Table.
+    std::shared_ptr<const Table_t> m_Table;
+    std::atomic<unsigned int> m_Version{0};
     std::atomic_bool m_Rebuild{true};
+    CInterpolationDirtyRange m_Dirty;
     std::mutex m_Lock;
 
-    void Free()
+    /// <summary>Returns the segment table for the current map, updating and publishing it if required.</summary>
+    /// <remarks>Lock-free unless the map changed since the last table was published.</remarks>
+    std::shared_ptr<const Table_t> GetTable(size_t n)
     {
-        delete[] m_Build.MOut; m_Build.MOut = 0;
-        delete[] m_Build.MIn;  m_Build.MIn  = 0;
-        delete[] m_Build.V;    m_Build.V    = 0;
-        delete[] m_Build.T;    m_Build.T    = 0;
-		delete[] m_Build.WIn;  m_Build.WIn  = 0;
-		delete[] m_Build.WOut; m_Build.WOut = 0;
-        m_Build.n = 0;
+        unsigned int version = m_Version.load(std::memory_order_acquire);
+        std::shared_ptr<const Table_t> table = std::atomic_load(&m_Table);
+        if (table && table->Version == version) return table;
+
+        std::lock_guard<std::mutex> _lock(m_Lock);
+
+        version = m_Version.load(std::memory_order_acquire);
+        table = std::atomic_load(&m_Table);
+        if (table && table->Version == version) return table;
+
+        CInterpolationDirtyRange changed;
+        Update(n, changed);
+
+        // Copy-on-write: readers may still hold the old table.
+        std::shared_ptr<Table_t> next;
+        int first = 0;
+        int last = m_Build.n - 1;
+        if (table && table->GetSize() == m_Build.n)
+        {
+            next = std::make_shared<Table_t>(*table);
+            if (changed.IsEmpty()) last = -1;
+            else { first = (int)changed.First; last = (int)changed.Last; }
+        }
+        else
+        {
+            next = std::make_shared<Table_t>();
+            next->Resize(m_Build.n);
+        }
+
+        for (int k = first; k <= last; ++k)
+        {
+            next->SetKey(k, m_Build.T[k], 0, m_Build.V[k]);
+        }
+        for (int k = 0 < first ? first - 1 : 0; k <= last && k < m_Build.n - 1; ++k)
+        {
+            next->SetSegment(k, 0, m_Build.V[k], m_Build.V[k + 1], m_Build.MOut[k], m_Build.MIn[k + 1], m_Build.WOut[k], m_Build.WIn[k + 1]);
+        }
+        next->Version = version;
+
+        table = std::move(next);
+        std::atomic_store(&m_Table, table);
+        return table;
     }
-};
-
-// Euler-angle based Hermite interpolation composing a Quaternion.
-// Uses per-key tangent in/out + mode for each Euler channel (Pitch/Yaw/Roll).
-// Value extraction from map uses Quaternion->Euler conversion and performs
-// simple unwrap across keys (minimize 360-degree jumps) per channel.
-template<class TMap>
-class CEulerHermiteQuaternionInterpolation : public CInterpolation<Quaternion>
-{
-public:
-    CEulerHermiteQuaternionInterpolation(
-        CInterpolationMap<TMap>* map,
-        // Roll (X)
-        double (* tanInRoll)(const TMap&),  double (* tanOutRoll)(const TMap&),
-        unsigned char (* modeInRoll)(const TMap&),  unsigned char (* modeOutRoll)(const TMap&),
-        double (* wInRoll)(const TMap&),  double (* wOutRoll)(const TMap&),
-        // Pitch (Y)
-        double (* tanInPitch)(const TMap&), double (* tanOutPitch)(const TMap&),
-        unsigned char (* modeInPitch)(const TMap&), unsigned char (* modeOutPitch)(const TMap&),
-        double (* wInPitch)(const TMap&),  double (* wOutPitch)(const TMap&),
-        // Yaw (Z)
-        double (* tanInYaw)(const TMap&),  double (* tanOutYaw)(const TMap&),
-        unsigned char (* modeInYaw)(const TMap&),  unsigned char (* modeOutYaw)(const TMap&),
-        double (* wInYaw)(const TMap&),   double (* wOutYaw)(const TMap&)
-    )
-    : m_Map(map)
-    , m_TanInRoll(tanInRoll), m_TanOutRoll(tanOutRoll), m_ModeInRoll(modeInRoll), m_ModeOutRoll(modeOutRoll), m_WInRoll(wInRoll), m_WOutRoll(wOutRoll)
-    , m_TanInPitch(tanInPitch), m_TanOutPitch(tanOutPitch), m_ModeInPitch(modeInPitch), m_ModeOutPitch(modeOutPitch), m_WInPitch(wInPitch), m_WOutPitch(wOutPitch)
-    , m_TanInYaw(tanInYaw), m_TanOutYaw(tanOutYaw), m_ModeInYaw(modeInYaw), m_ModeOutYaw(modeOutYaw), m_WInYaw(wInYaw), m_WOutYaw(wOutYaw)
-    {
-        InterpolationMapChanged();
-    }
-
-    virtual ~CEulerHermiteQuaternionInterpolation() { Free(); }
-
-    virtual void InterpolationMapChanged(void) { m_Rebuild.store(true, std::memory_order_relaxed); }
-
-    virtual bool CanEval(void) const { return 2 <= m_Map->size(); }
+
+    /// <param name="changed">Receives the range of keys with changed build data.</param>
+    void Update(size_t n, CInterpolationDirtyRange & changed)
+    {
+        if (m_Rebuild.load(std::memory_order_relaxed))
+        {
+            m_Rebuild.store(false, std::memory_order_relaxed);
+            Build(n);
+            changed.Add(0, n - 1);
+        }
+        else if (!m_Dirty.IsEmpty())
+        {
+            // Only values changed: reload the changed keys, re-solve the spline
+            // in a window around them and re-resolve the slopes it affects.
+            int first = (int)m_Dirty.First;
+            int last = (int)m_Dirty.Last;
+            m_Dirty.Clear();
+
+            LoadKeys(first, last);
+
+            int lo = first - 1 - AFX_MATH_LOCAL_UPDATE_WINDOW; if (lo < 0) lo = 0;
+            int hi = last + 1 + AFX_MATH_LOCAL_UPDATE_WINDOW; if (hi > m_Build.n - 1) hi = m_Build.n - 1;
+            spline_window(m_Build.T, m_Build.V, m_Build.n, false, 0.0, false, 0.0, m_Build.Y2, lo, hi);
+
+            lo = lo > 0 ? lo - 1 : 0;
+            hi = hi < m_Build.n - 1 ? hi + 1 : hi;
+            ResolveSlopes(lo, hi);
+            changed.Add(lo, hi);
+        }
+    }
+
+    void Build(size_t n)
+    {
+        Free();
+        m_Dirty.Clear();
+
+        m_Build.n = (int)n;
+        m_Build.T = new double[n];
+        m_Build.V = new double[n];
+        m_Build.MIn = new double[n];
+        m_Build.MOut = new double[n];
+		m_Build.WIn  = new double[n];
+		m_Build.WOut = new double[n];
+        m_Build.Y2 = new double[n];
+        m_Build.Has = true;
+
+        LoadKeys(0, (int)n - 1);
+
+        // Compute natural cubic-spline (clamped with endpoint derivatives 0.0) second derivatives
+        // to match CCubicDoubleInterpolation's default behavior for Auto mode.
+        spline(m_Build.T, m_Build.V, (int)n, false, 0.0, false, 0.0, m_Build.Y2);
+
+        ResolveSlopes(0, (int)n - 1);
+    }
+
+    /// <summary>Copies time, value, raw (Free) slopes and weights of the keys first..last.</summary>
+    void LoadKeys(int first, int last)
+    {
+        typename CInterpolationMap<TMap>::const_iterator it = m_Map->begin() + first;
+        for (int k = first; k <= last; ++k, ++it)
+        {
+            m_Build.T[k] = it->first;
+            const TMap& val = it->second;
+            m_Build.V[k] = m_ValueSelector(val);
+            // Raw user-provided tangents (only used for Free mode)
+            double rawIn = m_TanInSelector(val);
+            double rawOut = m_TanOutSelector(val);
+            unsigned char modeIn = m_ModeInSelector(val);
+            unsigned char modeOut = m_ModeOutSelector(val);
+            // Initialize; actual resolution in ResolveSlopes (needs neighbors)
+            m_Build.MIn[k] = (modeIn == 3 /*Free*/) ? rawIn : 0.0;
+            m_Build.MOut[k] = (modeOut == 3 /*Free*/) ? rawOut : 0.0;
+			m_Build.WIn[k]  = (modeIn  == 3 /*Free*/) ? m_WInSelector(val)  : 1.0;
+			m_Build.WOut[k] = (modeOut == 3 /*Free*/) ? m_WOutSelector(val) : 1.0;
+			if (m_Build.WIn[k]  < 0.0) m_Build.WIn[k]  = 0.0;
+			if (m_Build.WOut[k] < 0.0) m_Build.WOut[k] = 0.0;
+        }
+    }
+
+    /// <summary>Resolves the modes of the keys first..last to effective slopes.</summary>
+    void ResolveSlopes(int first, int last)
+    {
+        int n = m_Build.n;
+        const double* y2 = m_Build.Y2;
+
+        typename CInterpolationMap<TMap>::const_iterator it = m_Map->begin() + first;
+        for (int k = first; k <= last; ++k, ++it)
+        {
+            // neighbors
+            bool hasPrev = k > 0;
+            bool hasNext = k + 1 < n;
+            double ti = m_Build.T[k];
+            double vi = m_Build.V[k];
+            double tim1 = hasPrev ? m_Build.T[k - 1] : ti;
+            double tip1 = hasNext ? m_Build.T[k + 1] : ti;
+            double vim1 = hasPrev ? m_Build.V[k - 1] : vi;
+            double vip1 = hasNext ? m_Build.V[k + 1] : vi;
+
+            const TMap& val = it->second;
+            unsigned char modeIn = m_ModeInSelector(val);
+            unsigned char modeOut = m_ModeOutSelector(val);
+
+            // In slope
+            if (modeIn == 1 /*Flat*/)
+            {
+                m_Build.MIn[k] = 0.0;
+            }
+            else if (modeIn == 2 /*Linear*/)
+            {
+                if (hasPrev)
+                    m_Build.MIn[k] = (vi - vim1) / (ti - tim1);
+                else if (hasNext)
+                    m_Build.MIn[k] = (vip1 - vi) / (tip1 - ti);
+                else
+                    m_Build.MIn[k] = 0.0;
+            }
+            else if (modeIn == 0 /*Auto*/)
+            {
+                // derivative at x_k from the spline segment k-1
+                double h = ti - tim1;
+                m_Build.MIn[k] = hasPrev && 0.0 < h ? (vi - vim1) / h + h * (2.0 * y2[k] + y2[k - 1]) / 6.0 : 0.0;
+            }
+            // else Free already set from raw
+
+            // Out slope
+            if (modeOut == 1 /*Flat*/)
+            {
+                m_Build.MOut[k] = 0.0;
+            }
+            else if (modeOut == 2 /*Linear*/)
+            {
+                if (hasNext)
+                    m_Build.MOut[k] = (vip1 - vi) / (tip1 - ti);
+                else if (hasPrev)
+                    m_Build.MOut[k] = (vi - vim1) / (ti - tim1);
+                else
+                    m_Build.MOut[k] = 0.0;
+            }
+            else if (modeOut == 0 /*Auto*/)
+            {
+                // derivative at x_k from the spline segment k
+                double h = tip1 - ti;
+                m_Build.MOut[k] = hasNext && 0.0 < h ? (vip1 - vi) / h - h * (2.0 * y2[k] + y2[k + 1]) / 6.0 : 0.0;
+            }
+            // else Free already set from raw
+        }
+    }
+
+    void Free()
+    {
+        delete[] m_Build.MOut; m_Build.MOut = 0;
+        delete[] m_Build.MIn;  m_Build.MIn  = 0;
+        delete[] m_Build.V;    m_Build.V    = 0;
+        delete[] m_Build.T;    m_Build.T    = 0;
+		delete[] m_Build.WIn;  m_Build.WIn  = 0;
+		delete[] m_Build.WOut; m_Build.WOut = 0;
+        delete[] m_Build.Y2;   m_Build.Y2   = 0;
+        m_Build.n = 0;
+    }
+};
 
-    virtual Quaternion Eval(double t)
+// Euler-angle based Hermite interpolation composing a Quaternion.
+// Uses per-key tangent in/out + mode for each Euler channel (Pitch/Yaw/Roll).
+// Value extraction from map uses Quaternion->Euler conversion and performs
+// simple unwrap across keys (minimize 360-degree jumps) per channel.
+template<class TMap>
+class CEulerHermiteQuaternionInterpolation : public CInterpolation<Quaternion>
+{
+public:
+    CEulerHermiteQuaternionInterpolation(
+        CInterpolationMap<TMap>* map,
+        // Roll (X)
+        double (* tanInRoll)(const TMap&),  double (* tanOutRoll)(const TMap&),
+        unsigned char (* modeInRoll)(const TMap&),  unsigned char (* modeOutRoll)(const TMap&),
+        double (* wInRoll)(const TMap&),  double (* wOutRoll)(const TMap&),
+        // Pitch (Y)
+        double (* tanInPitch)(const TMap&), double (* tanOutPitch)(const TMap&),
+        unsigned char (* modeInPitch)(const TMap&), unsigned char (* modeOutPitch)(const TMap&),
+        double (* wInPitch)(const TMap&),  double (* wOutPitch)(const TMap&),
+        // Yaw (Z)
+        double (* tanInYaw)(const TMap&),  double (* tanOutYaw)(const TMap&),
+        unsigned char (* modeInYaw)(const TMap&),  unsigned char (* modeOutYaw)(const TMap&),
+        double (* wInYaw)(const TMap&),   double (* wOutYaw)(const TMap&)
+    )
+    : m_Map(map)
+    , m_TanInRoll(tanInRoll), m_TanOutRoll(tanOutRoll), m_ModeInRoll(modeInRoll), m_ModeOutRoll(modeOutRoll), m_WInRoll(wInRoll), m_WOutRoll(wOutRoll)
+    , m_TanInPitch(tanInPitch), m_TanOutPitch(tanOutPitch), m_ModeInPitch(modeInPitch), m_ModeOutPitch(modeOutPitch), m_WInPitch(wInPitch), m_WOutPitch(wOutPitch)
+    , m_TanInYaw(tanInYaw), m_TanOutYaw(tanOutYaw), m_ModeInYaw(modeInYaw), m_ModeOutYaw(modeOutYaw), m_WInYaw(wInYaw), m_WOutYaw(wOutYaw)
     {
-        std::lock_guard<std::mutex> _lock(m_Lock);
-        size_t n = m_Map->size();
-        if (n < 2) throw "CEulerHermiteQuaternionInterpolation::Eval requires at least 2 points.";
+        InterpolationMapChanged();
+    }
 
-        if (m_Rebuild.load(std::memory_order_relaxed))
-        {
-            m_Rebuild.store(false, std::memory_order_relaxed);
-            Build();
-        }
+    virtual ~CEulerHermiteQuaternionInterpolation() { Free(); }
 
-        // Clamp for no extrapolation
-        if (t <= m_T[0])
-        {
-            return Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(QEulerAngles(m_Pitch[0], m_Yaw[0], m_Roll[0])));
-        }
-        if (t >= m_T[m_n - 1])
-        {
-            return Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(QEulerAngles(m_Pitch[m_n-1], m_Yaw[m_n-1], m_Roll[m_n-1])));
-        }
+    virtual void InterpolationMapChanged(void)
+    {
+        m_Rebuild.store(true, std::memory_order_relaxed);
+        m_Version.fetch_add(1, std::memory_order_release);
+    }
 
-        // Binary search
-        int klo = 0, khi = (int)m_n - 1;
-        while (khi - klo > 1)
+    virtual void InterpolationMapValuesChanged(size_t first, size_t last)
+    {
         {
-            int k = (khi + klo) >> 1;
-            if (m_T[k] > t) khi = k; else klo = k;
+            std::lock_guard<std::mutex> _lock(m_Lock);
+            if (!m_Rebuild.load(std::memory_order_relaxed))
+            {
+                if ((size_t)m_n != m_Map->size() || (size_t)m_n <= last)
+                    m_Rebuild.store(true, std::memory_order_relaxed);
+                else
+                    m_Dirty.Add(first, last);
+            }
         }
+        m_Version.fetch_add(1, std::memory_order_release);
+    }
 
-        double t0 = m_T[klo];
-        double t1 = m_T[khi];
-        double h = t1 - t0; if (h <= 0.0) h = 1.0; // guard
+    virtual bool CanEval(void) const { return 2 <= m_Map->size(); }
 
-        auto hermite = [&](double v0, double v1, double m0, double m1, double w0, double w1)->double {
-            double u = (t - t0) / h;
-            double u2 = u * u;
-            double u3 = u2 * u;
-            double h00 = 2.0*u3 - 3.0*u2 + 1.0;
-            double h10 = u3 - 2.0*u2 + u;
-            double h01 = -2.0*u3 + 3.0*u2;
-            double h11 = u3 - u2;
-            return h00 * v0 + (w0 * h * h10 * m0) + h01 * v1 + (w1 * h * h11 * m1);
-        };
+    virtual Quaternion Eval(double t)
+    {
+        size_t n = m_Map->size();
+        if (n < 2) throw "CEulerHermiteQuaternionInterpolation::Eval requires at least 2 points.";
+
+        double angles[3];
+        GetTable()->Eval(t, angles);
+        return Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(QEulerAngles(angles[0], angles[1], angles[2])));
+    }
 
-        double pitch = hermite(m_Pitch[klo], m_Pitch[khi], m_PitchOut[klo], m_PitchIn[khi], m_PitchWOut[klo], m_PitchWIn[khi]);
-        double yaw   = hermite(m_Yaw[klo],   m_Yaw[khi],   m_YawOut[klo],   m_YawIn[khi],   m_YawWOut[klo],   m_YawWIn[khi]);
-        double roll  = hermite(m_Roll[klo],  m_Roll[khi],  m_RollOut[klo],  m_RollIn[khi],  m_RollWOut[klo],  m_RollWIn[khi]);
+    virtual void EvalRange(double t0, double dt, size_t count, Quaternion * out)
+    {
+        size_t n = m_Map->size();
+        if (n < 2) throw "CEulerHermiteQuaternionInterpolation::EvalRange requires at least 2 points.";
+
+        std::shared_ptr<const Table_t> table = GetTable();
 
-        return Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(QEulerAngles(pitch, yaw, roll)));
+        int klo = table->FindStart(t0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            double angles[3];
+            table->EvalForward(t0 + i * dt, klo, angles);
+            out[i] = Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(QEulerAngles(angles[0], angles[1], angles[2])));
+        }
     }
 
 private:
+    // Channels are Pitch, Yaw, Roll.
+    typedef CHermiteSegmentTable<3> Table_t;
+
     // Source data
     CInterpolationMap<TMap>* m_Map;
 
@@ -747,13 +1200,110 @@ private:
     // Cached arrays
     int m_n = 0;
     double* m_T = nullptr;
-    double* m_Pitch = nullptr; double* m_PitchIn = nullptr; double* m_PitchOut = nullptr; double* m_PitchWIn = nullptr; double* m_PitchWOut = nullptr;
-    double* m_Yaw   = nullptr; double* m_YawIn   = nullptr; double* m_YawOut   = nullptr; double* m_YawWIn   = nullptr; double* m_YawWOut   = nullptr;
-    double* m_Roll  = nullptr; double* m_RollIn  = nullptr; double* m_RollOut  = nullptr; double* m_RollWIn  = nullptr; double* m_RollWOut  = nullptr;
+    double* m_Pitch = nullptr; double* m_PitchIn = nullptr; double* m_PitchOut = nullptr; double* m_PitchWIn = nullptr; double* m_PitchWOut = nullptr; double* m_PitchY2 = nullptr;
+    double* m_Yaw   = nullptr; double* m_YawIn   = nullptr; double* m_YawOut   = nullptr; double* m_YawWIn   = nullptr; double* m_YawWOut   = nullptr; double* m_YawY2   = nullptr;
+    double* m_Roll  = nullptr; double* m_RollIn  = nullptr; double* m_RollOut  = nullptr; double* m_RollWIn  = nullptr; double* m_RollWOut  = nullptr; double* m_RollY2  = nullptr;
 
+    // Build state is only touched with m_Lock held, Eval only reads the published m_Table.
+    std::shared_ptr<const Table_t> m_Table;
+    std::atomic<unsigned int> m_Version{0};
     std::atomic_bool m_Rebuild{true};
+    CInterpolationDirtyRange m_Dirty;
     std::mutex m_Lock;
 
+    /// <summary>Returns the segment table for the current map, updating and publishing it if required.</summary>
+    /// <remarks>Lock-free unless the map changed since the last table was published.</remarks>
+    std::shared_ptr<const Table_t> GetTable()
+    {
+        unsigned int version = m_Version.load(std::memory_order_acquire);
+        std::shared_ptr<const Table_t> table = std::atomic_load(&m_Table);
+        if (table && table->Version == version) return table;
+
+        std::lock_guard<std::mutex> _lock(m_Lock);
+
+        version = m_Version.load(std::memory_order_acquire);
+        table = std::atomic_load(&m_Table);
+        if (table && table->Version == version) return table;
+
+        CInterpolationDirtyRange changed;
+        Update(changed);
+
+        // Copy-on-write: readers may still hold the old table.
+        std::shared_ptr<Table_t> next;
+        int first = 0;
+        int last = m_n - 1;
+        if (table && table->GetSize() == m_n)
+        {
+            next = std::make_shared<Table_t>(*table);
+            if (changed.IsEmpty()) last = -1;
+            else { first = (int)changed.First; last = (int)changed.Last; }
+        }
+        else
+        {
+            next = std::make_shared<Table_t>();
+            next->Resize(m_n);
+        }
+
+        for (int k = first; k <= last; ++k)
+        {
+            next->SetKey(k, m_T[k], 0, m_Pitch[k]);
+            next->SetKey(k, m_T[k], 1, m_Yaw[k]);
+            next->SetKey(k, m_T[k], 2, m_Roll[k]);
+        }
+        for (int k = 0 < first ? first - 1 : 0; k <= last && k < m_n - 1; ++k)
+        {
+            next->SetSegment(k, 0, m_Pitch[k], m_Pitch[k + 1], m_PitchOut[k], m_PitchIn[k + 1], m_PitchWOut[k], m_PitchWIn[k + 1]);
+            next->SetSegment(k, 1, m_Yaw[k],   m_Yaw[k + 1],   m_YawOut[k],   m_YawIn[k + 1],   m_YawWOut[k],   m_YawWIn[k + 1]);
+            next->SetSegment(k, 2, m_Roll[k],  m_Roll[k + 1],  m_RollOut[k],  m_RollIn[k + 1],  m_RollWOut[k],  m_RollWIn[k + 1]);
+        }
+        next->Version = version;
+
+        table = std::move(next);
+        std::atomic_store(&m_Table, table);
+        return table;
+    }
+
+    /// <param name="changed">Receives the range of keys with changed build data.</param>
+    void Update(CInterpolationDirtyRange & changed)
+    {
+        if (m_Rebuild.load(std::memory_order_relaxed))
+        {
+            m_Rebuild.store(false, std::memory_order_relaxed);
+            Build();
+            changed.Add(0, m_n - 1);
+        }
+        else if (!m_Dirty.IsEmpty())
+        {
+            int first = (int)m_Dirty.First;
+            int last = (int)m_Dirty.Last;
+            m_Dirty.Clear();
+
+            LoadKeys(first, last);
+
+            // Unwrap the changed keys against their predecessor; if that would change
+            // the unwrapping of the keys after them, all following keys are affected.
+            if (!UnwrapAngles(m_Pitch, m_n, first, last)
+                || !UnwrapAngles(m_Yaw, m_n, first, last)
+                || !UnwrapAngles(m_Roll, m_n, first, last))
+            {
+                Build();
+                changed.Add(0, m_n - 1);
+                return;
+            }
+
+            int lo = first - 1 - AFX_MATH_LOCAL_UPDATE_WINDOW; if (lo < 0) lo = 0;
+            int hi = last + 1 + AFX_MATH_LOCAL_UPDATE_WINDOW; if (hi > m_n - 1) hi = m_n - 1;
+            spline_window(m_T, m_Pitch, m_n, false, 0.0, false, 0.0, m_PitchY2, lo, hi);
+            spline_window(m_T, m_Yaw,   m_n, false, 0.0, false, 0.0, m_YawY2,   lo, hi);
+            spline_window(m_T, m_Roll,  m_n, false, 0.0, false, 0.0, m_RollY2,  lo, hi);
+
+            lo = lo > 0 ? lo - 1 : 0;
+            hi = hi < m_n - 1 ? hi + 1 : hi;
+            ResolveSlopes(lo, hi);
+            changed.Add(lo, hi);
+        }
+    }
+
     static void UnwrapAngles(double* vals, int n)
     {
         if (n <= 1) return;
@@ -767,34 +1317,63 @@ private:
         }
     }
 
+    /// <summary>Unwraps vals[first..last] only.</summary>
+    /// <returns>false if vals[last+1] would need to be unwrapped differently now.</returns>
+    static bool UnwrapAngles(double* vals, int n, int first, int last)
+    {
+        for (int i = first > 0 ? first : 1; i <= last; ++i)
+        {
+            double prev = vals[i-1];
+            double cur = vals[i];
+            while (cur - prev > 180.0) cur -= 360.0;
+            while (cur - prev < -180.0) cur += 360.0;
+            vals[i] = cur;
+        }
+        if (last + 1 < n)
+        {
+            double prev = vals[last];
+            double next = vals[last + 1];
+            if (next - prev > 180.0 || next - prev < -180.0) return false;
+        }
+        return true;
+    }
+
     void Build()
     {
         Free();
+        m_Dirty.Clear();
         m_n = (int)m_Map->size();
         m_T = new double[m_n];
-        m_Pitch = new double[m_n]; m_PitchIn = new double[m_n]; m_PitchOut = new double[m_n]; m_PitchWIn = new double[m_n]; m_PitchWOut = new double[m_n];
-        m_Yaw   = new double[m_n]; m_YawIn   = new double[m_n]; m_YawOut   = new double[m_n]; m_YawWIn   = new double[m_n]; m_YawWOut   = new double[m_n];
-        m_Roll  = new double[m_n]; m_RollIn  = new double[m_n]; m_RollOut  = new double[m_n]; m_RollWIn  = new double[m_n]; m_RollWOut  = new double[m_n];
+        m_Pitch = new double[m_n]; m_PitchIn = new double[m_n]; m_PitchOut = new double[m_n]; m_PitchWIn = new double[m_n]; m_PitchWOut = new double[m_n]; m_PitchY2 = new double[m_n];
+        m_Yaw   = new double[m_n]; m_YawIn   = new double[m_n]; m_YawOut   = new double[m_n]; m_YawWIn   = new double[m_n]; m_YawWOut   = new double[m_n]; m_YawY2   = new double[m_n];
+        m_Roll  = new double[m_n]; m_RollIn  = new double[m_n]; m_RollOut  = new double[m_n]; m_RollWIn  = new double[m_n]; m_RollWOut  = new double[m_n]; m_RollY2  = new double[m_n];
+
+        LoadKeys(0, m_n - 1);
 
-        // Extract times and Euler angles; setup initial slopes/weights
-        int i = 0; TMap lastV; bool hasLast = false;
-        for (typename CInterpolationMap<TMap>::const_iterator it = m_Map->begin(); it != m_Map->end(); ++it, ++i)
-        {
-            m_T[i] = it->first;
-            const TMap& v = it->second;
-            QEulerAngles a = v.R.ToQREulerAngles().ToQEulerAngles();
-            m_Pitch[i] = a.Pitch; m_Yaw[i] = a.Yaw; m_Roll[i] = a.Roll;
-        }
         // unwrap each channel to avoid jumps
         UnwrapAngles(m_Pitch, m_n);
         UnwrapAngles(m_Yaw,   m_n);
         UnwrapAngles(m_Roll,  m_n);
 
-        // Fill modes, raw/free slopes and weights
-        i = 0;
-        for (typename CInterpolationMap<TMap>::const_iterator it = m_Map->begin(); it != m_Map->end(); ++it, ++i)
+        // Compute natural cubic second derivatives for AUTO slopes
+        spline(m_T, m_Pitch, m_n, false, 0.0, false, 0.0, m_PitchY2);
+        spline(m_T, m_Yaw,   m_n, false, 0.0, false, 0.0, m_YawY2);
+        spline(m_T, m_Roll,  m_n, false, 0.0, false, 0.0, m_RollY2);
+
+        ResolveSlopes(0, m_n - 1);
+    }
+
+    /// <summary>Extracts times, (wrapped) Euler angles, raw (Free) slopes and weights of the keys first..last.</summary>
+    void LoadKeys(int first, int last)
+    {
+        typename CInterpolationMap<TMap>::const_iterator it = m_Map->begin() + first;
+        for (int i = first; i <= last; ++i, ++it)
         {
+            m_T[i] = it->first;
             const TMap& v = it->second;
+            QEulerAngles a = v.R.ToQREulerAngles().ToQEulerAngles();
+            m_Pitch[i] = a.Pitch; m_Yaw[i] = a.Yaw; m_Roll[i] = a.Roll;
+
             unsigned char modeInP  = m_ModeInPitch(v);
             unsigned char modeOutP = m_ModeOutPitch(v);
             unsigned char modeInY  = m_ModeInYaw(v);
@@ -823,33 +1402,27 @@ private:
             if (m_RollWIn[i]   < 0.0) m_RollWIn[i]   = 0.0;
             if (m_RollWOut[i]  < 0.0) m_RollWOut[i]  = 0.0;
         }
+    }
 
-        // Compute natural cubic second derivatives for AUTO slopes
-        auto computeAuto = [&](double* V, std::vector<double>& autoIn, std::vector<double>& autoOut)
-        {
-            double* y2 = new double[m_n];
-            spline(m_T, V, m_n, false, 0.0, false, 0.0, y2);
-            autoIn.assign(m_n, 0.0); autoOut.assign(m_n, 0.0);
-            for (int k = 0; k + 1 < m_n; ++k)
-            {
-                double h = m_T[k+1] - m_T[k];
-                if (h <= 0.0) continue;
-                double sec = (V[k+1] - V[k]) / h;
-                double d_i_right   = sec - h * (2.0 * y2[k] + y2[k+1]) / 6.0;
-                double d_ip1_left  = sec + h * (2.0 * y2[k+1] + y2[k]) / 6.0;
-                autoOut[k]   = d_i_right;
-                autoIn[k+1]  = d_ip1_left;
-            }
-            delete [] y2;
+    /// <summary>Resolves the modes of the keys first..last to effective slopes.</summary>
+    void ResolveSlopes(int first, int last)
+    {
+        // Slopes of the natural cubic spline through V at key k (segment k-1 / segment k)
+        auto autoIn = [&](const double* V, const double* y2, int k)->double {
+            if (k <= 0) return 0.0;
+            double h = m_T[k] - m_T[k-1];
+            if (h <= 0.0) return 0.0;
+            return (V[k] - V[k-1]) / h + h * (2.0 * y2[k] + y2[k-1]) / 6.0;
+        };
+        auto autoOut = [&](const double* V, const double* y2, int k)->double {
+            if (m_n <= k + 1) return 0.0;
+            double h = m_T[k+1] - m_T[k];
+            if (h <= 0.0) return 0.0;
+            return (V[k+1] - V[k]) / h - h * (2.0 * y2[k] + y2[k+1]) / 6.0;
         };
 
-        std::vector<double> autoInP, autoOutP, autoInY, autoOutY, autoInR, autoOutR;
-        computeAuto(m_Pitch, autoInP, autoOutP);
-        computeAuto(m_Yaw,   autoInY, autoOutY);
-        computeAuto(m_Roll,  autoInR, autoOutR);
-
-        // Resolve modes per key
-        for (int k = 0; k < m_n; ++k)
+        typename CInterpolationMap<TMap>::const_iterator it = m_Map->begin() + first;
+        for (int k = first; k <= last; ++k, ++it)
         {
             bool hasPrev = (k > 0);
             bool hasNext = (k + 1 < m_n);
@@ -858,38 +1431,38 @@ private:
             double vYi = m_Yaw[k];   double vYim1 = hasPrev ? m_Yaw[k-1]   : vYi; double vYip1 = hasNext ? m_Yaw[k+1]   : vYi;
             double vRi = m_Roll[k];  double vRim1 = hasPrev ? m_Roll[k-1]  : vRi; double vRip1 = hasNext ? m_Roll[k+1]  : vRi;
 
-            const TMap& v = m_Map->find(m_T[k])->second;
+            const TMap& v = it->second;
 
             // Pitch
             {
                 unsigned char mi = m_ModeInPitch(v), mo = m_ModeOutPitch(v);
                 if (mi == 1) m_PitchIn[k] = 0.0; // Flat
                 else if (mi == 2) m_PitchIn[k] = hasPrev ? (vPi - vPim1) / (ti - tim1) : (hasNext ? (vPip1 - vPi) / (tip1 - ti) : 0.0);
-                else if (mi == 0) m_PitchIn[k] = autoInP[k]; // Auto
+                else if (mi == 0) m_PitchIn[k] = autoIn(m_Pitch, m_PitchY2, k); // Auto
                 // else Free already set
                 if (mo == 1) m_PitchOut[k] = 0.0;
                 else if (mo == 2) m_PitchOut[k] = hasNext ? (vPip1 - vPi) / (tip1 - ti) : (hasPrev ? (vPi - vPim1) / (ti - tim1) : 0.0);
-                else if (mo == 0) m_PitchOut[k] = autoOutP[k];
+                else if (mo == 0) m_PitchOut[k] = autoOut(m_Pitch, m_PitchY2, k);
             }
             // Yaw
             {
                 unsigned char mi = m_ModeInYaw(v), mo = m_ModeOutYaw(v);
                 if (mi == 1) m_YawIn[k] = 0.0;
                 else if (mi == 2) m_YawIn[k] = hasPrev ? (vYi - vYim1) / (ti - tim1) : (hasNext ? (vYip1 - vYi) / (tip1 - ti) : 0.0);
-                else if (mi == 0) m_YawIn[k] = autoInY[k];
+                else if (mi == 0) m_YawIn[k] = autoIn(m_Yaw, m_YawY2, k);
                 if (mo == 1) m_YawOut[k] = 0.0;
                 else if (mo == 2) m_YawOut[k] = hasNext ? (vYip1 - vYi) / (tip1 - ti) : (hasPrev ? (vYi - vYim1) / (ti - tim1) : 0.0);
-                else if (mo == 0) m_YawOut[k] = autoOutY[k];
+                else if (mo == 0) m_YawOut[k] = autoOut(m_Yaw, m_YawY2, k);
             }
             // Roll
             {
                 unsigned char mi = m_ModeInRoll(v), mo = m_ModeOutRoll(v);
                 if (mi == 1) m_RollIn[k] = 0.0;
                 else if (mi == 2) m_RollIn[k] = hasPrev ? (vRi - vRim1) / (ti - tim1) : (hasNext ? (vRip1 - vRi) / (tip1 - ti) : 0.0);
-                else if (mi == 0) m_RollIn[k] = autoInR[k];
+                else if (mi == 0) m_RollIn[k] = autoIn(m_Roll, m_RollY2, k);
                 if (mo == 1) m_RollOut[k] = 0.0;
                 else if (mo == 2) m_RollOut[k] = hasNext ? (vRip1 - vRi) / (tip1 - ti) : (hasPrev ? (vRi - vRim1) / (ti - tim1) : 0.0);
-                else if (mo == 0) m_RollOut[k] = autoOutR[k];
+                else if (mo == 0) m_RollOut[k] = autoOut(m_Roll, m_RollY2, k);
             }
         }
     }
@@ -897,12 +1470,12 @@ private:
     void Free()
     {
         delete [] m_T; m_T = nullptr; m_n = 0;
-        delete [] m_Pitch; delete [] m_PitchIn; delete [] m_PitchOut; delete [] m_PitchWIn; delete [] m_PitchWOut;
-        m_Pitch = m_PitchIn = m_PitchOut = m_PitchWIn = m_PitchWOut = nullptr;
-        delete [] m_Yaw;   delete [] m_YawIn;   delete [] m_YawOut;   delete [] m_YawWIn;   delete [] m_YawWOut;
-        m_Yaw   = m_YawIn   = m_YawOut   = m_YawWIn   = m_YawWOut   = nullptr;
-        delete [] m_Roll;  delete [] m_RollIn;  delete [] m_RollOut;  delete [] m_RollWIn;  delete [] m_RollWOut;
-        m_Roll  = m_RollIn  = m_RollOut  = m_RollWIn  = m_RollWOut  = nullptr;
+        delete [] m_Pitch; delete [] m_PitchIn; delete [] m_PitchOut; delete [] m_PitchWIn; delete [] m_PitchWOut; delete [] m_PitchY2;
+        m_Pitch = m_PitchIn = m_PitchOut = m_PitchWIn = m_PitchWOut = m_PitchY2 = nullptr;
+        delete [] m_Yaw;   delete [] m_YawIn;   delete [] m_YawOut;   delete [] m_YawWIn;   delete [] m_YawWOut;   delete [] m_YawY2;
+        m_Yaw   = m_YawIn   = m_YawOut   = m_YawWIn   = m_YawWOut   = m_YawY2   = nullptr;
+        delete [] m_Roll;  delete [] m_RollIn;  delete [] m_RollOut;  delete [] m_RollWIn;  delete [] m_RollWOut;  delete [] m_RollY2;
+        m_Roll  = m_RollIn  = m_RollOut  = m_RollWIn  = m_RollWOut  = m_RollY2  = nullptr;
     }
 };
 
@@ -938,6 +1511,30 @@ public:
 		CInterpolationMapViewIterator<TMap, bool> itUpper;
 		m_View->GetNearestInterval(t, itLower, itUpper);
 
+		return EvalInterval(t, itLower, itUpper);
+	}
+
+	virtual void EvalRange(double t0, double dt, size_t n, bool * out)
+	{
+		if(0 == n) return;
+
+		CInterpolationMapViewIterator<TMap, bool> itLower;
+		CInterpolationMapViewIterator<TMap, bool> itUpper;
+		m_View->GetNearestInterval(t0, itLower, itUpper);
+
+		for(size_t i = 0; i < n; ++i)
+		{
+			double t = t0 + i * dt;
+			m_View->AdvanceInterval(t, itLower, itUpper);
+			out[i] = EvalInterval(t, itLower, itUpper);
+		}
+	}
+
+private:
+	CInterpolationMapView<TMap, bool> * m_View;
+
+	bool EvalInterval(double t, CInterpolationMapViewIterator<TMap, bool> & itLower, CInterpolationMapViewIterator<TMap, bool> & itUpper)
+	{
 		double lowerT = itLower.GetTime();
 		bool lowerV = itLower.GetValue();
 
@@ -956,9 +1553,6 @@ public:
 
 		return lowerV && upperV;
 	}
-
-private:
-	CInterpolationMapView<TMap, bool> * m_View;
 };
 
 template<class TMap>
@@ -993,6 +1587,30 @@ public:
 		CInterpolationMapViewIterator<TMap, double> itUpper;
 		m_View->GetNearestInterval(t, itLower, itUpper);
 
+		return EvalInterval(t, itLower, itUpper);
+	}
+
+	virtual void EvalRange(double t0, double dt, size_t n, double * out)
+	{
+		if(0 == n) return;
+
+		CInterpolationMapViewIterator<TMap, double> itLower;
+		CInterpolationMapViewIterator<TMap, double> itUpper;
+		m_View->GetNearestInterval(t0, itLower, itUpper);
+
+		for(size_t i = 0; i < n; ++i)
+		{
+			double t = t0 + i * dt;
+			m_View->AdvanceInterval(t, itLower, itUpper);
+			out[i] = EvalInterval(t, itLower, itUpper);
+		}
+	}
+
+private:
+	CInterpolationMapView<TMap, double> * m_View;
+
+	double EvalInterval(double t, CInterpolationMapViewIterator<TMap, double> & itLower, CInterpolationMapViewIterator<TMap, double> & itUpper)
+	{
 		double lowerT = itLower.GetTime();
 		double lowerV = itLower.GetValue();
 
@@ -1013,9 +1631,6 @@ public:
 
 		return (1-(t-lowerT)/deltaT)*lowerV +((t-lowerT)/deltaT)*upperV;
 	}
-
-private:
-	CInterpolationMapView<TMap, double> * m_View;
 };
 
 template<class TMap>
@@ -1023,6 +1638,7 @@ class CCubicDoubleInterpolation
 : public CInterpolation<double>
 {
 public:
+	/// <remarks>Eval and EvalRange may be called concurrently from multiple threads, as long as the map is not modified meanwhile.</remarks>
 	CCubicDoubleInterpolation(CInterpolationMapView<TMap, double> * view)
 	: CInterpolation<double>()
 	, m_View(view)
@@ -1032,12 +1648,30 @@ public:
 
 	virtual ~CCubicDoubleInterpolation()
 	{
-		Free();
 	}
 
 	virtual void InterpolationMapChanged(void)
 	{
-		m_Rebuild = true;
+		m_Rebuild.store(true, std::memory_order_relaxed);
+		m_Version.fetch_add(1, std::memory_order_release);
+	}
+
+	virtual void InterpolationMapValuesChanged(size_t first, size_t last)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+
+			if(!m_Rebuild.load(std::memory_order_relaxed))
+			{
+				std::shared_ptr<const Spline_s> spline = std::atomic_load(&m_Spline);
+
+				if(!spline || (size_t)spline->N != m_View->GetSize() || (size_t)spline->N <= last)
+					m_Rebuild.store(true, std::memory_order_relaxed);
+				else
+					m_Dirty.Add(first, last);
+			}
+		}
+		m_Version.fetch_add(1, std::memory_order_release);
 	}
 
 	virtual bool CanEval(void) const
@@ -1054,64 +1688,135 @@ public:
 
 		if(n < 4) throw "CCubicDoubleInterpolation::Eval only allowed with at least 4 points.";
 
-		if(m_Rebuild)
-		{
-			m_Rebuild = false;
+		std::shared_ptr<const Spline_s> spline = GetSpline(n);
 
-			Free();
+		double result;
 
-			m_Build.T = new double[n];
-			m_Build.X = new double[n];
-			m_Build.X2 = new double[n];
+		splint(spline->T.get(), spline->X.get(), spline->X2.get(), spline->N, t, &result);
 
-			{
-				int i = 0;
-				CInterpolationMapViewIterator<TMap, double> itEnd = m_View->GetEnd();
-				for(CInterpolationMapViewIterator<TMap, double> it = m_View->GetBegin(); it != itEnd; ++it)
-				{
-					m_Build.T[i] = it.GetTime();
-					m_Build.X[i] = it.GetValue();
-					++i;
-				}
-			}
+		return result;
+	}
 
-			spline(m_Build.T , m_Build.X, n, false, 0.0, false, 0.0, m_Build.X2);
-		}
+	virtual void EvalRange(double t0, double dt, size_t count, double * out)
+	{
+		int n = m_View->GetSize();
 
-		double result;
+		if(n < 4) throw "CCubicDoubleInterpolation::EvalRange only allowed with at least 4 points.";
 
-		splint(m_Build.T, m_Build.X, m_Build.X2, n, t, &result);
+		std::shared_ptr<const Spline_s> spline = GetSpline(n);
 
-		return result;
+		splint_range(spline->T.get(), spline->X.get(), spline->X2.get(), spline->N, t0, dt, count, out);
 	}
 
 private:
 	CInterpolationMapView<TMap, double> * m_View;
 
-	struct Build_s
+	/// <summary>Solved spline, not modified anymore once published.</summary>
+	struct Spline_s
 	{
-		double * T;
-		double * X;
-		double * X2;
+		/// <summary>Change version of the interpolation this spline was solved for.</summary>
+		unsigned int Version;
+		int N;
+		std::unique_ptr<double[]> T;
+		std::unique_ptr<double[]> X;
+		std::unique_ptr<double[]> X2;
+
+		Spline_s(int n)
+		: Version(0)
+		, N(n)
+		, T(new double[n])
+		, X(new double[n])
+		, X2(new double[n])
+		{
+		}
 
-		Build_s()
-		: T(0)
-		, X(0)
-		, X2(0)
+		Spline_s(const Spline_s & other)
+		: Spline_s(other.N)
 		{
+			std::copy(other.T.get(), other.T.get() + N, T.get());
+			std::copy(other.X.get(), other.X.get() + N, X.get());
+			std::copy(other.X2.get(), other.X2.get() + N, X2.get());
 		}
-	} m_Build;
+	};
+
+	// The dirty range is only touched with m_Lock held, Eval only reads the published m_Spline.
+	std::shared_ptr<const Spline_s> m_Spline;
+	std::atomic<unsigned int> m_Version{0};
+	std::atomic_bool m_Rebuild{true};
+	CInterpolationDirtyRange m_Dirty;
+	std::mutex m_Lock;
+
+	/// <summary>Returns the solved spline for the current map, solving and publishing it if required.</summary>
+	/// <remarks>Lock-free unless the map changed since the last spline was published.</remarks>
+	std::shared_ptr<const Spline_s> GetSpline(int n)
+	{
+		unsigned int version = m_Version.load(std::memory_order_acquire);
+		std::shared_ptr<const Spline_s> spline = std::atomic_load(&m_Spline);
+		if(spline && spline->Version == version) return spline;
+
+		std::lock_guard<std::mutex> lock(m_Lock);
 
-	bool m_Rebuild;
+		version = m_Version.load(std::memory_order_acquire);
+		spline = std::atomic_load(&m_Spline);
+		if(spline && spline->Version == version) return spline;
 
-	void Free()
+		std::shared_ptr<Spline_s> next;
+
+		if(m_Rebuild.load(std::memory_order_relaxed) || !spline || spline->N != n)
+		{
+			m_Rebuild.store(false, std::memory_order_relaxed);
+			m_Dirty.Clear();
+
+			next = std::make_shared<Spline_s>(n);
+			Build(*next);
+		}
+		else
+		{
+			// Copy-on-write: readers may still hold the old spline.
+			next = std::make_shared<Spline_s>(*spline);
+
+			if(!m_Dirty.IsEmpty())
+			{
+				// Only values changed, re-solve in a window around them.
+
+				int first = (int)m_Dirty.First;
+				int last = (int)m_Dirty.Last;
+				m_Dirty.Clear();
+
+				CInterpolationMapViewIterator<TMap, double> it = m_View->GetAt(first);
+				for(int i = first; i <= last; ++i, ++it)
+				{
+					next->X[i] = it.GetValue();
+				}
+
+				int lo = first - 1 - AFX_MATH_LOCAL_UPDATE_WINDOW; if(lo < 0) lo = 0;
+				int hi = last + 1 + AFX_MATH_LOCAL_UPDATE_WINDOW; if(hi > n - 1) hi = n - 1;
+
+				spline_window(next->T.get(), next->X.get(), n, false, 0.0, false, 0.0, next->X2.get(), lo, hi);
+			}
+		}
+
+		next->Version = version;
+
+		spline = std::move(next);
+		std::atomic_store(&m_Spline, spline);
+		return spline;
+	}
+
+	void Build(Spline_s & solved)
 	{
-		delete m_Build.X2;
-		m_Build.X2 = 0;
-		delete m_Build.X;
-		m_Build.X = 0;
-		delete m_Build.T;
-		m_Build.T = 0;
+		{
+			int i = 0;
+			CInterpolationMapViewIterator<TMap, double> itEnd = m_View->GetEnd();
+			for(CInterpolationMapViewIterator<TMap, double> it = m_View->GetBegin(); it != itEnd; ++it)
+			{
+				solved.T[i] = it.GetTime();
+				solved.X[i] = it.GetValue();
+				++i;
+			}
+		}
+
+		spline(solved.T.get(), solved.X.get(), solved.N, false, 0.0, false, 0.0, solved.X2.get());
 	}
 };
 
@@ -1147,6 +1852,30 @@ public:
 		CInterpolationMapViewIterator<TMap, Quaternion> itUpper;
 		m_View->GetNearestInterval(t, itLower, itUpper);
 
+		return EvalInterval(t, itLower, itUpper);
+	}
+
+	virtual void EvalRange(double t0, double dt, size_t n, Quaternion * out)
+	{
+		if(0 == n) return;
+
+		CInterpolationMapViewIterator<TMap, Quaternion> itLower;
+		CInterpolationMapViewIterator<TMap, Quaternion> itUpper;
+		m_View->GetNearestInterval(t0, itLower, itUpper);
+
+		for(size_t i = 0; i < n; ++i)
+		{
+			double t = t0 + i * dt;
+			m_View->AdvanceInterval(t, itLower, itUpper);
+			out[i] = EvalInterval(t, itLower, itUpper);
+		}
+	}
+
+private:
+	CInterpolationMapView<TMap, Quaternion> * m_View;
+
+	Quaternion EvalInterval(double t, CInterpolationMapViewIterator<TMap, Quaternion> & itLower, CInterpolationMapViewIterator<TMap, Quaternion> & itUpper)
+	{
 		double lowerT = itLower.GetTime();
 		Quaternion lowerV = itLower.GetValue();
 
@@ -1174,9 +1903,6 @@ public:
 		
 		return lowerV.Slerp(upperV, (t-lowerT)/deltaT);
 	}
-
-private:
-	CInterpolationMapView<TMap, Quaternion> * m_View;
 };
 
 template<class TMap>
@@ -1184,8 +1910,7 @@ class CSCubicQuaternionInterpolation
 : public CInterpolation<Quaternion>
 {
 public:
-	// TODO: make thread safe.
-	/// <remarks>Currently NOT threadsafe (TODO), because of use of temporary static global variables (slew3_*).</remarks>
+	/// <remarks>Eval and EvalRange may be called concurrently from multiple threads, as long as the map is not modified meanwhile.</remarks>
 	CSCubicQuaternionInterpolation(CInterpolationMapView<TMap, Quaternion> * view)
 	: CInterpolation<Quaternion>()
 	, m_View(view)
@@ -1195,12 +1920,30 @@ public:
 
 	virtual ~CSCubicQuaternionInterpolation()
 	{
-		Free();
 	}
 
 	virtual void InterpolationMapChanged(void)
 	{
-		m_Rebuild = true;
+		m_Rebuild.store(true, std::memory_order_relaxed);
+		m_Version.fetch_add(1, std::memory_order_release);
+	}
+
+	virtual void InterpolationMapValuesChanged(size_t first, size_t last)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+
+			if(!m_Rebuild.load(std::memory_order_relaxed))
+			{
+				std::shared_ptr<const Spline_s> spline = std::atomic_load(&m_Spline);
+
+				if(!spline || (size_t)spline->N != m_View->GetSize() || (size_t)spline->N <= last)
+					m_Rebuild.store(true, std::memory_order_relaxed);
+				else
+					m_Dirty.Add(first, last);
+			}
+		}
+		m_Version.fetch_add(1, std::memory_order_release);
 	}
 
 	virtual bool CanEval(void) const
@@ -1217,102 +1960,210 @@ public:
 
 		if(n < 4) throw "CSCubicQuaternionInterpolation::Eval only allowed with at least 4 points.";
 
-		if(m_Rebuild)
+		std::shared_ptr<const Spline_s> spline = GetSpline(n);
+
+		double Q[4],dum1[4],dum2[4];
+
+		qspline_interp(spline->N, t, spline->T.get(), spline->Q_y.get(), spline->Q_h.get(), spline->Q_dtheta.get(), spline->Q_e.get(), spline->Q_w.get(), Q, dum1, dum2);
+
+		return Quaternion(Q[3], Q[0], Q[1], Q[2]);
+	}
+
+	virtual void EvalRange(double t0, double dt, size_t count, Quaternion * out)
+	{
+		int n = m_View->GetSize();
+
+		if(n < 4) throw "CSCubicQuaternionInterpolation::EvalRange only allowed with at least 4 points.";
+
+		std::shared_ptr<const Spline_s> spline = GetSpline(n);
+
+		const size_t blockSize = 64;
+		double Q[blockSize][4];
+
+		for(size_t i = 0; i < count; i += blockSize)
 		{
-			m_Rebuild = false;
+			size_t blockCount = count - i < blockSize ? count - i : blockSize;
 
-			Free();
+			qspline_interp_range(spline->N, t0 + i * dt, dt, blockCount, spline->T.get(), spline->Q_y.get(), spline->Q_h.get(), spline->Q_dtheta.get(), spline->Q_e.get(), spline->Q_w.get(), Q);
 
-			m_Build.T = new double[n];
-			m_Build.Q_y = new double[n][4];
-			m_Build.Q_h = new double[n-1];
-			m_Build.Q_dtheta = new double[n-1];
-			m_Build.Q_e = new double[n-1][3];
-			m_Build.Q_w = new double[n][3];
+			for(size_t j = 0; j < blockCount; ++j)
+			{
+				out[i + j] = Quaternion(Q[j][3], Q[j][0], Q[j][1], Q[j][2]);
+			}
+		}
+	}
 
+private:
+	CInterpolationMapView<TMap, Quaternion> * m_View;
+
+	/// <summary>Solved spline, not modified anymore once published.</summary>
+	struct Spline_s
+	{
+		/// <summary>Change version of the interpolation this spline was solved for.</summary>
+		unsigned int Version;
+		int N;
+		std::unique_ptr<double[]> T;
+		std::unique_ptr<double[][4]> Q_y;
+		std::unique_ptr<double[]> Q_h;
+		std::unique_ptr<double[]> Q_dtheta;
+		std::unique_ptr<double[][3]> Q_e;
+		std::unique_ptr<double[][3]> Q_w;
+
+		Spline_s(int n)
+		: Version(0)
+		, N(n)
+		, T(new double[n])
+		, Q_y(new double[n][4])
+		, Q_h(new double[n-1])
+		, Q_dtheta(new double[n-1])
+		, Q_e(new double[n-1][3])
+		, Q_w(new double[n][3])
+		{
+		}
+
+		Spline_s(const Spline_s & other)
+		: Spline_s(other.N)
+		{
+			std::copy(other.T.get(), other.T.get() + N, T.get());
+			std::copy(other.Q_h.get(), other.Q_h.get() + N - 1, Q_h.get());
+			std::copy(other.Q_dtheta.get(), other.Q_dtheta.get() + N - 1, Q_dtheta.get());
+			for(int i = 0; i < N; ++i)
 			{
-				Quaternion QLast;
+				std::copy(other.Q_y[i], other.Q_y[i] + 4, Q_y[i]);
+				std::copy(other.Q_w[i], other.Q_w[i] + 3, Q_w[i]);
+				if(i < N - 1) std::copy(other.Q_e[i], other.Q_e[i] + 3, Q_e[i]);
+			}
+		}
+	};
+
+	// The dirty range is only touched with m_Lock held, Eval only reads the published m_Spline.
+	std::shared_ptr<const Spline_s> m_Spline;
+	std::atomic<unsigned int> m_Version{0};
+	std::atomic_bool m_Rebuild{true};
+	CInterpolationDirtyRange m_Dirty;
+	std::mutex m_Lock;
+
+	/// <summary>Returns the solved spline for the current map, solving and publishing it if required.</summary>
+	/// <remarks>Lock-free unless the map changed since the last spline was published.</remarks>
+	std::shared_ptr<const Spline_s> GetSpline(int n)
+	{
+		unsigned int version = m_Version.load(std::memory_order_acquire);
+		std::shared_ptr<const Spline_s> spline = std::atomic_load(&m_Spline);
+		if(spline && spline->Version == version) return spline;
 
-				int i = 0;
-				CInterpolationMapViewIterator<TMap, Quaternion> itEnd = m_View->GetEnd();
-				for(CInterpolationMapViewIterator<TMap, Quaternion> it = m_View->GetBegin(); it != itEnd; ++it)
-				{
-					m_Build.T[i] = it.GetTime();
+		std::lock_guard<std::mutex> lock(m_Lock);
 
-					Quaternion Q = it.GetValue();
-				
-					// Make sure we will travel the short way:
-					if(0<i)
-					{
-						// hasLast.
-						double dotProduct = DotProduct(Q,QLast);
-						if(dotProduct<0.0)
-						{
-							Q = -1.0 * Q;
-						}
-					}
+		version = m_Version.load(std::memory_order_acquire);
+		spline = std::atomic_load(&m_Spline);
+		if(spline && spline->Version == version) return spline;
 
-					m_Build.Q_y[i][0] = Q.X;
-					m_Build.Q_y[i][1] = Q.Y;
-					m_Build.Q_y[i][2] = Q.Z;
-					m_Build.Q_y[i][3] = Q.W;
+		std::shared_ptr<Spline_s> next;
 
-					QLast = Q;
-					i++;
-				}
+		if(!m_Rebuild.load(std::memory_order_relaxed) && spline && spline->N == n)
+		{
+			// Copy-on-write: readers may still hold the old spline.
+			next = std::make_shared<Spline_s>(*spline);
+
+			if(!m_Dirty.IsEmpty())
+			{
+				int first = (int)m_Dirty.First;
+				int last = (int)m_Dirty.Last;
+
+				if(!Update(*next, first, last)) next.reset();
 			}
+		}
 
-			double wi[3] = {0.0,0.0,0.0};
-			double wf[3] = {0.0,0.0,0.0};
-			qspline_init(n, 2, AFX_MATH_EPS, wi, wf, m_Build.T, m_Build.Q_y, m_Build.Q_h, m_Build.Q_dtheta, m_Build.Q_e, m_Build.Q_w);
+		if(!next)
+		{
+			next = std::make_shared<Spline_s>(n);
+			Build(*next);
 		}
 
-		double Q[4],dum1[4],dum2[4];
+		m_Rebuild.store(false, std::memory_order_relaxed);
+		m_Dirty.Clear();
 
-		qspline_interp(n, t, m_Build.T, m_Build.Q_y, m_Build.Q_h, m_Build.Q_dtheta, m_Build.Q_e, m_Build.Q_w, Q, dum1, dum2);
+		next->Version = version;
 
-		return Quaternion(Q[3], Q[0], Q[1], Q[2]);
+		spline = std::move(next);
+		std::atomic_store(&m_Spline, spline);
+		return spline;
 	}
 
-private:
-	CInterpolationMapView<TMap, Quaternion> * m_View;
+	/// <summary>Only values changed, re-solves in a window around them.</summary>
+	/// <returns>false if the whole spline has to be built again instead.</returns>
+	bool Update(Spline_s & solved, int first, int last)
+	{
+		int n = solved.N;
+
+		CInterpolationMapViewIterator<TMap, Quaternion> it = m_View->GetAt(first);
+		for(int i = first; i <= last; ++i, ++it)
+		{
+			Quaternion Q = it.GetValue();
+
+			// Make sure we will travel the short way:
+			if(0 < i && DotProduct(Q, Quaternion(solved.Q_y[i-1][3], solved.Q_y[i-1][0], solved.Q_y[i-1][1], solved.Q_y[i-1][2])) < 0.0)
+			{
+				Q = -1.0 * Q;
+			}
+
+			solved.Q_y[i][0] = Q.X;
+			solved.Q_y[i][1] = Q.Y;
+			solved.Q_y[i][2] = Q.Z;
+			solved.Q_y[i][3] = Q.W;
+		}
 
-	struct Build_s
-	{
-		double * T;
-		double (*Q_y)[4];
-		double * Q_h;
-		double * Q_dtheta;
-		double (*Q_e)[3];
-		double (*Q_w)[3];
-
-		Build_s()
-		: T(0)
-		, Q_y(0)
-		, Q_h(0)
-		, Q_dtheta(0)
-		, Q_e(0)
-		, Q_w(0)
+		// If the sign of the next key would change, all keys after it change too:
+		if(last + 1 < n && !(0.0 < DotProduct(
+			Quaternion(solved.Q_y[last+1][3], solved.Q_y[last+1][0], solved.Q_y[last+1][1], solved.Q_y[last+1][2]),
+			Quaternion(solved.Q_y[last][3], solved.Q_y[last][0], solved.Q_y[last][1], solved.Q_y[last][2]))))
 		{
+			return false;
 		}
-	} m_Build;
-
-	bool m_Rebuild;
-
-	void Free()
-	{
-		delete [] m_Build.Q_w;
-		m_Build.Q_w = 0;
-		delete [] m_Build.Q_e;
-		m_Build.Q_e = 0;
-		delete m_Build.Q_dtheta;
-		m_Build.Q_dtheta = 0;
-		delete m_Build.Q_h;
-		m_Build.Q_h = 0;
-		delete [] m_Build.Q_y;
-		m_Build.Q_y = 0;
-		delete m_Build.T;
-		m_Build.T = 0;
+
+		qspline_update(n, 2, AFX_MATH_EPS, first, last, AFX_MATH_LOCAL_UPDATE_WINDOW, solved.T.get(), solved.Q_y.get(), solved.Q_h.get(), solved.Q_dtheta.get(), solved.Q_e.get(), solved.Q_w.get());
+
+		return true;
+	}
+
+	void Build(Spline_s & solved)
+	{
+		int n = solved.N;
+
+		{
+			Quaternion QLast;
+
+			int i = 0;
+			CInterpolationMapViewIterator<TMap, Quaternion> itEnd = m_View->GetEnd();
+			for(CInterpolationMapViewIterator<TMap, Quaternion> it = m_View->GetBegin(); it != itEnd; ++it)
+			{
+				solved.T[i] = it.GetTime();
+
+				Quaternion Q = it.GetValue();
+			
+				// Make sure we will travel the short way:
+				if(0<i)
+				{
+					// hasLast.
+					double dotProduct = DotProduct(Q,QLast);
+					if(dotProduct<0.0)
+					{
+						Q = -1.0 * Q;
+					}
+				}
+
+				solved.Q_y[i][0] = Q.X;
+				solved.Q_y[i][1] = Q.Y;
+				solved.Q_y[i][2] = Q.Z;
+				solved.Q_y[i][3] = Q.W;
+
+				QLast = Q;
+				i++;
+			}
+		}
+
+		double wi[3] = {0.0,0.0,0.0};
+		double wf[3] = {0.0,0.0,0.0};
+		qspline_init(n, 2, AFX_MATH_EPS, wi, wf, solved.T.get(), solved.Q_y.get(), solved.Q_h.get(), solved.Q_dtheta.get(), solved.Q_e.get(), solved.Q_w.get());
 	}
 };
 
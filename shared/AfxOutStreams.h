@@ -5,7 +5,10 @@
 #include "RefCountedThreadSafe.h"
 #include "TImageBuffer.h"
 #include "EasySampler.h"
+#include "FramePipeline.h"
+#include "ThreadPool.h"
 
+#include <atomic>
 #include <mutex>
 #include <string>
 #include <list>
@@ -194,7 +197,6 @@ public:
 };
 
 
-// TODO: The sampler could work in parallel on the image.
 // TODO:
 // - optimize shutter to allow skipping (capturing of) frames.
 // - think about error propagation, though not entirely applicable.
@@ -206,12 +208,14 @@ template<bool bThreadSafe> class COutSamplingStream
 , public IFramePrinter<bThreadSafe>
 {
 public:
-	COutSamplingStream(const CImageFormat& imageFormat, TIOutVideoStream<true>* outVideoStream, float frameRate, EasySamplerSettings::Method method, double frameDuration, double exposure, float frameStrength, TGrowingBufferPool<bThreadSafe>* imageBufferPool)
+	/// <param name="threadPool">can be nullptr, otherwise the sampler works on row tiles of the image in parallel.</param>
+	COutSamplingStream(const CImageFormat& imageFormat, TIOutVideoStream<true>* outVideoStream, float frameRate, EasySamplerSettings::Method method, double frameDuration, double exposure, float frameStrength, TGrowingBufferPool<bThreadSafe>* imageBufferPool, class CThreadPool* threadPool = nullptr)
 	: COutVideoStreamImpl(imageFormat)
 	, m_OutVideoStream(outVideoStream)
 	, m_Time(0.0)
 	, m_InputFrameDuration(frameRate ? 1.0 / frameRate : 0.0)
 	, m_ImageBufferPool(imageBufferPool)
+	, m_OutFailed(false)
 	{
 		if (m_OutVideoStream) m_OutVideoStream->AddRef();
 
@@ -227,8 +231,9 @@ public:
 				frameDuration,
 				m_Time,
 				exposure,
-				frameStrength
-			), this, m_ImageBufferPool);
+				frameStrength,
+				m_InputFrameDuration // Samples come at a fixed rate, so the byte sampler can accumulate in fixed point.
+			), this, m_ImageBufferPool, threadPool);
 			break;
 		case ImageFormat::ZFloat:
 			m_EasySampler.Float = new EasyFloatSampler<bThreadSafe>(EasySamplerSettings(
@@ -238,7 +243,7 @@ public:
 				m_Time,
 				exposure,
 				frameStrength
-			), this, m_ImageBufferPool);
+			), this, m_ImageBufferPool, threadPool);
 			break;
 		default:
 			advancedfx::Warning("AFXERROR: COutSamplingStream::COutSamplingStream: Unsupported image format.");
@@ -276,12 +281,12 @@ public:
 
 		m_Time += m_InputFrameDuration;
 
-		return true;
+		return !m_OutFailed;
 	}
 
 	// Implements IFramePrinter<bThreadSafe>:
 	virtual void PrintSampledFrame(advancedfx::TImageBuffer<bThreadSafe> * pImageBuffer) override{
-		m_OutVideoStream->SupplyImageBuffer(this, pImageBuffer);
+		if (!m_OutVideoStream->SupplyImageBuffer(this, pImageBuffer)) m_OutFailed = true;
 	}	
 
 protected:
@@ -312,6 +317,87 @@ private:
 	double m_Time;
 	double m_InputFrameDuration;
 	TGrowingBufferPool<bThreadSafe>* m_ImageBufferPool;
+
+	/// <summary>Set once outVideoStream failed, SupplyImageBuffer keeps returning false from then on.</summary>
+	bool m_OutFailed;
+};
+
+/// <summary>Hands the images to outStream on a writer thread of its own, one at a time and in the order they were supplied.</summary>
+/// <remarks>
+///   SupplyImageBuffer returns as soon as the image is queued, so the caller can go on with the next frame while outStream
+///   (encoder, file writer) is still busy. When maxInFlight images are queued it blocks until outStream catches up.
+///   The writer thread is not taken from the shared pool, so the caller can be a pipeline stage running on that pool.<br />
+///   Since outStream runs later, its failure is only reported by the SupplyImageBuffer calls after it: once an image
+///   failed, they return false and don't queue anymore.
+/// </remarks>
+class COutPipelineVideoStream
+: public COutVideoStreamImpl
+, public TRefCounted<true>
+, public TIOutVideoStream<true>
+{
+public:
+	COutPipelineVideoStream(const CImageFormat& imageFormat, TIOutVideoStream<true>* outStream, size_t maxInFlight)
+		: COutVideoStreamImpl(imageFormat)
+		, m_OutStream(outStream)
+		, m_Failed(false)
+		, m_WriterThread(1)
+		, m_Pipeline(&m_WriterThread, maxInFlight)
+	{
+		if (m_OutStream) m_OutStream->AddRef();
+
+		m_Pipeline.AddSerialStage([this](CFramePipeline::CFrame* frame) {
+			if (!m_OutStream->SupplyImageBuffer(this, static_cast<CImageFrame*>(frame)->ImageBuffer)) {
+				advancedfx::Warning("AFXERROR: COutPipelineVideoStream: Failed to supply image %u.\n", (unsigned int)frame->GetFrameNumber());
+				m_Failed = true;
+			}
+		});
+	}
+
+	virtual void AddRef() override {
+		TRefCounted<true>::AddRef();
+	}
+
+	virtual void Release() override {
+		TRefCounted<true>::Release();
+	}
+
+	virtual bool SupplyImageBuffer(void * pSourceId, TIImageBuffer<true> * pImageBuffer) override
+	{
+		if (nullptr == m_OutStream || nullptr == pImageBuffer || m_Failed) return false;
+
+		m_Pipeline.Push(new CImageFrame(pImageBuffer));
+
+		return !m_Failed;
+	}
+
+protected:
+	virtual ~COutPipelineVideoStream() override
+	{
+		m_Pipeline.Flush();
+
+		if (m_OutStream) m_OutStream->Release();
+	}
+
+private:
+	class CImageFrame : public CFramePipeline::CFrame {
+	public:
+		CImageFrame(TIImageBuffer<true>* imageBuffer)
+			: ImageBuffer(imageBuffer)
+		{
+			ImageBuffer->AddRef();
+		}
+
+		virtual ~CImageFrame() override {
+			ImageBuffer->Release();
+		}
+
+		TIImageBuffer<true>* ImageBuffer;
+	};
+
+	TIOutVideoStream<true>* m_OutStream;
+	std::atomic_bool m_Failed;
+	CThreadPool m_WriterThread;
+	CFramePipeline m_Pipeline;
 };
 
 
@@ -0,0 +1,178 @@
+#include "stdafx.h"
+
+#include "AsyncFrameWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace advancedfx {
+
+	/// <summary>The thread draining the rings of all CAsyncFrameWriter instances.</summary>
+	/// <remarks>Owned by the writers, so the thread ends with the last writer (and not in a static destructor at unload).</remarks>
+	class CAsyncFrameWriter::CWorker {
+	public:
+		static std::shared_ptr<CWorker> Get() {
+			static std::mutex s_Mutex;
+			static std::weak_ptr<CWorker> s_Worker;
+
+			std::unique_lock<std::mutex> lock(s_Mutex);
+			std::shared_ptr<CWorker> result = s_Worker.lock();
+			if (!result) {
+				result = std::make_shared<CWorker>();
+				s_Worker = result;
+			}
+			return result;
+		}
+
+		CWorker() {
+			m_Thread = std::thread(&CWorker::ThreadFunc, this);
+		}
+
+		~CWorker() {
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_StopRequested = true;
+				m_WakeCv.notify_one();
+			}
+			m_Thread.join();
+		}
+
+		void Add(CAsyncFrameWriter * writer) {
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Writers.push_back(writer);
+		}
+
+		void Remove(CAsyncFrameWriter * writer) {
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			// The writer might be in the batch the thread is working on right now.
+			m_IdleCv.wait(lock, [this] { return !m_Busy; });
+			m_Writers.erase(std::remove(m_Writers.begin(), m_Writers.end(), writer), m_Writers.end());
+		}
+
+		void Wake() {
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Wake = true;
+			m_WakeCv.notify_one();
+		}
+
+		void Flush(CAsyncFrameWriter * writer) {
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			writer->m_FlushRequested = true;
+			m_Wake = true;
+			m_WakeCv.notify_one();
+			m_IdleCv.wait(lock, [writer] { return !writer->m_FlushRequested; });
+		}
+
+	private:
+		std::mutex m_Mutex;
+		std::condition_variable m_WakeCv;
+		std::condition_variable m_IdleCv;
+		std::vector<CAsyncFrameWriter *> m_Writers;
+		bool m_Wake = false;
+		bool m_Busy = false;
+		bool m_StopRequested = false;
+		std::thread m_Thread;
+
+		void ThreadFunc() {
+			std::vector<std::pair<CAsyncFrameWriter *, bool>> batch;
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			while (true) {
+				m_WakeCv.wait_for(lock, std::chrono::milliseconds(100), [this] { return m_Wake || m_StopRequested; });
+
+				// Only stopped once all writers are gone.
+				if (m_StopRequested) break;
+
+				// Everything pushed before a flush request is visible after taking the lock.
+				batch.clear();
+				for (CAsyncFrameWriter * writer : m_Writers) batch.emplace_back(writer, writer->m_FlushRequested);
+				m_Wake = false;
+				m_Busy = true;
+				lock.unlock();
+
+				for (auto & item : batch) {
+					item.first->Drain();
+					if (item.second) item.first->WriteBuffer();
+				}
+
+				lock.lock();
+				m_Busy = false;
+				for (auto & item : batch) {
+					if (item.second) item.first->m_FlushRequested = false;
+				}
+				m_IdleCv.notify_all();
+			}
+		}
+	};
+
+	CAsyncFrameWriter::CAsyncFrameWriter(Formatter_t formatter, Writer_t writer)
+		: m_Formatter(formatter)
+		, m_Writer(writer)
+		, m_Ring(new Record[c_RingSize])
+		, m_Worker(CWorker::Get())
+	{
+		m_Buffer.reserve(c_BlockSize + 1024);
+		m_Worker->Add(this);
+	}
+
+	CAsyncFrameWriter::~CAsyncFrameWriter() {
+		Stop();
+	}
+
+	void CAsyncFrameWriter::Push(Record const & record) {
+		size_t head = m_Head.load(std::memory_order_relaxed);
+		size_t tail = m_Tail.load(std::memory_order_acquire);
+
+		if (c_RingSize <= head - tail) {
+			m_Worker->Wake();
+			do {
+				std::this_thread::yield();
+				tail = m_Tail.load(std::memory_order_acquire);
+			} while (c_RingSize <= head - tail);
+		}
+
+		m_Ring[head & (c_RingSize - 1)] = record;
+		m_Head.store(head + 1, std::memory_order_release);
+
+		// Don't pay for the wake-up on every frame, the worker polls anyway.
+		if (c_RingSize / 2 <= head + 1 - tail) m_Worker->Wake();
+	}
+
+	void CAsyncFrameWriter::Flush() {
+		if (!m_Worker) return;
+		m_Worker->Flush(this);
+	}
+
+	void CAsyncFrameWriter::Stop() {
+		if (!m_Worker) return;
+		m_Worker->Flush(this);
+		m_Worker->Remove(this);
+		m_Worker.reset();
+	}
+
+	void CAsyncFrameWriter::Drain() {
+		size_t tail = m_Tail.load(std::memory_order_relaxed);
+		size_t head = m_Head.load(std::memory_order_acquire);
+
+		while (tail != head) {
+			for (; tail != head; ++tail) {
+				m_Formatter(m_Ring[tail & (c_RingSize - 1)], m_Buffer);
+				m_Tail.store(tail + 1, std::memory_order_release);
+
+				if (c_BlockSize <= m_Buffer.size()) WriteBuffer();
+			}
+			head = m_Head.load(std::memory_order_acquire);
+		}
+	}
+
+	void CAsyncFrameWriter::WriteBuffer() {
+		if (m_Buffer.empty()) return;
+		m_Writer(m_Buffer.data(), m_Buffer.size());
+		m_Buffer.clear();
+	}
+
+} // namespace advancedfx {
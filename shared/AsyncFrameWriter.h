@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace advancedfx {
+
+	/// <summary>Formats and writes fixed-size frame records on a background thread.</summary>
+	/// <remarks>
+	/// The producer (the engine thread) only copies the record into the writer's lock-free single-producer / single-consumer ring,
+	/// the worker formats the records and hands them to the writer in large blocks.<br />
+	/// All writers share one worker thread, it runs while at least one writer exists.<br />
+	/// Push and Flush must always be called from the same (producer) thread.
+	/// </remarks>
+	class CAsyncFrameWriter {
+	public:
+		struct Record {
+			double Values[8];
+		};
+
+		/// <summary>Appends the formatted record to outBuffer, called on the worker thread.</summary>
+		typedef std::function<void(Record const & record, std::string & outBuffer)> Formatter_t;
+
+		/// <summary>Writes a block of formatted data, called on the worker thread.</summary>
+		typedef std::function<void(char const * data, size_t size)> Writer_t;
+
+		CAsyncFrameWriter(Formatter_t formatter, Writer_t writer);
+
+		/// <remarks>Calls Stop.</remarks>
+		~CAsyncFrameWriter();
+
+		/// <remarks>Only blocks if the ring is full (the worker can't keep up).</remarks>
+		void Push(Record const & record);
+
+		/// <summary>Blocks until all records pushed so far have been written.</summary>
+		void Flush();
+
+		/// <summary>Flushes and leaves the worker, afterwards the writer is not called anymore.</summary>
+		void Stop();
+
+	private:
+		class CWorker;
+
+		static const size_t c_RingSize = 1024; // Must be a power of 2.
+		static const size_t c_BlockSize = 64 * 1024;
+
+		Formatter_t m_Formatter;
+		Writer_t m_Writer;
+
+		std::unique_ptr<Record[]> m_Ring;
+		alignas(64) std::atomic<size_t> m_Head{ 0 }; // Next slot to push, written by producer only.
+		alignas(64) std::atomic<size_t> m_Tail{ 0 }; // Next slot to format, written by worker only.
+
+		std::shared_ptr<CWorker> m_Worker;
+		bool m_FlushRequested = false; // Guarded by the worker's mutex.
+
+		std::string m_Buffer;
+
+		void Drain();
+		void WriteBuffer();
+	};
+
+} // namespace advancedfx {
@@ -0,0 +1,321 @@
+#include "stdafx.h"
+
+#include "BoneTransforms.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP) || defined(__SSE2__)
+#define ADVANCEDFX_BONETRANSFORMS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace advancedfx {
+namespace BoneTransforms {
+
+static const float c_Identity[3][4] = {
+	{ 1, 0, 0, 0 },
+	{ 0, 1, 0, 0 },
+	{ 0, 0, 1, 0 }
+};
+
+bool ToParentSpace_Scalar(int numBones, int const * parents, float const root[3][4], float const (*bones)[3][4], float (*outBones)[3][4], int * outFirstFailedBone)
+{
+	int firstFailedBone = -1;
+
+	for (int i = 0; i < numBones; ++i) {
+		int parent = parents[i];
+		float const (*p)[4] = 0 <= parent && parent < numBones ? bones[parent] : root;
+		float const (*b)[4] = bones[i];
+
+		double c00 = (double)p[1][1] * p[2][2] - (double)p[1][2] * p[2][1];
+		double c01 = (double)p[1][2] * p[2][0] - (double)p[1][0] * p[2][2];
+		double c02 = (double)p[1][0] * p[2][1] - (double)p[1][1] * p[2][0];
+		double det = p[0][0] * c00 + p[0][1] * c01 + p[0][2] * c02;
+
+		if (0 == det) {
+			if (-1 == firstFailedBone) firstFailedBone = i;
+			memcpy(outBones[i], b, sizeof(outBones[i]));
+			continue;
+		}
+
+		double invDet = 1.0 / det;
+		double inv[3][3] = {
+			{ c00 * invDet, ((double)p[0][2] * p[2][1] - (double)p[0][1] * p[2][2]) * invDet, ((double)p[0][1] * p[1][2] - (double)p[0][2] * p[1][1]) * invDet },
+			{ c01 * invDet, ((double)p[0][0] * p[2][2] - (double)p[0][2] * p[2][0]) * invDet, ((double)p[0][2] * p[1][0] - (double)p[0][0] * p[1][2]) * invDet },
+			{ c02 * invDet, ((double)p[0][1] * p[2][0] - (double)p[0][0] * p[2][1]) * invDet, ((double)p[0][0] * p[1][1] - (double)p[0][1] * p[1][0]) * invDet }
+		};
+
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 3; ++c) {
+				outBones[i][r][c] = (float)(inv[r][0] * b[0][c] + inv[r][1] * b[1][c] + inv[r][2] * b[2][c]);
+			}
+			outBones[i][r][3] = (float)(inv[r][0] * ((double)b[0][3] - p[0][3]) + inv[r][1] * ((double)b[1][3] - p[1][3]) + inv[r][2] * ((double)b[2][3] - p[2][3]));
+		}
+	}
+
+	if (outFirstFailedBone) *outFirstFailedBone = firstFailedBone;
+
+	return -1 == firstFailedBone;
+}
+
+void ToQuaternions_Scalar(int numBones, float const (*bones)[3][4], float (*outQuaternions)[4])
+{
+	for (int i = 0; i < numBones; ++i) {
+		float const (*m)[4] = bones[i];
+
+		double tw = 1.0 + m[0][0] + m[1][1] + m[2][2];
+		double tx = 1.0 + m[0][0] - m[1][1] - m[2][2];
+		double ty = 1.0 - m[0][0] + m[1][1] - m[2][2];
+		double tz = 1.0 - m[0][0] - m[1][1] + m[2][2];
+
+		double d0 = (double)m[2][1] - m[1][2], d1 = (double)m[0][2] - m[2][0], d2 = (double)m[1][0] - m[0][1];
+		double a0 = (double)m[0][1] + m[1][0], a1 = (double)m[0][2] + m[2][0], a2 = (double)m[1][2] + m[2][1];
+
+		double x, y, z, w;
+
+		// The largest component is computed from the diagonal, the others from it:
+		if (tw >= tx && tw >= ty && tw >= tz) {
+			double s = 0 < tw ? 0.5 / sqrt(tw) : 0;
+			w = 0 < tw ? 0.5 * sqrt(tw) : 0; x = d0 * s; y = d1 * s; z = d2 * s;
+		} else if (tx >= ty && tx >= tz) {
+			double s = 0 < tx ? 0.5 / sqrt(tx) : 0;
+			x = 0 < tx ? 0.5 * sqrt(tx) : 0; w = d0 * s; y = a0 * s; z = a1 * s;
+		} else if (ty >= tz) {
+			double s = 0 < ty ? 0.5 / sqrt(ty) : 0;
+			y = 0 < ty ? 0.5 * sqrt(ty) : 0; w = d1 * s; x = a0 * s; z = a2 * s;
+		} else {
+			double s = 0 < tz ? 0.5 / sqrt(tz) : 0;
+			z = 0 < tz ? 0.5 * sqrt(tz) : 0; w = d2 * s; x = a1 * s; y = a2 * s;
+		}
+
+		double len = sqrt(x * x + y * y + z * z + w * w);
+		if (0 < len) {
+			x /= len; y /= len; z /= len; w /= len;
+		} else {
+			x = 0; y = 0; z = 0; w = 1;
+		}
+
+		outQuaternions[i][0] = (float)x;
+		outQuaternions[i][1] = (float)y;
+		outQuaternions[i][2] = (float)z;
+		outQuaternions[i][3] = (float)w;
+	}
+}
+
+#ifdef ADVANCEDFX_BONETRANSFORMS_SSE2
+
+// 4 bones in SoA layout: m[r][c] holds element [r][c] of each bone.
+struct Bones4_s {
+	__m128 m[3][4];
+};
+
+static inline void BoneTransforms_Load4(float const (*m0)[4], float const (*m1)[4], float const (*m2)[4], float const (*m3)[4], Bones4_s & out)
+{
+	for (int r = 0; r < 3; ++r) {
+		__m128 a = _mm_loadu_ps(m0[r]);
+		__m128 b = _mm_loadu_ps(m1[r]);
+		__m128 c = _mm_loadu_ps(m2[r]);
+		__m128 d = _mm_loadu_ps(m3[r]);
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		out.m[r][0] = a; out.m[r][1] = b; out.m[r][2] = c; out.m[r][3] = d;
+	}
+}
+
+static inline void BoneTransforms_Store4(Bones4_s const & in, float (*m0)[4], float (*m1)[4], float (*m2)[4], float (*m3)[4])
+{
+	for (int r = 0; r < 3; ++r) {
+		__m128 a = in.m[r][0], b = in.m[r][1], c = in.m[r][2], d = in.m[r][3];
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_storeu_ps(m0[r], a);
+		_mm_storeu_ps(m1[r], b);
+		_mm_storeu_ps(m2[r], c);
+		_mm_storeu_ps(m3[r], d);
+	}
+}
+
+static inline __m128 BoneTransforms_Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/// <returns>Mask of the lanes where the parent could not be inverted (these get the bone unchanged).</returns>
+static inline int BoneTransforms_ToParentSpace4(Bones4_s const & p, Bones4_s const & b, Bones4_s & out)
+{
+	__m128 p00 = p.m[0][0], p01 = p.m[0][1], p02 = p.m[0][2];
+	__m128 p10 = p.m[1][0], p11 = p.m[1][1], p12 = p.m[1][2];
+	__m128 p20 = p.m[2][0], p21 = p.m[2][1], p22 = p.m[2][2];
+
+	// Inverse of the rotation part by cofactors:
+
+	__m128 c00 = _mm_sub_ps(_mm_mul_ps(p11, p22), _mm_mul_ps(p12, p21));
+	__m128 c01 = _mm_sub_ps(_mm_mul_ps(p12, p20), _mm_mul_ps(p10, p22));
+	__m128 c02 = _mm_sub_ps(_mm_mul_ps(p10, p21), _mm_mul_ps(p11, p20));
+
+	__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p00, c00), _mm_mul_ps(p01, c01)), _mm_mul_ps(p02, c02));
+	__m128 failed = _mm_cmpeq_ps(det, _mm_setzero_ps());
+	__m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), BoneTransforms_Select(failed, _mm_set1_ps(1.0f), det));
+
+	__m128 inv[3][3] = {
+		{ c00, _mm_sub_ps(_mm_mul_ps(p02, p21), _mm_mul_ps(p01, p22)), _mm_sub_ps(_mm_mul_ps(p01, p12), _mm_mul_ps(p02, p11)) },
+		{ c01, _mm_sub_ps(_mm_mul_ps(p00, p22), _mm_mul_ps(p02, p20)), _mm_sub_ps(_mm_mul_ps(p02, p10), _mm_mul_ps(p00, p12)) },
+		{ c02, _mm_sub_ps(_mm_mul_ps(p01, p20), _mm_mul_ps(p00, p21)), _mm_sub_ps(_mm_mul_ps(p00, p11), _mm_mul_ps(p01, p10)) }
+	};
+
+	// Translation relative to the parent:
+	__m128 t[3];
+	for (int k = 0; k < 3; ++k) t[k] = _mm_sub_ps(b.m[k][3], p.m[k][3]);
+
+	for (int r = 0; r < 3; ++r) {
+		for (int k = 0; k < 3; ++k) inv[r][k] = _mm_mul_ps(inv[r][k], invDet);
+
+		for (int c = 0; c < 3; ++c) {
+			__m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(inv[r][0], b.m[0][c]), _mm_mul_ps(inv[r][1], b.m[1][c])), _mm_mul_ps(inv[r][2], b.m[2][c]));
+			out.m[r][c] = BoneTransforms_Select(failed, b.m[r][c], value);
+		}
+
+		__m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(inv[r][0], t[0]), _mm_mul_ps(inv[r][1], t[1])), _mm_mul_ps(inv[r][2], t[2]));
+		out.m[r][3] = BoneTransforms_Select(failed, b.m[r][3], value);
+	}
+
+	return _mm_movemask_ps(failed);
+}
+
+bool ToParentSpace(int numBones, int const * parents, float const root[3][4], float const (*bones)[3][4], float (*outBones)[3][4], int * outFirstFailedBone)
+{
+	int firstFailedBone = -1;
+
+	Bones4_s p, b, out;
+	float tmpOut[4][3][4];
+
+	for (int i = 0; i < numBones; i += 4) {
+		float const (*pBones[4])[4];
+		float const (*pParents[4])[4];
+		int count = numBones - i < 4 ? numBones - i : 4;
+
+		for (int j = 0; j < 4; ++j) {
+			if (j < count) {
+				int parent = parents[i + j];
+				pBones[j] = bones[i + j];
+				pParents[j] = 0 <= parent && parent < numBones ? bones[parent] : root;
+			} else {
+				pBones[j] = c_Identity;
+				pParents[j] = c_Identity;
+			}
+		}
+
+		BoneTransforms_Load4(pParents[0], pParents[1], pParents[2], pParents[3], p);
+		BoneTransforms_Load4(pBones[0], pBones[1], pBones[2], pBones[3], b);
+
+		int failed = BoneTransforms_ToParentSpace4(p, b, out);
+
+		if (failed && -1 == firstFailedBone) {
+			for (int j = 0; j < count; ++j) {
+				if (failed & (1 << j)) {
+					firstFailedBone = i + j;
+					break;
+				}
+			}
+		}
+
+		if (4 == count) {
+			BoneTransforms_Store4(out, outBones[i], outBones[i + 1], outBones[i + 2], outBones[i + 3]);
+		} else {
+			BoneTransforms_Store4(out, tmpOut[0], tmpOut[1], tmpOut[2], tmpOut[3]);
+			memcpy(outBones[i], tmpOut, count * sizeof(tmpOut[0]));
+		}
+	}
+
+	if (outFirstFailedBone) *outFirstFailedBone = firstFailedBone;
+
+	return -1 == firstFailedBone;
+}
+
+void ToQuaternions(int numBones, float const (*bones)[3][4], float (*outQuaternions)[4])
+{
+	Bones4_s m;
+	float tmpOut[4][4];
+
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 half = _mm_set1_ps(0.5f);
+	__m128 zero = _mm_setzero_ps();
+
+	for (int i = 0; i < numBones; i += 4) {
+		int count = numBones - i < 4 ? numBones - i : 4;
+
+		float const (*pBones[4])[4];
+		for (int j = 0; j < 4; ++j) pBones[j] = j < count ? bones[i + j] : c_Identity;
+
+		BoneTransforms_Load4(pBones[0], pBones[1], pBones[2], pBones[3], m);
+
+		__m128 m00 = m.m[0][0], m11 = m.m[1][1], m22 = m.m[2][2];
+
+		__m128 tw = _mm_add_ps(_mm_add_ps(one, m00), _mm_add_ps(m11, m22));
+		__m128 tx = _mm_sub_ps(_mm_add_ps(one, m00), _mm_add_ps(m11, m22));
+		__m128 ty = _mm_sub_ps(_mm_add_ps(one, m11), _mm_add_ps(m00, m22));
+		__m128 tz = _mm_sub_ps(_mm_add_ps(one, m22), _mm_add_ps(m00, m11));
+
+		__m128 d0 = _mm_sub_ps(m.m[2][1], m.m[1][2]), d1 = _mm_sub_ps(m.m[0][2], m.m[2][0]), d2 = _mm_sub_ps(m.m[1][0], m.m[0][1]);
+		__m128 a0 = _mm_add_ps(m.m[0][1], m.m[1][0]), a1 = _mm_add_ps(m.m[0][2], m.m[2][0]), a2 = _mm_add_ps(m.m[1][2], m.m[2][1]);
+
+		// Same case selection as in ToQuaternions_Scalar:
+		__m128 selW = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(tw, tx), _mm_cmpge_ps(tw, ty)), _mm_cmpge_ps(tw, tz));
+		__m128 selX = _mm_andnot_ps(selW, _mm_and_ps(_mm_cmpge_ps(tx, ty), _mm_cmpge_ps(tx, tz)));
+		__m128 selY = _mm_andnot_ps(_mm_or_ps(selW, selX), _mm_cmpge_ps(ty, tz));
+
+		__m128 t = BoneTransforms_Select(selW, tw, BoneTransforms_Select(selX, tx, BoneTransforms_Select(selY, ty, tz)));
+		__m128 positive = _mm_cmpgt_ps(t, zero);
+		__m128 root = _mm_sqrt_ps(_mm_max_ps(t, zero));
+		__m128 largest = _mm_mul_ps(half, root);
+		__m128 s = _mm_and_ps(positive, _mm_div_ps(half, BoneTransforms_Select(positive, root, one)));
+
+		d0 = _mm_mul_ps(d0, s); d1 = _mm_mul_ps(d1, s); d2 = _mm_mul_ps(d2, s);
+		a0 = _mm_mul_ps(a0, s); a1 = _mm_mul_ps(a1, s); a2 = _mm_mul_ps(a2, s);
+
+		__m128 w = BoneTransforms_Select(selW, largest, BoneTransforms_Select(selX, d0, BoneTransforms_Select(selY, d1, d2)));
+		__m128 x = BoneTransforms_Select(selW, d0, BoneTransforms_Select(selX, largest, BoneTransforms_Select(selY, a0, a1)));
+		__m128 y = BoneTransforms_Select(selW, d1, BoneTransforms_Select(selX, a0, BoneTransforms_Select(selY, largest, a2)));
+		__m128 z = BoneTransforms_Select(selW, d2, BoneTransforms_Select(selX, a1, BoneTransforms_Select(selY, a2, largest)));
+
+		__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w))));
+		__m128 valid = _mm_cmpgt_ps(len, zero);
+		__m128 invLen = _mm_div_ps(one, BoneTransforms_Select(valid, len, one));
+
+		x = _mm_and_ps(valid, _mm_mul_ps(x, invLen));
+		y = _mm_and_ps(valid, _mm_mul_ps(y, invLen));
+		z = _mm_and_ps(valid, _mm_mul_ps(z, invLen));
+		w = BoneTransforms_Select(valid, _mm_mul_ps(w, invLen), one);
+
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		if (4 == count) {
+			_mm_storeu_ps(outQuaternions[i], x);
+			_mm_storeu_ps(outQuaternions[i + 1], y);
+			_mm_storeu_ps(outQuaternions[i + 2], z);
+			_mm_storeu_ps(outQuaternions[i + 3], w);
+		} else {
+			_mm_storeu_ps(tmpOut[0], x);
+			_mm_storeu_ps(tmpOut[1], y);
+			_mm_storeu_ps(tmpOut[2], z);
+			_mm_storeu_ps(tmpOut[3], w);
+			memcpy(outQuaternions[i], tmpOut, count * sizeof(tmpOut[0]));
+		}
+	}
+}
+
+#else
+
+bool ToParentSpace(int numBones, int const * parents, float const root[3][4], float const (*bones)[3][4], float (*outBones)[3][4], int * outFirstFailedBone)
+{
+	return ToParentSpace_Scalar(numBones, parents, root, bones, outBones, outFirstFailedBone);
+}
+
+void ToQuaternions(int numBones, float const (*bones)[3][4], float (*outQuaternions)[4])
+{
+	ToQuaternions_Scalar(numBones, bones, outQuaternions);
+}
+
+#endif
+
+} // namespace BoneTransforms {
+} // namespace advancedfx {
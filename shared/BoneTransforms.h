@@ -0,0 +1,28 @@
+#pragma once
+
+namespace advancedfx {
+namespace BoneTransforms {
+
+/// <summary>Makes bone transforms relative to their parent bone, for all bones of a model at once.</summary>
+/// <param name="parents">Parent bone index per bone, -1 for bones relative to root.</param>
+/// <param name="root">Transform for bones without parent (i.e. the model's rotation matrix).</param>
+/// <param name="bones">Bone transforms (world space).</param>
+/// <param name="outBones">Bone transforms relative to their parent, can not be the same as bones.</param>
+/// <param name="outFirstFailedBone">If not null, receives the first bone whose parent could not be inverted (or -1).</param>
+/// <returns>false if a parent could not be inverted, these bones are output unchanged.</returns>
+/// <remarks>Uses SSE2 (4 bones at a time) where available, ToParentSpace_Scalar otherwise.</remarks>
+bool ToParentSpace(int numBones, int const * parents, float const root[3][4], float const (*bones)[3][4], float (*outBones)[3][4], int * outFirstFailedBone = nullptr);
+
+/// <summary>Reference implementation of ToParentSpace (in double precision).</summary>
+bool ToParentSpace_Scalar(int numBones, int const * parents, float const root[3][4], float const (*bones)[3][4], float (*outBones)[3][4], int * outFirstFailedBone = nullptr);
+
+/// <summary>Converts the rotation part of bone transforms to normalized quaternions.</summary>
+/// <param name="outQuaternions">x, y, z, w per bone, the largest component is positive.</param>
+/// <remarks>Uses SSE2 (4 bones at a time) where available, ToQuaternions_Scalar otherwise.</remarks>
+void ToQuaternions(int numBones, float const (*bones)[3][4], float (*outQuaternions)[4]);
+
+/// <summary>Reference implementation of ToQuaternions (in double precision).</summary>
+void ToQuaternions_Scalar(int numBones, float const (*bones)[3][4], float (*outQuaternions)[4]);
+
+} // namespace BoneTransforms {
+} // namespace advancedfx {
@@ -4,7 +4,11 @@
 
 #include <string>
 #include <sstream>
+#include <charconv>
+#include <algorithm>
 #include <share.h>
+#include <string.h>
+#include <stdint.h>
 
 double CamIO::DoFovScaling(double width, double height, double fov)
 {
@@ -28,30 +32,112 @@ double CamIO::UndoFovScaling(double width, double height, double fov)
 	return fov;
 }
 
+// Binary format: CamIOBinaryHeader_s followed by CamIOBinaryFrame_s records up to the end of the file.
+// Little-endian (we only run on x86), so a frame's offset is sizeof(header) + index * sizeof(frame).
+
+static char const c_CamIOBinaryMagic[8] = { 'a', 'f', 'x', 'C', 'a', 'm', 'I', 'O' };
+static uint32_t const c_CamIOBinaryVersion = 1;
+
+struct CamIOBinaryHeader_s {
+	char Magic[8];
+	uint32_t Version;
+	uint8_t ScaleFov; // CamIO::ScaleFov
+	uint8_t Reserved[3];
+};
+static_assert(sizeof(CamIOBinaryHeader_s) == 16, "Unexpected CamIOBinaryHeader_s layout.");
+
+struct CamIOBinaryFrame_s {
+	double Time;
+	double XPosition, YPosition, ZPosition;
+	double XRotation, YRotation, ZRotation;
+	double Fov; // Scaled according to header ScaleFov.
+};
+static_assert(sizeof(CamIOBinaryFrame_s) == 64, "Unexpected CamIOBinaryFrame_s layout.");
+
+static void CamIO_WriteBinaryHeader(std::ostream & os, CamIO::ScaleFov scaleFov)
+{
+	CamIOBinaryHeader_s header = {};
+	memcpy(header.Magic, c_CamIOBinaryMagic, sizeof(header.Magic));
+	header.Version = c_CamIOBinaryVersion;
+	header.ScaleFov = (uint8_t)scaleFov;
+
+	os.write((char const *)&header, sizeof(header));
+}
+
+static void CamIO_WriteBinaryFrame(std::ostream & os, CamIO::CamData const & camData, double fov)
+{
+	CamIOBinaryFrame_s frame = {
+		camData.Time,
+		camData.XPosition, camData.YPosition, camData.ZPosition,
+		camData.XRotation, camData.YRotation, camData.ZRotation,
+		fov
+	};
+
+	os.write((char const *)&frame, sizeof(frame));
+}
 
-CamExport::CamExport(const wchar_t * fileName)
+static void CamIO_WriteTextHeader(std::ostream & os, CamIO::ScaleFov scaleFov)
+{
+	os << "advancedfx Cam" << std::endl;
+	os << "version 2" << std::endl;
+	if (CamIO::SF_New != scaleFov) os << "scaleFov " << (scaleFov == CamIO::SF_OldAlienSwarm ? "alienSwarm" : "none") << std::endl;
+	os << "channels time xPosition yPosition zPosition xRotation yRotation zRotation fov" << std::endl;
+	os << "DATA" << std::endl;
+}
+
+CamExport::CamExport(const wchar_t * fileName, bool binary)
 	: m_Ofs(fileName, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc)
+	, m_Binary(binary)
 {
 	m_ScaleFov = SF_New;
 
-	m_Ofs << "advancedfx Cam" << std::endl;
-	m_Ofs << "version 2" << std::endl;
-	//m_Ofs << "scaleFov " << (m_ScaleFov == SF_AlienSwarm ? "alienSwarm" : "none") << std::endl;
-	m_Ofs << "channels time xPosition yPosition zPosition xRotation yRotation zRotation fov" << std::endl;
-	m_Ofs << "DATA" << std::endl;
+	if (m_Binary)
+		CamIO_WriteBinaryHeader(m_Ofs, m_ScaleFov);
+	else
+		CamIO_WriteTextHeader(m_Ofs, m_ScaleFov);
 
-	m_Ofs << std::fixed;
-	m_Ofs.precision(6);
+	// Record values are the channels in file order, with the fov already scaled.
+	advancedfx::CAsyncFrameWriter::Formatter_t formatter;
+	if (m_Binary)
+	{
+		formatter = [](advancedfx::CAsyncFrameWriter::Record const & record, std::string & outBuffer) {
+			static_assert(sizeof(CamIOBinaryFrame_s) == sizeof(record.Values), "Record does not match CamIOBinaryFrame_s.");
+			outBuffer.append((char const *)record.Values, sizeof(record.Values));
+		};
+	}
+	else
+	{
+		// Same as std::fixed with precision 6.
+		formatter = [](advancedfx::CAsyncFrameWriter::Record const & record, std::string & outBuffer) {
+			char szLine[1024];
+			int len = _snprintf_s(szLine, _TRUNCATE, "%f %f %f %f %f %f %f %f\n",
+				record.Values[0], record.Values[1], record.Values[2], record.Values[3],
+				record.Values[4], record.Values[5], record.Values[6], record.Values[7]);
+			if (0 < len) outBuffer.append(szLine, len);
+		};
+	}
+
+	m_Writer.reset(new advancedfx::CAsyncFrameWriter(formatter, [this](char const * data, size_t size) {
+		m_Ofs.write(data, size);
+	}));
 }
 
 CamExport::~CamExport()
 {
+	// Writes all pending frames.
+	m_Writer.reset();
+
 	m_Ofs.close();
 }
 
 void CamExport::WriteFrame(double width, double height, const CamData & camData)
 {
-	m_Ofs << camData.Time << " " << camData.XPosition << " " << camData.YPosition << " " << camData.ZPosition << " " << camData.XRotation << " " << camData.YRotation << " " << camData.ZRotation << " " << DoFovScaling(width, height, camData.Fov) << std::endl;
+	m_Writer->Push({
+		camData.Time,
+		camData.XPosition, camData.YPosition, camData.ZPosition,
+		camData.XRotation, camData.YRotation, camData.ZRotation,
+		DoFovScaling(width, height, camData.Fov)
+	});
 }
 
 void afx_std_string_remove_CR(std::string & inOutValue) {
@@ -59,24 +145,63 @@ void afx_std_string_remove_CR(std::string & inOutValue) {
 		inOutValue.erase(--inOutValue.end());
 }
 
+static char const * CamImport_SkipSpace(char const * first, char const * last)
+{
+	while (first < last && (' ' == *first || '\t' == *first)) ++first;
+	return first;
+}
+
+/// <returns>If all channels could be parsed (same as reading them with operator &gt;&gt; would).</returns>
+static bool CamImport_ParseDataLine(char const * first, char const * last, CamIO::CamData & outCamData)
+{
+	double * channels[] = {
+		&outCamData.Time,
+		&outCamData.XPosition, &outCamData.YPosition, &outCamData.ZPosition,
+		&outCamData.XRotation, &outCamData.YRotation, &outCamData.ZRotation,
+		&outCamData.Fov
+	};
+
+	for (double * channel : channels)
+	{
+		first = CamImport_SkipSpace(first, last);
+		std::from_chars_result result = std::from_chars(first, last, *channel);
+		if (std::errc() != result.ec)
+			return false;
+		first = result.ptr;
+	}
+
+	return true;
+}
+
 CamImport::CamImport(char const * fileName, double startTime)
-	: m_Ifs(fileName, std::ifstream::in | std::ofstream::binary, _SH_DENYWR)
-	, m_StartTime(startTime)
+	: m_StartTime(startTime)
 {
+	std::ifstream ifs(fileName, std::ifstream::in | std::ofstream::binary, _SH_DENYWR);
+
+	char binaryMagic[sizeof(c_CamIOBinaryMagic)] = { 0 };
+	if (ifs.read(binaryMagic, sizeof(binaryMagic)) && 0 == memcmp(binaryMagic, c_CamIOBinaryMagic, sizeof(c_CamIOBinaryMagic)))
+	{
+		m_Binary = true;
+		m_Bad = !ReadBinary(ifs);
+		return;
+	}
+	ifs.clear();
+	ifs.seekg(0, std::ios_base::beg);
+
 	int version = 0;
 	m_ScaleFov = SF_New;
 
 	char magic[14 + 1 + 1] = { 0 };
 
-	m_Ifs.getline(magic, sizeof(magic) / sizeof(char), '\n'); if ('\r' == magic[14]) magic[14] = '\0';
-	if (0 != strcmp(magic, "advancedfx Cam"))m_Ifs.clear(m_Ifs.rdstate() | std::ifstream::badbit);
+	ifs.getline(magic, sizeof(magic) / sizeof(char), '\n'); if ('\r' == magic[14]) magic[14] = '\0';
+	if (0 != strcmp(magic, "advancedfx Cam")) ifs.clear(ifs.rdstate() | std::ifstream::badbit);
 
 
-	while (m_Ifs.good())
+	while (ifs.good())
 	{
 		std::string line;
 
-		std::getline(m_Ifs, line, '\n'); afx_std_string_remove_CR(line);
+		std::getline(ifs, line, '\n'); afx_std_string_remove_CR(line);
 
 		std::istringstream iss(line);
 
@@ -103,160 +228,226 @@ CamImport::CamImport(char const * fileName, double startTime)
 		}
 	}
 
-	if (version < 1 || version > 2) m_Ifs.setstate(m_Ifs.rdstate() | std::ifstream::badbit);
+	if (version < 1 || version > 2) ifs.setstate(ifs.rdstate() | std::ifstream::badbit);
 
-	m_DataStart = m_Ifs.tellg();
-}
+	if (ifs.bad())
+	{
+		m_Bad = true;
+		return;
+	}
 
-CamImport::~CamImport()
-{
-	m_Ifs.close();
-}
+	// Read the data section at once and index it:
 
-void CamImport::SetStart(double startTime)
-{
-	m_StartTime = startTime;
-}
+	std::streampos dataStart = ifs.tellg();
+	ifs.seekg(0, std::ios_base::end);
+	std::streampos dataEnd = ifs.tellg();
+	ifs.seekg(dataStart, std::ios_base::beg);
 
-bool CamImport::GetCamData(double time, double width, double height, CamData & outCamData)
-{
-	if (m_Ifs.bad())
-		return false; // too broken
+	if (ifs.fail() || dataEnd < dataStart)
+	{
+		m_Bad = true;
+		return;
+	}
 
-	if (time - m_StartTime < 0)
-		return false; // too early
+	std::string data((size_t)(dataEnd - dataStart), '\0');
+	if (!data.empty() && ifs.read(&data[0], data.size()).bad())
+	{
+		m_Bad = true;
+		return;
+	}
 
-	if (m_HasFinalFrame && m_FinalFrameTime - m_FirstFrameTime < time - m_StartTime)
-		return false; // too late
+	char const * cur = data.data();
+	char const * end = cur + data.size();
 
-	if (!m_HasLastFrame) {
+	while (cur < end)
+	{
+		char const * lineEnd = std::find(cur, end, '\n');
 
-		m_CurPos = m_Ifs.tellg();
-		m_HasLastFrame = ReadDataLine(m_LastFrame);
-		if (!m_HasLastFrame)
-			return false;
+		CamData frame;
+		if (!CamImport_ParseDataLine(cur, lineEnd, frame))
+			break; // Like before, the first line that can't be read ends the data.
 
-		// First frame
-		m_FirstFrameTime = m_LastFrame.Time;
+		m_Frames.push_back(frame);
+		m_Quats.push_back(Afx::Math::Quaternion::FromQREulerAngles(Afx::Math::QREulerAngles::FromQEulerAngles(Afx::Math::QEulerAngles(frame.YRotation, frame.ZRotation, frame.XRotation))));
 
-		m_LastQuat = Afx::Math::Quaternion::FromQREulerAngles(Afx::Math::QREulerAngles::FromQEulerAngles(Afx::Math::QEulerAngles(m_LastFrame.YRotation, m_LastFrame.ZRotation, m_LastFrame.XRotation)));
-		m_NextFrame = m_LastFrame;
-		m_NextQuat = m_LastQuat;
+		cur = lineEnd < end ? lineEnd + 1 : end;
 	}
+}
 
-	// Jump backwards if required:
-	if (
-		m_LastFrame.Time - m_FirstFrameTime > time - m_StartTime // time is before current interval
-		)
+bool CamImport::ReadBinary(std::ifstream & ifs)
+{
+	CamIOBinaryHeader_s header;
+	memcpy(header.Magic, c_CamIOBinaryMagic, sizeof(header.Magic));
+	if (!ifs.read((char *)&header + sizeof(header.Magic), sizeof(header) - sizeof(header.Magic)))
+		return false;
+
+	if (c_CamIOBinaryVersion != header.Version)
+		return false;
+
+	switch (header.ScaleFov)
 	{
-		size_t loPos = m_DataStart;
-		size_t hiPos = m_CurPos;
+	case SF_OldNone:
+	case SF_OldAlienSwarm:
+	case SF_New:
+		m_ScaleFov = (ScaleFov)header.ScaleFov;
+		break;
+	default:
+		return false;
+	}
 
-		m_Ifs.clear(std::ios::eofbit);
-		if (m_Ifs.seekg(m_DataStart, std::ios_base::beg).bad()) return false;
-		if(!ReadDataLine(m_LastFrame))
-			return false;
-		
-		CamData curFrame;
-		while (loPos < hiPos) {
-			size_t curPos = (loPos + hiPos) / 2;
+	std::streampos dataStart = ifs.tellg();
+	ifs.seekg(0, std::ios_base::end);
+	std::streampos dataEnd = ifs.tellg();
+	ifs.seekg(dataStart, std::ios_base::beg);
 
-			m_Ifs.clear(std::ios::eofbit);
-			if (m_Ifs.seekg(curPos, std::ios_base::beg).bad()) return false;
+	if (ifs.fail() || dataEnd < dataStart)
+		return false;
 
-			while (!m_Ifs.bad() && !m_Ifs.eof() && '\n' != m_Ifs.get()); // seek until next line
+	// Records are fixed size, so we can read them all at once (an incomplete trailing record is ignored).
+	size_t frameCount = (size_t)(dataEnd - dataStart) / sizeof(CamIOBinaryFrame_s);
+	std::vector<CamIOBinaryFrame_s> frames(frameCount);
+	if (0 < frameCount && !ifs.read((char *)&frames[0], frameCount * sizeof(CamIOBinaryFrame_s)))
+		return false;
 
-			if (m_Ifs.bad())
-				return false;
+	m_Frames.resize(frameCount);
+	m_Quats.resize(frameCount);
+	for (size_t i = 0; i < frameCount; ++i)
+	{
+		CamIOBinaryFrame_s const & src = frames[i];
+		CamData & frame = m_Frames[i];
+		frame.Time = src.Time;
+		frame.XPosition = src.XPosition;
+		frame.YPosition = src.YPosition;
+		frame.ZPosition = src.ZPosition;
+		frame.XRotation = src.XRotation;
+		frame.YRotation = src.YRotation;
+		frame.ZRotation = src.ZRotation;
+		frame.Fov = src.Fov;
+		m_Quats[i] = Afx::Math::Quaternion::FromQREulerAngles(Afx::Math::QREulerAngles::FromQEulerAngles(Afx::Math::QEulerAngles(frame.YRotation, frame.ZRotation, frame.XRotation)));
+	}
 
-			if (m_Ifs.eof()) {
-				hiPos = curPos;
-				continue;
-			}
+	return true;
+}
 
-			if (ReadDataLine(curFrame)) {
-				float sub = (curFrame.Time - m_FirstFrameTime) - (time - m_StartTime);
-
-				if (sub == 0) {
-					m_CurPos = curPos;
-					m_LastFrame = curFrame;
-					break;
-				}
-				else if (sub > 0) {
-					hiPos = curPos;
-				}
-				else {
-					loPos = curPos;
-					m_CurPos = curPos;
-					m_LastFrame = curFrame;
-				}
-			}
-			
-			if (m_Ifs.bad())
-				return false;
-			
-			hiPos = curPos;
-		}
+CamImport::~CamImport()
+{
+}
 
-		m_LastQuat = Afx::Math::Quaternion::FromQREulerAngles(Afx::Math::QREulerAngles::FromQEulerAngles(Afx::Math::QEulerAngles(m_LastFrame.YRotation, m_LastFrame.ZRotation, m_LastFrame.XRotation)));
-		m_NextFrame = m_LastFrame;
-		m_NextQuat = m_LastQuat;
-	}
+bool CamImport::Save(wchar_t const * fileName, bool binary)
+{
+	if (m_Bad)
+		return false;
 
-	// Read next frame and Seek forward if required
+	std::ofstream ofs(fileName, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if (!ofs)
+		return false;
 
-	while (m_NextFrame.Time - m_FirstFrameTime < time - m_StartTime)
+	if (binary)
 	{
-		m_LastFrame = m_NextFrame;
-		m_LastQuat = m_NextQuat;
-		
-		m_CurPos = m_Ifs.tellg();
-		if (!ReadDataLine(m_NextFrame)) {
-			m_FinalFrameTime = m_LastFrame.Time;
-			m_HasFinalFrame = true;
-			return false;
-		}
-		m_NextQuat = Afx::Math::Quaternion::FromQREulerAngles(Afx::Math::QREulerAngles::FromQEulerAngles(Afx::Math::QEulerAngles(m_NextFrame.YRotation, m_NextFrame.ZRotation, m_NextFrame.XRotation)));
+		CamIO_WriteBinaryHeader(ofs, m_ScaleFov);
 
-		// Make sure we will travel the short way:
-		double dotProduct = DotProduct(m_NextQuat, m_LastQuat);
-		if (dotProduct<0.0)
+		for (std::vector<CamData>::const_iterator it = m_Frames.begin(); it != m_Frames.end(); ++it)
 		{
-			m_NextQuat = -1.0 * m_NextQuat;
+			CamIO_WriteBinaryFrame(ofs, *it, it->Fov);
 		}
 	}
+	else
+	{
+		CamIO_WriteTextHeader(ofs, m_ScaleFov);
 
-	double orgTime = time - m_StartTime + m_FirstFrameTime;
+		std::string line;
+		for (std::vector<CamData>::const_iterator it = m_Frames.begin(); it != m_Frames.end(); ++it)
+		{
+			double channels[] = { it->Time, it->XPosition, it->YPosition, it->ZPosition, it->XRotation, it->YRotation, it->ZRotation, it->Fov };
+
+			line.clear();
+			for (double channel : channels)
+			{
+				char buffer[32]; // Enough for any double.
+				std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), channel);
+				if (!line.empty()) line += ' ';
+				line.append(buffer, result.ptr);
+			}
+			line += '\n';
 
-	double delta = m_NextFrame.Time - m_LastFrame.Time;
-	double t = delta ? ((orgTime - m_LastFrame.Time) / delta) : 0;
+			ofs.write(line.data(), line.size());
+		}
+	}
 
-	Afx::Math::QEulerAngles rot = m_LastQuat.Slerp(m_NextQuat, t).ToQREulerAngles().ToQEulerAngles();
+	ofs.close();
 
-	outCamData.Time = time;
-	outCamData.XPosition = (1 - t) * m_LastFrame.XPosition + t * m_NextFrame.XPosition;
-	outCamData.YPosition = (1 - t) * m_LastFrame.YPosition + t * m_NextFrame.YPosition;
-	outCamData.ZPosition = (1 - t) * m_LastFrame.ZPosition + t * m_NextFrame.ZPosition;
-	outCamData.XRotation = rot.Roll;
-	outCamData.YRotation = rot.Pitch;
-	outCamData.ZRotation = rot.Yaw;
-	outCamData.Fov = (1 - t) * UndoFovScaling(width, height, m_LastFrame.Fov) + t * UndoFovScaling(width, height, m_NextFrame.Fov); // TODO: this maybe won't result in linear perception, maybe fix it when time.
+	return !ofs.fail();
+}
 
-	return true;
+void CamImport::SetStart(double startTime)
+{
+	m_StartTime = startTime;
 }
 
-bool CamImport::ReadDataLine(CamData & outCamData)
+size_t CamImport::FindNextFrame(double orgTime)
 {
-	std::string line;
+	size_t size = m_Frames.size();
+
+	// Try the frame from the last lookup and its successor first:
+	for (size_t i = m_Cursor; i < size && i <= m_Cursor + 1; ++i)
+	{
+		if ((0 == i || m_Frames[i - 1].Time < orgTime) && !(m_Frames[i].Time < orgTime))
+		{
+			m_Cursor = i;
+			return i;
+		}
+	}
 
-	if (!std::getline(m_Ifs, line, '\n'))
+	size_t result = std::lower_bound(m_Frames.begin(), m_Frames.end(), orgTime, [](CamData const & frame, double value) {
+		return frame.Time < value;
+	}) - m_Frames.begin();
+
+	if (result < size) m_Cursor = result;
+
+	return result;
+}
+
+bool CamImport::GetCamData(double time, double width, double height, CamData & outCamData)
+{
+	if (m_Bad || m_Frames.empty())
 		return false;
 
-	afx_std_string_remove_CR(line);
+	if (time - m_StartTime < 0)
+		return false; // too early
+
+	double orgTime = time - m_StartTime + m_Frames.front().Time;
+
+	// The first frame at or after orgTime and the one before it:
+	size_t nextIndex = FindNextFrame(orgTime);
+	if (m_Frames.size() <= nextIndex)
+		return false; // too late
+	size_t lastIndex = 0 < nextIndex ? nextIndex - 1 : 0;
+
+	CamData const & lastFrame = m_Frames[lastIndex];
+	CamData const & nextFrame = m_Frames[nextIndex];
+	Afx::Math::Quaternion const & lastQuat = m_Quats[lastIndex];
+	Afx::Math::Quaternion nextQuat = m_Quats[nextIndex];
+
+	// Make sure we will travel the short way:
+	double dotProduct = DotProduct(nextQuat, lastQuat);
+	if (dotProduct<0.0)
+	{
+		nextQuat = -1.0 * nextQuat;
+	}
 
-	std::istringstream iss(line);
+	double delta = nextFrame.Time - lastFrame.Time;
+	double t = delta ? ((orgTime - lastFrame.Time) / delta) : 0;
 
-	iss >> outCamData.Time >> outCamData.XPosition >> outCamData.YPosition >> outCamData.ZPosition >> outCamData.XRotation >> outCamData.YRotation >> outCamData.ZRotation >> outCamData.Fov;
+	Afx::Math::QEulerAngles rot = lastQuat.Slerp(nextQuat, t).ToQREulerAngles().ToQEulerAngles();
 
-	return !iss.fail();
+	outCamData.Time = time;
+	outCamData.XPosition = (1 - t) * lastFrame.XPosition + t * nextFrame.XPosition;
+	outCamData.YPosition = (1 - t) * lastFrame.YPosition + t * nextFrame.YPosition;
+	outCamData.ZPosition = (1 - t) * lastFrame.ZPosition + t * nextFrame.ZPosition;
+	outCamData.XRotation = rot.Roll;
+	outCamData.YRotation = rot.Pitch;
+	outCamData.ZRotation = rot.Yaw;
+	outCamData.Fov = (1 - t) * UndoFovScaling(width, height, lastFrame.Fov) + t * UndoFovScaling(width, height, nextFrame.Fov); // TODO: this maybe won't result in linear perception, maybe fix it when time.
+
+	return true;
 }
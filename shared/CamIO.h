@@ -1,11 +1,14 @@
 #pragma once
 
 #include "AfxMath.h"
+#include "AsyncFrameWriter.h"
 #include "FovScaling.h"
 
 #include <stdio.h>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <vector>
 
 
 class CamIO
@@ -41,10 +44,12 @@ protected:
 class CamExport : public CamIO
 {
 public:
-	CamExport(const wchar_t * fileName);
+	/// <param name="binary">Use the binary format (fixed-size records, smaller and faster to read) instead of text.</param>
+	CamExport(const wchar_t * fileName, bool binary = false);
 
 	~CamExport();
 
+	/// <remarks>Formatting and writing happens on a background thread.</remarks>
 	void WriteFrame(
 		double width, double height
 		, const CamData & camData
@@ -52,9 +57,15 @@ public:
 
 private:
 	std::ofstream m_Ofs;
+	bool m_Binary;
+	std::unique_ptr<advancedfx::CAsyncFrameWriter> m_Writer;
 };
 
-/// <remarks>Going back in time is very inefficient, you should avoid that or improve code for that.</remarks>
+/// <remarks>
+/// Reads both the text and the binary format (detected automatically).<br />
+/// All frames are parsed into memory on construction,
+/// so GetCamData does no I/O and seeking (also backwards) is O(log n), playing forward is O(1).
+/// </remarks>
 class CamImport : public CamIO
 {
 public:
@@ -67,21 +78,27 @@ public:
 	/// <remarks>If the function fails outCamData content is undefined.</remarks>
 	bool GetCamData(double time, double width, double height, CamData & outCamData);
 
-	bool IsBad() { return m_Ifs.bad(); }
+	bool IsBad() { return m_Bad; }
+
+	bool IsBinary() { return m_Binary; }
+
+	/// <summary>Saves the imported frames as they are, i.e. to convert between the text and binary format.</summary>
+	/// <remarks>The conversion is lossless, the text format is written with the shortest representation that reads back the same.</remarks>
+	bool Save(wchar_t const * fileName, bool binary);
 
 private:
-	std::ifstream m_Ifs;
+	bool m_Bad = false;
+	bool m_Binary = false;
 	double m_StartTime;
-	std::streampos m_DataStart;
-	std::streampos m_CurPos;
-	double m_FirstFrameTime;
-	bool m_HasLastFrame = false;
-	double m_FinalFrameTime;
-	bool m_HasFinalFrame = false;
-	CamData m_LastFrame;
-	Afx::Math::Quaternion m_LastQuat;
-	CamData m_NextFrame;
-	Afx::Math::Quaternion m_NextQuat;
-
-	bool ReadDataLine(CamData & outCamData);
+
+	// Frames in file order, with the rotation pre-converted for interpolation.
+	std::vector<CamData> m_Frames;
+	std::vector<Afx::Math::Quaternion> m_Quats;
+
+	// Index of the frame found by the last lookup, so playing forward doesn't need to search.
+	size_t m_Cursor = 0;
+
+	size_t FindNextFrame(double orgTime);
+
+	bool ReadBinary(std::ifstream & ifs);
 };
@@ -2,6 +2,8 @@
 
 #include "CamPath.h"
 
+#include "FileTools.h"
+
 #include "../deps/release/rapidxml/rapidxml.hpp"
 #include "../deps/release/rapidxml/rapidxml_print.hpp"
 #include <iterator>
@@ -11,6 +13,9 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include <float.h>
 
 #ifdef min
 #undef min
@@ -135,15 +140,6 @@ char const* CamPath::TangentMode_ToString(unsigned char value)
 
 CamPathValue::CamPathValue()
 : X(0.0), Y(0.0), Z(0.0), R(), Fov(90.0), Selected(false)
-, TxIn(0.0), TxOut(0.0), TxModeIn(0), TxModeOut(0)
-, TyIn(0.0), TyOut(0.0), TyModeIn(0), TyModeOut(0)
-, TzIn(0.0), TzOut(0.0), TzModeIn(0), TzModeOut(0)
-, TfovIn(0.0), TfovOut(0.0), TfovModeIn(0), TfovModeOut(0)
-, TxWIn(1.0), TxWOut(1.0), TyWIn(1.0), TyWOut(1.0), TzWIn(1.0), TzWOut(1.0), TfovWIn(1.0), TfovWOut(1.0)
-, TRxIn(0.0), TRxOut(0.0), TRxModeIn(0), TRxModeOut(0)
-, TRyIn(0.0), TRyOut(0.0), TRyModeIn(0), TRyModeOut(0)
-, TRzIn(0.0), TRzOut(0.0), TRzModeIn(0), TRzModeOut(0)
-, TRxWIn(1.0), TRxWOut(1.0), TRyWIn(1.0), TRyWOut(1.0), TRzWIn(1.0), TRzWOut(1.0)
 {
 }
 
@@ -154,32 +150,41 @@ CamPathValue::CamPathValue(double x, double y, double z, double pitch, double ya
 , R(Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(QEulerAngles(pitch,yaw,roll))))
 , Fov(fov)
 , Selected(false)
-, TxIn(0.0), TxOut(0.0), TxModeIn(0), TxModeOut(0)
-, TyIn(0.0), TyOut(0.0), TyModeIn(0), TyModeOut(0)
-, TzIn(0.0), TzOut(0.0), TzModeIn(0), TzModeOut(0)
-, TfovIn(0.0), TfovOut(0.0), TfovModeIn(0), TfovModeOut(0)
-, TxWIn(1.0), TxWOut(1.0), TyWIn(1.0), TyWOut(1.0), TzWIn(1.0), TzWOut(1.0), TfovWIn(1.0), TfovWOut(1.0)
-, TRxIn(0.0), TRxOut(0.0), TRxModeIn(0), TRxModeOut(0)
-, TRyIn(0.0), TRyOut(0.0), TRyModeIn(0), TRyModeOut(0)
-, TRzIn(0.0), TRzOut(0.0), TRzModeIn(0), TRzModeOut(0)
-, TRxWIn(1.0), TRxWOut(1.0), TRyWIn(1.0), TRyWOut(1.0), TRzWIn(1.0), TRzWOut(1.0)
 {
 }
 
 CamPathValue::CamPathValue(double x, double y, double z, double q_w, double q_x, double q_y, double q_z, double fov, bool selected)
 : X(x), Y(y), Z(z), R(Quaternion(q_w,q_x,q_y,q_z)), Fov(fov), Selected(selected)
-, TxIn(0.0), TxOut(0.0), TxModeIn(0), TxModeOut(0)
-, TyIn(0.0), TyOut(0.0), TyModeIn(0), TyModeOut(0)
-, TzIn(0.0), TzOut(0.0), TzModeIn(0), TzModeOut(0)
-, TfovIn(0.0), TfovOut(0.0), TfovModeIn(0), TfovModeOut(0)
-, TxWIn(1.0), TxWOut(1.0), TyWIn(1.0), TyWOut(1.0), TzWIn(1.0), TzWOut(1.0), TfovWIn(1.0), TfovWOut(1.0)
-, TRxIn(0.0), TRxOut(0.0), TRxModeIn(0), TRxModeOut(0)
-, TRyIn(0.0), TRyOut(0.0), TRyModeIn(0), TRyModeOut(0)
-, TRzIn(0.0), TRzOut(0.0), TRzModeIn(0), TRzModeOut(0)
-, TRxWIn(1.0), TRxWOut(1.0), TRyWIn(1.0), TRyWOut(1.0), TRzWIn(1.0), TRzWOut(1.0)
 {
 }
 
+bool CamPathTangents::IsDefault() const
+{
+	for(int i = 0; i < 7; ++i)
+	{
+		if(!Channels[i].IsDefault())
+			return false;
+	}
+	return true;
+}
+
+CamPathTangent const & CamPathValue::GetTangent(int channel) const
+{
+	static const CamPathTangent defaultTangent;
+
+	return Tangents ? Tangents->Channels[channel] : defaultTangent;
+}
+
+CamPathTangent & CamPathValue::EditTangent(int channel)
+{
+	if(!Tangents)
+		Tangents = std::make_shared<CamPathTangents>();
+	else if(1 < Tangents.use_count())
+		Tangents = std::make_shared<CamPathTangents>(*Tangents);
+
+	return Tangents->Channels[channel];
+}
+
 CamPathIterator::CamPathIterator(CInterpolationMap<CamPathValue>::const_iterator & it) : wrapped(it)
 {
 }
@@ -227,6 +232,8 @@ CamPath::CamPath()
 {
 	m_OnChangedIt = m_OnChanged.end();
 
+	OnChangedAdd(ArcLengthChanged, this);
+
 	m_XInterp = new CCubicDoubleInterpolation<CamPathValue>(&m_XView);
 	m_YInterp = new CCubicDoubleInterpolation<CamPathValue>(&m_YView);
 	m_ZInterp = new CCubicDoubleInterpolation<CamPathValue>(&m_ZView);
@@ -257,6 +264,16 @@ void CamPath::DoInterpolationMapChangedAll(void)
 	m_SelectedInterp->InterpolationMapChanged();
 }
 
+void CamPath::DoInterpolationMapValuesChangedAll(size_t first, size_t last)
+{
+	m_XInterp->InterpolationMapValuesChanged(first, last);
+	m_YInterp->InterpolationMapValuesChanged(first, last);
+	m_ZInterp->InterpolationMapValuesChanged(first, last);
+	m_RInterp->InterpolationMapValuesChanged(first, last);
+	m_FovInterp->InterpolationMapValuesChanged(first, last);
+	m_SelectedInterp->InterpolationMapValuesChanged(first, last);
+}
+
 void CamPath::Enabled_set(bool enable)
 {
 	m_Enabled = enable;
@@ -275,6 +292,18 @@ bool CamPath::GetHold(void) const
 void CamPath::SetHold(bool value)
 {
 	m_Hold = value;
+	Changed();
+}
+
+bool CamPath::GetConstantSpeed(void) const
+{
+	return m_ConstantSpeed;
+}
+
+void CamPath::SetConstantSpeed(bool value)
+{
+	m_ConstantSpeed = value;
+	Changed();
 }
 
 void CamPath::PositionInterpMethod_set(DoubleInterp value)
@@ -405,13 +434,52 @@ CamPath::DoubleInterp CamPath::FovInterpMethod_get(void) const
 
 void CamPath::Add(double time, const CamPathValue & value)
 {
-	m_Map[time] = value;
+	CInterpolationMap<CamPathValue>::iterator it = m_Map.find(time);
+	if(it != m_Map.end())
+	{
+		// Replacing a key's value keeps the keys and times, so allow local updates.
+		it->second = value;
+		size_t index = it - m_Map.begin();
+		DoInterpolationMapValuesChangedAll(index, index);
+	}
+	else
+	{
+		m_Map[time] = value;
+		DoInterpolationMapChangedAll();
+	}
+	Changed();
+}
+
+void CamPath::Add(std::vector<std::pair<double, CamPathValue>> const & keys)
+{
+	if(keys.empty())
+		return;
+
+	m_Map.reserve(m_Map.size() + keys.size());
+
+	for(std::vector<std::pair<double, CamPathValue>>::const_iterator it = keys.begin(); it != keys.end(); ++it)
+	{
+		m_Map[it->first] = it->second;
+	}
+
 	DoInterpolationMapChangedAll();
 	Changed();
 }
 
 void CamPath::Changed()
 {
+	if(m_HasUndoPending)
+	{
+		m_HasUndoPending = false;
+		m_UndoStack.emplace_back(std::move(m_UndoPending));
+		m_RedoStack.clear();
+	}
+	else if(!m_RestoringSnapshot)
+	{
+		// An edit without checkpoint (i.e. from a script) can't be undone on its own, but it invalidates what's to redo.
+		m_RedoStack.clear();
+	}
+
 	for(m_OnChangedIt = m_OnChanged.begin(); m_OnChangedIt != m_OnChanged.end(); m_OnChangedIt++) {
 		m_OnChangedIt->Notify();
 		if(m_OnChangedIt == m_OnChanged.end()) break;
@@ -429,19 +497,15 @@ void CamPath::Clear()
 {
 	bool selectAll = true;
 
-	CInterpolationMap<CamPathValue>::iterator last = m_Map.end();
 	for(CInterpolationMap<CamPathValue>::iterator it = m_Map.begin(); it != m_Map.end();)
 	{
-		CInterpolationMap<CamPathValue>::iterator itNext = it;
-		++itNext;
-
 		if(it->second.Selected)
 		{
 			selectAll = false;
-			m_Map.erase(it);
+			it = m_Map.erase(it);
 		}
-
-		it = itNext;
+		else
+			++it;
 	}
 
 	if(selectAll) m_Map.clear();
@@ -489,9 +553,16 @@ bool CamPath::CanEval(void) const
 }
 
 CamPathValue CamPath::Eval(double t)
+{
+	if(m_ConstantSpeed) t = ConstantSpeedTime(t);
+
+	return EvalCurve(t);
+}
+
+CamPathValue CamPath::EvalCurve(double t)
 {
 	CamPathValue val;
-	
+
 	val.X = m_XInterp->Eval(t);
 	val.Y = m_YInterp->Eval(t);
 	val.Z = m_ZInterp->Eval(t);
@@ -502,6 +573,32 @@ CamPathValue CamPath::Eval(double t)
 	return val;
 }
 
+void CamPath::EvalRange(double t0, double dt, size_t n, double * outX, double * outY, double * outZ, Quaternion * outR, double * outFov, bool * outSelected)
+{
+	if(m_ConstantSpeed)
+	{
+		// The re-mapped times are not evenly spaced anymore.
+		for(size_t i = 0; i < n; ++i)
+		{
+			double t = ConstantSpeedTime(t0 + i * dt);
+			if(outX) outX[i] = m_XInterp->Eval(t);
+			if(outY) outY[i] = m_YInterp->Eval(t);
+			if(outZ) outZ[i] = m_ZInterp->Eval(t);
+			if(outR) outR[i] = m_RInterp->Eval(t);
+			if(outFov) outFov[i] = m_FovInterp->Eval(t);
+			if(outSelected) outSelected[i] = m_SelectedInterp->Eval(t);
+		}
+		return;
+	}
+
+	if(outX) m_XInterp->EvalRange(t0, dt, n, outX);
+	if(outY) m_YInterp->EvalRange(t0, dt, n, outY);
+	if(outZ) m_ZInterp->EvalRange(t0, dt, n, outZ);
+	if(outR) m_RInterp->EvalRange(t0, dt, n, outR);
+	if(outFov) m_FovInterp->EvalRange(t0, dt, n, outFov);
+	if(outSelected) m_SelectedInterp->EvalRange(t0, dt, n, outSelected);
+}
+
 char * double2xml(rapidxml::xml_document<> & doc, double value)
 {
 	char szTmp[196];
@@ -509,6 +606,44 @@ char * double2xml(rapidxml::xml_document<> & doc, double value)
 	return doc.allocate_string(szTmp);
 }
 
+struct CamPathXmlTangentNames_s {
+	char const * In, * Out;
+	char const * ModeIn, * ModeOut;
+	char const * WIn, * WOut;
+};
+
+// Indexed by CamPath::Channel.
+static CamPathXmlTangentNames_s const c_CamPathXmlTangentNames[7] = {
+	{ "tx_in", "tx_out", "tx_mode_in", "tx_mode_out", "tx_w_in", "tx_w_out" },
+	{ "ty_in", "ty_out", "ty_mode_in", "ty_mode_out", "ty_w_in", "ty_w_out" },
+	{ "tz_in", "tz_out", "tz_mode_in", "tz_mode_out", "tz_w_in", "tz_w_out" },
+	{ "tfov_in", "tfov_out", "tfov_mode_in", "tfov_mode_out", "tfov_w_in", "tfov_w_out" },
+	{ "try_in", "try_out", "try_mode_in", "try_mode_out", "try_w_in", "try_w_out" },
+	{ "trz_in", "trz_out", "trz_mode_in", "trz_mode_out", "trz_w_in", "trz_w_out" },
+	{ "trx_in", "trx_out", "trx_mode_in", "trx_mode_out", "trx_w_in", "trx_w_out" }
+};
+
+static void LoadXmlTangents(rapidxml::xml_node<> * node, CamPathValue & value)
+{
+	CamPathTangents tangents;
+
+	for(int ch = 0; ch < 7; ++ch)
+	{
+		CamPathTangent & tangent = tangents.Channels[ch];
+		CamPathXmlTangentNames_s const & names = c_CamPathXmlTangentNames[ch];
+
+		if (rapidxml::xml_attribute<> * a = node->first_attribute(names.In)) tangent.In = atof(a->value());
+		if (rapidxml::xml_attribute<> * a = node->first_attribute(names.Out)) tangent.Out = atof(a->value());
+		if (rapidxml::xml_attribute<> * a = node->first_attribute(names.ModeIn)) CamPath::TangentMode_FromString(a->value(), tangent.ModeIn);
+		if (rapidxml::xml_attribute<> * a = node->first_attribute(names.ModeOut)) CamPath::TangentMode_FromString(a->value(), tangent.ModeOut);
+		if (rapidxml::xml_attribute<> * a = node->first_attribute(names.WIn)) tangent.WIn = atof(a->value());
+		if (rapidxml::xml_attribute<> * a = node->first_attribute(names.WOut)) tangent.WOut = atof(a->value());
+	}
+
+	// Keys without custom tangents don't need a tangent block at all.
+	value.Tangents = tangents.IsDefault() ? nullptr : std::make_shared<CamPathTangents>(tangents);
+}
+
 bool CamPath::Save(wchar_t const * fileName)
 {
 	rapidxml::xml_document<> doc;
@@ -529,6 +664,8 @@ bool CamPath::Save(wchar_t const * fileName)
 		cam->append_attribute(doc.allocate_attribute("offset", double2xml(doc, m_Offset)));
 	if (m_Hold)
 		cam->append_attribute(doc.allocate_attribute("hold"));
+	if (m_ConstantSpeed)
+		cam->append_attribute(doc.allocate_attribute("constantSpeed"));
 	doc.append_node(cam);
 
 	rapidxml::xml_node<> * pts = doc.allocate_node(rapidxml::node_element, "points");
@@ -565,59 +702,35 @@ bool CamPath::Save(wchar_t const * fileName)
 		pt->append_attribute(doc.allocate_attribute("qz", double2xml(doc,it.wrapped->second.R.Z)));
 
 		// Tangents and modes (optional; always saved for completeness)
-		pt->append_attribute(doc.allocate_attribute("tx_in", double2xml(doc, it.wrapped->second.TxIn)));
-		pt->append_attribute(doc.allocate_attribute("tx_out", double2xml(doc, it.wrapped->second.TxOut)));
-		pt->append_attribute(doc.allocate_attribute("tx_mode_in", doc.allocate_string(TangentMode_ToString(it.wrapped->second.TxModeIn))));
-		pt->append_attribute(doc.allocate_attribute("tx_mode_out", doc.allocate_string(TangentMode_ToString(it.wrapped->second.TxModeOut))));
-
-		pt->append_attribute(doc.allocate_attribute("ty_in", double2xml(doc, it.wrapped->second.TyIn)));
-		pt->append_attribute(doc.allocate_attribute("ty_out", double2xml(doc, it.wrapped->second.TyOut)));
-		pt->append_attribute(doc.allocate_attribute("ty_mode_in", doc.allocate_string(TangentMode_ToString(it.wrapped->second.TyModeIn))));
-		pt->append_attribute(doc.allocate_attribute("ty_mode_out", doc.allocate_string(TangentMode_ToString(it.wrapped->second.TyModeOut))));
-
-		pt->append_attribute(doc.allocate_attribute("tz_in", double2xml(doc, it.wrapped->second.TzIn)));
-		pt->append_attribute(doc.allocate_attribute("tz_out", double2xml(doc, it.wrapped->second.TzOut)));
-		pt->append_attribute(doc.allocate_attribute("tz_mode_in", doc.allocate_string(TangentMode_ToString(it.wrapped->second.TzModeIn))));
-		pt->append_attribute(doc.allocate_attribute("tz_mode_out", doc.allocate_string(TangentMode_ToString(it.wrapped->second.TzModeOut))));
-
-		pt->append_attribute(doc.allocate_attribute("tfov_in", double2xml(doc, it.wrapped->second.TfovIn)));
-		pt->append_attribute(doc.allocate_attribute("tfov_out", double2xml(doc, it.wrapped->second.TfovOut)));
-		pt->append_attribute(doc.allocate_attribute("tfov_mode_in", doc.allocate_string(TangentMode_ToString(it.wrapped->second.TfovModeIn))));
-		pt->append_attribute(doc.allocate_attribute("tfov_mode_out", doc.allocate_string(TangentMode_ToString(it.wrapped->second.TfovModeOut))));
-
-		pt->append_attribute(doc.allocate_attribute("tx_w_in",  double2xml(doc, it.wrapped->second.TxWIn)));
-		pt->append_attribute(doc.allocate_attribute("tx_w_out", double2xml(doc, it.wrapped->second.TxWOut)));
-
-		pt->append_attribute(doc.allocate_attribute("ty_w_in",  double2xml(doc, it.wrapped->second.TyWIn)));
-		pt->append_attribute(doc.allocate_attribute("ty_w_out", double2xml(doc, it.wrapped->second.TyWOut)));
-
-		pt->append_attribute(doc.allocate_attribute("tz_w_in",  double2xml(doc, it.wrapped->second.TzWIn)));
-		pt->append_attribute(doc.allocate_attribute("tz_w_out", double2xml(doc, it.wrapped->second.TzWOut)));
-
-		pt->append_attribute(doc.allocate_attribute("tfov_w_in",  double2xml(doc, it.wrapped->second.TfovWIn)));
-		pt->append_attribute(doc.allocate_attribute("tfov_w_out", double2xml(doc, it.wrapped->second.TfovWOut)));
+		for(int ch = CH_X; ch <= CH_FOV; ++ch)
+		{
+			CamPathTangent const & tangent = val.GetTangent(ch);
+			CamPathXmlTangentNames_s const & names = c_CamPathXmlTangentNames[ch];
+			pt->append_attribute(doc.allocate_attribute(names.In, double2xml(doc, tangent.In)));
+			pt->append_attribute(doc.allocate_attribute(names.Out, double2xml(doc, tangent.Out)));
+			pt->append_attribute(doc.allocate_attribute(names.ModeIn, doc.allocate_string(TangentMode_ToString(tangent.ModeIn))));
+			pt->append_attribute(doc.allocate_attribute(names.ModeOut, doc.allocate_string(TangentMode_ToString(tangent.ModeOut))));
+		}
+		for(int ch = CH_X; ch <= CH_FOV; ++ch)
+		{
+			CamPathTangent const & tangent = val.GetTangent(ch);
+			CamPathXmlTangentNames_s const & names = c_CamPathXmlTangentNames[ch];
+			pt->append_attribute(doc.allocate_attribute(names.WIn, double2xml(doc, tangent.WIn)));
+			pt->append_attribute(doc.allocate_attribute(names.WOut, double2xml(doc, tangent.WOut)));
+		}
 
 		// Rotation (Euler) tangent data for custom rotation interpolation
-		pt->append_attribute(doc.allocate_attribute("trx_in",  double2xml(doc, it.wrapped->second.TRxIn)));
-		pt->append_attribute(doc.allocate_attribute("trx_out", double2xml(doc, it.wrapped->second.TRxOut)));
-		pt->append_attribute(doc.allocate_attribute("trx_mode_in",  doc.allocate_string(TangentMode_ToString(it.wrapped->second.TRxModeIn))));
-		pt->append_attribute(doc.allocate_attribute("trx_mode_out", doc.allocate_string(TangentMode_ToString(it.wrapped->second.TRxModeOut))));
-		pt->append_attribute(doc.allocate_attribute("trx_w_in",  double2xml(doc, it.wrapped->second.TRxWIn)));
-		pt->append_attribute(doc.allocate_attribute("trx_w_out", double2xml(doc, it.wrapped->second.TRxWOut)));
-
-		pt->append_attribute(doc.allocate_attribute("try_in",  double2xml(doc, it.wrapped->second.TRyIn)));
-		pt->append_attribute(doc.allocate_attribute("try_out", double2xml(doc, it.wrapped->second.TRyOut)));
-		pt->append_attribute(doc.allocate_attribute("try_mode_in",  doc.allocate_string(TangentMode_ToString(it.wrapped->second.TRyModeIn))));
-		pt->append_attribute(doc.allocate_attribute("try_mode_out", doc.allocate_string(TangentMode_ToString(it.wrapped->second.TRyModeOut))));
-		pt->append_attribute(doc.allocate_attribute("try_w_in",  double2xml(doc, it.wrapped->second.TRyWIn)));
-		pt->append_attribute(doc.allocate_attribute("try_w_out", double2xml(doc, it.wrapped->second.TRyWOut)));
-
-		pt->append_attribute(doc.allocate_attribute("trz_in",  double2xml(doc, it.wrapped->second.TRzIn)));
-		pt->append_attribute(doc.allocate_attribute("trz_out", double2xml(doc, it.wrapped->second.TRzOut)));
-		pt->append_attribute(doc.allocate_attribute("trz_mode_in",  doc.allocate_string(TangentMode_ToString(it.wrapped->second.TRzModeIn))));
-		pt->append_attribute(doc.allocate_attribute("trz_mode_out", doc.allocate_string(TangentMode_ToString(it.wrapped->second.TRzModeOut))));
-		pt->append_attribute(doc.allocate_attribute("trz_w_in",  double2xml(doc, it.wrapped->second.TRzWIn)));
-		pt->append_attribute(doc.allocate_attribute("trz_w_out", double2xml(doc, it.wrapped->second.TRzWOut)));
+		for(int ch : { CH_RROLL, CH_RPITCH, CH_RYAW })
+		{
+			CamPathTangent const & tangent = val.GetTangent(ch);
+			CamPathXmlTangentNames_s const & names = c_CamPathXmlTangentNames[ch];
+			pt->append_attribute(doc.allocate_attribute(names.In, double2xml(doc, tangent.In)));
+			pt->append_attribute(doc.allocate_attribute(names.Out, double2xml(doc, tangent.Out)));
+			pt->append_attribute(doc.allocate_attribute(names.ModeIn, doc.allocate_string(TangentMode_ToString(tangent.ModeIn))));
+			pt->append_attribute(doc.allocate_attribute(names.ModeOut, doc.allocate_string(TangentMode_ToString(tangent.ModeOut))));
+			pt->append_attribute(doc.allocate_attribute(names.WIn, double2xml(doc, tangent.WIn)));
+			pt->append_attribute(doc.allocate_attribute(names.WOut, double2xml(doc, tangent.WOut)));
+		}
 
 
 
@@ -647,27 +760,226 @@ bool CamPath::Save(wchar_t const * fileName)
 	return bOk;
 }
 
-bool CamPath::Load(wchar_t const * fileName)
+// Binary campath format //////////////////////////////////////////////////////
+//
+// Little-endian, fixed-size records:
+// CamPathBinaryHeader_s, then KeyCount times CamPathBinaryKey_s (ascending T)
+// and if CPBF_Tangents is set KeyCount times CamPathBinaryTangents_s.
+
+static char const c_CamPathBinaryMagic[8] = { 'a', 'f', 'x', 'C', 'P', 'a', 't', 'h' };
+static uint32_t const c_CamPathBinaryVersion = 1;
+
+enum CamPathBinaryFlags_e : uint32_t {
+	CPBF_Hold = 1 << 0,
+	CPBF_ConstantSpeed = 1 << 1,
+	CPBF_Tangents = 1 << 2
+};
+
+struct CamPathBinaryHeader_s {
+	char Magic[8];
+	uint32_t Version;
+	uint32_t Flags; // CamPathBinaryFlags_e
+	uint8_t PositionInterp;
+	uint8_t RotationInterp;
+	uint8_t FovInterp;
+	uint8_t Reserved;
+	uint32_t KeyCount;
+	double Offset;
+};
+static_assert(sizeof(CamPathBinaryHeader_s) == 32, "Unexpected CamPathBinaryHeader_s layout.");
+
+struct CamPathBinaryKey_s {
+	double T;
+	double X, Y, Z;
+	double QW, QX, QY, QZ;
+	double Fov;
+	uint8_t Selected;
+	uint8_t Reserved[7];
+};
+static_assert(sizeof(CamPathBinaryKey_s) == 80, "Unexpected CamPathBinaryKey_s layout.");
+
+struct CamPathBinaryTangent_s {
+	double In, Out;
+	double WIn, WOut;
+	uint8_t ModeIn, ModeOut;
+	uint8_t Reserved[6];
+};
+static_assert(sizeof(CamPathBinaryTangent_s) == 40, "Unexpected CamPathBinaryTangent_s layout.");
+
+struct CamPathBinaryTangents_s {
+	CamPathBinaryTangent_s Channels[7]; // Indexed by CamPath::Channel.
+};
+
+bool CamPath::SaveBinary(wchar_t const * fileName)
 {
-	bool bOk = false;
+	CamPathBinaryHeader_s header = {};
+	memcpy(header.Magic, c_CamPathBinaryMagic, sizeof(header.Magic));
+	header.Version = c_CamPathBinaryVersion;
+	header.Flags = (m_Hold ? CPBF_Hold : 0) | (m_ConstantSpeed ? CPBF_ConstantSpeed : 0);
+	header.PositionInterp = (uint8_t)m_PositionInterpMethod;
+	header.RotationInterp = (uint8_t)m_RotationInterpMethod;
+	header.FovInterp = (uint8_t)m_FovInterpMethod;
+	header.KeyCount = (uint32_t)m_Map.size();
+	header.Offset = m_Offset;
+
+	std::vector<CamPathBinaryKey_s> keys(m_Map.size());
+	std::vector<CamPathBinaryTangents_s> tangents(m_Map.size());
+
+	size_t i = 0;
+	for(CInterpolationMap<CamPathValue>::iterator it = m_Map.begin(); it != m_Map.end(); ++it, ++i)
+	{
+		CamPathValue & val = it->second;
+
+		CamPathBinaryKey_s & key = keys[i];
+		memset(&key, 0, sizeof(key));
+		key.T = it->first;
+		key.X = val.X;
+		key.Y = val.Y;
+		key.Z = val.Z;
+		key.QW = val.R.W;
+		key.QX = val.R.X;
+		key.QY = val.R.Y;
+		key.QZ = val.R.Z;
+		key.Fov = val.Fov;
+		key.Selected = val.Selected ? 1 : 0;
+
+		// Only store the tangent section if any key has custom tangents.
+		if(val.Tangents && !val.Tangents->IsDefault())
+			header.Flags |= CPBF_Tangents;
+
+		for(int ch = 0; ch < 7; ++ch)
+		{
+			CamPathTangent const & src = val.GetTangent(ch);
+			CamPathBinaryTangent_s & tangent = tangents[i].Channels[ch];
+			memset(&tangent, 0, sizeof(tangent));
+			tangent.In = src.In;
+			tangent.Out = src.Out;
+			tangent.WIn = src.WIn;
+			tangent.WOut = src.WOut;
+			tangent.ModeIn = src.ModeIn;
+			tangent.ModeOut = src.ModeOut;
+		}
+	}
 
-	FILE * pFile = 0;
+	FILE * pFile = nullptr;
+	_wfopen_s(&pFile, fileName, L"wb");
+	if(!pFile)
+		return false;
 
-	_wfopen_s(&pFile, fileName, L"rb");
+	bool bOk = 1 == fwrite(&header, sizeof(header), 1, pFile);
+	if(bOk && !keys.empty())
+	{
+		bOk = keys.size() == fwrite(&keys[0], sizeof(CamPathBinaryKey_s), keys.size(), pFile);
+		if(bOk && (header.Flags & CPBF_Tangents))
+			bOk = tangents.size() == fwrite(&tangents[0], sizeof(CamPathBinaryTangents_s), tangents.size(), pFile);
+	}
 
+	if(0 != fclose(pFile))
+		bOk = false;
+
+	return bOk;
+}
+
+bool CamPath::IsBinaryFile(wchar_t const * fileName)
+{
+	FILE * pFile = nullptr;
+	_wfopen_s(&pFile, fileName, L"rb");
 	if(!pFile)
 		return false;
-	
-	fseek(pFile, 0, SEEK_END);
-	size_t fileSize = ftell(pFile);
-	rewind(pFile);
 
-	char * pData = new char[fileSize+1];
-	pData[fileSize] = 0;
+	char magic[sizeof(c_CamPathBinaryMagic)];
+	bool bOk = 1 == fread(magic, sizeof(magic), 1, pFile) && 0 == memcmp(magic, c_CamPathBinaryMagic, sizeof(magic));
+
+	fclose(pFile);
+
+	return bOk;
+}
+
+bool CamPath::LoadBinary(unsigned char const * pData, size_t dataSize)
+{
+	CamPathBinaryHeader_s header;
+	if(dataSize < sizeof(header))
+		return false;
+
+	memcpy(&header, pData, sizeof(header));
+	if(0 != memcmp(header.Magic, c_CamPathBinaryMagic, sizeof(header.Magic)) || c_CamPathBinaryVersion < header.Version)
+		return false;
+
+	size_t recordSize = sizeof(CamPathBinaryKey_s) + ((header.Flags & CPBF_Tangents) ? sizeof(CamPathBinaryTangents_s) : 0);
+	if((dataSize - sizeof(header)) / recordSize < header.KeyCount)
+		return false;
+
+	unsigned char const * pKeys = pData + sizeof(header);
+	unsigned char const * pTangents = pKeys + header.KeyCount * sizeof(CamPathBinaryKey_s);
+
+	// Clear current Campath:
+	SelectNone();
+	Clear();
+
+	PositionInterpMethod_set(header.PositionInterp < _DI_COUNT ? (DoubleInterp)header.PositionInterp : DI_DEFAULT);
+	RotationInterpMethod_set(header.RotationInterp < _QI_COUNT ? (QuaternionInterp)header.RotationInterp : QI_DEFAULT);
+	FovInterpMethod_set(header.FovInterp < _DI_COUNT ? (DoubleInterp)header.FovInterp : DI_DEFAULT);
+	SetOffset(header.Offset);
+	SetHold(0 != (header.Flags & CPBF_Hold));
+	SetConstantSpeed(0 != (header.Flags & CPBF_ConstantSpeed));
+
+	m_Map.reserve(header.KeyCount);
+
+	for(uint32_t i = 0; i < header.KeyCount; ++i)
+	{
+		CamPathBinaryKey_s key;
+		memcpy(&key, pKeys + i * sizeof(key), sizeof(key));
+
+		CamPathValue r(key.X, key.Y, key.Z, key.QW, key.QX, key.QY, key.QZ, key.Fov, 0 != key.Selected);
+
+		if(header.Flags & CPBF_Tangents)
+		{
+			CamPathBinaryTangents_s tangents;
+			memcpy(&tangents, pTangents + i * sizeof(tangents), sizeof(tangents));
+
+			CamPathTangents value;
+			for(int ch = 0; ch < 7; ++ch)
+			{
+				CamPathBinaryTangent_s const & tangent = tangents.Channels[ch];
+				CamPathTangent & dst = value.Channels[ch];
+				dst.In = tangent.In;
+				dst.Out = tangent.Out;
+				dst.WIn = tangent.WIn;
+				dst.WOut = tangent.WOut;
+				dst.ModeIn = tangent.ModeIn;
+				dst.ModeOut = tangent.ModeOut;
+			}
+			if(!value.IsDefault())
+				r.Tangents = std::make_shared<CamPathTangents>(value);
+		}
+
+		// Add point (appends if keys are in order as written by SaveBinary):
+		m_Map[key.T] = r;
+	}
+
+	DoInterpolationMapChangedAll();
+	Changed();
+
+	return true;
+}
+
+bool CamPath::Load(wchar_t const * fileName)
+{
+	CMappedFile mappedFile;
+	if(!mappedFile.Open(fileName))
+		return false;
+
+	if(sizeof(c_CamPathBinaryMagic) <= mappedFile.GetSize() && 0 == memcmp(mappedFile.GetData(), c_CamPathBinaryMagic, sizeof(c_CamPathBinaryMagic)))
+		return LoadBinary(mappedFile.GetData(), mappedFile.GetSize());
 
-	size_t readSize = fread(pData, sizeof(char), fileSize, pFile);
-	bOk = readSize == fileSize;
-	if(bOk)
+	// rapidxml parses in place, so it needs a writable zero terminated copy of the view.
+	std::vector<char> data(mappedFile.GetData(), mappedFile.GetData() + mappedFile.GetSize());
+	data.push_back(0);
+	char * pData = &data[0];
+
+	mappedFile.Close();
+
+	bool bOk = true;
 	{
 		try
 		{
@@ -706,6 +1018,9 @@ bool CamPath::Load(wchar_t const * fileName)
 				bool bHold = nullptr != holdA;
 				SetHold(bHold);
 
+				rapidxml::xml_attribute<> * constantSpeedA = cur_node->first_attribute("constantSpeed");
+				SetConstantSpeed(nullptr != constantSpeedA);
+
 				cur_node = cur_node->first_node("points");
 				if(!cur_node) break;
 
@@ -747,127 +1062,7 @@ bool CamPath::Load(wchar_t const * fileName)
 						r.Selected = 0 != selectedA;
 
 						// Optional tangents/modes
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tx_in")) r.TxIn = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tx_out")) r.TxOut = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tx_mode_in")) TangentMode_FromString(a->value(), r.TxModeIn);
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tx_mode_out")) TangentMode_FromString(a->value(), r.TxModeOut);
-
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("ty_in")) r.TyIn = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("ty_out")) r.TyOut = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("ty_mode_in")) TangentMode_FromString(a->value(), r.TyModeIn);
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("ty_mode_out")) TangentMode_FromString(a->value(), r.TyModeOut);
-
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tz_in")) r.TzIn = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tz_out")) r.TzOut = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tz_mode_in")) TangentMode_FromString(a->value(), r.TzModeIn);
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tz_mode_out")) TangentMode_FromString(a->value(), r.TzModeOut);
-
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tfov_in")) r.TfovIn = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tfov_out")) r.TfovOut = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tfov_mode_in")) TangentMode_FromString(a->value(), r.TfovModeIn);
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tfov_mode_out")) TangentMode_FromString(a->value(), r.TfovModeOut);
-
-						if (auto* a = cur_node->first_attribute("tx_w_in"))   r.TxWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("tx_w_out"))  r.TxWOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("ty_w_in"))   r.TyWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("ty_w_out"))  r.TyWOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("tz_w_in"))   r.TzWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("tz_w_out"))  r.TzWOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("tfov_w_in"))  r.TfovWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("tfov_w_out")) r.TfovWOut = atof(a->value());
-
-						// Rotation (Euler) tangents / modes / weights (optional)
-						if (auto* a = cur_node->first_attribute("trx_in"))  r.TRxIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trx_out")) r.TRxOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trx_mode_in"))  TangentMode_FromString(a->value(), r.TRxModeIn);
-						if (auto* a = cur_node->first_attribute("trx_mode_out")) TangentMode_FromString(a->value(), r.TRxModeOut);
-						if (auto* a = cur_node->first_attribute("trx_w_in"))  r.TRxWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trx_w_out")) r.TRxWOut = atof(a->value());
-
-						if (auto* a = cur_node->first_attribute("try_in"))  r.TRyIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("try_out")) r.TRyOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("try_mode_in"))  TangentMode_FromString(a->value(), r.TRyModeIn);
-						if (auto* a = cur_node->first_attribute("try_mode_out")) TangentMode_FromString(a->value(), r.TRyModeOut);
-						if (auto* a = cur_node->first_attribute("try_w_in"))  r.TRyWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("try_w_out")) r.TRyWOut = atof(a->value());
-
-						if (auto* a = cur_node->first_attribute("trz_in"))  r.TRzIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trz_out")) r.TRzOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trz_mode_in"))  TangentMode_FromString(a->value(), r.TRzModeIn);
-						if (auto* a = cur_node->first_attribute("trz_mode_out")) TangentMode_FromString(a->value(), r.TRzModeOut);
-						if (auto* a = cur_node->first_attribute("trz_w_in"))  r.TRzWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trz_w_out")) r.TRzWOut = atof(a->value());
-
-
-						// Add point:
-						m_Map[dT] = r;
-					}
-					else
-					{
-						double dRXroll = rxA ? atof(rxA->value()) : 0.0;
-						double dRYpitch = ryA ? atof(ryA->value()) : 0.0;
-						double dRZyaw = rzA ? atof(rzA->value()) : 0.0;
-
-						CamPathValue r;
-						r.X = dX;
-						r.Y = dY;
-						r.Z = dZ;
-						r.R = Quaternion::FromQREulerAngles(QREulerAngles::FromQEulerAngles(QEulerAngles(dRYpitch, dRZyaw, dRXroll)));
-						r.Fov = dFov;
-						r.Selected = 0 != selectedA;
-
-						// Optional tangents/modes
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tx_in")) r.TxIn = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tx_out")) r.TxOut = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tx_mode_in")) TangentMode_FromString(a->value(), r.TxModeIn);
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tx_mode_out")) TangentMode_FromString(a->value(), r.TxModeOut);
-
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("ty_in")) r.TyIn = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("ty_out")) r.TyOut = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("ty_mode_in")) TangentMode_FromString(a->value(), r.TyModeIn);
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("ty_mode_out")) TangentMode_FromString(a->value(), r.TyModeOut);
-
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tz_in")) r.TzIn = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tz_out")) r.TzOut = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tz_mode_in")) TangentMode_FromString(a->value(), r.TzModeIn);
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tz_mode_out")) TangentMode_FromString(a->value(), r.TzModeOut);
-
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tfov_in")) r.TfovIn = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tfov_out")) r.TfovOut = atof(a->value());
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tfov_mode_in")) TangentMode_FromString(a->value(), r.TfovModeIn);
-						if (rapidxml::xml_attribute<> * a = cur_node->first_attribute("tfov_mode_out")) TangentMode_FromString(a->value(), r.TfovModeOut);
-
-						if (auto* a = cur_node->first_attribute("tx_w_in"))   r.TxWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("tx_w_out"))  r.TxWOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("ty_w_in"))   r.TyWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("ty_w_out"))  r.TyWOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("tz_w_in"))   r.TzWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("tz_w_out"))  r.TzWOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("tfov_w_in"))  r.TfovWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("tfov_w_out")) r.TfovWOut = atof(a->value());
-
-						// Rotation (Euler) tangents / modes / weights (optional)
-						if (auto* a = cur_node->first_attribute("trx_in"))  r.TRxIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trx_out")) r.TRxOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trx_mode_in"))  TangentMode_FromString(a->value(), r.TRxModeIn);
-						if (auto* a = cur_node->first_attribute("trx_mode_out")) TangentMode_FromString(a->value(), r.TRxModeOut);
-						if (auto* a = cur_node->first_attribute("trx_w_in"))  r.TRxWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trx_w_out")) r.TRxWOut = atof(a->value());
-
-						if (auto* a = cur_node->first_attribute("try_in"))  r.TRyIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("try_out")) r.TRyOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("try_mode_in"))  TangentMode_FromString(a->value(), r.TRyModeIn);
-						if (auto* a = cur_node->first_attribute("try_mode_out")) TangentMode_FromString(a->value(), r.TRyModeOut);
-
-						if (auto* a = cur_node->first_attribute("try_w_in"))  r.TRyWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("try_w_out")) r.TRyWOut = atof(a->value());
-
-						if (auto* a = cur_node->first_attribute("trz_in"))  r.TRzIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trz_out")) r.TRzOut = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trz_mode_in"))  TangentMode_FromString(a->value(), r.TRzModeIn);
-						if (auto* a = cur_node->first_attribute("trz_mode_out")) TangentMode_FromString(a->value(), r.TRzModeOut);
-						if (auto* a = cur_node->first_attribute("trz_w_in"))  r.TRzWIn = atof(a->value());
-						if (auto* a = cur_node->first_attribute("trz_w_out")) r.TRzWOut = atof(a->value());
+						LoadXmlTangents(cur_node, r);
 
 
 						// Add point:
@@ -883,10 +1078,6 @@ bool CamPath::Load(wchar_t const * fileName)
 		}
 	}
 
-	delete pData;
-
-	fclose(pFile);
-
 	DoInterpolationMapChangedAll();
 	Changed();
 
@@ -1150,9 +1341,10 @@ void CamPath::SetPosition(double x, double y, double z, bool setX, bool setY, bo
 	double y0 = (maxY +minY) / 2;
 	double z0 = (maxZ +minZ) / 2;
 
+	CInterpolationDirtyRange changed;
+
 	for(CInterpolationMap<CamPathValue>::iterator it = m_Map.begin(); it != m_Map.end(); ++it)
 	{
-		double curT = it->first;
 		CamPathValue curValue = it->second;
 
 		if(selectAll || curValue.Selected)
@@ -1162,12 +1354,13 @@ void CamPath::SetPosition(double x, double y, double z, bool setX, bool setY, bo
 			if(setZ) curValue.Z = z +(curValue.Z -z0);
 
 			it->second = curValue;
+			changed.Add(it - m_Map.begin());
 		}
 	}
 
-	m_XInterp->InterpolationMapChanged();
-	m_YInterp->InterpolationMapChanged();
-	m_ZInterp->InterpolationMapChanged();
+	m_XInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+	m_YInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+	m_ZInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
 
 	Changed();
 }
@@ -1190,9 +1383,10 @@ void CamPath::SetAngles(double yPitch, double zYaw, double xRoll, bool setY, boo
 		}
 	}
 
+	CInterpolationDirtyRange changed;
+
 	for(CInterpolationMap<CamPathValue>::iterator it = m_Map.begin(); it != m_Map.end(); ++it)
 	{
-		double curT = it->first;
 		CamPathValue curValue = it->second;
 
 		if(selectAll || curValue.Selected)
@@ -1209,11 +1403,12 @@ void CamPath::SetAngles(double yPitch, double zYaw, double xRoll, bool setY, boo
 			}
 
 			it->second = curValue;
+			changed.Add(it - m_Map.begin());
 		}
 
 	}
 
-	m_RInterp->InterpolationMapChanged();
+	m_RInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
 
 	Changed();
 }
@@ -1236,9 +1431,10 @@ void CamPath::SetFov(double fov)
 		}
 	}
 
+	CInterpolationDirtyRange changed;
+
 	for(CInterpolationMap<CamPathValue>::iterator it = m_Map.begin(); it != m_Map.end(); ++it)
 	{
-		double curT = it->first;
 		CamPathValue curValue = it->second;
 
 		if(selectAll || curValue.Selected)
@@ -1246,11 +1442,12 @@ void CamPath::SetFov(double fov)
 			curValue.Fov = fov;
 
 			it->second = curValue;
+			changed.Add(it - m_Map.begin());
 		}
 
 	}
 
-	m_FovInterp->InterpolationMapChanged();
+	m_FovInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
 
 	Changed();
 }
@@ -1265,43 +1462,16 @@ void CamPath::SetTangent(Channel ch, bool setIn, bool setOut, double slopeIn, do
         if (itc->second.Selected) { selectAll = false; break; }
     }
 
+    CInterpolationDirtyRange changed;
+
     for (CInterpolationMap<CamPathValue>::iterator it = m_Map.begin(); it != m_Map.end(); ++it)
     {
-        CamPathValue cur = it->second;
-        if (selectAll || cur.Selected)
+        if (selectAll || it->second.Selected)
         {
-            switch (ch)
-            {
-            case CH_X:
-                if (setIn)  cur.TxIn = slopeIn;
-                if (setOut) cur.TxOut = slopeOut;
-                break;
-            case CH_Y:
-                if (setIn)  cur.TyIn = slopeIn;
-                if (setOut) cur.TyOut = slopeOut;
-                break;
-            case CH_Z:
-                if (setIn)  cur.TzIn = slopeIn;
-                if (setOut) cur.TzOut = slopeOut;
-                break;
-            case CH_FOV:
-                if (setIn)  cur.TfovIn = slopeIn;
-                if (setOut) cur.TfovOut = slopeOut;
-                break;
-            case CH_RPITCH:
-                if (setIn)  cur.TRyIn = slopeIn;
-                if (setOut) cur.TRyOut = slopeOut;
-                break;
-            case CH_RYAW:
-                if (setIn)  cur.TRzIn = slopeIn;
-                if (setOut) cur.TRzOut = slopeOut;
-                break;
-            case CH_RROLL:
-                if (setIn)  cur.TRxIn = slopeIn;
-                if (setOut) cur.TRxOut = slopeOut;
-                break;
-            }
-            it->second = cur;
+            CamPathTangent & tangent = it->second.EditTangent(ch);
+            if (setIn)  tangent.In = slopeIn;
+            if (setOut) tangent.Out = slopeOut;
+            changed.Add(it - m_Map.begin());
         }
     }
 
@@ -1310,19 +1480,19 @@ void CamPath::SetTangent(Channel ch, bool setIn, bool setOut, double slopeIn, do
     {
         if (m_PositionInterpMethod == DI_CUSTOM)
         {
-            m_XInterp->InterpolationMapChanged();
-            m_YInterp->InterpolationMapChanged();
-            m_ZInterp->InterpolationMapChanged();
+            m_XInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+            m_YInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+            m_ZInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
         }
     }
     if (ch == CH_FOV && m_FovInterpMethod == DI_CUSTOM)
     {
-        m_FovInterp->InterpolationMapChanged();
+        m_FovInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
     }
     // rotation custom -> update
     if ((ch == CH_RPITCH || ch == CH_RYAW || ch == CH_RROLL) && m_RotationInterpMethod == QI_CUSTOM)
     {
-        m_RInterp->InterpolationMapChanged();
+        m_RInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
     }
 
     Changed();
@@ -1338,43 +1508,16 @@ void CamPath::SetTangentMode(Channel ch, bool setIn, bool setOut, unsigned char
         if (itc->second.Selected) { selectAll = false; break; }
     }
 
+    CInterpolationDirtyRange changed;
+
     for (CInterpolationMap<CamPathValue>::iterator it = m_Map.begin(); it != m_Map.end(); ++it)
     {
-        CamPathValue cur = it->second;
-        if (selectAll || cur.Selected)
+        if (selectAll || it->second.Selected)
         {
-            switch (ch)
-            {
-            case CH_X:
-                if (setIn)  cur.TxModeIn = mode;
-                if (setOut) cur.TxModeOut = mode;
-                break;
-            case CH_Y:
-                if (setIn)  cur.TyModeIn = mode;
-                if (setOut) cur.TyModeOut = mode;
-                break;
-            case CH_Z:
-                if (setIn)  cur.TzModeIn = mode;
-                if (setOut) cur.TzModeOut = mode;
-                break;
-            case CH_FOV:
-                if (setIn)  cur.TfovModeIn = mode;
-                if (setOut) cur.TfovModeOut = mode;
-                break;
-            case CH_RPITCH:
-                if (setIn)  cur.TRyModeIn = mode;
-                if (setOut) cur.TRyModeOut = mode;
-                break;
-            case CH_RYAW:
-                if (setIn)  cur.TRzModeIn = mode;
-                if (setOut) cur.TRzModeOut = mode;
-                break;
-            case CH_RROLL:
-                if (setIn)  cur.TRxModeIn = mode;
-                if (setOut) cur.TRxModeOut = mode;
-                break;
-            }
-            it->second = cur;
+            CamPathTangent & tangent = it->second.EditTangent(ch);
+            if (setIn)  tangent.ModeIn = mode;
+            if (setOut) tangent.ModeOut = mode;
+            changed.Add(it - m_Map.begin());
         }
     }
 
@@ -1382,19 +1525,19 @@ void CamPath::SetTangentMode(Channel ch, bool setIn, bool setOut, unsigned char
     {
         if (m_PositionInterpMethod == DI_CUSTOM)
         {
-            m_XInterp->InterpolationMapChanged();
-            m_YInterp->InterpolationMapChanged();
-            m_ZInterp->InterpolationMapChanged();
+            m_XInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+            m_YInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+            m_ZInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
         }
     }
     if (ch == CH_FOV && m_FovInterpMethod == DI_CUSTOM)
     {
-        m_FovInterp->InterpolationMapChanged();
+        m_FovInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
     }
 
     if ((ch == CH_RPITCH || ch == CH_RYAW || ch == CH_RROLL) && m_RotationInterpMethod == QI_CUSTOM)
     {
-        m_RInterp->InterpolationMapChanged();
+        m_RInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
     }
 
     Changed();
@@ -1409,36 +1552,31 @@ void CamPath::SetTangentWeight(Channel ch, bool setIn, bool setOut, double wIn,
         if (it->second.Selected) { selectAll = false; break; }
     }
 
+    CInterpolationDirtyRange changed;
+
     for (auto it = m_Map.begin(); it != m_Map.end(); ++it) {
-        CamPathValue cur = it->second;
-        if (selectAll || cur.Selected) {
-            switch (ch) {
-            case CH_X:   if (setIn) cur.TxWIn = wIn;   if (setOut) cur.TxWOut = wOut; break;
-            case CH_Y:   if (setIn) cur.TyWIn = wIn;   if (setOut) cur.TyWOut = wOut; break;
-            case CH_Z:   if (setIn) cur.TzWIn = wIn;   if (setOut) cur.TzWOut = wOut; break;
-            case CH_FOV: if (setIn) cur.TfovWIn = wIn; if (setOut) cur.TfovWOut = wOut; break;
-            case CH_RPITCH: if (setIn) cur.TRyWIn = wIn; if (setOut) cur.TRyWOut = wOut; break;
-            case CH_RYAW:   if (setIn) cur.TRzWIn = wIn; if (setOut) cur.TRzWOut = wOut; break;
-            case CH_RROLL:  if (setIn) cur.TRxWIn = wIn; if (setOut) cur.TRxWOut = wOut; break;
-            }
-            it->second = cur;
+        if (selectAll || it->second.Selected) {
+            CamPathTangent & tangent = it->second.EditTangent(ch);
+            if (setIn) tangent.WIn = wIn;
+            if (setOut) tangent.WOut = wOut;
+            changed.Add(it - m_Map.begin());
         }
     }
 
     // weights affect only DI_CUSTOM paths (position/fov)
     if (ch == CH_X || ch == CH_Y || ch == CH_Z) {
         if (m_PositionInterpMethod == DI_CUSTOM) {
-            m_XInterp->InterpolationMapChanged();
-            m_YInterp->InterpolationMapChanged();
-            m_ZInterp->InterpolationMapChanged();
+            m_XInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+            m_YInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+            m_ZInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
         }
     }
     if (ch == CH_FOV && m_FovInterpMethod == DI_CUSTOM) {
-        m_FovInterp->InterpolationMapChanged();
+        m_FovInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
     }
 
     if ((ch == CH_RPITCH || ch == CH_RYAW || ch == CH_RROLL) && m_RotationInterpMethod == QI_CUSTOM) {
-        m_RInterp->InterpolationMapChanged();
+        m_RInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
     }
 
     Changed();
@@ -1530,9 +1668,10 @@ void CamPath::Rotate(double yPitch, double zYaw, double xRoll)
 
 	// rotate:
 
+	CInterpolationDirtyRange changed;
+
 	for(CInterpolationMap<CamPathValue>::iterator it = m_Map.begin(); it != m_Map.end(); ++it)
 	{
-		double curT = it->first;
 		CamPathValue curValue = it->second;
 
 		if(selectAll || curValue.Selected)
@@ -1564,14 +1703,15 @@ void CamPath::Rotate(double yPitch, double zYaw, double xRoll)
 
 			// update:
 			it->second = curValue;
+			changed.Add(it - m_Map.begin());
 		}
 
 	}
 
-	m_XInterp->InterpolationMapChanged();
-	m_YInterp->InterpolationMapChanged();
-	m_ZInterp->InterpolationMapChanged();
-	m_RInterp->InterpolationMapChanged();
+	m_XInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+	m_YInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+	m_ZInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+	m_RInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
 
 	Changed();
 }
@@ -1642,9 +1782,10 @@ void CamPath::AnchorTransform(double anchorX, double anchorY, double anchorZ, do
 
 	// rotate:
 
+	CInterpolationDirtyRange changed;
+
 	for(CInterpolationMap<CamPathValue>::iterator it = m_Map.begin(); it != m_Map.end(); ++it)
 	{
-		double curT = it->first;
 		CamPathValue curValue = it->second;
 
 		if(selectAll || curValue.Selected)
@@ -1676,18 +1817,227 @@ void CamPath::AnchorTransform(double anchorX, double anchorY, double anchorZ, do
 
 			// update:
 			it->second = curValue;
+			changed.Add(it - m_Map.begin());
 		}
 
 	}
 
-	m_XInterp->InterpolationMapChanged();
-	m_YInterp->InterpolationMapChanged();
-	m_ZInterp->InterpolationMapChanged();
-	m_RInterp->InterpolationMapChanged();
+	m_XInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+	m_YInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+	m_ZInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
+	m_RInterp->InterpolationMapValuesChanged(changed.First, changed.Last);
 
 	Changed();
 }
 
+static double SimplifyRatio(double error, double tolerance)
+{
+	// Deviations below this are rounding noise, even between identical paths:
+	if(error <= 1e-9) return 0.0;
+
+	return 0 < tolerance ? error / tolerance : DBL_MAX;
+}
+
+/// <returns>Deviation relative to the tolerances, greater than 1 means out of tolerance.</returns>
+static double SimplifyDeviation(CamPathValue const & a, CamPathValue const & b, double posTolerance, double angTolerance, double fovTolerance)
+{
+	double dX = a.X - b.X;
+	double dY = a.Y - b.Y;
+	double dZ = a.Z - b.Z;
+	double pos = sqrt(dX * dX + dY * dY + dZ * dZ);
+
+	// 4 asin(|qa - qb| / 2) instead of 2 acos(qa . qb), since the latter is off by about 1e-6 degrees near 0.
+	Quaternion qA = a.R.Normalized();
+	Quaternion qB = b.R.Normalized();
+	if(DotProduct(qA, qB) < 0) qB = -1.0 * qB;
+	Quaternion qD = qA + -1.0 * qB;
+	double ang = 4.0 * asin(std::min(0.5 * qD.Norm(), 1.0)) * 180.0 / M_PI;
+
+	double fov = fabs(a.Fov - b.Fov);
+
+	return std::max(SimplifyRatio(pos, posTolerance), std::max(SimplifyRatio(ang, angTolerance), SimplifyRatio(fov, fovTolerance)));
+}
+
+size_t CamPath::Simplify(double posTolerance, double angTolerance, double fovTolerance)
+{
+	size_t count = m_Map.size();
+	if(count <= 4 || !CanEval()) return 0;
+
+	std::vector<double> keyT;
+	std::vector<CamPathValue> keyV;
+	keyT.reserve(count);
+	keyV.reserve(count);
+
+	bool selectAll = true;
+	for(CInterpolationMap<CamPathValue>::const_iterator it = m_Map.begin(); it != m_Map.end(); ++it)
+	{
+		keyT.push_back(it->first);
+		keyV.push_back(it->second);
+		if(it->second.Selected) selectAll = false;
+	}
+
+	std::vector<bool> keep(count, false);
+	keep[0] = true;
+	keep[count - 1] = true;
+	if(!selectAll)
+	{
+		for(size_t i = 0; i < count; ++i)
+		{
+			if(!keyV[i].Selected) keep[i] = true;
+		}
+	}
+
+	// Initial guess: Douglas-Peucker against linear (slerp for rotation) interpolation between the kept keys.
+	{
+		std::vector<std::pair<size_t, size_t>> ranges;
+		for(size_t a = 0, b = 1; b < count; ++b)
+		{
+			if(!keep[b]) continue;
+			if(1 < b - a) ranges.emplace_back(a, b);
+			a = b;
+		}
+
+		while(!ranges.empty())
+		{
+			size_t a = ranges.back().first;
+			size_t b = ranges.back().second;
+			ranges.pop_back();
+
+			double worst = 1.0;
+			size_t worstIndex = 0;
+			for(size_t i = a + 1; i < b; ++i)
+			{
+				double u = (keyT[i] - keyT[a]) / (keyT[b] - keyT[a]);
+				CamPathValue lerp;
+				lerp.X = keyV[a].X + u * (keyV[b].X - keyV[a].X);
+				lerp.Y = keyV[a].Y + u * (keyV[b].Y - keyV[a].Y);
+				lerp.Z = keyV[a].Z + u * (keyV[b].Z - keyV[a].Z);
+				lerp.R = keyV[a].R.Slerp(keyV[b].R, u);
+				lerp.Fov = keyV[a].Fov + u * (keyV[b].Fov - keyV[a].Fov);
+
+				double deviation = SimplifyDeviation(keyV[i], lerp, posTolerance, angTolerance, fovTolerance);
+				if(worst < deviation)
+				{
+					worst = deviation;
+					worstIndex = i;
+				}
+			}
+
+			if(worstIndex)
+			{
+				keep[worstIndex] = true;
+				if(1 < worstIndex - a) ranges.emplace_back(a, worstIndex);
+				if(1 < b - worstIndex) ranges.emplace_back(worstIndex, b);
+			}
+		}
+	}
+
+	// Cubic interpolations need at least 4 keys.
+	if(std::count(keep.begin(), keep.end(), true) < 4)
+	{
+		keep[count / 3] = true;
+		keep[2 * count / 3] = true;
+	}
+
+	// Reference samples at the keys and in between them, sample s lies in the interval of key s / samplesPerKey.
+	const size_t samplesPerKey = c_SimplifySamplesPerInterval + 1;
+	std::vector<double> sampleT;
+	std::vector<CamPathValue> sampleV;
+	sampleT.reserve((count - 1) * samplesPerKey + 1);
+	sampleV.reserve((count - 1) * samplesPerKey + 1);
+	for(size_t i = 0; i < count; ++i)
+	{
+		for(size_t j = 0; j < samplesPerKey && (0 == j || i + 1 < count); ++j)
+		{
+			double t = keyT[i] + (0 == j ? 0.0 : (keyT[i + 1] - keyT[i]) * j / samplesPerKey);
+			sampleT.push_back(t);
+			sampleV.push_back(EvalCurve(t));
+		}
+	}
+
+	// Verify against the actual interpolation and put back keys where needed, until within tolerance
+	// or there is nothing left to put back.
+	CamPath candidate;
+	candidate.PositionInterpMethod_set(m_PositionInterpMethod);
+	candidate.RotationInterpMethod_set(m_RotationInterpMethod);
+	candidate.FovInterpMethod_set(m_FovInterpMethod);
+
+	while(true)
+	{
+		candidate.m_Map.clear();
+		for(size_t i = 0; i < count; ++i)
+		{
+			if(keep[i]) candidate.m_Map[keyT[i]] = keyV[i];
+		}
+		candidate.DoInterpolationMapChangedAll();
+
+		bool bOk = true;
+		bool bKeptMore = false;
+
+		for(size_t a = 0, b = 1; b < count; ++b)
+		{
+			if(!keep[b]) continue;
+
+			double worst = 1.0;
+			size_t worstSample = 0;
+			for(size_t s = a * samplesPerKey + 1; s < b * samplesPerKey; ++s)
+			{
+				double deviation = SimplifyDeviation(sampleV[s], candidate.EvalCurve(sampleT[s]), posTolerance, angTolerance, fovTolerance);
+				if(worst < deviation)
+				{
+					worst = deviation;
+					worstSample = s;
+				}
+			}
+
+			if(worstSample)
+			{
+				bOk = false;
+
+				if(1 < b - a)
+				{
+					// Put back the removed key nearest to the worst sample.
+					size_t i = worstSample / samplesPerKey;
+					if(i == a || (i + 1 < b && keyT[i + 1] - sampleT[worstSample] < sampleT[worstSample] - keyT[i])) ++i;
+					keep[i] = true;
+					bKeptMore = true;
+				}
+				else
+				{
+					// Nothing removed in between, so the deviation is caused by removed neighbours (i.e. cubic splines), put back the nearest ones.
+					for(size_t i = a; 0 < i;)
+					{
+						--i;
+						if(!keep[i]) { keep[i] = true; bKeptMore = true; break; }
+					}
+					for(size_t i = b + 1; i < count; ++i)
+					{
+						if(!keep[i]) { keep[i] = true; bKeptMore = true; break; }
+					}
+				}
+			}
+
+			a = b;
+		}
+
+		// Not putting back anything means all keys that could help are kept already,
+		// then the remaining deviation can't be fixed by keys (i.e. tolerance 0 against rounding).
+		if(bOk || !bKeptMore) break;
+	}
+
+	size_t removed = count - candidate.m_Map.size();
+	if(0 < removed)
+	{
+		CopyMap(m_Map, candidate.m_Map);
+
+		DoInterpolationMapChangedAll();
+
+		Changed();
+	}
+
+	return removed;
+}
+
 void CamPath::CopyMap(CInterpolationMap<CamPathValue> & dst, CInterpolationMap<CamPathValue> & src)
 {
 	dst.clear();
@@ -1712,6 +2062,236 @@ void CamPath::SetOffset(double value)
 	Changed();
 }
 
+void CamPath::ArcLengthChanged(void * pUserData)
+{
+	static_cast<CamPath *>(pUserData)->m_ArcLengthVersion.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<const CamPath::ArcLengthTable_s> CamPath::GetArcLength()
+{
+	unsigned int version = m_ArcLengthVersion.load(std::memory_order_acquire);
+	std::shared_ptr<const ArcLengthTable_s> table = std::atomic_load(&m_ArcLength);
+	if(table && table->Version == version) return table;
+
+	std::lock_guard<std::mutex> lock(m_ArcLengthLock);
+
+	version = m_ArcLengthVersion.load(std::memory_order_acquire);
+	table = std::atomic_load(&m_ArcLength);
+	if(table && table->Version == version) return table;
+
+	std::shared_ptr<ArcLengthTable_s> next = std::make_shared<ArcLengthTable_s>();
+	next->Version = version;
+
+	if(2 <= m_Map.size())
+	{
+		size_t n = (m_Map.size() - 1) * c_ArcLengthSamplesPerInterval + 1;
+		double t0 = GetLowerBound();
+		double dt = GetDuration() / (n - 1);
+
+		std::vector<double> x(n), y(n), z(n);
+		m_XInterp->EvalRange(t0, dt, n, &x[0]);
+		m_YInterp->EvalRange(t0, dt, n, &y[0]);
+		m_ZInterp->EvalRange(t0, dt, n, &z[0]);
+
+		next->T.resize(n);
+		next->S.resize(n);
+		next->T[0] = t0;
+		next->S[0] = 0;
+		for(size_t i = 1; i < n; ++i)
+		{
+			double dx = x[i] - x[i - 1];
+			double dy = y[i] - y[i - 1];
+			double dz = z[i] - z[i - 1];
+			next->T[i] = t0 + i * dt;
+			next->S[i] = next->S[i - 1] + sqrt(dx * dx + dy * dy + dz * dz);
+		}
+		next->T[n - 1] = GetUpperBound();
+	}
+
+	table = std::move(next);
+	std::atomic_store(&m_ArcLength, table);
+	return table;
+}
+
+double CamPath::ConstantSpeedTime(double t)
+{
+	std::shared_ptr<const ArcLengthTable_s> table = GetArcLength();
+
+	const std::vector<double> & T = table->T;
+	const std::vector<double> & S = table->S;
+
+	if(T.size() < 2 || t <= T.front() || T.back() <= t) return t;
+
+	double length = S.back();
+	if(length <= 0) return t; // Not moving at all.
+
+	double s = (t - T.front()) / (T.back() - T.front()) * length;
+
+	// 0 < s < length, so 1 <= k < T.size().
+	size_t k = std::upper_bound(S.begin(), S.end(), s) - S.begin();
+
+	double ds = S[k] - S[k - 1];
+	if(ds <= 0) return T[k - 1];
+
+	return T[k - 1] + (s - S[k - 1]) / ds * (T[k] - T[k - 1]);
+}
+
+static bool SnapshotKeyEqual(std::pair<double, CamPathValue> const & a, std::pair<double, CamPathValue> const & b)
+{
+	return a.first == b.first
+		&& a.second.X == b.second.X
+		&& a.second.Y == b.second.Y
+		&& a.second.Z == b.second.Z
+		&& a.second.R.W == b.second.R.W
+		&& a.second.R.X == b.second.R.X
+		&& a.second.R.Y == b.second.R.Y
+		&& a.second.R.Z == b.second.R.Z
+		&& a.second.Fov == b.second.Fov
+		&& a.second.Selected == b.second.Selected
+		&& a.second.Tangents == b.second.Tangents; // Copy on write, so same block means unchanged.
+}
+
+CamPath::Snapshot_s CamPath::TakeSnapshot(Snapshot_s const * base) const
+{
+	Snapshot_s result;
+	result.Size = m_Map.size();
+	result.PositionInterpMethod = m_PositionInterpMethod;
+	result.RotationInterpMethod = m_RotationInterpMethod;
+	result.FovInterpMethod = m_FovInterpMethod;
+	result.Hold = m_Hold;
+	result.ConstantSpeed = m_ConstantSpeed;
+	result.Offset = m_Offset;
+
+	// Share the leading and trailing blocks of base that are unchanged, only the keys in between [first, last) need copying.
+	size_t first = 0;
+	size_t last = result.Size;
+	size_t headBlocks = 0;
+	size_t tailBlocks = 0;
+
+	if(base)
+	{
+		size_t blockCount = base->Blocks.size();
+
+		while(headBlocks < blockCount)
+		{
+			Snapshot_s::Block_t const & block = *base->Blocks[headBlocks];
+			if(last - first < block.size() || !std::equal(block.begin(), block.end(), m_Map.begin() + first, SnapshotKeyEqual))
+				break;
+			first += block.size();
+			++headBlocks;
+		}
+
+		while(headBlocks + tailBlocks < blockCount)
+		{
+			Snapshot_s::Block_t const & block = *base->Blocks[blockCount - 1 - tailBlocks];
+			if(last - first < block.size() || !std::equal(block.begin(), block.end(), m_Map.begin() + (last - block.size()), SnapshotKeyEqual))
+				break;
+			last -= block.size();
+			++tailBlocks;
+		}
+
+		result.Blocks.insert(result.Blocks.end(), base->Blocks.begin(), base->Blocks.begin() + headBlocks);
+	}
+
+	for(size_t i = first; i < last; i += c_SnapshotBlockSize)
+	{
+		result.Blocks.emplace_back(std::make_shared<const Snapshot_s::Block_t>(m_Map.begin() + i, m_Map.begin() + std::min(i + c_SnapshotBlockSize, last)));
+	}
+
+	if(base)
+		result.Blocks.insert(result.Blocks.end(), base->Blocks.end() - tailBlocks, base->Blocks.end());
+
+	return result;
+}
+
+void CamPath::RestoreSnapshot(Snapshot_s const & snapshot)
+{
+	m_RestoringSnapshot = true;
+
+	if(m_PositionInterpMethod != snapshot.PositionInterpMethod) PositionInterpMethod_set(snapshot.PositionInterpMethod);
+	if(m_RotationInterpMethod != snapshot.RotationInterpMethod) RotationInterpMethod_set(snapshot.RotationInterpMethod);
+	if(m_FovInterpMethod != snapshot.FovInterpMethod) FovInterpMethod_set(snapshot.FovInterpMethod);
+	m_Hold = snapshot.Hold;
+	m_ConstantSpeed = snapshot.ConstantSpeed;
+	m_Offset = snapshot.Offset;
+
+	m_Map.clear();
+	m_Map.reserve(snapshot.Size);
+	for(std::vector<std::shared_ptr<const Snapshot_s::Block_t>>::const_iterator itBlock = snapshot.Blocks.begin(); itBlock != snapshot.Blocks.end(); ++itBlock)
+	{
+		for(Snapshot_s::Block_t::const_iterator it = (*itBlock)->begin(); it != (*itBlock)->end(); ++it)
+		{
+			m_Map[it->first] = it->second;
+		}
+	}
+
+	DoInterpolationMapChangedAll();
+
+	Changed();
+
+	m_RestoringSnapshot = false;
+}
+
+void CamPath::UndoCheckpoint()
+{
+	m_UndoPending = TakeSnapshot(m_UndoStack.empty() ? nullptr : &m_UndoStack.back());
+	m_HasUndoPending = true;
+}
+
+void CamPath::UndoCheckpointEnd()
+{
+	if(!m_HasUndoPending) return;
+
+	m_HasUndoPending = false;
+	m_UndoPending = Snapshot_s();
+}
+
+bool CamPath::CanUndo() const
+{
+	return !m_UndoStack.empty();
+}
+
+bool CamPath::CanRedo() const
+{
+	return !m_RedoStack.empty();
+}
+
+bool CamPath::Undo()
+{
+	if(m_UndoStack.empty()) return false;
+
+	m_HasUndoPending = false;
+	m_RedoStack.emplace_back(TakeSnapshot(&m_UndoStack.back()));
+
+	Snapshot_s snapshot(std::move(m_UndoStack.back()));
+	m_UndoStack.pop_back();
+	RestoreSnapshot(snapshot);
+
+	return true;
+}
+
+bool CamPath::Redo()
+{
+	if(m_RedoStack.empty()) return false;
+
+	m_HasUndoPending = false;
+	m_UndoStack.emplace_back(TakeSnapshot(&m_RedoStack.back()));
+
+	Snapshot_s snapshot(std::move(m_RedoStack.back()));
+	m_RedoStack.pop_back();
+	RestoreSnapshot(snapshot);
+
+	return true;
+}
+
+void CamPath::ClearHistory()
+{
+	m_HasUndoPending = false;
+	m_UndoPending = Snapshot_s();
+	m_UndoStack.clear();
+	m_RedoStack.clear();
+}
+
 double CamPath::GetOffset() const
 {
 	return m_Offset;
@@ -3,10 +3,37 @@
 #include "AfxMath.h"
 
 #include <list>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
 
 using namespace Afx;
 using namespace Afx::Math;
 
+/// <summary>Custom Hermite tangent of one channel of a key.</summary>
+struct CamPathTangent
+{
+    double In = 0.0;
+    double Out = 0.0;
+    double WIn = 1.0;
+    double WOut = 1.0;
+    unsigned char ModeIn = 0; // CamPath::TangentMode
+    unsigned char ModeOut = 0; // CamPath::TangentMode
+
+    bool IsDefault() const {
+        return In == 0.0 && Out == 0.0 && WIn == 1.0 && WOut == 1.0 && ModeIn == 0 && ModeOut == 0;
+    }
+};
+
+/// <summary>Custom tangents of all channels of a key, indexed by CamPath::Channel.</summary>
+struct CamPathTangents
+{
+    CamPathTangent Channels[7];
+
+    bool IsDefault() const;
+};
+
 struct CamPathValue
 {
     double X;
@@ -19,25 +46,14 @@ struct CamPathValue
 
     bool Selected;
 
-    // Per-key tangents and modes (for Hermite interpolation)
-    double TxIn, TxOut; unsigned char TxModeIn, TxModeOut;
-    double TyIn, TyOut; unsigned char TyModeIn, TyModeOut;
-    double TzIn, TzOut; unsigned char TzModeIn, TzModeOut;
-    double TfovIn, TfovOut; unsigned char TfovModeIn, TfovModeOut;
-	//weights
-	double TxWIn, TxWOut;
-	double TyWIn, TyWOut;
-	double TzWIn, TzWOut;
-	double TfovWIn, TfovWOut;
-
-    // Rotation (Euler) per-key tangents, modes and weights for custom rotation backend
-    // Order/semantics follow Quake convention: Pitch=Y axis, Yaw=Z axis, Roll=X axis
-    double TRxIn, TRxOut; unsigned char TRxModeIn, TRxModeOut; // Roll (X)
-    double TRyIn, TRyOut; unsigned char TRyModeIn, TRyModeOut; // Pitch (Y)
-    double TRzIn, TRzOut; unsigned char TRzModeIn, TRzModeOut; // Yaw (Z)
-    double TRxWIn, TRxWOut; // weights for Free mode handles
-    double TRyWIn, TRyWOut;
-    double TRzWIn, TRzWOut;
+    /// <summary>Per-key tangents, modes and weights (for custom Hermite interpolation).</summary>
+    /// <remarks>
+    /// Kept out of line, since most keys never get custom tangents: nullptr means all channels are default.
+    /// The block is shared between copies of a value and copied on write by EditTangent,
+    /// so copying keys around (CopyMap, SetStart, SetDuration, Rotate, ...) stays cheap.
+    /// Rotation channels follow Quake convention: Pitch=Y axis, Yaw=Z axis, Roll=X axis.
+    /// </remarks>
+    std::shared_ptr<CamPathTangents> Tangents;
 
 	CamPathValue();
 
@@ -45,6 +61,12 @@ struct CamPathValue
 
 	CamPathValue(double x, double y, double z, double q_w, double q_x, double q_y, double q_z, double fov, bool selected);
 
+	/// <param name="channel">CamPath::Channel</param>
+	CamPathTangent const & GetTangent(int channel) const;
+
+	/// <summary>Returns a writeable tangent, un-sharing the tangent block first if needed.</summary>
+	/// <param name="channel">CamPath::Channel</param>
+	CamPathTangent & EditTangent(int channel);
 };
 
 struct CamPathIterator
@@ -114,6 +136,14 @@ public:
 	bool GetHold(void) const;
 	void SetHold(bool value);
 
+	/// <summary>Whether to move along the position curve at constant speed.</summary>
+	/// <remarks>
+	/// If enabled, Eval and EvalRange re-map t through a cached arc-length table of the position curve,
+	/// so the keyframe times only determine the shape of the path and its start and end.
+	/// </remarks>
+	bool GetConstantSpeed(void) const;
+	void SetConstantSpeed(bool value);
+
 	void PositionInterpMethod_set(DoubleInterp value);
 	DoubleInterp PositionInterpMethod_get(void) const;
 
@@ -125,6 +155,10 @@ public:
 
 	void Add(double time, const CamPathValue & value);
 
+	/// <summary>Adds many keys at once with a single change notification.</summary>
+	/// <remarks>O(n) if the keys are in ascending time order and after the existing keys.</remarks>
+	void Add(std::vector<std::pair<double, CamPathValue>> const & keys);
+
 	void Remove(double time);
 	void Clear();
 
@@ -146,8 +180,23 @@ public:
 	/// </remarks>
 	CamPathValue Eval(double t);
 
+	/// <summary>Evaluates n samples at t0 + i * dt into separate output arrays.</summary>
+	/// <remarks>
+	/// Must not be called if CanEval() returns false!<br />
+	/// dt must not be negative. Any output pointer may be nullptr in order to skip that channel.
+	/// </remarks>
+	void EvalRange(double t0, double dt, size_t n, double * outX, double * outY, double * outZ, Quaternion * outR = nullptr, double * outFov = nullptr, bool * outSelected = nullptr);
+
 	bool Save(wchar_t const * fileName);
+
+	/// <summary>Saves in the binary campath format, which is much faster to load than XML.</summary>
+	bool SaveBinary(wchar_t const * fileName);
+
+	/// <remarks>Detects the format (XML or binary) automatically.</remarks>
 	bool Load(wchar_t const * fileName);
+
+	/// <returns>If the file is in the binary campath format.</returns>
+	static bool IsBinaryFile(wchar_t const * fileName);
 	
 	/// <remarks>In the current implementation if points happen to fall on the same time value, then the last point's value will be used (no interpolation).</remarks>
 	/// <param name="relative">If t is an relative offset (true), or absolute value (false).</param>
@@ -178,6 +227,17 @@ public:
 
 	void AnchorTransform(double anchorX, double anchorY, double anchorZ, double anchorYPitch, double anchorZYaw, double anchorXRoll, double destX, double destY, double destZ, double destYPitch, double destZYaw, double destXRoll);
 
+	/// <summary>Removes keyframes that are not needed to stay within the given tolerances (i.e. for dense recorded paths).</summary>
+	/// <remarks>
+	/// Applies to the selected keyframes if any, otherwise to all. The first and last keyframe are always kept.<br />
+	/// The deviation is measured against the current path with the current interpolation methods, at the keyframes and in between them.
+	/// </remarks>
+	/// <param name="posTolerance">Maximum position deviation in units.</param>
+	/// <param name="angTolerance">Maximum rotation deviation in degrees.</param>
+	/// <param name="fovTolerance">Maximum fov deviation in degrees.</param>
+	/// <returns>Number of keyframes removed.</returns>
+	size_t Simplify(double posTolerance, double angTolerance, double fovTolerance);
+
 	size_t SelectAll();
 
 	void SelectNone();
@@ -210,6 +270,29 @@ public:
 
 	double GetOffset() const;
 
+	/// <summary>Records the current state as an undo step, for the next edit.</summary>
+	/// <remarks>
+	/// Call this before an edit or before a series of edits that should be undone at once (i.e. a drag).
+	/// The step is only added to the history by the next change, so it's fine to call this before something that might not change the path.<br />
+	/// Snapshots share unchanged blocks of keyframes with their neighbour in the history, so a step only costs memory for the keyframes that changed.
+	/// </remarks>
+	void UndoCheckpoint();
+
+	/// <summary>Drops the checkpoint if the edit it was taken for ended without changing anything.</summary>
+	/// <remarks>Call this when the drag or command ends, so a later edit doesn't add the old state as its undo step.</remarks>
+	void UndoCheckpointEnd();
+
+	bool CanUndo() const;
+	bool CanRedo() const;
+
+	/// <returns>false if there is nothing to undo.</returns>
+	bool Undo();
+
+	/// <returns>false if there is nothing to redo.</returns>
+	bool Redo();
+
+	void ClearHistory();
+
 private:
 	struct CamPathChangedData {
 		CamPathChanged pFn;
@@ -263,60 +346,61 @@ private:
     }
 
     // Tangent selectors for Hermite interpolation (double channels)
-    static double XTanInSelector(CamPathValue const& v) { return v.TxIn; }
-    static double XTanOutSelector(CamPathValue const& v) { return v.TxOut; }
-    static unsigned char XTanModeInSelector(CamPathValue const& v) { return v.TxModeIn; }
-    static unsigned char XTanModeOutSelector(CamPathValue const& v) { return v.TxModeOut; }
-
-    static double YTanInSelector(CamPathValue const& v) { return v.TyIn; }
-    static double YTanOutSelector(CamPathValue const& v) { return v.TyOut; }
-    static unsigned char YTanModeInSelector(CamPathValue const& v) { return v.TyModeIn; }
-    static unsigned char YTanModeOutSelector(CamPathValue const& v) { return v.TyModeOut; }
-
-    static double ZTanInSelector(CamPathValue const& v) { return v.TzIn; }
-    static double ZTanOutSelector(CamPathValue const& v) { return v.TzOut; }
-    static unsigned char ZTanModeInSelector(CamPathValue const& v) { return v.TzModeIn; }
-    static unsigned char ZTanModeOutSelector(CamPathValue const& v) { return v.TzModeOut; }
-
-    static double FovTanInSelector(CamPathValue const& v) { return v.TfovIn; }
-    static double FovTanOutSelector(CamPathValue const& v) { return v.TfovOut; }
-    static unsigned char FovTanModeInSelector(CamPathValue const& v) { return v.TfovModeIn; }
-    static unsigned char FovTanModeOutSelector(CamPathValue const& v) { return v.TfovModeOut; }
+    static double XTanInSelector(CamPathValue const& v) { return v.GetTangent(CH_X).In; }
+    static double XTanOutSelector(CamPathValue const& v) { return v.GetTangent(CH_X).Out; }
+    static unsigned char XTanModeInSelector(CamPathValue const& v) { return v.GetTangent(CH_X).ModeIn; }
+    static unsigned char XTanModeOutSelector(CamPathValue const& v) { return v.GetTangent(CH_X).ModeOut; }
+
+    static double YTanInSelector(CamPathValue const& v) { return v.GetTangent(CH_Y).In; }
+    static double YTanOutSelector(CamPathValue const& v) { return v.GetTangent(CH_Y).Out; }
+    static unsigned char YTanModeInSelector(CamPathValue const& v) { return v.GetTangent(CH_Y).ModeIn; }
+    static unsigned char YTanModeOutSelector(CamPathValue const& v) { return v.GetTangent(CH_Y).ModeOut; }
+
+    static double ZTanInSelector(CamPathValue const& v) { return v.GetTangent(CH_Z).In; }
+    static double ZTanOutSelector(CamPathValue const& v) { return v.GetTangent(CH_Z).Out; }
+    static unsigned char ZTanModeInSelector(CamPathValue const& v) { return v.GetTangent(CH_Z).ModeIn; }
+    static unsigned char ZTanModeOutSelector(CamPathValue const& v) { return v.GetTangent(CH_Z).ModeOut; }
+
+    static double FovTanInSelector(CamPathValue const& v) { return v.GetTangent(CH_FOV).In; }
+    static double FovTanOutSelector(CamPathValue const& v) { return v.GetTangent(CH_FOV).Out; }
+    static unsigned char FovTanModeInSelector(CamPathValue const& v) { return v.GetTangent(CH_FOV).ModeIn; }
+    static unsigned char FovTanModeOutSelector(CamPathValue const& v) { return v.GetTangent(CH_FOV).ModeOut; }
 
 	// Weight selectors (used by interpolation / UI)
-	static double XTanWInSelector(CamPathValue const& v)  { return v.TxWIn; }
-	static double XTanWOutSelector(CamPathValue const& v) { return v.TxWOut; }
-	static double YTanWInSelector(CamPathValue const& v)  { return v.TyWIn; }
-	static double YTanWOutSelector(CamPathValue const& v) { return v.TyWOut; }
-	static double ZTanWInSelector(CamPathValue const& v)  { return v.TzWIn; }
-	static double ZTanWOutSelector(CamPathValue const& v) { return v.TzWOut; }
-	static double FovTanWInSelector(CamPathValue const& v)  { return v.TfovWIn; }
-	static double FovTanWOutSelector(CamPathValue const& v) { return v.TfovWOut; }
+	static double XTanWInSelector(CamPathValue const& v)  { return v.GetTangent(CH_X).WIn; }
+	static double XTanWOutSelector(CamPathValue const& v) { return v.GetTangent(CH_X).WOut; }
+	static double YTanWInSelector(CamPathValue const& v)  { return v.GetTangent(CH_Y).WIn; }
+	static double YTanWOutSelector(CamPathValue const& v) { return v.GetTangent(CH_Y).WOut; }
+	static double ZTanWInSelector(CamPathValue const& v)  { return v.GetTangent(CH_Z).WIn; }
+	static double ZTanWOutSelector(CamPathValue const& v) { return v.GetTangent(CH_Z).WOut; }
+	static double FovTanWInSelector(CamPathValue const& v)  { return v.GetTangent(CH_FOV).WIn; }
+	static double FovTanWOutSelector(CamPathValue const& v) { return v.GetTangent(CH_FOV).WOut; }
 
     // Rotation (Euler) tangent and mode selectors for custom rotation interpolation
-    static double RTanIn_Roll_Selector(CamPathValue const& v)  { return v.TRxIn; }
-    static double RTanOut_Roll_Selector(CamPathValue const& v) { return v.TRxOut; }
-    static unsigned char RTanModeIn_Roll_Selector(CamPathValue const& v)  { return v.TRxModeIn; }
-    static unsigned char RTanModeOut_Roll_Selector(CamPathValue const& v) { return v.TRxModeOut; }
-    static double RTanWIn_Roll_Selector(CamPathValue const& v)  { return v.TRxWIn; }
-    static double RTanWOut_Roll_Selector(CamPathValue const& v) { return v.TRxWOut; }
-
-    static double RTanIn_Pitch_Selector(CamPathValue const& v)  { return v.TRyIn; }
-    static double RTanOut_Pitch_Selector(CamPathValue const& v) { return v.TRyOut; }
-    static unsigned char RTanModeIn_Pitch_Selector(CamPathValue const& v)  { return v.TRyModeIn; }
-    static unsigned char RTanModeOut_Pitch_Selector(CamPathValue const& v) { return v.TRyModeOut; }
-    static double RTanWIn_Pitch_Selector(CamPathValue const& v)  { return v.TRyWIn; }
-    static double RTanWOut_Pitch_Selector(CamPathValue const& v) { return v.TRyWOut; }
-
-    static double RTanIn_Yaw_Selector(CamPathValue const& v)  { return v.TRzIn; }
-    static double RTanOut_Yaw_Selector(CamPathValue const& v) { return v.TRzOut; }
-    static unsigned char RTanModeIn_Yaw_Selector(CamPathValue const& v)  { return v.TRzModeIn; }
-    static unsigned char RTanModeOut_Yaw_Selector(CamPathValue const& v) { return v.TRzModeOut; }
-    static double RTanWIn_Yaw_Selector(CamPathValue const& v)  { return v.TRzWIn; }
-    static double RTanWOut_Yaw_Selector(CamPathValue const& v) { return v.TRzWOut; }
+    static double RTanIn_Roll_Selector(CamPathValue const& v)  { return v.GetTangent(CH_RROLL).In; }
+    static double RTanOut_Roll_Selector(CamPathValue const& v) { return v.GetTangent(CH_RROLL).Out; }
+    static unsigned char RTanModeIn_Roll_Selector(CamPathValue const& v)  { return v.GetTangent(CH_RROLL).ModeIn; }
+    static unsigned char RTanModeOut_Roll_Selector(CamPathValue const& v) { return v.GetTangent(CH_RROLL).ModeOut; }
+    static double RTanWIn_Roll_Selector(CamPathValue const& v)  { return v.GetTangent(CH_RROLL).WIn; }
+    static double RTanWOut_Roll_Selector(CamPathValue const& v) { return v.GetTangent(CH_RROLL).WOut; }
+
+    static double RTanIn_Pitch_Selector(CamPathValue const& v)  { return v.GetTangent(CH_RPITCH).In; }
+    static double RTanOut_Pitch_Selector(CamPathValue const& v) { return v.GetTangent(CH_RPITCH).Out; }
+    static unsigned char RTanModeIn_Pitch_Selector(CamPathValue const& v)  { return v.GetTangent(CH_RPITCH).ModeIn; }
+    static unsigned char RTanModeOut_Pitch_Selector(CamPathValue const& v) { return v.GetTangent(CH_RPITCH).ModeOut; }
+    static double RTanWIn_Pitch_Selector(CamPathValue const& v)  { return v.GetTangent(CH_RPITCH).WIn; }
+    static double RTanWOut_Pitch_Selector(CamPathValue const& v) { return v.GetTangent(CH_RPITCH).WOut; }
+
+    static double RTanIn_Yaw_Selector(CamPathValue const& v)  { return v.GetTangent(CH_RYAW).In; }
+    static double RTanOut_Yaw_Selector(CamPathValue const& v) { return v.GetTangent(CH_RYAW).Out; }
+    static unsigned char RTanModeIn_Yaw_Selector(CamPathValue const& v)  { return v.GetTangent(CH_RYAW).ModeIn; }
+    static unsigned char RTanModeOut_Yaw_Selector(CamPathValue const& v) { return v.GetTangent(CH_RYAW).ModeOut; }
+    static double RTanWIn_Yaw_Selector(CamPathValue const& v)  { return v.GetTangent(CH_RYAW).WIn; }
+    static double RTanWOut_Yaw_Selector(CamPathValue const& v) { return v.GetTangent(CH_RYAW).WOut; }
 
 	bool m_Enabled;
 	bool m_Hold = false;
+	bool m_ConstantSpeed = false;
 	DoubleInterp m_PositionInterpMethod;
 	QuaternionInterp m_RotationInterpMethod;
 	DoubleInterp m_FovInterpMethod;
@@ -342,4 +426,64 @@ private:
 	void CopyMap(CInterpolationMap<CamPathValue> & dst, CInterpolationMap<CamPathValue> & src);
 
 	void DoInterpolationMapChangedAll(void);
+	void DoInterpolationMapValuesChangedAll(size_t first, size_t last);
+
+	bool LoadBinary(unsigned char const * pData, size_t dataSize);
+
+	/// <summary>Evaluates the interpolations at t, without constant speed re-mapping.</summary>
+	CamPathValue EvalCurve(double t);
+
+	static const size_t c_SimplifySamplesPerInterval = 4;
+
+	/// <summary>Immutable state of the path for the undo history.</summary>
+	struct Snapshot_s
+	{
+		typedef std::vector<std::pair<double, CamPathValue>> Block_t;
+
+		// Blocks of keyframes in order, shared between snapshots.
+		std::vector<std::shared_ptr<const Block_t>> Blocks;
+		size_t Size = 0;
+
+		DoubleInterp PositionInterpMethod = DI_DEFAULT;
+		QuaternionInterp RotationInterpMethod = QI_DEFAULT;
+		DoubleInterp FovInterpMethod = DI_DEFAULT;
+		bool Hold = false;
+		bool ConstantSpeed = false;
+		double Offset = 0.0;
+	};
+
+	static const size_t c_SnapshotBlockSize = 64;
+
+	std::vector<Snapshot_s> m_UndoStack;
+	std::vector<Snapshot_s> m_RedoStack;
+	Snapshot_s m_UndoPending;
+	bool m_HasUndoPending = false;
+	bool m_RestoringSnapshot = false;
+
+	/// <param name="base">Snapshot to share unchanged blocks with, can be nullptr.</param>
+	Snapshot_s TakeSnapshot(Snapshot_s const * base) const;
+
+	void RestoreSnapshot(Snapshot_s const & snapshot);
+
+	/// <summary>Cumulative arc length S of the position curve at the times T.</summary>
+	struct ArcLengthTable_s
+	{
+		unsigned int Version;
+		std::vector<double> T;
+		std::vector<double> S;
+	};
+
+	static const size_t c_ArcLengthSamplesPerInterval = 32;
+
+	// Invalidated by ArcLengthChanged (registered with OnChangedAdd), rebuilt on demand.
+	std::shared_ptr<const ArcLengthTable_s> m_ArcLength;
+	std::atomic<unsigned int> m_ArcLengthVersion{0};
+	std::mutex m_ArcLengthLock;
+
+	static void ArcLengthChanged(void * pUserData);
+
+	std::shared_ptr<const ArcLengthTable_s> GetArcLength();
+
+	/// <summary>Maps t to the time at which the position curve has covered the same fraction of its length.</summary>
+	double ConstantSpeedTime(double t);
 };
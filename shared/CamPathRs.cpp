@@ -86,6 +86,14 @@ extern "C" void advancedfx_campath_set_hold(CamPath * ptr, FFIBool value) {
     ptr->SetHold(FFIBOOL_TO_BOOL(value));
 }
 
+extern "C" FFIBool advancedfx_campath_get_constant_speed(const CamPath * ptr) {
+    return BOOL_TO_FFIBOOL(ptr->GetConstantSpeed());
+}
+
+extern "C" void advancedfx_campath_set_constant_speed(CamPath * ptr, FFIBool value) {
+    ptr->SetConstantSpeed(FFIBOOL_TO_BOOL(value));
+}
+
 extern "C" uint8_t advancedfx_campath_position_interp_get(const CamPath * ptr) {
     return (uint8_t)ptr->PositionInterpMethod_get();
 }
@@ -162,6 +170,22 @@ extern "C" CamPathValueRs advancedfx_campath_eval(const CamPath * ptr, double ti
     };
 }
 
+extern "C" void advancedfx_campath_eval_range(const CamPath * ptr, double t0, double dt, size_t n, double * out_x, double * out_y, double * out_z, QuaternionRs * out_r, double * out_fov) {
+    CamPath * campath = const_cast<CamPath *>(ptr);
+    campath->EvalRange(t0, dt, n, out_x, out_y, out_z, nullptr, out_fov);
+    if(out_r) {
+        const size_t blockSize = 64;
+        Quaternion r[blockSize];
+        for(size_t i = 0; i < n; i += blockSize) {
+            size_t blockCount = n - i < blockSize ? n - i : blockSize;
+            campath->EvalRange(t0 + i * dt, dt, blockCount, nullptr, nullptr, nullptr, r, nullptr);
+            for(size_t j = 0; j < blockCount; ++j) {
+                out_r[i + j] = { r[j].W, r[j].X, r[j].Y, r[j].Z };
+            }
+        }
+    }
+}
+
 extern "C" FFIBool advancedfx_campath_load(CamPath * ptr, const char * file_name) {
     std::wstring wideStr;
     if(!UTF8StringToWideString(file_name,wideStr)) return FFIBOOL_FALSE;
@@ -174,6 +198,12 @@ extern "C" FFIBool advancedfx_campath_save(CamPath * ptr, const char * file_name
     return BOOL_TO_FFIBOOL(ptr->Save(wideStr.c_str()));
 }
 
+extern "C" FFIBool advancedfx_campath_save_binary(CamPath * ptr, const char * file_name) {
+    std::wstring wideStr;
+    if(!UTF8StringToWideString(file_name,wideStr)) return FFIBOOL_FALSE;
+    return BOOL_TO_FFIBOOL(ptr->SaveBinary(wideStr.c_str()));
+}
+
 extern "C" void advancedfx_campath_set_start(CamPath * ptr, double time, FFIBool relative) {
     ptr->SetStart(time, FFIBOOL_TO_BOOL(relative));
 }
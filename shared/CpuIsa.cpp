@@ -0,0 +1,90 @@
+#include "stdafx.h"
+
+#include "CpuIsa.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(_M_AMD64) || defined(__i386__) || defined(__x86_64__)
+#define ADVANCEDFX_CPUISA_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace advancedfx {
+
+#ifdef ADVANCEDFX_CPUISA_X86
+
+static void CpuIsa_Cpuid(unsigned int leaf, unsigned int subLeaf, unsigned int outRegs[4]) {
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuidex(regs, (int)leaf, (int)subLeaf);
+	for (int i = 0; i < 4; ++i) outRegs[i] = (unsigned int)regs[i];
+#else
+	__cpuid_count(leaf, subLeaf, outRegs[0], outRegs[1], outRegs[2], outRegs[3]);
+#endif
+}
+
+static unsigned long long CpuIsa_Xgetbv0() {
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+static CpuIsa CpuIsa_Detect() {
+	unsigned int regs[4];
+
+	CpuIsa_Cpuid(0, 0, regs);
+	unsigned int maxLeaf = regs[0];
+	if (maxLeaf < 1) return CpuIsa::Scalar;
+
+	CpuIsa_Cpuid(1, 0, regs);
+	unsigned int ecx1 = regs[2];
+	unsigned int edx1 = regs[3];
+
+	if (0 == (edx1 & (1u << 26))) return CpuIsa::Scalar;
+	if (0 == (ecx1 & (1u << 9))) return CpuIsa::SSE2;
+
+	// AVX2 also needs the OS to save the YMM registers:
+	bool fma = 0 != (ecx1 & (1u << 12));
+	bool osxsave = 0 != (ecx1 & (1u << 27));
+	bool avx = 0 != (ecx1 & (1u << 28));
+	if (maxLeaf < 7 || !fma || !osxsave || !avx || 0x6 != (CpuIsa_Xgetbv0() & 0x6)) return CpuIsa::SSSE3;
+
+	CpuIsa_Cpuid(7, 0, regs);
+	if (0 == (regs[1] & (1u << 5))) return CpuIsa::SSSE3;
+
+	return CpuIsa::AVX2;
+}
+
+#endif // ADVANCEDFX_CPUISA_X86
+
+CpuIsa GetCpuIsa() {
+#ifdef ADVANCEDFX_CPUISA_X86
+	static const CpuIsa isa = CpuIsa_Detect();
+	return isa;
+#else
+	return CpuIsa::Scalar;
+#endif
+}
+
+const char* GetCpuIsaName(CpuIsa isa) {
+	switch (isa) {
+	case CpuIsa::SSE2:
+		return "SSE2";
+	case CpuIsa::SSSE3:
+		return "SSSE3";
+	case CpuIsa::AVX2:
+		return "AVX2";
+	default:
+		break;
+	}
+	return "Scalar";
+}
+
+} // namespace advancedfx
@@ -0,0 +1,19 @@
+#pragma once
+
+namespace advancedfx {
+
+	/// <summary>Instruction set levels the SIMD kernels are built for, each includes the ones before.</summary>
+	enum class CpuIsa : int {
+		Scalar = 0,
+		SSE2 = 1,
+		SSSE3 = 2,
+		/// <summary>AVX2 and FMA3.</summary>
+		AVX2 = 3
+	};
+
+	/// <returns>Best level supported by CPU and OS (detected once).</returns>
+	CpuIsa GetCpuIsa();
+
+	const char* GetCpuIsaName(CpuIsa isa);
+
+} // namespace advancedfx
@@ -1,6 +1,9 @@
 #include "stdafx.h"
 
 #include "EasySampler.h"
+#include "EasySamplerKernels.h"
+
+#include "ThreadPool.h"
 
 #include <assert.h>
 #include <math.h>
@@ -13,12 +16,39 @@
 #endif
 
 
+// Row tiles ///////////////////////////////////////////////////////////////////
+
+/// <summary>
+///   Calls fn(firstRow, numRows) for row tiles covering all rows, split across the threadPool
+///   (the calling thread helps) and returns when all tiles are done.
+/// </summary>
+/// <param name="threadPool">can be 0 (everything is done on the calling thread)</param>
+/// <param name="rowValues">values per row, tiles have at least minTileValues, because smaller ones would cost more than they save.</param>
+template<class TFn> static void ForEachRows(advancedfx::CThreadPool * threadPool, int height, size_t rowValues, const TFn& fn)
+{
+	const size_t minTileValues = 64 * 1024;
+
+	if (nullptr == threadPool || (size_t)height * rowValues < 2 * minTileValues) {
+		if (0 < height) fn(0, height);
+		return;
+	}
+
+	size_t grain = rowValues < minTileValues ? (minTileValues + rowValues - 1) / rowValues : 1;
+
+	threadPool->ParallelFor((size_t)height, grain, [&fn](size_t first, size_t num) {
+		fn((int)first, (int)num);
+	});
+}
+
+
 // EasyByteSamplerImpl /////////////////////////////////////////////////////////
 
 EasyByteSamplerImpl::EasyByteSamplerImpl(
-	EasySamplerSettings const & settings)
+	EasySamplerSettings const & settings,
+	advancedfx::CThreadPool * threadPool)
 : EasySamplerBase(settings.FrameDuration_get(), settings.StartTime_get(), settings.Exposure_get())
 , m_Settings(settings)
+, m_ThreadPool(threadPool)
 {
 	const advancedfx::CImageFormat& imageFormat = settings.ImageFormat_get();
 	switch(imageFormat.Format) {
@@ -39,7 +69,10 @@ EasyByteSamplerImpl::EasyByteSamplerImpl(
 
 	assert(packedRowSize <= pitch);
 
-	m_Frame = new Frame(height * packedRowSize);
+	m_Accumulator = settings.ByteAccumulator_get();
+	m_FixedPointScale = EasySamplerSettings::ESA_Float != m_Accumulator ? ldexp(1.0, settings.FixedPointBits_get()) / settings.SampleDuration_get() : 0;
+
+	m_Frame = new Frame(height * packedRowSize, m_Accumulator);
 }
 
 
@@ -56,78 +89,215 @@ void EasyByteSamplerImpl::ClearFrame(float frameStrength)
 }
 
 
-void EasyByteSamplerImpl::Fn_1(void const * sample)
+unsigned int EasyByteSamplerImpl::FixedPoint_Weight(double w)
 {
+	m_Frame->WeightTime += w;
+
+	double sum = floor(m_Frame->WeightTime * m_FixedPointScale + 0.5);
+	double maxWeight = m_Settings.FixedPointMaxWeight_get();
+	if(maxWeight < sum) sum = maxWeight;
+
+	unsigned int q = sum <= m_Frame->WeightSum ? 0 : (unsigned int)sum - m_Frame->WeightSum;
+
+	m_Frame->WeightSum += q;
+
+	return q;
+}
+
+void EasyByteSamplerImpl::FixedPoint_Fn(void const * sampleA, unsigned int qA, void const * sampleB, unsigned int qB)
+{
+	if(0 == qA)
+	{
+		sampleA = sampleB;
+		qA = qB;
+		sampleB = 0;
+		qB = 0;
+	}
+
+	if(0 == qA)
+		return;
+
+	if(0xffff < qA || 0xffff < qB)
+	{
+		// The kernels take 16 bit weights (only a very long sample can get here with ESA_Fixed32):
+		unsigned int q = 0xffff < qA ? 0xffff : qA;
+		FixedPoint_Fn(sampleA, q, 0, 0);
+		FixedPoint_Fn(sampleA, qA - q, sampleB, qB);
+		return;
+	}
+
 	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
-	int height = imageFormat.Height;
-	int width = imageFormat.Width *  imageFormat.GetPixelStride();
-	size_t deltaPitch = imageFormat.Pitch - width;
-	float *fdata = m_Frame->Data;
-	unsigned char const * cdata = (unsigned char const *)sample;
+	size_t width = imageFormat.Width *  imageFormat.GetPixelStride();
+	size_t pitch = imageFormat.Pitch;
+	unsigned short * frame16 = m_Frame->Data16;
+	unsigned int * frame32 = m_Frame->Data32;
+	const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
 
-	for( int iy=0; iy < height; iy++ )
+	ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
 	{
-		for( int ix=0; ix < width; ix++ ) 
+		unsigned char const * cdataA = (unsigned char const *)sampleA + firstRow * pitch;
+		unsigned char const * cdataB = sampleB ? (unsigned char const *)sampleB + firstRow * pitch : nullptr;
+
+		if(frame16)
 		{
-			*fdata = *fdata + *cdata;
-			
-			fdata++;
-			cdata++;
+			unsigned short * idata = frame16 + firstRow * width;
+
+			for( int iy=0; iy < numRows; iy++ )
+			{
+				if(cdataB)
+				{
+					kernels.ByteFn_3_U16(idata, cdataA, qA, cdataB, qB, width);
+					cdataB += pitch;
+				}
+				else
+					kernels.ByteFn_2_U16(idata, cdataA, width, qA);
+				idata += width;
+				cdataA += pitch;
+			}
 		}
-		cdata += deltaPitch;
+		else
+		{
+			unsigned int * idata = frame32 + firstRow * width;
+
+			for( int iy=0; iy < numRows; iy++ )
+			{
+				if(cdataB)
+				{
+					kernels.ByteFn_3_U32(idata, cdataA, qA, cdataB, qB, width);
+					cdataB += pitch;
+				}
+				else
+					kernels.ByteFn_2_U32(idata, cdataA, width, qA);
+				idata += width;
+				cdataA += pitch;
+			}
+		}
+	});
+}
+
+void EasyByteSamplerImpl::Fn_1(void const * sample)
+{
+	if(EasySamplerSettings::ESA_Float != m_Accumulator)
+	{
+		FixedPoint_Fn(sample, FixedPoint_Weight(1.0), 0, 0);
+		return;
 	}
 
+	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
+	size_t width = imageFormat.Width *  imageFormat.GetPixelStride();
+	size_t pitch = imageFormat.Pitch;
+	float * frame = m_Frame->Data;
+	const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
+
+	ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
+	{
+		float *fdata = frame + firstRow * width;
+		unsigned char const * cdata = (unsigned char const *)sample + firstRow * pitch;
+
+		for( int iy=0; iy < numRows; iy++ )
+		{
+			kernels.ByteFn_1(fdata, cdata, width);
+			fdata += width;
+			cdata += pitch;
+		}
+	});
+
 	m_Frame->WhitePoint += 255.0f;
 }
 
 void EasyByteSamplerImpl::Fn_2(void const * sample, float w)
 {
+	if(EasySamplerSettings::ESA_Float != m_Accumulator)
+	{
+		FixedPoint_Fn(sample, FixedPoint_Weight(w), 0, 0);
+		return;
+	}
+
 	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
-	int height = imageFormat.Height;
-	int width = imageFormat.Width *  imageFormat.GetPixelStride();
-	size_t deltaPitch = imageFormat.Pitch - width;
-	float *fdata = m_Frame->Data;
-	unsigned char const * cdata = (unsigned char const *)sample;
+	size_t width = imageFormat.Width *  imageFormat.GetPixelStride();
+	size_t pitch = imageFormat.Pitch;
+	float * frame = m_Frame->Data;
+	const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
 
-	for( int iy=0; iy < height; iy++ )
+	ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
 	{
-		for( int ix=0; ix < width; ix++ ) 
+		float *fdata = frame + firstRow * width;
+		unsigned char const * cdata = (unsigned char const *)sample + firstRow * pitch;
+
+		for( int iy=0; iy < numRows; iy++ )
 		{
-			*fdata = *fdata + w * *cdata;
-			
-			fdata++;
-			cdata++;
+			kernels.ByteFn_2(fdata, cdata, width, w);
+			fdata += width;
+			cdata += pitch;
 		}
-		cdata += deltaPitch;
-	}
+	});
 
 	m_Frame->WhitePoint += w * 255.0f;
 }
 
-void EasyByteSamplerImpl::Fn_4(void const * sampleA, void const * sampleB, float w)
+void EasyByteSamplerImpl::Fn_3(void const * sampleA, float wA, void const * sampleB, float wB)
 {
+	if(EasySamplerSettings::ESA_Float != m_Accumulator)
+	{
+		unsigned int qA = FixedPoint_Weight(wA);
+		FixedPoint_Fn(sampleA, qA, sampleB, FixedPoint_Weight(wB));
+		return;
+	}
+
 	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
-	int height = imageFormat.Height;
-	int width = imageFormat.Width *  imageFormat.GetPixelStride();
-	size_t deltaPitch = imageFormat.Pitch - width;
-	float *fdata = m_Frame->Data;
-	unsigned char const * cdataA = (unsigned char const *)sampleA;
-	unsigned char const * cdataB = (unsigned char const *)sampleB;
+	size_t width = imageFormat.Width *  imageFormat.GetPixelStride();
+	size_t pitch = imageFormat.Pitch;
+	float * frame = m_Frame->Data;
+	const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
 
-	for( int iy=0; iy < height; iy++ )
+	ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
 	{
-		for( int ix=0; ix < width; ix++ ) 
+		float *fdata = frame + firstRow * width;
+		unsigned char const * cdataA = (unsigned char const *)sampleA + firstRow * pitch;
+		unsigned char const * cdataB = (unsigned char const *)sampleB + firstRow * pitch;
+
+		for( int iy=0; iy < numRows; iy++ )
 		{
-			*fdata = *fdata + w * ((unsigned int)*cdataA +(unsigned int)*cdataB);
-			
-			fdata++;
-			cdataA++;
-			cdataB++;
+			kernels.ByteFn_3(fdata, cdataA, wA, cdataB, wB, width);
+			fdata += width;
+			cdataA += pitch;
+			cdataB += pitch;
 		}
-		cdataA += deltaPitch;
-		cdataB += deltaPitch;
+	});
+
+	m_Frame->WhitePoint += (wA + wB) * 255.0f;
+}
+
+void EasyByteSamplerImpl::Fn_4(void const * sampleA, void const * sampleB, float w)
+{
+	if(EasySamplerSettings::ESA_Float != m_Accumulator)
+	{
+		unsigned int qA = FixedPoint_Weight(w);
+		FixedPoint_Fn(sampleA, qA, sampleB, FixedPoint_Weight(w));
+		return;
 	}
 
+	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
+	size_t width = imageFormat.Width *  imageFormat.GetPixelStride();
+	size_t pitch = imageFormat.Pitch;
+	float * frame = m_Frame->Data;
+	const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
+
+	ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
+	{
+		float *fdata = frame + firstRow * width;
+		unsigned char const * cdataA = (unsigned char const *)sampleA + firstRow * pitch;
+		unsigned char const * cdataB = (unsigned char const *)sampleB + firstRow * pitch;
+
+		for( int iy=0; iy < numRows; iy++ )
+		{
+			kernels.ByteFn_4(fdata, cdataA, cdataB, width, w);
+			fdata += width;
+			cdataA += pitch;
+			cdataB += pitch;
+		}
+	});
+
 	m_Frame->WhitePoint += w * 2.0f * 255.0f;
 }
 
@@ -136,6 +306,40 @@ void EasyByteSamplerImpl::PrintFrame(unsigned char * data)
 {
 	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
 
+	if(EasySamplerSettings::ESA_Float != m_Accumulator)
+	{
+		if(0 == m_Frame->WeightSum)
+		{
+			memset(data, 0, imageFormat.Height * imageFormat.Pitch);
+			return;
+		}
+
+		unsigned short * frame16 = m_Frame->Data16;
+		unsigned int * frame32 = m_Frame->Data32;
+
+		size_t width = imageFormat.Width * imageFormat.GetPixelStride();
+		size_t pitch = imageFormat.Pitch;
+
+		float w = 1.0f / m_Frame->WeightSum;
+
+		const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
+
+		ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
+		{
+			unsigned char * cdata = data + firstRow * pitch;
+
+			for( int iy=0; iy < numRows; iy++ )
+			{
+				if(frame16)
+					kernels.BytePrint_U16(cdata, frame16 + (firstRow + iy) * width, width, w);
+				else
+					kernels.BytePrint_U32(cdata, frame32 + (firstRow + iy) * width, width, w);
+				cdata += pitch;
+			}
+		});
+		return;
+	}
+
 	float w = m_Frame->WhitePoint;
 
 	if(0 == w)
@@ -144,31 +348,59 @@ void EasyByteSamplerImpl::PrintFrame(unsigned char * data)
 	}
 	else
 	{
-		float * fdata = m_Frame->Data;
+		float * frame = m_Frame->Data;
 
-		int height = imageFormat.Height;
-		int width = imageFormat.Width * imageFormat.GetPixelStride();
-		size_t deltaPitch = imageFormat.Pitch - width;
+		size_t width = imageFormat.Width * imageFormat.GetPixelStride();
+		size_t pitch = imageFormat.Pitch;
 
 		w = 255.0f / w;
 
-		for( int iy=0; iy < height; iy++ )
+		const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
+
+		ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
 		{
-			for( int ix=0; ix < width; ix++ )
-			{
-				*data = (unsigned char)(w * *fdata);
+			float * fdata = frame + firstRow * width;
+			unsigned char * cdata = data + firstRow * pitch;
 
-				fdata++;
-				data++;
+			for( int iy=0; iy < numRows; iy++ )
+			{
+				kernels.BytePrint(cdata, fdata, width, w);
+				fdata += width;
+				cdata += pitch;
 			}
-
-			data += deltaPitch;
-		}
+		});
 	}
 }
 
 void EasyByteSamplerImpl::ScaleFrame(float factor)
 {
+	if(EasySamplerSettings::ESA_Float != m_Accumulator)
+	{
+		// The fixed point accumulator is only used with a frame strength of 1, so this can only keep or clear:
+		assert(1 == factor || 0 == factor);
+
+		if(1 == factor || (0 == m_Frame->WeightSum && 0 == m_Frame->WeightTime))
+			return;
+
+		unsigned short * frame16 = m_Frame->Data16;
+		unsigned int * frame32 = m_Frame->Data32;
+
+		const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
+		size_t width = imageFormat.Width * imageFormat.GetPixelStride();
+
+		m_Frame->WeightSum = 0;
+		m_Frame->WeightTime = 0;
+
+		ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
+		{
+			if(frame16)
+				memset(frame16 + firstRow * width, 0, numRows * width * sizeof(unsigned short));
+			else
+				memset(frame32 + firstRow * width, 0, numRows * width * sizeof(unsigned int));
+		});
+		return;
+	}
+
 	float w = m_Frame->WhitePoint;
 
 	if(w * factor == w)
@@ -177,32 +409,31 @@ void EasyByteSamplerImpl::ScaleFrame(float factor)
 		return;
 	}
 	
+	float * frame = m_Frame->Data;
+
+	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
+	size_t width = imageFormat.Width * imageFormat.GetPixelStride();
+
 	if(0 == w * factor)
 	{
 		// Zero.
 		m_Frame->WhitePoint = 0;
 
-		const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
-		memset(m_Frame->Data, 0, imageFormat.Height * imageFormat.Width * imageFormat.GetPixelStride() * sizeof(float));
+		ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
+		{
+			memset(frame + firstRow * width, 0, numRows * width * sizeof(float));
+		});
 		return;
 	}
-	
-	float * fdata = m_Frame->Data;
-
-	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
-	int height = imageFormat.Height;
-	int width =imageFormat.Width * imageFormat.GetPixelStride();
 
 	m_Frame->WhitePoint *= factor;
 
-	for( int iy=0; iy < height; iy++ )
+	const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
+
+	ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
 	{
-		for( int ix=0; ix < width; ix++ )
-		{
-			*fdata = factor * *fdata;
-			fdata++;
-		}
-	}
+		kernels.Scale(frame + firstRow * width, numRows * width, factor);
+	});
 }
 
 
@@ -211,10 +442,12 @@ void EasyByteSamplerImpl::ScaleFrame(float factor)
 // EasyFloatSampler ////////////////////////////////////////////////////////////
 
 EasyFloatSamplerImpl::EasyFloatSamplerImpl(
-	EasySamplerSettings const & settings
+	EasySamplerSettings const & settings,
+	advancedfx::CThreadPool * threadPool
 )
 : EasySamplerBase(settings.FrameDuration_get(), settings.StartTime_get(), settings.Exposure_get())
 , m_Settings(settings)
+, m_ThreadPool(threadPool)
 {
 	const advancedfx::CImageFormat& imageFormat = settings.ImageFormat_get();
 	switch(imageFormat.Format) {
@@ -234,12 +467,14 @@ EasyFloatSamplerImpl::EasyFloatSamplerImpl(
 
 	m_FrameData = new float[height * width];
 	m_FrameWhitePoint = 0;
+
+	memset(m_FrameData, 0, sizeof(float) * height * width);
 }
 
 
 EasyFloatSamplerImpl::~EasyFloatSamplerImpl()
 {
-	delete m_FrameData;
+	delete [] m_FrameData;
 }
 
 void EasyFloatSamplerImpl::ClearFrame(float frameStrength)
@@ -252,24 +487,23 @@ void EasyFloatSamplerImpl::ClearFrame(float frameStrength)
 void EasyFloatSamplerImpl::Fn_1(void const * sample)
 {
 	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
-	int height = imageFormat.Height;
-	int width = imageFormat.Width;
-	size_t deltaPitch = imageFormat.Pitch - width *  imageFormat.GetPixelStride();
-	float *fdata = m_FrameData;
-	float const * cdata = (float const *)sample;
+	size_t width = imageFormat.Width;
+	size_t pitch = imageFormat.Pitch;
+	float * frame = m_FrameData;
+	const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
 
-	for( int iy=0; iy < height; iy++ )
+	ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
 	{
-		for( int ix=0; ix < width; ix++ ) 
+		float *fdata = frame + firstRow * width;
+		float const * cdata = (float const *)((unsigned char const *)sample + firstRow * pitch);
+
+		for( int iy=0; iy < numRows; iy++ )
 		{
-			*fdata = *fdata + *cdata;
-			
-			fdata++;
-			cdata++;
+			kernels.FloatFn_1(fdata, cdata, width);
+			fdata += width;
+			cdata = (float const *)((unsigned char const *)cdata + pitch);
 		}
-
-		cdata = (float const *)((unsigned char const *)cdata + deltaPitch);
-	}
+	});
 
 	m_FrameWhitePoint += 1.0f;
 }
@@ -277,52 +511,75 @@ void EasyFloatSamplerImpl::Fn_1(void const * sample)
 void EasyFloatSamplerImpl::Fn_2(void const * sample, float w)
 {
 	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
-	int height = imageFormat.Height;
-	int width = imageFormat.Width;
-	size_t deltaPitch = imageFormat.Pitch - width *  imageFormat.GetPixelStride();
-	float *fdata = m_FrameData;
-	float const * cdata = (float const *)sample;
+	size_t width = imageFormat.Width;
+	size_t pitch = imageFormat.Pitch;
+	float * frame = m_FrameData;
+	const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
 
-	for( int iy=0; iy < height; iy++ )
+	ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
 	{
-		for( int ix=0; ix < width; ix++ ) 
+		float *fdata = frame + firstRow * width;
+		float const * cdata = (float const *)((unsigned char const *)sample + firstRow * pitch);
+
+		for( int iy=0; iy < numRows; iy++ )
 		{
-			*fdata = *fdata + w * *cdata;
-			
-			fdata++;
-			cdata++;
+			kernels.FloatFn_2(fdata, cdata, width, w);
+			fdata += width;
+			cdata = (float const *)((unsigned char const *)cdata + pitch);
 		}
-
-		cdata = (float const *)((unsigned char const *)cdata + deltaPitch);
-	}
+	});
 
 	m_FrameWhitePoint += w * 1.0f;
 }
 
-void EasyFloatSamplerImpl::Fn_4(void const * sampleA, void const * sampleB, float w)
+void EasyFloatSamplerImpl::Fn_3(void const * sampleA, float wA, void const * sampleB, float wB)
 {
 	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
-	int height = imageFormat.Height;
-	int width = imageFormat.Width;
-	size_t deltaPitch = imageFormat.Pitch - width *  imageFormat.GetPixelStride();
-	float *fdata = m_FrameData;
-	float const * cdataA = (float const *)sampleA;
-	float const * cdataB = (float const *)sampleB;
+	size_t width = imageFormat.Width;
+	size_t pitch = imageFormat.Pitch;
+	float * frame = m_FrameData;
+	const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
 
-	for( int iy=0; iy < height; iy++ )
+	ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
 	{
-		for( int ix=0; ix < width; ix++ ) 
+		float *fdata = frame + firstRow * width;
+		float const * cdataA = (float const *)((unsigned char const *)sampleA + firstRow * pitch);
+		float const * cdataB = (float const *)((unsigned char const *)sampleB + firstRow * pitch);
+
+		for( int iy=0; iy < numRows; iy++ )
 		{
-			*fdata = *fdata + w * (*cdataA + *cdataB);
-			
-			fdata++;
-			cdataA++;
-			cdataB++;
+			kernels.FloatFn_3(fdata, cdataA, wA, cdataB, wB, width);
+			fdata += width;
+			cdataA = (float const *)((unsigned char const *)cdataA + pitch);
+			cdataB = (float const *)((unsigned char const *)cdataB + pitch);
 		}
+	});
 
-		cdataA = (float const *)((unsigned char const *)cdataA + deltaPitch);
-		cdataB = (float const *)((unsigned char const *)cdataB + deltaPitch);
-	}
+	m_FrameWhitePoint += (wA + wB) * 1.0f;
+}
+
+void EasyFloatSamplerImpl::Fn_4(void const * sampleA, void const * sampleB, float w)
+{
+	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
+	size_t width = imageFormat.Width;
+	size_t pitch = imageFormat.Pitch;
+	float * frame = m_FrameData;
+	const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
+
+	ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
+	{
+		float *fdata = frame + firstRow * width;
+		float const * cdataA = (float const *)((unsigned char const *)sampleA + firstRow * pitch);
+		float const * cdataB = (float const *)((unsigned char const *)sampleB + firstRow * pitch);
+
+		for( int iy=0; iy < numRows; iy++ )
+		{
+			kernels.FloatFn_4(fdata, cdataA, cdataB, width, w);
+			fdata += width;
+			cdataA = (float const *)((unsigned char const *)cdataA + pitch);
+			cdataB = (float const *)((unsigned char const *)cdataB + pitch);
+		}
+	});
 
 	m_FrameWhitePoint += w * 2.0f * 1.0f;
 }
@@ -340,26 +597,27 @@ void EasyFloatSamplerImpl::PrintFrame(float * data)
 	}
 	else
 	{
-		float * fdata = m_FrameData;
+		float * frame = m_FrameData;
 
-		int height = imageFormat.Height;
-		int width = imageFormat.Width;
-		size_t deltaPitch = imageFormat.Pitch - width *  imageFormat.GetPixelStride();
+		size_t width = imageFormat.Width;
+		size_t pitch = imageFormat.Pitch;
 
 		w = 1.0f / w;
 
-		for( int iy=0; iy < height; iy++ )
+		const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
+
+		ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
 		{
-			for( int ix=0; ix < width; ix++ )
-			{
-				*data = w * *fdata;
+			float * fdata = frame + firstRow * width;
+			float * cdata = (float *)((unsigned char *)data + firstRow * pitch);
 
-				fdata++;
-				data++;
+			for( int iy=0; iy < numRows; iy++ )
+			{
+				kernels.FloatPrint(cdata, fdata, width, w);
+				fdata += width;
+				cdata = (float *)((unsigned char *)cdata + pitch);
 			}
-
-			data = (float *)((unsigned char *)data + deltaPitch);
-		}
+		});
 	}
 }
 
@@ -373,32 +631,31 @@ void EasyFloatSamplerImpl::ScaleFrame(float factor)
 		return;
 	}
 	
+	float * frame = m_FrameData;
+
+	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
+	size_t width = imageFormat.Width;
+
 	if(0 == w * factor)
 	{
 		// Zero.
 		m_FrameWhitePoint = 0;
 
-		const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
-		memset(m_FrameData, 0, imageFormat.Height * imageFormat.Width * sizeof(float));
+		ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
+		{
+			memset(frame + firstRow * width, 0, numRows * width * sizeof(float));
+		});
 		return;
 	}
-	
-	float * fdata = m_FrameData;
-
-	const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
-	int height = imageFormat.Height;
-	int width = imageFormat.Width;
 
 	m_FrameWhitePoint *= factor;
 
-	for( int iy=0; iy < height; iy++ )
+	const advancedfx::EasySampler::Kernels_s& kernels = advancedfx::EasySampler::GetKernels();
+
+	ForEachRows(m_ThreadPool, imageFormat.Height, width, [&](int firstRow, int numRows)
 	{
-		for( int ix=0; ix < width; ix++ )
-		{
-			*fdata = factor * *fdata;
-			fdata++;
-		}
-	}
+		kernels.Scale(frame + firstRow * width, numRows * width, factor);
+	});
 }
 
 
@@ -416,6 +673,9 @@ EasySamplerBase::EasySamplerBase(
 	m_ShutterOpen = 0.0 < exposure;
 	m_ShutterOpenDuration = frameDuration * (exposure < 0 ? 0 : (exposure > 1 ? 1 : exposure));
 	m_ShutterTime = m_LastFrameTime;
+	m_PendingSampleWeight = 0;
+	m_LastSampleWeight = 0;
+	m_CurSampleWeight = 0;
 }
 
 
@@ -550,6 +810,124 @@ void EasySamplerBase::Integrator_Fn(ISampleFns *fns, void const * sampleA, void
 }
 
 
+void EasySamplerBase::Integrator_Add(bool hasLastSample, bool hasCurSample, double timeA, double timeB, double subTimeA, double subTimeB)
+{
+	double weightA;
+	double weightB;
+
+	{
+		// Calculate weigths (same as Integrator_Fn):
+		double dAB = timeB -timeA;
+		double w1 = (subTimeB -subTimeA) / 2.0;
+		double w2 = dAB ? (subTimeA +subTimeB -2.0 * timeA) / dAB : 0.0;
+		weightA = w1 * (2 -w2);
+		weightB = w1 * w2;
+	}
+
+	// Same cases as Integrator_Fn:
+
+	if(hasLastSample)
+	{
+		m_LastSampleWeight += weightA;
+
+		if(hasCurSample) m_CurSampleWeight += weightB;
+	}
+	else if(hasCurSample)
+	{
+		// 1 point sampling.
+
+		m_CurSampleWeight += weightA + weightB;
+	}
+}
+
+void EasySamplerBase::Integrator_Flush(ISampleFns *fns, void const *pendingSample, void const *lastSample, void const *curSample)
+{
+	Integrator_Accumulate(fns, pendingSample, m_PendingSampleWeight, lastSample, m_LastSampleWeight);
+	Integrator_Accumulate(fns, curSample, m_CurSampleWeight, 0, 0);
+
+	m_PendingSampleWeight = 0;
+	m_LastSampleWeight = 0;
+	m_CurSampleWeight = 0;
+}
+
+EasySamplerBase::PendingSample_e EasySamplerBase::Integrator_Next(ISampleFns *fns, void const *pendingSample, void const *lastSample, void const *curSample, bool keepCurSample)
+{
+	// Finished samples, in order:
+
+	void const * samples[3];
+	double weights[3];
+	PendingSample_e results[3];
+	int count = 0;
+
+	if(pendingSample && 0 != m_PendingSampleWeight)
+	{
+		samples[count] = pendingSample; weights[count] = m_PendingSampleWeight; results[count] = PendingSample_Keep; ++count;
+	}
+	if(lastSample && 0 != m_LastSampleWeight)
+	{
+		samples[count] = lastSample; weights[count] = m_LastSampleWeight; results[count] = PendingSample_Last; ++count;
+	}
+	if(!keepCurSample && curSample && 0 != m_CurSampleWeight)
+	{
+		samples[count] = curSample; weights[count] = m_CurSampleWeight; results[count] = PendingSample_Cur; ++count;
+	}
+
+	PendingSample_e result = PendingSample_None;
+	m_PendingSampleWeight = 0;
+
+	int first = 0;
+
+	if(2 <= count)
+	{
+		Integrator_Accumulate(fns, samples[0], weights[0], samples[1], weights[1]);
+		first = 2;
+	}
+
+	if(first < count)
+	{
+		result = results[first];
+		m_PendingSampleWeight = weights[first];
+	}
+
+	m_LastSampleWeight = keepCurSample ? m_CurSampleWeight : 0;
+	m_CurSampleWeight = 0;
+
+	return result;
+}
+
+void EasySamplerBase::Integrator_Accumulate(ISampleFns *fns, void const *sampleA, double weightA, void const *sampleB, double weightB)
+{
+	if(0 == sampleA || 0 == weightA)
+	{
+		sampleA = sampleB;
+		weightA = weightB;
+		sampleB = 0;
+		weightB = 0;
+	}
+
+	if(0 == sampleA || 0 == weightA)
+	{
+		return; // done.
+	}
+
+	if(0 == sampleB || 0 == weightB)
+	{
+		if(1 == weightA)
+			fns->Fn_1(sampleA);
+		else
+			fns->Fn_2(sampleA, (float)weightA);
+	}
+	else if(weightA == weightB)
+	{
+		fns->Fn_4(sampleA, sampleB, (float)weightA);
+	}
+	else
+	{
+		fns->Fn_3(sampleA, (float)weightA, sampleB, (float)weightB);
+	}
+}
+
+
 void EasySamplerBase::Sample(double time)
 {	
 	double subMin = m_LastSampleTime;
@@ -636,7 +1014,8 @@ EasySamplerSettings::EasySamplerSettings(
 	double frameDuration,
 	double startTime,
 	double exposure,
-	float frameStrength)
+	float frameStrength,
+	double sampleDuration)
 : m_ImageFormat(imageFormat)
 {
 	assert(0 <= imageFormat.Height);
@@ -647,6 +1026,36 @@ EasySamplerSettings::EasySamplerSettings(
 	m_FrameStrength = frameStrength;
 	m_Method = method;
 	m_StartTime = startTime;
+	m_SampleDuration = sampleDuration;
+	m_ByteAccumulator = ESA_Float;
+	m_FixedPointBits = 0;
+	m_FixedPointMaxWeight = 0;
+
+	// Fixed point needs the weights to be multiples of a known unit and no fractional carry-over between frames:
+	if(ESM_Rectangle == method && 1.0f == frameStrength && 0 < sampleDuration && 0 < frameDuration && 0 < exposure)
+	{
+		double samples = ceil(frameDuration * (1 < exposure ? 1 : exposure) / sampleDuration);
+
+		// +1: Rounding the partial samples at both ends of the shutter.
+		// ESA_Fixed16 only while at least 4 fraction bits (1/16 sample) remain for the partial samples:
+		if(samples * 16 + 1 <= 0xffff / 255)
+		{
+			m_ByteAccumulator = ESA_Fixed16;
+			m_FixedPointMaxWeight = 0xffff / 255;
+		}
+		else if(samples + 1 <= 0x7fffffff / 255)
+		{
+			m_ByteAccumulator = ESA_Fixed32;
+			m_FixedPointMaxWeight = 0x7fffffff / 255;
+		}
+
+		// Use the remaining range for fraction bits, at most 15, so that a single weight fits 16 bit:
+		if(ESA_Float != m_ByteAccumulator)
+		{
+			while(m_FixedPointBits < 15 && samples * (double)(2 << m_FixedPointBits) + 1 <= m_FixedPointMaxWeight)
+				++m_FixedPointBits;
+		}
+	}
 }
 
 EasySamplerSettings::EasySamplerSettings(EasySamplerSettings const & settings)
@@ -657,6 +1066,10 @@ EasySamplerSettings::EasySamplerSettings(EasySamplerSettings const & settings)
 	m_FrameStrength = settings.FrameStrength_get();
 	m_Method = settings.Method_get();
 	m_StartTime = settings.StartTime_get();
+	m_SampleDuration = settings.SampleDuration_get();
+	m_ByteAccumulator = settings.ByteAccumulator_get();
+	m_FixedPointBits = settings.FixedPointBits_get();
+	m_FixedPointMaxWeight = settings.FixedPointMaxWeight_get();
 }
 
 const advancedfx::CImageFormat& EasySamplerSettings::ImageFormat_get() const {
@@ -683,3 +1096,19 @@ double EasySamplerSettings::StartTime_get() const
 {
 	return m_StartTime;
 }
+double EasySamplerSettings::SampleDuration_get() const
+{
+	return m_SampleDuration;
+}
+EasySamplerSettings::Accumulator EasySamplerSettings::ByteAccumulator_get() const
+{
+	return m_ByteAccumulator;
+}
+int EasySamplerSettings::FixedPointBits_get() const
+{
+	return m_FixedPointBits;
+}
+unsigned int EasySamplerSettings::FixedPointMaxWeight_get() const
+{
+	return m_FixedPointMaxWeight;
+}
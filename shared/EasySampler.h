@@ -1,19 +1,15 @@
 #pragma once
 
-// TODO:
-//
-// In the average case where the full range of a sample is
-// used (within a frame), CPU power is wasted, because the same multiplication
-// is done twice when interpolating from the next sample.
-// (First it's the new one, then the old one and factors
-// are about the same, this is a waste).
-
 #include "ImageFormat.h"
 #include "TImageBuffer.h"
 #include "TGrowingBufferPool.h"
 
 #include <memory.h>
 
+namespace advancedfx {
+	class CThreadPool;
+}
+
 template<bool bThreadSafe> class __declspec(novtable) IFramePrinter abstract
 {
 public:
@@ -29,6 +25,9 @@ public:
 	/// <summary>frame += w * sample </summary>
 	virtual void Fn_2(void const *sample, float w) abstract = 0;
 
+	/// <summary>frame += wA * sampleA + wB * sampleB</summary>
+	virtual void Fn_3(void const *sampleA, float wA, void const *sampleB, float wB) abstract = 0;
+
 	/// <summary>frame += w * (sampleA + sampleB)</summary>
 	virtual void Fn_4(void const *sampleA, void const *sampleB, float w) abstract = 0;
 };
@@ -43,6 +42,7 @@ public:
 class EasySamplerBase abstract
 {
 public:
+	virtual ~EasySamplerBase() {}
 
 protected:
 	/// <param name="exposure">time the shutter is kept open measured in number of frames</param>
@@ -89,15 +89,64 @@ protected:
 	/// </summary>
 	/// <param name="sampleA">can be 0</param>
 	/// <param name="sampleB">can be 0</param>
+	/// <remarks>
+	///   Accumulates both samples for every sub-integral, so in trapezoid mode every sample is
+	///   accumulated twice. EasyByteSampler / EasyFloatSampler use Integrator_Add instead.
+	/// </remarks>
 	static void Integrator_Fn(ISampleFns *fns, void const *sampleA, void const *sampleB, double timeA, double timeB, double subTimeA, double subTimeB);
 
+	enum PendingSample_e
+	{
+		PendingSample_None,
+		PendingSample_Keep,
+		PendingSample_Last,
+		PendingSample_Cur
+	};
+
+	/// <summary>
+	///   Same integration as Integrator_Fn, but only collects the weights per sample:<br />
+	///   The weights a sample gets from the sub-integrals before and after it are summed up and
+	///   the sample is accumulated once, two finished samples in one pass (see Integrator_Next).
+	/// </summary>
+	/// <remarks>
+	///   Exact with dyadic weights. Otherwise summing the weights first rounds differently than
+	///   accumulating twice: a float frame differs by at most one float epsilon per accumulated sample
+	///   (relative to the frame value), a byte frame by at most 1.
+	/// </remarks>
+	/// <param name="hasLastSample">The sample at timeA is available.</param>
+	/// <param name="hasCurSample">The sample at timeB is available.</param>
+	void Integrator_Add(bool hasLastSample, bool hasCurSample, double timeA, double timeB, double subTimeA, double subTimeB);
+
+	/// <summary>
+	///   Accumulates all collected weights, must be called before the frame is printed.<br />
+	///   The pending sample is not needed anymore afterwards.
+	/// </summary>
+	/// <param name="pendingSample">can be 0</param>
+	/// <param name="lastSample">can be 0</param>
+	/// <param name="curSample">can be 0</param>
+	void Integrator_Flush(ISampleFns *fns, void const *pendingSample, void const *lastSample, void const *curSample);
+
+	/// <summary>
+	///   Must be called after Sample(double), when the last sample is not needed anymore and
+	///   the current sample becomes the next last sample (keepCurSample) or is not needed anymore either.<br />
+	///   Finished samples are accumulated in pairs, a single one is kept pending until it can be paired.
+	/// </summary>
+	/// <returns>Which sample to keep as pending sample from now on (PendingSample_Keep: the current one).</returns>
+	PendingSample_e Integrator_Next(ISampleFns *fns, void const *pendingSample, void const *lastSample, void const *curSample, bool keepCurSample);
+
 private:
+	/// <summary>frame += weightA * sampleA + weightB * sampleB in one pass, samples / weights can be 0.</summary>
+	static void Integrator_Accumulate(ISampleFns *fns, void const *sampleA, double weightA, void const *sampleB, double weightB);
+
 	double m_FrameDuration;
 	double m_LastFrameTime;
 	double m_LastSampleTime;
 	bool m_ShutterOpen;
 	double m_ShutterOpenDuration;
 	double m_ShutterTime;
+	double m_PendingSampleWeight;
+	double m_LastSampleWeight;
+	double m_CurSampleWeight;
 };
 
 
@@ -115,13 +164,27 @@ public:
 		ESM_Trapezoid
 	};
 
+	/// <summary>Frame accumulator of EasyByteSampler.</summary>
+	enum Accumulator
+	{
+		ESA_Float,
+		ESA_Fixed16,
+		ESA_Fixed32
+	};
+
+	/// <param name="sampleDuration">
+	///   Expected time between two samples, 0 if unknown.<br />
+	///   With rectangle sampling and a frameStrength of 1 this allows EasyByteSampler to
+	///   accumulate in fixed point, see ByteAccumulator_get.
+	/// </param>
 	EasySamplerSettings(
 		const advancedfx::CImageFormat& imageFormat,
 		Method method,
 		double frameDuration,
 		double startTime,
 		double exposure,
-		float frameStrength
+		float frameStrength,
+		double sampleDuration = 0
 	);
 
 	EasySamplerSettings(EasySamplerSettings const & settings);
@@ -133,6 +196,20 @@ public:
 	float FrameStrength_get() const;
 	Method Method_get() const;
 	double StartTime_get() const;
+	double SampleDuration_get() const;
+
+	/// <summary>
+	///   ESA_Fixed16 / ESA_Fixed32 if the weights can be integers: Rectangle sampling,
+	///   frameStrength 1 and a known sampleDuration. The weights are in units of
+	///   sampleDuration / 2^FixedPointBits_get(), picked so that the weights of a frame
+	///   (the shutter duration plus one sample) fit in FixedPointMaxWeight_get(),
+	///   ESA_Fixed16 is used for up to 16 samples per frame, so that the weights keep
+	///   at least 4 fraction bits.
+	/// </summary>
+	Accumulator ByteAccumulator_get() const;
+	int FixedPointBits_get() const;
+	/// <summary>Maximum sum of the weights of a frame, so that 255 times it fits the accumulator.</summary>
+	unsigned int FixedPointMaxWeight_get() const;
 
 private:
 	double m_Exposure;
@@ -140,6 +217,10 @@ private:
 	float m_FrameStrength;
 	Method m_Method;
 	double m_StartTime;
+	double m_SampleDuration;
+	Accumulator m_ByteAccumulator;
+	int m_FixedPointBits;
+	unsigned int m_FixedPointMaxWeight;
 	advancedfx::CImageFormat m_ImageFormat;
 };
 
@@ -151,8 +232,10 @@ class EasyByteSamplerImpl : public EasySamplerBase,
 {
 public:
 	/// <param name="pitch">bytes of memory to skip for a row</param>
+	/// <param name="threadPool">can be 0, otherwise the frame operations are split into row tiles on it</param>
 	EasyByteSamplerImpl(
-		EasySamplerSettings const & settings
+		EasySamplerSettings const & settings,
+		advancedfx::CThreadPool * threadPool = nullptr
 	);
 
 	~EasyByteSamplerImpl();
@@ -169,24 +252,66 @@ private:
 	class Frame
 	{
 	public:
-		Frame(size_t length)
+		/// <remarks>Only the buffer of the accumulator is allocated, the others are 0.</remarks>
+		Frame(size_t length, EasySamplerSettings::Accumulator accumulator)
 		{
-			Data = new float[length];
+			Data = nullptr;
+			Data16 = nullptr;
+			Data32 = nullptr;
 			WhitePoint = 0;
-
-			memset(Data, 0, sizeof(float) * length);
+			WeightSum = 0;
+			WeightTime = 0;
+
+			switch(accumulator)
+			{
+			case EasySamplerSettings::ESA_Fixed16:
+				Data16 = new unsigned short[length];
+				memset(Data16, 0, sizeof(unsigned short) * length);
+				break;
+			case EasySamplerSettings::ESA_Fixed32:
+				Data32 = new unsigned int[length];
+				memset(Data32, 0, sizeof(unsigned int) * length);
+				break;
+			default:
+				Data = new float[length];
+				memset(Data, 0, sizeof(float) * length);
+				break;
+			}
 		}
 
 		~Frame()
 		{
-			delete Data;
+			delete [] Data;
+			delete [] Data16;
+			delete [] Data32;
 		}
 
 		float * Data;
+		unsigned short * Data16;
+		unsigned int * Data32;
 		float WhitePoint;
+
+		/// <summary>Fixed point: sum of the integer weights accumulated.</summary>
+		unsigned int WeightSum;
+
+		/// <summary>Fixed point: sum of the weights accumulated (unquantized).</summary>
+		double WeightTime;
 	};
 
 	Frame * m_Frame;
+	advancedfx::CThreadPool * m_ThreadPool;
+	EasySamplerSettings::Accumulator m_Accumulator;
+	double m_FixedPointScale;
+
+	/// <summary>Quantizes the weight w for the fixed point accumulator.</summary>
+	/// <remarks>
+	///   Rounds the running sum instead of each weight, so the rounding errors don't add up over the frame
+	///   and WeightSum stays within EasySamplerSettings::FixedPointMaxWeight_get().
+	/// </remarks>
+	unsigned int FixedPoint_Weight(double w);
+
+	/// <summary>frame += qA * sampleA + qB * sampleB for the fixed point accumulator, sampleB can be 0.</summary>
+	void FixedPoint_Fn(void const * sampleA, unsigned int qA, void const * sampleB, unsigned int qB);
 
 	/// <summary>Implements ISampleFns.</summary>
 	virtual void Fn_1(void const * sample) override;
@@ -194,6 +319,9 @@ private:
 	/// <summary>Implements ISampleFns.</summary>
 	virtual void Fn_2(void const * sample, float w) override;
 
+	/// <summary>Implements ISampleFns.</summary>
+	virtual void Fn_3(void const * sampleA, float wA, void const * sampleB, float wB) override;
+
 	/// <summary>Implements ISampleFns.</summary>
 	virtual void Fn_4(void const * sampleA, void const * sampleB, float w) override;
 
@@ -205,11 +333,13 @@ template<bool bThreadSafe> class EasyByteSampler
 {
 public:
 	/// <param name="pitch">bytes of memory to skip for a row</param>
+	/// <param name="threadPool">can be 0, see EasyByteSamplerImpl</param>
 	EasyByteSampler(
 		EasySamplerSettings const & settings,
 		IFramePrinter<bThreadSafe> * framePrinter,
-		advancedfx::TGrowingBufferPool<bThreadSafe> * pGrowingBufferPool)
-	: EasyByteSamplerImpl(settings)
+		advancedfx::TGrowingBufferPool<bThreadSafe> * pGrowingBufferPool,
+		advancedfx::CThreadPool * threadPool = nullptr)
+	: EasyByteSamplerImpl(settings, threadPool)
 	, m_FramePrinter(framePrinter)
 	, m_pGrowingBufferPool(pGrowingBufferPool)
 	{
@@ -217,6 +347,7 @@ public:
 
 	~EasyByteSampler() {
 		// ? // PrintFrame();
+		if(m_pPendingSample) m_pPendingSample->Release();
 		if(m_pLastSample) m_pLastSample->Release();
 	}
 
@@ -237,6 +368,21 @@ public:
 
 		bool twoPoint = EasySamplerSettings::ESM_Trapezoid == m_Settings.Method_get();
 
+		switch(Integrator_Next(this, GetSampleData(m_pPendingSample), GetSampleData(m_pLastSample), GetSampleData(m_pCurSample), twoPoint && pImageBuffer))
+		{
+		case PendingSample_Keep:
+			break;
+		case PendingSample_Last:
+			SetPendingSample(m_pLastSample);
+			break;
+		case PendingSample_Cur:
+			SetPendingSample(m_pCurSample);
+			break;
+		default:
+			SetPendingSample(nullptr);
+			break;
+		}
+
 		if(twoPoint && pImageBuffer)
 		{
 			if(m_pLastSample)  m_pLastSample->Release();
@@ -256,6 +402,8 @@ public:
 protected:
 	virtual void EasySamplerBase::MakeFrame() override
 	{
+		Integrator_Flush(this, GetSampleData(m_pPendingSample), GetSampleData(m_pLastSample), GetSampleData(m_pCurSample));
+		SetPendingSample(nullptr);
 		PrintFrame();
 		ClearFrame(m_Settings.FrameStrength_get());
 	}
@@ -266,18 +414,29 @@ protected:
 		double subTimeA,
 		double subTimeB
 	) override {
-		Integrator_Fn(this,
-			m_pLastSample ? m_pLastSample->GetImageBufferData() : nullptr, m_pCurSample->GetImageBufferData(),
-			timeA, timeB, subTimeA, subTimeB
-		);
+		Integrator_Add(nullptr != m_pLastSample, nullptr != m_pCurSample, timeA, timeB, subTimeA, subTimeB);
 	}
 
 private:
 	advancedfx::TGrowingBufferPool<bThreadSafe> * m_pGrowingBufferPool;
 	advancedfx::TIImageBuffer<bThreadSafe> * m_pCurSample = nullptr;
 	advancedfx::TIImageBuffer<bThreadSafe> * m_pLastSample = nullptr;
+	/// <summary>Finished sample waiting to be accumulated together with the next one, see Integrator_Next.</summary>
+	advancedfx::TIImageBuffer<bThreadSafe> * m_pPendingSample = nullptr;
 	IFramePrinter<bThreadSafe> * m_FramePrinter;
 
+	static void const * GetSampleData(advancedfx::TIImageBuffer<bThreadSafe> * pSample)
+	{
+		return pSample ? pSample->GetImageBufferData() : nullptr;
+	}
+
+	void SetPendingSample(advancedfx::TIImageBuffer<bThreadSafe> * pSample)
+	{
+		if(pSample) pSample->AddRef();
+		if(m_pPendingSample) m_pPendingSample->Release();
+		m_pPendingSample = pSample;
+	}
+
 	void PrintFrame()
 	{
 		const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
@@ -299,8 +458,10 @@ class EasyFloatSamplerImpl : public EasySamplerBase,
 	protected ISampleFns
 {
 public:
+	/// <param name="threadPool">can be 0, otherwise the frame operations are split into row tiles on it</param>
 	EasyFloatSamplerImpl(
-		EasySamplerSettings const & settings
+		EasySamplerSettings const & settings,
+		advancedfx::CThreadPool * threadPool = nullptr
 	);
 
 	~EasyFloatSamplerImpl();
@@ -315,6 +476,7 @@ protected:
 private:
 	float * m_FrameData;
 	float m_FrameWhitePoint;
+	advancedfx::CThreadPool * m_ThreadPool;
 
 	/// <summary>Implements ISampleFns.</summary>
 	virtual void Fn_1(void const * sample);
@@ -322,6 +484,9 @@ private:
 	/// <summary>Implements ISampleFns.</summary>
 	virtual void Fn_2(void const * sample, float w);
 
+	/// <summary>Implements ISampleFns.</summary>
+	virtual void Fn_3(void const * sampleA, float wA, void const * sampleB, float wB);
+
 	/// <summary>Implements ISampleFns.</summary>
 	virtual void Fn_4(void const * sampleA, void const * sampleB, float w);
 
@@ -332,12 +497,14 @@ template<bool bThreadSafe> class EasyFloatSampler
 : public EasyFloatSamplerImpl
 {
 public:
+	/// <param name="threadPool">can be 0, see EasyFloatSamplerImpl</param>
 	EasyFloatSampler(
 		EasySamplerSettings const & settings,
 		IFramePrinter<bThreadSafe> * framePrinter,
-		advancedfx::TGrowingBufferPool<bThreadSafe> * pGrowingBufferPool
+		advancedfx::TGrowingBufferPool<bThreadSafe> * pGrowingBufferPool,
+		advancedfx::CThreadPool * threadPool = nullptr
 	)
-	: EasyFloatSamplerImpl(settings)
+	: EasyFloatSamplerImpl(settings, threadPool)
 	, m_FramePrinter(framePrinter)
 	, m_pGrowingBufferPool(pGrowingBufferPool)
 	{
@@ -347,6 +514,7 @@ public:
 	{
 		// ? // PrintFrame();
 
+		if(m_pPendingSample) m_pPendingSample->Release();
 		if(m_pLastSample) m_pLastSample->Release();
 	}	
 
@@ -367,6 +535,21 @@ public:
 
 		bool twoPoint = EasySamplerSettings::ESM_Trapezoid == m_Settings.Method_get();
 
+		switch(Integrator_Next(this, GetSampleData(m_pPendingSample), GetSampleData(m_pLastSample), GetSampleData(m_pCurSample), twoPoint && pImageBuffer))
+		{
+		case PendingSample_Keep:
+			break;
+		case PendingSample_Last:
+			SetPendingSample(m_pLastSample);
+			break;
+		case PendingSample_Cur:
+			SetPendingSample(m_pCurSample);
+			break;
+		default:
+			SetPendingSample(nullptr);
+			break;
+		}
+
 		if(twoPoint && pImageBuffer)
 		{
 			if(m_pLastSample)  m_pLastSample->Release();
@@ -386,6 +569,8 @@ public:
 protected:
 	virtual void EasySamplerBase::MakeFrame()
 	{
+		Integrator_Flush(this, GetSampleData(m_pPendingSample), GetSampleData(m_pLastSample), GetSampleData(m_pCurSample));
+		SetPendingSample(nullptr);
 		PrintFrame();
 		ClearFrame(m_Settings.FrameStrength_get());
 	}
@@ -396,18 +581,29 @@ protected:
 		double subTimeA,
 		double subTimeB)
 	{
-		Integrator_Fn(this,
-			m_pLastSample ? m_pLastSample->GetImageBufferData() : nullptr, m_pCurSample->GetImageBufferData(),
-			timeA, timeB, subTimeA, subTimeB
-		);
+		Integrator_Add(nullptr != m_pLastSample, nullptr != m_pCurSample, timeA, timeB, subTimeA, subTimeB);
 	}
 
 private:
 	advancedfx::TGrowingBufferPool<bThreadSafe> * m_pGrowingBufferPool;
 	advancedfx::TIImageBuffer<bThreadSafe> * m_pCurSample = nullptr;
 	advancedfx::TIImageBuffer<bThreadSafe> * m_pLastSample = nullptr;
+	/// <summary>Finished sample waiting to be accumulated together with the next one, see Integrator_Next.</summary>
+	advancedfx::TIImageBuffer<bThreadSafe> * m_pPendingSample = nullptr;
 	IFramePrinter<bThreadSafe> * m_FramePrinter;
 
+	static void const * GetSampleData(advancedfx::TIImageBuffer<bThreadSafe> * pSample)
+	{
+		return pSample ? pSample->GetImageBufferData() : nullptr;
+	}
+
+	void SetPendingSample(advancedfx::TIImageBuffer<bThreadSafe> * pSample)
+	{
+		if(pSample) pSample->AddRef();
+		if(m_pPendingSample) m_pPendingSample->Release();
+		m_pPendingSample = pSample;
+	}
+
 	void PrintFrame()
 	{
 		const advancedfx::CImageFormat& imageFormat = m_Settings.ImageFormat_get();
@@ -0,0 +1,747 @@
+#include "stdafx.h"
+
+#include "EasySamplerKernels.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(_M_AMD64) || defined(__i386__) || defined(__x86_64__)
+#define ADVANCEDFX_EASYSAMPLER_X86
+#include <immintrin.h>
+#endif
+
+// MSVC allows intrinsics of any instruction set in any function, GCC / Clang need them enabled per function:
+#if defined(__GNUC__)
+#define ADVANCEDFX_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ADVANCEDFX_TARGET(isa)
+#endif
+
+namespace advancedfx {
+namespace EasySampler {
+
+////////////////////////////////////////////////////////////////////////////////
+// Scalar (reference)
+
+static void ByteFn_1_Scalar(float* frame, const unsigned char* sample, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = frame[i] + sample[i];
+	}
+}
+
+static void ByteFn_2_Scalar(float* frame, const unsigned char* sample, size_t count, float w) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = frame[i] + w * sample[i];
+	}
+}
+
+static void ByteFn_3_Scalar(float* frame, const unsigned char* sampleA, float wA, const unsigned char* sampleB, float wB, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = frame[i] + wA * sampleA[i] + wB * sampleB[i];
+	}
+}
+
+static void ByteFn_4_Scalar(float* frame, const unsigned char* sampleA, const unsigned char* sampleB, size_t count, float w) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = frame[i] + w * ((unsigned int)sampleA[i] + (unsigned int)sampleB[i]);
+	}
+}
+
+static void BytePrint_Scalar(unsigned char* data, const float* frame, size_t count, float w) {
+	for (size_t i = 0; i < count; ++i) {
+		float value = w * frame[i];
+		data[i] = (unsigned char)(value < 0.0f ? 0.0f : (255.0f < value ? 255.0f : value));
+	}
+}
+
+static void FloatFn_1_Scalar(float* frame, const float* sample, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = frame[i] + sample[i];
+	}
+}
+
+static void FloatFn_2_Scalar(float* frame, const float* sample, size_t count, float w) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = frame[i] + w * sample[i];
+	}
+}
+
+static void FloatFn_3_Scalar(float* frame, const float* sampleA, float wA, const float* sampleB, float wB, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = frame[i] + wA * sampleA[i] + wB * sampleB[i];
+	}
+}
+
+static void FloatFn_4_Scalar(float* frame, const float* sampleA, const float* sampleB, size_t count, float w) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = frame[i] + w * (sampleA[i] + sampleB[i]);
+	}
+}
+
+static void FloatPrint_Scalar(float* data, const float* frame, size_t count, float w) {
+	for (size_t i = 0; i < count; ++i) {
+		data[i] = w * frame[i];
+	}
+}
+
+static void Scale_Scalar(float* frame, size_t count, float factor) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = factor * frame[i];
+	}
+}
+
+static void ByteFn_2_U16_Scalar(unsigned short* frame, const unsigned char* sample, size_t count, unsigned int q) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = (unsigned short)(frame[i] + q * sample[i]);
+	}
+}
+
+static void ByteFn_3_U16_Scalar(unsigned short* frame, const unsigned char* sampleA, unsigned int qA, const unsigned char* sampleB, unsigned int qB, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = (unsigned short)(frame[i] + qA * sampleA[i] + qB * sampleB[i]);
+	}
+}
+
+static void BytePrint_U16_Scalar(unsigned char* data, const unsigned short* frame, size_t count, float w) {
+	for (size_t i = 0; i < count; ++i) {
+		float value = w * ((float)frame[i] + 0.5f);
+		data[i] = (unsigned char)(255.0f < value ? 255.0f : value);
+	}
+}
+
+static void ByteFn_2_U32_Scalar(unsigned int* frame, const unsigned char* sample, size_t count, unsigned int q) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = frame[i] + q * sample[i];
+	}
+}
+
+static void ByteFn_3_U32_Scalar(unsigned int* frame, const unsigned char* sampleA, unsigned int qA, const unsigned char* sampleB, unsigned int qB, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		frame[i] = frame[i] + qA * sampleA[i] + qB * sampleB[i];
+	}
+}
+
+static void BytePrint_U32_Scalar(unsigned char* data, const unsigned int* frame, size_t count, float w) {
+	for (size_t i = 0; i < count; ++i) {
+		float value = w * ((float)(int)frame[i] + 0.5f);
+		data[i] = (unsigned char)(255.0f < value ? 255.0f : value);
+	}
+}
+
+#ifdef ADVANCEDFX_EASYSAMPLER_X86
+
+////////////////////////////////////////////////////////////////////////////////
+// SSE2
+//
+// 16 values at a time, tails are done by the scalar kernels.
+
+// 16 bytes (zero extended to 16 bit) to 2x 4 floats.
+ADVANCEDFX_TARGET("sse2")
+static inline void Widen8_SSE2(__m128i v16, __m128& out0, __m128& out1) {
+	const __m128i zero = _mm_setzero_si128();
+	out0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v16, zero));
+	out1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v16, zero));
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void ByteFn_1_SSE2(float* frame, const unsigned char* sample, size_t count) {
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(sample + i));
+		__m128 f0, f1, f2, f3;
+		Widen8_SSE2(_mm_unpacklo_epi8(v, zero), f0, f1);
+		Widen8_SSE2(_mm_unpackhi_epi8(v, zero), f2, f3);
+		_mm_storeu_ps(frame + i + 0, _mm_add_ps(_mm_loadu_ps(frame + i + 0), f0));
+		_mm_storeu_ps(frame + i + 4, _mm_add_ps(_mm_loadu_ps(frame + i + 4), f1));
+		_mm_storeu_ps(frame + i + 8, _mm_add_ps(_mm_loadu_ps(frame + i + 8), f2));
+		_mm_storeu_ps(frame + i + 12, _mm_add_ps(_mm_loadu_ps(frame + i + 12), f3));
+	}
+	ByteFn_1_Scalar(frame + i, sample + i, count - i);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void ByteFn_2_SSE2(float* frame, const unsigned char* sample, size_t count, float w) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 weight = _mm_set1_ps(w);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(sample + i));
+		__m128 f0, f1, f2, f3;
+		Widen8_SSE2(_mm_unpacklo_epi8(v, zero), f0, f1);
+		Widen8_SSE2(_mm_unpackhi_epi8(v, zero), f2, f3);
+		_mm_storeu_ps(frame + i + 0, _mm_add_ps(_mm_loadu_ps(frame + i + 0), _mm_mul_ps(weight, f0)));
+		_mm_storeu_ps(frame + i + 4, _mm_add_ps(_mm_loadu_ps(frame + i + 4), _mm_mul_ps(weight, f1)));
+		_mm_storeu_ps(frame + i + 8, _mm_add_ps(_mm_loadu_ps(frame + i + 8), _mm_mul_ps(weight, f2)));
+		_mm_storeu_ps(frame + i + 12, _mm_add_ps(_mm_loadu_ps(frame + i + 12), _mm_mul_ps(weight, f3)));
+	}
+	ByteFn_2_Scalar(frame + i, sample + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void ByteFn_3_SSE2(float* frame, const unsigned char* sampleA, float wA, const unsigned char* sampleB, float wB, size_t count) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 weightA = _mm_set1_ps(wA);
+	const __m128 weightB = _mm_set1_ps(wB);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(sampleA + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(sampleB + i));
+		__m128 a0, a1, a2, a3, b0, b1, b2, b3;
+		Widen8_SSE2(_mm_unpacklo_epi8(a, zero), a0, a1);
+		Widen8_SSE2(_mm_unpackhi_epi8(a, zero), a2, a3);
+		Widen8_SSE2(_mm_unpacklo_epi8(b, zero), b0, b1);
+		Widen8_SSE2(_mm_unpackhi_epi8(b, zero), b2, b3);
+		_mm_storeu_ps(frame + i + 0, _mm_add_ps(_mm_add_ps(_mm_loadu_ps(frame + i + 0), _mm_mul_ps(weightA, a0)), _mm_mul_ps(weightB, b0)));
+		_mm_storeu_ps(frame + i + 4, _mm_add_ps(_mm_add_ps(_mm_loadu_ps(frame + i + 4), _mm_mul_ps(weightA, a1)), _mm_mul_ps(weightB, b1)));
+		_mm_storeu_ps(frame + i + 8, _mm_add_ps(_mm_add_ps(_mm_loadu_ps(frame + i + 8), _mm_mul_ps(weightA, a2)), _mm_mul_ps(weightB, b2)));
+		_mm_storeu_ps(frame + i + 12, _mm_add_ps(_mm_add_ps(_mm_loadu_ps(frame + i + 12), _mm_mul_ps(weightA, a3)), _mm_mul_ps(weightB, b3)));
+	}
+	ByteFn_3_Scalar(frame + i, sampleA + i, wA, sampleB + i, wB, count - i);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void ByteFn_4_SSE2(float* frame, const unsigned char* sampleA, const unsigned char* sampleB, size_t count, float w) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 weight = _mm_set1_ps(w);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(sampleA + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(sampleB + i));
+		// The sum of two bytes fits 16 bit:
+		__m128 f0, f1, f2, f3;
+		Widen8_SSE2(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)), f0, f1);
+		Widen8_SSE2(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)), f2, f3);
+		_mm_storeu_ps(frame + i + 0, _mm_add_ps(_mm_loadu_ps(frame + i + 0), _mm_mul_ps(weight, f0)));
+		_mm_storeu_ps(frame + i + 4, _mm_add_ps(_mm_loadu_ps(frame + i + 4), _mm_mul_ps(weight, f1)));
+		_mm_storeu_ps(frame + i + 8, _mm_add_ps(_mm_loadu_ps(frame + i + 8), _mm_mul_ps(weight, f2)));
+		_mm_storeu_ps(frame + i + 12, _mm_add_ps(_mm_loadu_ps(frame + i + 12), _mm_mul_ps(weight, f3)));
+	}
+	ByteFn_4_Scalar(frame + i, sampleA + i, sampleB + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void BytePrint_SSE2(unsigned char* data, const float* frame, size_t count, float w) {
+	const __m128 weight = _mm_set1_ps(w);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		// Truncate, the packs saturate to [0, 255]:
+		__m128i i0 = _mm_cvttps_epi32(_mm_mul_ps(weight, _mm_loadu_ps(frame + i + 0)));
+		__m128i i1 = _mm_cvttps_epi32(_mm_mul_ps(weight, _mm_loadu_ps(frame + i + 4)));
+		__m128i i2 = _mm_cvttps_epi32(_mm_mul_ps(weight, _mm_loadu_ps(frame + i + 8)));
+		__m128i i3 = _mm_cvttps_epi32(_mm_mul_ps(weight, _mm_loadu_ps(frame + i + 12)));
+		_mm_storeu_si128((__m128i*)(data + i), _mm_packus_epi16(_mm_packs_epi32(i0, i1), _mm_packs_epi32(i2, i3)));
+	}
+	BytePrint_Scalar(data + i, frame + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void FloatFn_1_SSE2(float* frame, const float* sample, size_t count) {
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(frame + i, _mm_add_ps(_mm_loadu_ps(frame + i), _mm_loadu_ps(sample + i)));
+	}
+	FloatFn_1_Scalar(frame + i, sample + i, count - i);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void FloatFn_2_SSE2(float* frame, const float* sample, size_t count, float w) {
+	const __m128 weight = _mm_set1_ps(w);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(frame + i, _mm_add_ps(_mm_loadu_ps(frame + i), _mm_mul_ps(weight, _mm_loadu_ps(sample + i))));
+	}
+	FloatFn_2_Scalar(frame + i, sample + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void FloatFn_3_SSE2(float* frame, const float* sampleA, float wA, const float* sampleB, float wB, size_t count) {
+	const __m128 weightA = _mm_set1_ps(wA);
+	const __m128 weightB = _mm_set1_ps(wB);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(frame + i, _mm_add_ps(_mm_add_ps(_mm_loadu_ps(frame + i), _mm_mul_ps(weightA, _mm_loadu_ps(sampleA + i))), _mm_mul_ps(weightB, _mm_loadu_ps(sampleB + i))));
+	}
+	FloatFn_3_Scalar(frame + i, sampleA + i, wA, sampleB + i, wB, count - i);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void FloatFn_4_SSE2(float* frame, const float* sampleA, const float* sampleB, size_t count, float w) {
+	const __m128 weight = _mm_set1_ps(w);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(frame + i, _mm_add_ps(_mm_loadu_ps(frame + i), _mm_mul_ps(weight, _mm_add_ps(_mm_loadu_ps(sampleA + i), _mm_loadu_ps(sampleB + i)))));
+	}
+	FloatFn_4_Scalar(frame + i, sampleA + i, sampleB + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void FloatPrint_SSE2(float* data, const float* frame, size_t count, float w) {
+	const __m128 weight = _mm_set1_ps(w);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(data + i, _mm_mul_ps(weight, _mm_loadu_ps(frame + i)));
+	}
+	FloatPrint_Scalar(data + i, frame + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void Scale_SSE2(float* frame, size_t count, float factor) {
+	const __m128 f = _mm_set1_ps(factor);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(frame + i, _mm_mul_ps(f, _mm_loadu_ps(frame + i)));
+	}
+	Scale_Scalar(frame + i, count - i, factor);
+}
+
+// The products of the 16 bit accumulator wrap like the sums, the caller guarantees the results fit.
+ADVANCEDFX_TARGET("sse2")
+static void ByteFn_2_U16_SSE2(unsigned short* frame, const unsigned char* sample, size_t count, unsigned int q) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i weight = _mm_set1_epi16((short)q);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(sample + i));
+		__m128i f0 = _mm_loadu_si128((const __m128i*)(frame + i + 0));
+		__m128i f1 = _mm_loadu_si128((const __m128i*)(frame + i + 8));
+		_mm_storeu_si128((__m128i*)(frame + i + 0), _mm_add_epi16(f0, _mm_mullo_epi16(weight, _mm_unpacklo_epi8(v, zero))));
+		_mm_storeu_si128((__m128i*)(frame + i + 8), _mm_add_epi16(f1, _mm_mullo_epi16(weight, _mm_unpackhi_epi8(v, zero))));
+	}
+	ByteFn_2_U16_Scalar(frame + i, sample + i, count - i, q);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void ByteFn_3_U16_SSE2(unsigned short* frame, const unsigned char* sampleA, unsigned int qA, const unsigned char* sampleB, unsigned int qB, size_t count) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i weightA = _mm_set1_epi16((short)qA);
+	const __m128i weightB = _mm_set1_epi16((short)qB);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(sampleA + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(sampleB + i));
+		__m128i f0 = _mm_loadu_si128((const __m128i*)(frame + i + 0));
+		__m128i f1 = _mm_loadu_si128((const __m128i*)(frame + i + 8));
+		f0 = _mm_add_epi16(f0, _mm_add_epi16(_mm_mullo_epi16(weightA, _mm_unpacklo_epi8(a, zero)), _mm_mullo_epi16(weightB, _mm_unpacklo_epi8(b, zero))));
+		f1 = _mm_add_epi16(f1, _mm_add_epi16(_mm_mullo_epi16(weightA, _mm_unpackhi_epi8(a, zero)), _mm_mullo_epi16(weightB, _mm_unpackhi_epi8(b, zero))));
+		_mm_storeu_si128((__m128i*)(frame + i + 0), f0);
+		_mm_storeu_si128((__m128i*)(frame + i + 8), f1);
+	}
+	ByteFn_3_U16_Scalar(frame + i, sampleA + i, qA, sampleB + i, qB, count - i);
+}
+
+// 4 int32 (fitting 31 bit) to 4 floats, + 0.5, * w, truncated.
+ADVANCEDFX_TARGET("sse2")
+static inline __m128i PrintInt_SSE2(__m128i v, __m128 half, __m128 weight) {
+	return _mm_cvttps_epi32(_mm_mul_ps(weight, _mm_add_ps(_mm_cvtepi32_ps(v), half)));
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void BytePrint_U16_SSE2(unsigned char* data, const unsigned short* frame, size_t count, float w) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 weight = _mm_set1_ps(w);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i f0 = _mm_loadu_si128((const __m128i*)(frame + i + 0));
+		__m128i f1 = _mm_loadu_si128((const __m128i*)(frame + i + 8));
+		__m128i i0 = PrintInt_SSE2(_mm_unpacklo_epi16(f0, zero), half, weight);
+		__m128i i1 = PrintInt_SSE2(_mm_unpackhi_epi16(f0, zero), half, weight);
+		__m128i i2 = PrintInt_SSE2(_mm_unpacklo_epi16(f1, zero), half, weight);
+		__m128i i3 = PrintInt_SSE2(_mm_unpackhi_epi16(f1, zero), half, weight);
+		_mm_storeu_si128((__m128i*)(data + i), _mm_packus_epi16(_mm_packs_epi32(i0, i1), _mm_packs_epi32(i2, i3)));
+	}
+	BytePrint_U16_Scalar(data + i, frame + i, count - i, w);
+}
+
+// 8 u16 values times q (16 bit) to 2x 4 u32 products.
+ADVANCEDFX_TARGET("sse2")
+static inline void MulU16_SSE2(__m128i v, __m128i weight, __m128i& out0, __m128i& out1) {
+	__m128i lo = _mm_mullo_epi16(v, weight);
+	__m128i hi = _mm_mulhi_epu16(v, weight);
+	out0 = _mm_unpacklo_epi16(lo, hi);
+	out1 = _mm_unpackhi_epi16(lo, hi);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void ByteFn_2_U32_SSE2(unsigned int* frame, const unsigned char* sample, size_t count, unsigned int q) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i weight = _mm_set1_epi16((short)q);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(sample + i));
+		__m128i p0, p1, p2, p3;
+		MulU16_SSE2(_mm_unpacklo_epi8(v, zero), weight, p0, p1);
+		MulU16_SSE2(_mm_unpackhi_epi8(v, zero), weight, p2, p3);
+		_mm_storeu_si128((__m128i*)(frame + i + 0), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 0)), p0));
+		_mm_storeu_si128((__m128i*)(frame + i + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 4)), p1));
+		_mm_storeu_si128((__m128i*)(frame + i + 8), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 8)), p2));
+		_mm_storeu_si128((__m128i*)(frame + i + 12), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 12)), p3));
+	}
+	ByteFn_2_U32_Scalar(frame + i, sample + i, count - i, q);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void ByteFn_3_U32_SSE2(unsigned int* frame, const unsigned char* sampleA, unsigned int qA, const unsigned char* sampleB, unsigned int qB, size_t count) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i weightA = _mm_set1_epi16((short)qA);
+	const __m128i weightB = _mm_set1_epi16((short)qB);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(sampleA + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(sampleB + i));
+		__m128i a0, a1, a2, a3, b0, b1, b2, b3;
+		MulU16_SSE2(_mm_unpacklo_epi8(a, zero), weightA, a0, a1);
+		MulU16_SSE2(_mm_unpackhi_epi8(a, zero), weightA, a2, a3);
+		MulU16_SSE2(_mm_unpacklo_epi8(b, zero), weightB, b0, b1);
+		MulU16_SSE2(_mm_unpackhi_epi8(b, zero), weightB, b2, b3);
+		_mm_storeu_si128((__m128i*)(frame + i + 0), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 0)), _mm_add_epi32(a0, b0)));
+		_mm_storeu_si128((__m128i*)(frame + i + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 4)), _mm_add_epi32(a1, b1)));
+		_mm_storeu_si128((__m128i*)(frame + i + 8), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 8)), _mm_add_epi32(a2, b2)));
+		_mm_storeu_si128((__m128i*)(frame + i + 12), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 12)), _mm_add_epi32(a3, b3)));
+	}
+	ByteFn_3_U32_Scalar(frame + i, sampleA + i, qA, sampleB + i, qB, count - i);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void BytePrint_U32_SSE2(unsigned char* data, const unsigned int* frame, size_t count, float w) {
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 weight = _mm_set1_ps(w);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		__m128i i0 = PrintInt_SSE2(_mm_loadu_si128((const __m128i*)(frame + i + 0)), half, weight);
+		__m128i i1 = PrintInt_SSE2(_mm_loadu_si128((const __m128i*)(frame + i + 4)), half, weight);
+		__m128i i2 = PrintInt_SSE2(_mm_loadu_si128((const __m128i*)(frame + i + 8)), half, weight);
+		__m128i i3 = PrintInt_SSE2(_mm_loadu_si128((const __m128i*)(frame + i + 12)), half, weight);
+		_mm_storeu_si128((__m128i*)(data + i), _mm_packus_epi16(_mm_packs_epi32(i0, i1), _mm_packs_epi32(i2, i3)));
+	}
+	BytePrint_U32_Scalar(data + i, frame + i, count - i, w);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// AVX2 + FMA
+//
+// 32 bytes / 8 floats at a time, tails are done by the SSE2 kernels.
+
+ADVANCEDFX_TARGET("avx2,fma")
+static inline __m256 Widen8_AVX2(const unsigned char* sample) {
+	return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)sample)));
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void ByteFn_1_AVX2(float* frame, const unsigned char* sample, size_t count) {
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		for (size_t j = 0; j < 32; j += 8) {
+			_mm256_storeu_ps(frame + i + j, _mm256_add_ps(_mm256_loadu_ps(frame + i + j), Widen8_AVX2(sample + i + j)));
+		}
+	}
+	ByteFn_1_SSE2(frame + i, sample + i, count - i);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void ByteFn_2_AVX2(float* frame, const unsigned char* sample, size_t count, float w) {
+	const __m256 weight = _mm256_set1_ps(w);
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		for (size_t j = 0; j < 32; j += 8) {
+			_mm256_storeu_ps(frame + i + j, _mm256_fmadd_ps(weight, Widen8_AVX2(sample + i + j), _mm256_loadu_ps(frame + i + j)));
+		}
+	}
+	ByteFn_2_SSE2(frame + i, sample + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void ByteFn_3_AVX2(float* frame, const unsigned char* sampleA, float wA, const unsigned char* sampleB, float wB, size_t count) {
+	const __m256 weightA = _mm256_set1_ps(wA);
+	const __m256 weightB = _mm256_set1_ps(wB);
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		for (size_t j = 0; j < 32; j += 8) {
+			__m256 value = _mm256_fmadd_ps(weightA, Widen8_AVX2(sampleA + i + j), _mm256_loadu_ps(frame + i + j));
+			_mm256_storeu_ps(frame + i + j, _mm256_fmadd_ps(weightB, Widen8_AVX2(sampleB + i + j), value));
+		}
+	}
+	ByteFn_3_SSE2(frame + i, sampleA + i, wA, sampleB + i, wB, count - i);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void ByteFn_4_AVX2(float* frame, const unsigned char* sampleA, const unsigned char* sampleB, size_t count, float w) {
+	const __m256 weight = _mm256_set1_ps(w);
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		for (size_t j = 0; j < 32; j += 8) {
+			__m256i a = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(sampleA + i + j)));
+			__m256i b = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(sampleB + i + j)));
+			_mm256_storeu_ps(frame + i + j, _mm256_fmadd_ps(weight, _mm256_cvtepi32_ps(_mm256_add_epi32(a, b)), _mm256_loadu_ps(frame + i + j)));
+		}
+	}
+	ByteFn_4_SSE2(frame + i, sampleA + i, sampleB + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void BytePrint_AVX2(unsigned char* data, const float* frame, size_t count, float w) {
+	const __m256 weight = _mm256_set1_ps(w);
+	// The packs work per 128 bit lane, this restores the order of the 4 byte groups:
+	const __m256i permute = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		__m256i i0 = _mm256_cvttps_epi32(_mm256_mul_ps(weight, _mm256_loadu_ps(frame + i + 0)));
+		__m256i i1 = _mm256_cvttps_epi32(_mm256_mul_ps(weight, _mm256_loadu_ps(frame + i + 8)));
+		__m256i i2 = _mm256_cvttps_epi32(_mm256_mul_ps(weight, _mm256_loadu_ps(frame + i + 16)));
+		__m256i i3 = _mm256_cvttps_epi32(_mm256_mul_ps(weight, _mm256_loadu_ps(frame + i + 24)));
+		__m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(i0, i1), _mm256_packs_epi32(i2, i3));
+		_mm256_storeu_si256((__m256i*)(data + i), _mm256_permutevar8x32_epi32(packed, permute));
+	}
+	BytePrint_SSE2(data + i, frame + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void FloatFn_1_AVX2(float* frame, const float* sample, size_t count) {
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(frame + i, _mm256_add_ps(_mm256_loadu_ps(frame + i), _mm256_loadu_ps(sample + i)));
+	}
+	FloatFn_1_SSE2(frame + i, sample + i, count - i);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void FloatFn_2_AVX2(float* frame, const float* sample, size_t count, float w) {
+	const __m256 weight = _mm256_set1_ps(w);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(frame + i, _mm256_fmadd_ps(weight, _mm256_loadu_ps(sample + i), _mm256_loadu_ps(frame + i)));
+	}
+	FloatFn_2_SSE2(frame + i, sample + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void FloatFn_3_AVX2(float* frame, const float* sampleA, float wA, const float* sampleB, float wB, size_t count) {
+	const __m256 weightA = _mm256_set1_ps(wA);
+	const __m256 weightB = _mm256_set1_ps(wB);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 value = _mm256_fmadd_ps(weightA, _mm256_loadu_ps(sampleA + i), _mm256_loadu_ps(frame + i));
+		_mm256_storeu_ps(frame + i, _mm256_fmadd_ps(weightB, _mm256_loadu_ps(sampleB + i), value));
+	}
+	FloatFn_3_SSE2(frame + i, sampleA + i, wA, sampleB + i, wB, count - i);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void FloatFn_4_AVX2(float* frame, const float* sampleA, const float* sampleB, size_t count, float w) {
+	const __m256 weight = _mm256_set1_ps(w);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(frame + i, _mm256_fmadd_ps(weight, _mm256_add_ps(_mm256_loadu_ps(sampleA + i), _mm256_loadu_ps(sampleB + i)), _mm256_loadu_ps(frame + i)));
+	}
+	FloatFn_4_SSE2(frame + i, sampleA + i, sampleB + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void FloatPrint_AVX2(float* data, const float* frame, size_t count, float w) {
+	const __m256 weight = _mm256_set1_ps(w);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(data + i, _mm256_mul_ps(weight, _mm256_loadu_ps(frame + i)));
+	}
+	FloatPrint_SSE2(data + i, frame + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void Scale_AVX2(float* frame, size_t count, float factor) {
+	const __m256 f = _mm256_set1_ps(factor);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(frame + i, _mm256_mul_ps(f, _mm256_loadu_ps(frame + i)));
+	}
+	Scale_SSE2(frame + i, count - i, factor);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void ByteFn_2_U16_AVX2(unsigned short* frame, const unsigned char* sample, size_t count, unsigned int q) {
+	const __m256i weight = _mm256_set1_epi16((short)q);
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		for (size_t j = 0; j < 32; j += 16) {
+			__m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(sample + i + j)));
+			__m256i f = _mm256_loadu_si256((const __m256i*)(frame + i + j));
+			_mm256_storeu_si256((__m256i*)(frame + i + j), _mm256_add_epi16(f, _mm256_mullo_epi16(weight, v)));
+		}
+	}
+	ByteFn_2_U16_SSE2(frame + i, sample + i, count - i, q);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void ByteFn_3_U16_AVX2(unsigned short* frame, const unsigned char* sampleA, unsigned int qA, const unsigned char* sampleB, unsigned int qB, size_t count) {
+	const __m256i weightA = _mm256_set1_epi16((short)qA);
+	const __m256i weightB = _mm256_set1_epi16((short)qB);
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		for (size_t j = 0; j < 32; j += 16) {
+			__m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(sampleA + i + j)));
+			__m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(sampleB + i + j)));
+			__m256i f = _mm256_loadu_si256((const __m256i*)(frame + i + j));
+			_mm256_storeu_si256((__m256i*)(frame + i + j), _mm256_add_epi16(f, _mm256_add_epi16(_mm256_mullo_epi16(weightA, a), _mm256_mullo_epi16(weightB, b))));
+		}
+	}
+	ByteFn_3_U16_SSE2(frame + i, sampleA + i, qA, sampleB + i, qB, count - i);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static inline __m256i PrintInt_AVX2(__m256i v, __m256 half, __m256 weight) {
+	return _mm256_cvttps_epi32(_mm256_mul_ps(weight, _mm256_add_ps(_mm256_cvtepi32_ps(v), half)));
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void BytePrint_U16_AVX2(unsigned char* data, const unsigned short* frame, size_t count, float w) {
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 weight = _mm256_set1_ps(w);
+	// The packs work per 128 bit lane, this restores the order of the 4 byte groups:
+	const __m256i permute = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		__m256i i0 = PrintInt_AVX2(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 0))), half, weight);
+		__m256i i1 = PrintInt_AVX2(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 8))), half, weight);
+		__m256i i2 = PrintInt_AVX2(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 16))), half, weight);
+		__m256i i3 = PrintInt_AVX2(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(frame + i + 24))), half, weight);
+		__m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(i0, i1), _mm256_packs_epi32(i2, i3));
+		_mm256_storeu_si256((__m256i*)(data + i), _mm256_permutevar8x32_epi32(packed, permute));
+	}
+	BytePrint_U16_SSE2(data + i, frame + i, count - i, w);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void ByteFn_2_U32_AVX2(unsigned int* frame, const unsigned char* sample, size_t count, unsigned int q) {
+	const __m256i weight = _mm256_set1_epi32((int)q);
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		for (size_t j = 0; j < 32; j += 8) {
+			__m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(sample + i + j)));
+			__m256i f = _mm256_loadu_si256((const __m256i*)(frame + i + j));
+			_mm256_storeu_si256((__m256i*)(frame + i + j), _mm256_add_epi32(f, _mm256_mullo_epi32(weight, v)));
+		}
+	}
+	ByteFn_2_U32_SSE2(frame + i, sample + i, count - i, q);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void ByteFn_3_U32_AVX2(unsigned int* frame, const unsigned char* sampleA, unsigned int qA, const unsigned char* sampleB, unsigned int qB, size_t count) {
+	const __m256i weightA = _mm256_set1_epi32((int)qA);
+	const __m256i weightB = _mm256_set1_epi32((int)qB);
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		for (size_t j = 0; j < 32; j += 8) {
+			__m256i a = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(sampleA + i + j)));
+			__m256i b = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(sampleB + i + j)));
+			__m256i f = _mm256_loadu_si256((const __m256i*)(frame + i + j));
+			_mm256_storeu_si256((__m256i*)(frame + i + j), _mm256_add_epi32(f, _mm256_add_epi32(_mm256_mullo_epi32(weightA, a), _mm256_mullo_epi32(weightB, b))));
+		}
+	}
+	ByteFn_3_U32_SSE2(frame + i, sampleA + i, qA, sampleB + i, qB, count - i);
+}
+
+ADVANCEDFX_TARGET("avx2,fma")
+static void BytePrint_U32_AVX2(unsigned char* data, const unsigned int* frame, size_t count, float w) {
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 weight = _mm256_set1_ps(w);
+	// The packs work per 128 bit lane, this restores the order of the 4 byte groups:
+	const __m256i permute = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		__m256i i0 = PrintInt_AVX2(_mm256_loadu_si256((const __m256i*)(frame + i + 0)), half, weight);
+		__m256i i1 = PrintInt_AVX2(_mm256_loadu_si256((const __m256i*)(frame + i + 8)), half, weight);
+		__m256i i2 = PrintInt_AVX2(_mm256_loadu_si256((const __m256i*)(frame + i + 16)), half, weight);
+		__m256i i3 = PrintInt_AVX2(_mm256_loadu_si256((const __m256i*)(frame + i + 24)), half, weight);
+		__m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(i0, i1), _mm256_packs_epi32(i2, i3));
+		_mm256_storeu_si256((__m256i*)(data + i), _mm256_permutevar8x32_epi32(packed, permute));
+	}
+	BytePrint_U32_SSE2(data + i, frame + i, count - i, w);
+}
+
+#endif // ADVANCEDFX_EASYSAMPLER_X86
+
+////////////////////////////////////////////////////////////////////////////////
+
+static const Kernels_s g_Kernels_Scalar = {
+	ByteFn_1_Scalar,
+	ByteFn_2_Scalar,
+	ByteFn_3_Scalar,
+	ByteFn_4_Scalar,
+	BytePrint_Scalar,
+	FloatFn_1_Scalar,
+	FloatFn_2_Scalar,
+	FloatFn_3_Scalar,
+	FloatFn_4_Scalar,
+	FloatPrint_Scalar,
+	Scale_Scalar,
+	ByteFn_2_U16_Scalar,
+	ByteFn_3_U16_Scalar,
+	BytePrint_U16_Scalar,
+	ByteFn_2_U32_Scalar,
+	ByteFn_3_U32_Scalar,
+	BytePrint_U32_Scalar
+};
+
+#ifdef ADVANCEDFX_EASYSAMPLER_X86
+
+static const Kernels_s g_Kernels_SSE2 = {
+	ByteFn_1_SSE2,
+	ByteFn_2_SSE2,
+	ByteFn_3_SSE2,
+	ByteFn_4_SSE2,
+	BytePrint_SSE2,
+	FloatFn_1_SSE2,
+	FloatFn_2_SSE2,
+	FloatFn_3_SSE2,
+	FloatFn_4_SSE2,
+	FloatPrint_SSE2,
+	Scale_SSE2,
+	ByteFn_2_U16_SSE2,
+	ByteFn_3_U16_SSE2,
+	BytePrint_U16_SSE2,
+	ByteFn_2_U32_SSE2,
+	ByteFn_3_U32_SSE2,
+	BytePrint_U32_SSE2
+};
+
+static const Kernels_s g_Kernels_AVX2 = {
+	ByteFn_1_AVX2,
+	ByteFn_2_AVX2,
+	ByteFn_3_AVX2,
+	ByteFn_4_AVX2,
+	BytePrint_AVX2,
+	FloatFn_1_AVX2,
+	FloatFn_2_AVX2,
+	FloatFn_3_AVX2,
+	FloatFn_4_AVX2,
+	FloatPrint_AVX2,
+	Scale_AVX2,
+	ByteFn_2_U16_AVX2,
+	ByteFn_3_U16_AVX2,
+	BytePrint_U16_AVX2,
+	ByteFn_2_U32_AVX2,
+	ByteFn_3_U32_AVX2,
+	BytePrint_U32_AVX2
+};
+
+#endif
+
+const Kernels_s& GetKernels(CpuIsa isa) {
+	switch (isa) {
+#ifdef ADVANCEDFX_EASYSAMPLER_X86
+	case CpuIsa::SSE2:
+	case CpuIsa::SSSE3:
+		return g_Kernels_SSE2;
+	case CpuIsa::AVX2:
+		return g_Kernels_AVX2;
+#endif
+	default:
+		break;
+	}
+	return g_Kernels_Scalar;
+}
+
+const Kernels_s& GetKernels() {
+	static const Kernels_s& kernels = GetKernels(GetCpuIsa());
+	return kernels;
+}
+
+} // namespace EasySampler {
+} // namespace advancedfx
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "CpuIsa.h"
+
+#include <stddef.h>
+
+namespace advancedfx {
+namespace EasySampler {
+
+	/// <summary>Row kernels of EasyByteSamplerImpl and EasyFloatSamplerImpl.</summary>
+	/// <remarks>
+	///   count is the number of channel values (bytes / floats) in the row.<br />
+	///   The _U16 / _U32 kernels are for the fixed point accumulators (integer weights q).
+	/// </remarks>
+	struct Kernels_s {
+		/// <summary>frame += sample</summary>
+		void (*ByteFn_1)(float* frame, const unsigned char* sample, size_t count);
+
+		/// <summary>frame += w * sample</summary>
+		void (*ByteFn_2)(float* frame, const unsigned char* sample, size_t count, float w);
+
+		/// <summary>frame += wA * sampleA + wB * sampleB</summary>
+		void (*ByteFn_3)(float* frame, const unsigned char* sampleA, float wA, const unsigned char* sampleB, float wB, size_t count);
+
+		/// <summary>frame += w * (sampleA + sampleB)</summary>
+		void (*ByteFn_4)(float* frame, const unsigned char* sampleA, const unsigned char* sampleB, size_t count, float w);
+
+		/// <summary>data = w * frame, truncated to [0, 255].</summary>
+		void (*BytePrint)(unsigned char* data, const float* frame, size_t count, float w);
+
+		/// <summary>frame += sample</summary>
+		void (*FloatFn_1)(float* frame, const float* sample, size_t count);
+
+		/// <summary>frame += w * sample</summary>
+		void (*FloatFn_2)(float* frame, const float* sample, size_t count, float w);
+
+		/// <summary>frame += wA * sampleA + wB * sampleB</summary>
+		void (*FloatFn_3)(float* frame, const float* sampleA, float wA, const float* sampleB, float wB, size_t count);
+
+		/// <summary>frame += w * (sampleA + sampleB)</summary>
+		void (*FloatFn_4)(float* frame, const float* sampleA, const float* sampleB, size_t count, float w);
+
+		/// <summary>data = w * frame</summary>
+		void (*FloatPrint)(float* data, const float* frame, size_t count, float w);
+
+		/// <summary>frame = factor * frame</summary>
+		void (*Scale)(float* frame, size_t count, float factor);
+
+		/// <summary>frame += q * sample, with q * 255 + frame fitting 16 bit.</summary>
+		void (*ByteFn_2_U16)(unsigned short* frame, const unsigned char* sample, size_t count, unsigned int q);
+
+		/// <summary>frame += qA * sampleA + qB * sampleB, with the result fitting 16 bit.</summary>
+		void (*ByteFn_3_U16)(unsigned short* frame, const unsigned char* sampleA, unsigned int qA, const unsigned char* sampleB, unsigned int qB, size_t count);
+
+		/// <summary>data = w * (frame + 0.5), truncated to [0, 255].</summary>
+		void (*BytePrint_U16)(unsigned char* data, const unsigned short* frame, size_t count, float w);
+
+		/// <summary>frame += q * sample, with q &lt;= 0xffff and the result fitting 31 bit.</summary>
+		void (*ByteFn_2_U32)(unsigned int* frame, const unsigned char* sample, size_t count, unsigned int q);
+
+		/// <summary>frame += qA * sampleA + qB * sampleB, with qA, qB &lt;= 0xffff and the result fitting 31 bit.</summary>
+		void (*ByteFn_3_U32)(unsigned int* frame, const unsigned char* sampleA, unsigned int qA, const unsigned char* sampleB, unsigned int qB, size_t count);
+
+		/// <summary>data = w * (frame + 0.5), truncated to [0, 255], frame must fit 31 bit.</summary>
+		void (*BytePrint_U32)(unsigned char* data, const unsigned int* frame, size_t count, float w);
+	};
+
+	/// <param name="isa">Must be supported, see GetCpuIsa. CpuIsa::Scalar is the reference.</param>
+	/// <remarks>CpuIsa::AVX2 uses FMA, so results can differ from the other levels in the last bit.</remarks>
+	const Kernels_s& GetKernels(CpuIsa isa);
+
+	/// <returns>GetKernels(GetCpuIsa()).</returns>
+	const Kernels_s& GetKernels();
+
+} // namespace EasySampler {
+} // namespace advancedfx
@@ -136,3 +136,75 @@ bool CreatePath(wchar_t const * path, std::wstring & outPath, bool noErrorIfExit
 
 	return bOk;
 }
+
+CMappedFile::CMappedFile()
+: m_File(INVALID_HANDLE_VALUE)
+, m_Mapping(NULL)
+, m_Data(nullptr)
+, m_Size(0)
+{
+}
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+bool CMappedFile::Open(wchar_t const * fileName)
+{
+	Close();
+
+	m_File = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(INVALID_HANDLE_VALUE == m_File)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(m_File, &fileSize) || (unsigned long long)fileSize.QuadPart > (size_t)-1)
+	{
+		Close();
+		return false;
+	}
+
+	m_Size = (size_t)fileSize.QuadPart;
+	if(0 == m_Size)
+		return true; // Can't map empty files.
+
+	m_Mapping = CreateFileMappingW(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(NULL == m_Mapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_Data = (unsigned char const *)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+	if(nullptr == m_Data)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if(m_Data)
+	{
+		UnmapViewOfFile(m_Data);
+		m_Data = nullptr;
+	}
+
+	if(NULL != m_Mapping)
+	{
+		CloseHandle(m_Mapping);
+		m_Mapping = NULL;
+	}
+
+	if(INVALID_HANDLE_VALUE != m_File)
+	{
+		CloseHandle(m_File);
+		m_File = INVALID_HANDLE_VALUE;
+	}
+
+	m_Size = 0;
+}
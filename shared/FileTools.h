@@ -5,3 +5,29 @@
 bool SuggestTakePath(wchar_t const * takePath, int takeDigits, std::wstring & outPath);
 
 bool CreatePath(wchar_t const * path, std::wstring & outPath, bool noErrorIfExits = false);
+
+/// <summary>Read-only memory mapping of a whole file.</summary>
+class CMappedFile
+{
+public:
+	CMappedFile();
+	~CMappedFile();
+
+	/// <remarks>An empty file can be opened, but has no data.</remarks>
+	bool Open(wchar_t const * fileName);
+
+	void Close();
+
+	unsigned char const * GetData() const { return m_Data; }
+
+	size_t GetSize() const { return m_Size; }
+
+private:
+	void * m_File;
+	void * m_Mapping;
+	unsigned char const * m_Data;
+	size_t m_Size;
+
+	CMappedFile(CMappedFile const &) = delete;
+	CMappedFile & operator = (CMappedFile const &) = delete;
+};
@@ -0,0 +1,116 @@
+#include "stdafx.h"
+
+#include "FramePipeline.h"
+
+#include "ThreadPool.h"
+
+namespace advancedfx {
+
+	class CFramePipeline::CStageTask : public CThreadPool::CTask {
+	public:
+		CStageTask(CFramePipeline* pipeline, CFrame* frame)
+			: m_Pipeline(pipeline)
+			, m_Frame(frame)
+		{
+		}
+
+		virtual void Execute() override {
+			m_Pipeline->Process(m_Frame);
+		}
+
+	private:
+		CFramePipeline* m_Pipeline;
+		CFrame* m_Frame;
+	};
+
+	CFramePipeline::CFramePipeline(CThreadPool* threadPool, size_t maxInFlight)
+		: m_ThreadPool(threadPool)
+		, m_MaxInFlight(0 < maxInFlight ? maxInFlight : 1)
+		, m_InFlight(0)
+		, m_NextFrameNumber(0)
+	{
+	}
+
+	CFramePipeline::~CFramePipeline() {
+		Flush();
+	}
+
+	void CFramePipeline::AddParallelStage(Stage_t stage) {
+		m_Stages.emplace_back(stage, false);
+	}
+
+	void CFramePipeline::AddSerialStage(Stage_t stage) {
+		m_Stages.emplace_back(stage, true);
+	}
+
+	void CFramePipeline::Push(CFrame* frame) {
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			while (m_MaxInFlight <= m_InFlight) m_Cv.wait(lock);
+			m_InFlight++;
+			frame->m_FrameNumber = m_NextFrameNumber++;
+		}
+		frame->m_Stage = 0;
+
+		if (Enter(frame)) Schedule(frame);
+	}
+
+	void CFramePipeline::Flush() {
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (0 < m_InFlight) m_Cv.wait(lock);
+	}
+
+	bool CFramePipeline::Enter(CFrame* frame) {
+		if (m_Stages.size() <= frame->m_Stage) {
+			delete frame;
+
+			// Under the lock, so Flush() can not return (and the pipeline be destroyed) before we are done here.
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_InFlight--;
+			m_Cv.notify_all();
+			return false;
+		}
+
+		Stage_s& stage = m_Stages[frame->m_Stage];
+		if (stage.Serial) {
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			if (frame->m_FrameNumber != stage.Next) {
+				stage.Waiting[frame->m_FrameNumber] = frame;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void CFramePipeline::Schedule(CFrame* frame) {
+		if (m_ThreadPool) m_ThreadPool->QueueTask(new CStageTask(this, frame));
+		else Process(frame);
+	}
+
+	void CFramePipeline::Process(CFrame* frame) {
+		do {
+			Stage_s& stage = m_Stages[frame->m_Stage];
+
+			stage.Fn(frame);
+
+			if (stage.Serial) {
+				CFrame* released = nullptr;
+				{
+					std::unique_lock<std::mutex> lock(m_Mutex);
+					stage.Next = frame->m_FrameNumber + 1;
+					auto it = stage.Waiting.find(stage.Next);
+					if (it != stage.Waiting.end()) {
+						released = it->second;
+						stage.Waiting.erase(it);
+					}
+				}
+				if (released) Schedule(released);
+			}
+
+			// Stay on this thread for the frame's next stage, it's likely still in our cache.
+			frame->m_Stage++;
+		} while (Enter(frame));
+	}
+
+} // namespace advancedfx {
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace advancedfx {
+
+	class CThreadPool;
+
+	/// <summary>Runs frames through a chain of stages on a CThreadPool, keeping the order where it matters.</summary>
+	/// <remarks>
+	///   Parallel stages work on different frames at the same time and finish in any order, a serial stage gets one
+	///   frame at a time in frame number order: frames that arrive early wait in the stage's reorder buffer until the
+	///   one before them has passed.<br />
+	///   At most maxInFlight frames are in the pipeline, Push blocks until there is room again, so a slow
+	///   serial stage slows down the producer instead of frames piling up in memory.<br />
+	///   Push and Flush must not be called from this pipeline's pool threads or stages (they could wait for themselves).
+	/// </remarks>
+	class CFramePipeline {
+	public:
+		class CFrame {
+		public:
+			CFrame()
+				: m_FrameNumber(0)
+				, m_Stage(0)
+			{
+			}
+
+			virtual ~CFrame() {
+			}
+
+			/// <returns>The sequence number assigned by Push, starting at 0.</returns>
+			size_t GetFrameNumber() const {
+				return m_FrameNumber;
+			}
+
+		private:
+			friend class CFramePipeline;
+
+			size_t m_FrameNumber;
+			size_t m_Stage;
+		};
+
+		typedef std::function<void(CFrame* frame)> Stage_t;
+
+		/// <param name="threadPool">can be nullptr, then the stages are run on the thread calling Push.</param>
+		/// <param name="maxInFlight">Number of frames Push lets into the pipeline before it blocks.</param>
+		CFramePipeline(CThreadPool* threadPool, size_t maxInFlight);
+
+		/// <remarks>Flushes.</remarks>
+		~CFramePipeline();
+
+		/// <remarks>Stages must be added before the first Push.</remarks>
+		void AddParallelStage(Stage_t stage);
+
+		/// <remarks>Stages must be added before the first Push.</remarks>
+		void AddSerialStage(Stage_t stage);
+
+		/// <summary>Hands the frame to the first stage, blocks while the pipeline is full.</summary>
+		/// <remarks>Takes ownership, the frame is deleted after the last stage.</remarks>
+		void Push(CFrame* frame);
+
+		/// <summary>Waits until all pushed frames have passed the last stage.</summary>
+		void Flush();
+
+	private:
+		class CStageTask;
+
+		struct Stage_s {
+			Stage_s(Stage_t fn, bool serial)
+				: Fn(fn)
+				, Serial(serial)
+				, Next(0)
+			{
+			}
+
+			Stage_t Fn;
+			bool Serial;
+
+			/// <summary>Serial only: number of the frame whose turn it is.</summary>
+			size_t Next;
+
+			/// <summary>Serial only: frames that arrived before their turn.</summary>
+			std::map<size_t, CFrame*> Waiting;
+		};
+
+		CThreadPool* m_ThreadPool;
+		size_t m_MaxInFlight;
+		std::vector<Stage_s> m_Stages;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Cv;
+		size_t m_InFlight;
+		size_t m_NextFrameNumber;
+
+		/// <summary>Lets the frame enter its current stage.</summary>
+		/// <returns>true if the stage can be run now, false if the frame waits for its turn or has left the pipeline.</returns>
+		bool Enter(CFrame* frame);
+
+		void Schedule(CFrame* frame);
+
+		/// <summary>Runs the frame's stages until it has to wait or is done.</summary>
+		void Process(CFrame* frame);
+	};
+
+} // namespace advancedfx {
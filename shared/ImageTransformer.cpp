@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "ImageTransformer.h"
+#include "ImageTransformerKernels.h"
 #include "ImageBufferThreadSafe.h"
 #include "RefCountedThreadSafe.h"
 #include "AfxConsole.h"
@@ -18,31 +19,12 @@ namespace ImageTransformer {
 		return result;
 	}
 
-	class CTranformTask
-		: public advancedfx::CThreadPool::CTask
-	{
-	public:
-		CTranformTask(std::atomic_int& task_counter)
-			: task_counter(task_counter)			
-		{
-			task_counter++;
-		}
-
-		virtual ~CTranformTask() {
-			task_counter--;
-		}
-
-	protected:
-
-	private:
-		std::atomic_int& task_counter;
-	};
-
 	class ITransform {
 	public:
 		virtual IImageBufferThreadSafe* CreateOutput(CGrowingBufferPoolThreadSafe * imageBufferPool) = 0;
-		virtual size_t GetTaskSize() = 0;
-		virtual CTranformTask* CreateTask(std::atomic_int& task_counter, int taskIndex, int taskSize) = 0;
+		virtual size_t GetRowCount() = 0;
+		/// <summary>Transforms numRows rows starting at firstRow, called in parallel for disjoint row ranges.</summary>
+		virtual void TransformRows(size_t firstRow, size_t numRows) = 0;
 	};
 	class CTransformAColorBRedAsAlpha
 		: public ITransform {
@@ -88,65 +70,21 @@ namespace ImageTransformer {
 			return nullptr;
 		}
 
-		virtual size_t GetTaskSize() {
+		virtual size_t GetRowCount() {
 			return (size_t)std::abs(m_OutFormat.Height);
 		}
 
-		virtual CTranformTask* CreateTask(std::atomic_int& task_counter, int taskIndex, int taskSize) {
-			return new CMyTransformTask(task_counter,
-				m_pInDataA + taskIndex * m_InFormatA.Pitch, m_InFormatA.Pitch, m_InFormatA.GetPixelStride(),
-				m_pInDataB + taskIndex * m_InFormatB.Pitch, m_InFormatB.Pitch, m_InFormatB.GetPixelStride(),
-				m_pOutData + taskIndex * m_OutFormat.Pitch, m_OutFormat.Width, taskSize);
-		}
-
-	private:
-		class CMyTransformTask : public CTranformTask {
-		public:
-			CMyTransformTask(std::atomic_int& task_counter, const unsigned char* pDataA, size_t pitchA, size_t pixelPichtA, const unsigned char* pDataB, size_t pitchB, size_t pixelPichtB, unsigned char* pOutData, size_t width, size_t height)
-				: CTranformTask(task_counter)
-				, pDataA(pDataA)
-				, pitchA(pitchA)
-				, pixelPichtA(pixelPichtA)
-				, pDataB(pDataB)
-				, pitchB(pitchB)
-				, pixelPichtB(pixelPichtB)
-				, pOutData(pOutData)
-				, width(width)
-				, height(height)
+		virtual void TransformRows(size_t firstRow, size_t numRows) {
+			const Kernels_s& kernels = GetKernels();
+			size_t pixelPitchA = m_InFormatA.GetPixelStride();
+			size_t pixelPitchB = m_InFormatB.GetPixelStride();
+			for (size_t y = firstRow; y < firstRow + numRows; ++y)
 			{
+				kernels.AColorBRedAsAlpha(m_pInDataA + y * m_InFormatA.Pitch, pixelPitchA, m_pInDataB + y * m_InFormatB.Pitch, pixelPitchB, m_pOutData + y * m_OutFormat.Pitch, m_OutFormat.Width);
 			}
+		}
 
-			virtual void Execute() {
-				size_t targetPitch = width * 4 * sizeof(unsigned char);
-				for (size_t y = 0; y < height; ++y)
-				{
-					for (size_t x = 0; x < width; ++x)
-					{
-						const unsigned char* pInA = (const unsigned char*)(pDataA + y * pitchA + x * pixelPichtA);
-						const unsigned char* pInB = (const unsigned char*)(pDataB + y * pitchB + x * pixelPichtB);
-						unsigned char* pOut = (unsigned char*)(pOutData + y * targetPitch + x * 4 * sizeof(unsigned char));
-
-						pOut[0] = pInA[0];
-						pOut[1] = pInA[1];
-						pOut[2] = pInA[2];
-						pOut[3] = pInB[0];
-
-					}
-				}
-			}
-
-		private:
-			const unsigned char* pDataA;
-			size_t pitchA;
-			size_t pixelPichtA;
-			const unsigned char* pDataB;
-			size_t pitchB;
-			size_t pixelPichtB;
-			unsigned char* pOutData;
-			size_t width;
-			size_t height;
-		};
-
+	private:
 		IImageBufferThreadSafe* m_BufferA;
 		IImageBufferThreadSafe* m_BufferB;
 		advancedfx::CImageFormat m_InFormatA;
@@ -201,77 +139,21 @@ namespace ImageTransformer {
 			return nullptr;
 		}
 
-		virtual size_t GetTaskSize() {
+		virtual size_t GetRowCount() {
 			return (size_t)std::abs(m_OutFormat.Height);
 		}
 
-		virtual CTranformTask* CreateTask(std::atomic_int& task_counter, int taskIndex, int taskSize) {
-			return new CMyTransformTask(task_counter,
-				m_pInDataEntBlack + taskIndex * m_InFormatEntBlack.Pitch, m_InFormatEntBlack.Pitch, m_InFormatEntBlack.GetPixelStride(),
-				m_pInDataEntWhite + taskIndex * m_InFormatEntWhite.Pitch, m_InFormatEntWhite.Pitch, m_InFormatEntWhite.GetPixelStride(),
-				m_pOutData + taskIndex * m_OutFormat.Pitch, m_OutFormat.Width, taskSize);
-		}
-
-	private:
-		class CMyTransformTask : public CTranformTask {
-		public:
-			CMyTransformTask(std::atomic_int& task_counter, const unsigned char* pDataEntBlack, size_t pitchEntBlack, size_t pixelPichtEntBlack, const unsigned char* pDataEntWhite, size_t pitchEntWhite, size_t pixelPichtEntWhite, unsigned char* pOutData, size_t width, size_t height)
-				: CTranformTask(task_counter)
-				, pDataEntBlack(pDataEntBlack)
-				, pitchEntBlack(pitchEntBlack)
-				, pixelPichtEntBlack(pixelPichtEntBlack)
-				, pDataEntWhite(pDataEntWhite)
-				, pitchEntWhite(pitchEntWhite)
-				, pixelPichtEntWhite(pixelPichtEntWhite)
-				, pOutData(pOutData)
-				, width(width)
-				, height(height)
+		virtual void TransformRows(size_t firstRow, size_t numRows) {
+			const Kernels_s& kernels = GetKernels();
+			size_t pixelPitchEntBlack = m_InFormatEntBlack.GetPixelStride();
+			size_t pixelPitchEntWhite = m_InFormatEntWhite.GetPixelStride();
+			for (size_t y = firstRow; y < firstRow + numRows; ++y)
 			{
+				kernels.Matte(m_pInDataEntBlack + y * m_InFormatEntBlack.Pitch, pixelPitchEntBlack, m_pInDataEntWhite + y * m_InFormatEntWhite.Pitch, pixelPitchEntWhite, m_pOutData + y * m_OutFormat.Pitch, m_OutFormat.Width);
 			}
+		}
 
-			virtual void Execute() {
-				size_t targetPitch = width * 4 * sizeof(unsigned char);
-				for (size_t y = 0; y < height; ++y)
-				{
-					for (size_t x = 0; x < width; ++x)
-					{
-						const unsigned char* pInEntBlack = (const unsigned char*)(pDataEntBlack + y * pitchEntBlack + x * pixelPichtEntBlack);
-						const unsigned char* pInEntWhite = (const unsigned char*)(pDataEntWhite + y * pitchEntWhite + x * pixelPichtEntWhite);
-						unsigned char* pOut = (unsigned char*)(pOutData + y * targetPitch + x * 4 * sizeof(unsigned char));
-
-						unsigned char entBlack_b = pInEntBlack[0];
-						unsigned char entBlack_g = pInEntBlack[1];
-						unsigned char entBlack_r = pInEntBlack[2];
-
-						unsigned char entWhite_b = pInEntWhite[0];
-						unsigned char entWhite_g = pInEntWhite[1];
-						unsigned char entWhite_r = pInEntWhite[2];
-
-						//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 0] = y < 1 * height / 3 ? entBlack_b : (y < 2 * height / 3 ? entWhite_b : (unsigned char)(((int)entBlack_b + (int)entWhite_b)/2));
-						//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 1] = y < 1 * height / 3 ? entBlack_g : (y < 2 * height / 3 ? entWhite_g : (unsigned char)(((int)entBlack_g + (int)entWhite_g)/2));
-						//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 2] = y < 1 * height / 3 ? entBlack_r : (y < 2 * height / 3 ? entWhite_r : (unsigned char)(((int)entBlack_r + (int)entWhite_r)/2));
-						//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 3] = y < 1 * height / 3 ? 255 : (y < 2 * height / 3 ? 255 : (unsigned char)min(max((255l - (int)entWhite_b + (int)entBlack_b + 255l - (int)entWhite_g + (int)entBlack_g + 255l - (int)entWhite_r + (int)entBlack_r) / 3l, 0), 255));
-						pOut[0] = (unsigned char)(((int)entBlack_b + (int)entWhite_b) / 2);
-						pOut[1] = (unsigned char)(((int)entBlack_g + (int)entWhite_g) / 2);
-						pOut[2] = (unsigned char)(((int)entBlack_r + (int)entWhite_r) / 2);
-						pOut[3] = (unsigned char)std::min(std::max((255l - (int)entWhite_b + (int)entBlack_b + 255l - (int)entWhite_g + (int)entBlack_g + 255l - (int)entWhite_r + (int)entBlack_r) / 3l, 0l), 255l);
-
-					}
-				}
-			}
-
-		private:
-			const unsigned char* pDataEntBlack;
-			size_t pitchEntBlack;
-			size_t pixelPichtEntBlack;
-			const unsigned char* pDataEntWhite;
-			size_t pitchEntWhite;
-			size_t pixelPichtEntWhite;
-			unsigned char* pOutData;
-			size_t width;
-			size_t height;
-		};
-
+	private:
 		IImageBufferThreadSafe* m_BufferEntBlack;
 		IImageBufferThreadSafe* m_BufferEntWhite;
 		advancedfx::CImageFormat m_InFormatEntBlack;
@@ -312,51 +194,19 @@ namespace ImageTransformer {
 			return nullptr;
 		}
 
-		virtual size_t GetTaskSize() {
+		virtual size_t GetRowCount() {
 			return (size_t)std::abs(m_InFormat.Height);
 		}
 
-		virtual CTranformTask* CreateTask(std::atomic_int& task_counter, int taskIndex, int taskSize) {
-			return new CMyTransformTask(task_counter, m_pInData + taskIndex * m_InFormat.Pitch, m_InFormat.Pitch, m_pOutData + taskIndex * m_OutFormat.Pitch, m_OutFormat.Width, taskSize);
-		}
-
-	private:
-		class CMyTransformTask : public CTranformTask {
-		public:
-			CMyTransformTask(std::atomic_int& task_counter, const unsigned char* pData, size_t pitch, unsigned char* pOutData, size_t width, size_t height)
-				: CTranformTask(task_counter)
-				, pData(pData)
-				, pitch(pitch)
-				, pOutData(pOutData)
-				, width(width)
-				, height(height)
+		virtual void TransformRows(size_t firstRow, size_t numRows) {
+			const Kernels_s& kernels = GetKernels();
+			for (size_t y = firstRow; y < firstRow + numRows; ++y)
 			{
+				kernels.StripAlpha(m_pInData + y * m_InFormat.Pitch, m_pOutData + y * m_OutFormat.Pitch, m_OutFormat.Width);
 			}
+		}
 
-			virtual void Execute() {
-				size_t targetPitch = width * 3 * sizeof(unsigned char);
-				for (size_t y = 0; y < height; ++y)
-				{
-					for (size_t x = 0; x < width; ++x)
-					{
-						const unsigned char * pIn = (const unsigned char *)(pData + y * pitch + x * 4 * sizeof(unsigned char));
-						unsigned char * pOut = (unsigned char*)(pOutData + y * targetPitch + x * 3 * sizeof(unsigned char));
-	
-						pOut[0] = pIn[0];
-						pOut[1] = pIn[1];
-						pOut[2] = pIn[2];
-					}
-				}
-			}
-
-		private:
-			const unsigned char* pData;
-			size_t pitch;
-			unsigned char* pOutData;
-			size_t width;
-			size_t height;
-		};
-
+	private:
 		IImageBufferThreadSafe* m_Buffer;
 		advancedfx::CImageFormat m_InFormat;
 		const unsigned char* m_pInData;
@@ -394,51 +244,19 @@ namespace ImageTransformer {
 			return nullptr;
 		}
 
-		virtual size_t GetTaskSize() {
+		virtual size_t GetRowCount() {
 			return (size_t)std::abs(m_InFormat.Height);
 		}
 
-		virtual CTranformTask* CreateTask(std::atomic_int& task_counter, int taskIndex, int taskSize) {
-			return new CMyTransformTask(task_counter, m_pInData + taskIndex * m_InFormat.Pitch, m_InFormat.Pitch, m_pOutData + taskIndex * m_OutFormat.Pitch, m_OutFormat.Width, taskSize);
-		}
-
-	private:
-		class CMyTransformTask : public CTranformTask {
-		public:
-			CMyTransformTask(std::atomic_int& task_counter, const unsigned char* pData, size_t pitch, unsigned char* pOutData, size_t width, size_t height)
-				: CTranformTask(task_counter)
-				, pData(pData)
-				, pitch(pitch)
-				, pOutData(pOutData)
-				, width(width)
-				, height(height)
+		virtual void TransformRows(size_t firstRow, size_t numRows) {
+			const Kernels_s& kernels = GetKernels();
+			for (size_t y = firstRow; y < firstRow + numRows; ++y)
 			{
+				kernels.RgbaToBgr(m_pInData + y * m_InFormat.Pitch, m_pOutData + y * m_OutFormat.Pitch, m_OutFormat.Width);
 			}
+		}
 
-			virtual void Execute() {
-				size_t targetPitch = width * 3 * sizeof(unsigned char);
-				for (size_t y = 0; y < height; ++y)
-				{
-					for (size_t x = 0; x < width; ++x)
-					{
-						const unsigned char * pIn = (const unsigned char *)(pData + y * pitch + x * 4 * sizeof(unsigned char));
-						unsigned char * pOut = (unsigned char*)(pOutData + y * targetPitch + x * 3 * sizeof(unsigned char));
-	
-						pOut[0] = pIn[2];
-						pOut[1] = pIn[1];
-						pOut[2] = pIn[0];
-					}
-				}
-			}
-
-		private:
-			const unsigned char* pData;
-			size_t pitch;
-			unsigned char* pOutData;
-			size_t width;
-			size_t height;
-		};
-
+	private:
 		IImageBufferThreadSafe* m_Buffer;
 		advancedfx::CImageFormat m_InFormat;
 		const unsigned char* m_pInData;
@@ -476,52 +294,19 @@ namespace ImageTransformer {
 			return nullptr;
 		}
 
-		virtual size_t GetTaskSize() {
+		virtual size_t GetRowCount() {
 			return (size_t)std::abs(m_InFormat.Height);
 		}
 
-		virtual CTranformTask* CreateTask(std::atomic_int& task_counter, int taskIndex, int taskSize) {
-			return new CMyTransformTask(task_counter, m_pInData + taskIndex * m_InFormat.Pitch, m_InFormat.Pitch, m_pOutData + taskIndex * m_OutFormat.Pitch, m_OutFormat.Width, taskSize);
-		}
-
-	private:
-		class CMyTransformTask : public CTranformTask {
-		public:
-			CMyTransformTask(std::atomic_int& task_counter, const unsigned char* pData, size_t pitch, unsigned char* pOutData, size_t width, size_t height)
-				: CTranformTask(task_counter)
-				, pData(pData)
-				, pitch(pitch)
-				, pOutData(pOutData)
-				, width(width)
-				, height(height)
+		virtual void TransformRows(size_t firstRow, size_t numRows) {
+			const Kernels_s& kernels = GetKernels();
+			for (size_t y = firstRow; y < firstRow + numRows; ++y)
 			{
+				kernels.RgbaToBgra(m_pInData + y * m_InFormat.Pitch, m_pOutData + y * m_OutFormat.Pitch, m_OutFormat.Width);
 			}
+		}
 
-			virtual void Execute() {
-				size_t targetPitch = width * 4 * sizeof(unsigned char);
-				for (size_t y = 0; y < height; ++y)
-				{
-					for (size_t x = 0; x < width; ++x)
-					{
-						const unsigned char * pIn = (const unsigned char *)(pData + y * pitch + x * 4 * sizeof(unsigned char));
-						unsigned char * pOut = (unsigned char*)(pOutData + y * targetPitch + x * 4 * sizeof(unsigned char));
-	
-						pOut[0] = pIn[2];
-						pOut[1] = pIn[1];
-						pOut[2] = pIn[0];
-						pOut[3] = pIn[3];
-					}
-				}
-			}
-
-		private:
-			const unsigned char* pData;
-			size_t pitch;
-			unsigned char* pOutData;
-			size_t width;
-			size_t height;
-		};
-
+	private:
 		IImageBufferThreadSafe* m_Buffer;
 		advancedfx::CImageFormat m_InFormat;
 		const unsigned char* m_pInData;
@@ -561,56 +346,19 @@ namespace ImageTransformer {
 			return nullptr;
 		}
 
-		virtual size_t GetTaskSize() {
+		virtual size_t GetRowCount() {
 			return (size_t)std::abs(m_InFormat.Height);
 		}
 
-		virtual CTranformTask* CreateTask(std::atomic_int& task_counter, int taskIndex, int taskSize) {
-			return new CMyTransformTask(task_counter, m_pInData + taskIndex * m_InFormat.Pitch, m_InFormat.Pitch, m_pOutData + taskIndex * m_OutFormat.Pitch, m_OutFormat.Width, taskSize, m_DepthScale, m_DepthOfs);
-		}
-
-	private:
-		class CMyTransformTask : public CTranformTask {
-		public:
-			CMyTransformTask(std::atomic_int& task_counter, const unsigned char* pData, size_t pitch, unsigned char* pOutData, size_t width, size_t height, float depthScale, float depthOfs)
-				: CTranformTask(task_counter)
-				, pData(pData)
-				, pitch(pitch)
-				, pOutData(pOutData)
-				, width(width)
-				, height(height)
-				, depthScale(depthScale)
-				, depthOfs(depthOfs)
+		virtual void TransformRows(size_t firstRow, size_t numRows) {
+			const Kernels_s& kernels = GetKernels();
+			for (size_t y = firstRow; y < firstRow + numRows; ++y)
 			{
+				kernels.DepthF((const float*)(m_pInData + y * m_InFormat.Pitch), (float*)(m_pOutData + y * m_OutFormat.Pitch), m_OutFormat.Width, m_DepthScale, m_DepthOfs);
 			}
+		}
 
-			virtual void Execute() {
-				size_t targetPitch = width * sizeof(float);
-				for (size_t y = 0; y < height; ++y)
-				{
-					for (size_t x = 0; x < width; ++x)
-					{
-						float depth = *(const float*)(pData + y * pitch + x * sizeof(float));
-
-						depth *= depthScale;
-						depth += depthOfs;
-
-						*(float*)(pOutData + y * targetPitch + x * sizeof(float))
-							= depth;
-					}
-				}
-			}
-
-		private:
-			const unsigned char* pData;
-			size_t pitch;
-			unsigned char* pOutData;
-			size_t width;
-			size_t height;
-			float depthScale;
-			float depthOfs;
-		};
-
+	private:
 		IImageBufferThreadSafe* m_Buffer;
 		advancedfx::CImageFormat m_InFormat;
 		const unsigned char* m_pInData;
@@ -652,63 +400,20 @@ namespace ImageTransformer {
 			return nullptr;
 		}
 
-		virtual size_t GetTaskSize() {
+		virtual size_t GetRowCount() {
 			return (size_t)std::abs(m_InFormat.Height);
 		}
 
-		virtual CTranformTask* CreateTask(std::atomic_int& task_counter, int taskIndex, int taskSize) {
-			return new CMyTransformTask(task_counter, m_pInData + taskIndex * m_InFormat.Pitch, m_InFormat.Pitch, m_InFormat.GetPixelStride(), m_pOutData + taskIndex * m_OutFormat.Pitch, m_OutFormat.Width, taskSize, m_DepthScale, m_DepthOfs);
-		}
-
-	private:
-		class CMyTransformTask : public CTranformTask {
-		public:
-			CMyTransformTask(std::atomic_int& task_counter, const unsigned char* pData, size_t pitch, size_t pixelPitch, unsigned char* pOutData, size_t width, size_t height, float depthScale, float depthOfs)
-				: CTranformTask(task_counter)
-				, pData(pData)
-				, pitch(pitch)
-				, pixelPitch(pixelPitch)
-				, pOutData(pOutData)
-				, width(width)
-				, height(height)
-				, depthScale(depthScale)
-				, depthOfs(depthOfs)
+		virtual void TransformRows(size_t firstRow, size_t numRows) {
+			const Kernels_s& kernels = GetKernels();
+			size_t pixelPitch = m_InFormat.GetPixelStride();
+			for (size_t y = firstRow; y < firstRow + numRows; ++y)
 			{
+				kernels.Depth24(m_pInData + y * m_InFormat.Pitch, pixelPitch, (float*)(m_pOutData + y * m_OutFormat.Pitch), m_OutFormat.Width, m_DepthScale, m_DepthOfs);
 			}
+		}
 
-			virtual void Execute() {
-				size_t targetPitch = width * sizeof(float);
-				for (size_t y = 0; y < height; ++y)
-				{
-					for (size_t x = 0; x < width; ++x)
-					{
-						const unsigned char b = pData[y * pitch + x * pixelPitch + 0];
-						const unsigned char g = pData[y * pitch + x * pixelPitch + 1];
-						const unsigned char r = pData[y * pitch + x * pixelPitch + 2];
-
-						float depth;
-
-						depth = (1.0f / 16777215.0f) * r + (256.0f / 16777215.0f) * g + (65536.0f / 16777215.0f) * b;
-
-						depth *= depthScale;
-						depth += depthOfs;
-
-						*(float*)(pOutData + y * targetPitch + x * sizeof(float)) = depth;
-					}
-				}
-			}
-
-		private:
-			const unsigned char* pData;
-			size_t pitch;
-			size_t pixelPitch;
-			unsigned char* pOutData;
-			size_t width;
-			size_t height;
-			float depthScale;
-			float depthOfs;
-		};
-
+	private:
 		IImageBufferThreadSafe* m_Buffer;
 		advancedfx::CImageFormat m_InFormat;
 		const unsigned char* m_pInData;
@@ -720,31 +425,10 @@ namespace ImageTransformer {
 
 IImageBufferThreadSafe* Transform(class CThreadPool * threadPool, CGrowingBufferPoolThreadSafe * imageBufferPool, class ITransform* transform) {
     if (IImageBufferThreadSafe* pOutBuffer = transform->CreateOutput(imageBufferPool)) {
-        size_t outTaskSize = transform->GetTaskSize();
-        size_t thread_count = std::min(threadPool->GetThreadCount() + 1, outTaskSize);
-        size_t lines_per_task = outTaskSize / thread_count;
-        size_t lines_per_task_remainder = outTaskSize % thread_count;
-        std::atomic_int task_counter(0);
-        size_t line = 0;
-        if (1 < thread_count) {
-            std::vector<advancedfx::CThreadPool::CTask*> tasks(thread_count - 1);
-            for (size_t i = 0; i < tasks.size(); i++) {
-                size_t cur_task_lines = lines_per_task;
-                if (0 < lines_per_task_remainder) {
-                    cur_task_lines += 1;
-                    lines_per_task_remainder--;
-                }
-                tasks[i] = transform->CreateTask(task_counter, line, cur_task_lines);
-                line += cur_task_lines;
-            }
-            threadPool->QueueTasks(tasks);
-        }
-        {
-            advancedfx::CThreadPool::CTask* lastTask = transform->CreateTask(task_counter, line, lines_per_task);
-            lastTask->Execute();
-            delete lastTask;
-        }
-        while (0 < task_counter) {}
+        // 16 rows are enough work per chunk to hide claiming it, and leave enough chunks to balance the threads:
+        threadPool->ParallelFor(transform->GetRowCount(), 16, [transform](size_t first, size_t num) {
+            transform->TransformRows(first, num);
+        });
 
         return pOutBuffer;
     }
@@ -0,0 +1,517 @@
+#include "stdafx.h"
+
+#include "ImageTransformerKernels.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(_M_AMD64) || defined(__i386__) || defined(__x86_64__)
+#define ADVANCEDFX_IMAGETRANSFORMER_X86
+#include <immintrin.h>
+#endif
+
+// MSVC allows intrinsics of any instruction set in any function, GCC / Clang need them enabled per function:
+#if defined(__GNUC__)
+#define ADVANCEDFX_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ADVANCEDFX_TARGET(isa)
+#endif
+
+namespace advancedfx {
+namespace ImageTransformer {
+
+////////////////////////////////////////////////////////////////////////////////
+// Scalar (reference)
+
+static void StripAlpha_Scalar(const unsigned char* in, unsigned char* out, size_t width) {
+	for (size_t x = 0; x < width; ++x) {
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+		in += 4;
+		out += 3;
+	}
+}
+
+static void RgbaToBgr_Scalar(const unsigned char* in, unsigned char* out, size_t width) {
+	for (size_t x = 0; x < width; ++x) {
+		out[0] = in[2];
+		out[1] = in[1];
+		out[2] = in[0];
+		in += 4;
+		out += 3;
+	}
+}
+
+static void RgbaToBgra_Scalar(const unsigned char* in, unsigned char* out, size_t width) {
+	for (size_t x = 0; x < width; ++x) {
+		out[0] = in[2];
+		out[1] = in[1];
+		out[2] = in[0];
+		out[3] = in[3];
+		in += 4;
+		out += 4;
+	}
+}
+
+static void Matte_Scalar(const unsigned char* inEntBlack, size_t pixelStrideEntBlack, const unsigned char* inEntWhite, size_t pixelStrideEntWhite, unsigned char* out, size_t width) {
+	for (size_t x = 0; x < width; ++x) {
+		unsigned char bB = inEntBlack[0];
+		unsigned char bG = inEntBlack[1];
+		unsigned char bR = inEntBlack[2];
+		unsigned char wB = inEntWhite[0];
+		unsigned char wG = inEntWhite[1];
+		unsigned char wR = inEntWhite[2];
+
+		out[0] = (unsigned char)(((int)bB + (int)wB) / 2);
+		out[1] = (unsigned char)(((int)bG + (int)wG) / 2);
+		out[2] = (unsigned char)(((int)bR + (int)wR) / 2);
+
+		int alpha = (255 - (int)wB + (int)bB + 255 - (int)wG + (int)bG + 255 - (int)wR + (int)bR) / 3;
+		out[3] = (unsigned char)(alpha < 0 ? 0 : (255 < alpha ? 255 : alpha));
+
+		inEntBlack += pixelStrideEntBlack;
+		inEntWhite += pixelStrideEntWhite;
+		out += 4;
+	}
+}
+
+static void AColorBRedAsAlpha_Scalar(const unsigned char* inA, size_t pixelStrideA, const unsigned char* inB, size_t pixelStrideB, unsigned char* out, size_t width) {
+	for (size_t x = 0; x < width; ++x) {
+		out[0] = inA[0];
+		out[1] = inA[1];
+		out[2] = inA[2];
+		out[3] = inB[0];
+		inA += pixelStrideA;
+		inB += pixelStrideB;
+		out += 4;
+	}
+}
+
+static void DepthF_Scalar(const float* in, float* out, size_t width, float depthScale, float depthOfs) {
+	for (size_t x = 0; x < width; ++x) {
+		float depth = in[x];
+		depth *= depthScale;
+		depth += depthOfs;
+		out[x] = depth;
+	}
+}
+
+static void Depth24_Scalar(const unsigned char* in, size_t pixelStride, float* out, size_t width, float depthScale, float depthOfs) {
+	for (size_t x = 0; x < width; ++x) {
+		unsigned char b = in[0];
+		unsigned char g = in[1];
+		unsigned char r = in[2];
+		float depth = (1.0f / 16777215.0f) * r + (256.0f / 16777215.0f) * g + (65536.0f / 16777215.0f) * b;
+		depth *= depthScale;
+		depth += depthOfs;
+		out[x] = depth;
+		in += pixelStride;
+	}
+}
+
+#ifdef ADVANCEDFX_IMAGETRANSFORMER_X86
+
+////////////////////////////////////////////////////////////////////////////////
+// SSE2
+//
+// Channel swizzles that drop bytes need SSSE3 (pshufb), SSE2 only does the
+// ones that work on whole 32 bit pixels and the arithmetic.
+// Tails (and unsupported pixel strides) are done by the scalar kernels.
+
+// 8 BGR(A) pixels (as 32 bit each, 4th byte ignored) of black and white to 8 BGRA.
+ADVANCEDFX_TARGET("sse2")
+static inline void Matte8_SSE2(__m128i black0, __m128i black1, __m128i white0, __m128i white1, __m128i& out0, __m128i& out1) {
+	const __m128i mask = _mm_set1_epi32(0xff);
+
+	__m128i bB = _mm_packs_epi32(_mm_and_si128(black0, mask), _mm_and_si128(black1, mask));
+	__m128i bG = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(black0, 8), mask), _mm_and_si128(_mm_srli_epi32(black1, 8), mask));
+	__m128i bR = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(black0, 16), mask), _mm_and_si128(_mm_srli_epi32(black1, 16), mask));
+	__m128i wB = _mm_packs_epi32(_mm_and_si128(white0, mask), _mm_and_si128(white1, mask));
+	__m128i wG = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(white0, 8), mask), _mm_and_si128(_mm_srli_epi32(white1, 8), mask));
+	__m128i wR = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(white0, 16), mask), _mm_and_si128(_mm_srli_epi32(white1, 16), mask));
+
+	__m128i oB = _mm_srli_epi16(_mm_add_epi16(bB, wB), 1);
+	__m128i oG = _mm_srli_epi16(_mm_add_epi16(bG, wG), 1);
+	__m128i oR = _mm_srli_epi16(_mm_add_epi16(bR, wR), 1);
+
+	// 0 <= sum <= 1530, so sum / 3 == (sum * 0xaaab) >> 17 and only the upper clamp is needed:
+	__m128i sum = _mm_add_epi16(_mm_set1_epi16(3 * 255), _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(bB, bG), bR), _mm_add_epi16(_mm_add_epi16(wB, wG), wR)));
+	__m128i alpha = _mm_min_epi16(_mm_srli_epi16(_mm_mulhi_epu16(sum, _mm_set1_epi16((short)0xaaab)), 1), _mm_set1_epi16(255));
+
+	__m128i bg = _mm_or_si128(oB, _mm_slli_epi16(oG, 8));
+	__m128i ra = _mm_or_si128(oR, _mm_slli_epi16(alpha, 8));
+
+	out0 = _mm_unpacklo_epi16(bg, ra);
+	out1 = _mm_unpackhi_epi16(bg, ra);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static inline __m128i AColorBRedAsAlpha4_SSE2(__m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(a, _mm_set1_epi32(0x00ffffff)), _mm_slli_epi32(b, 24));
+}
+
+// 4 BGR(A) pixels (as 32 bit each, 4th byte ignored) to depth.
+ADVANCEDFX_TARGET("sse2")
+static inline __m128 Depth24_4_SSE2(__m128i in, __m128 depthScale, __m128 depthOfs) {
+	const __m128i mask = _mm_set1_epi32(0xff);
+
+	__m128 b = _mm_cvtepi32_ps(_mm_and_si128(in, mask));
+	__m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(in, 8), mask));
+	__m128 r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(in, 16), mask));
+
+	// Same order of operations as in Depth24_Scalar:
+	__m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.0f / 16777215.0f), r), _mm_mul_ps(_mm_set1_ps(256.0f / 16777215.0f), g)), _mm_mul_ps(_mm_set1_ps(65536.0f / 16777215.0f), b));
+	return _mm_add_ps(_mm_mul_ps(depth, depthScale), depthOfs);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void RgbaToBgra_SSE2(const unsigned char* in, unsigned char* out, size_t width) {
+	const __m128i maskGA = _mm_set1_epi32((int)0xff00ff00);
+	const __m128i maskLow = _mm_set1_epi32(0xff);
+	size_t x = 0;
+	for (; x + 4 <= width; x += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(in + 4 * x));
+		__m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), maskLow);
+		__m128i b = _mm_slli_epi32(_mm_and_si128(v, maskLow), 16);
+		_mm_storeu_si128((__m128i*)(out + 4 * x), _mm_or_si128(_mm_and_si128(v, maskGA), _mm_or_si128(r, b)));
+	}
+	RgbaToBgra_Scalar(in + 4 * x, out + 4 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void Matte_SSE2(const unsigned char* inEntBlack, size_t pixelStrideEntBlack, const unsigned char* inEntWhite, size_t pixelStrideEntWhite, unsigned char* out, size_t width) {
+	size_t x = 0;
+	if (4 == pixelStrideEntBlack && 4 == pixelStrideEntWhite) {
+		for (; x + 8 <= width; x += 8) {
+			__m128i out0, out1;
+			Matte8_SSE2(
+				_mm_loadu_si128((const __m128i*)(inEntBlack + 4 * x)), _mm_loadu_si128((const __m128i*)(inEntBlack + 4 * x + 16)),
+				_mm_loadu_si128((const __m128i*)(inEntWhite + 4 * x)), _mm_loadu_si128((const __m128i*)(inEntWhite + 4 * x + 16)),
+				out0, out1);
+			_mm_storeu_si128((__m128i*)(out + 4 * x), out0);
+			_mm_storeu_si128((__m128i*)(out + 4 * x + 16), out1);
+		}
+	}
+	Matte_Scalar(inEntBlack + pixelStrideEntBlack * x, pixelStrideEntBlack, inEntWhite + pixelStrideEntWhite * x, pixelStrideEntWhite, out + 4 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void AColorBRedAsAlpha_SSE2(const unsigned char* inA, size_t pixelStrideA, const unsigned char* inB, size_t pixelStrideB, unsigned char* out, size_t width) {
+	size_t x = 0;
+	if (4 == pixelStrideA && 4 == pixelStrideB) {
+		for (; x + 4 <= width; x += 4) {
+			_mm_storeu_si128((__m128i*)(out + 4 * x), AColorBRedAsAlpha4_SSE2(_mm_loadu_si128((const __m128i*)(inA + 4 * x)), _mm_loadu_si128((const __m128i*)(inB + 4 * x))));
+		}
+	}
+	AColorBRedAsAlpha_Scalar(inA + pixelStrideA * x, pixelStrideA, inB + pixelStrideB * x, pixelStrideB, out + 4 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void DepthF_SSE2(const float* in, float* out, size_t width, float depthScale, float depthOfs) {
+	const __m128 scale = _mm_set1_ps(depthScale);
+	const __m128 ofs = _mm_set1_ps(depthOfs);
+	size_t x = 0;
+	for (; x + 4 <= width; x += 4) {
+		_mm_storeu_ps(out + x, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + x), scale), ofs));
+	}
+	DepthF_Scalar(in + x, out + x, width - x, depthScale, depthOfs);
+}
+
+ADVANCEDFX_TARGET("sse2")
+static void Depth24_SSE2(const unsigned char* in, size_t pixelStride, float* out, size_t width, float depthScale, float depthOfs) {
+	const __m128 scale = _mm_set1_ps(depthScale);
+	const __m128 ofs = _mm_set1_ps(depthOfs);
+	size_t x = 0;
+	if (4 == pixelStride) {
+		for (; x + 4 <= width; x += 4) {
+			_mm_storeu_ps(out + x, Depth24_4_SSE2(_mm_loadu_si128((const __m128i*)(in + 4 * x)), scale, ofs));
+		}
+	}
+	Depth24_Scalar(in + pixelStride * x, pixelStride, out + x, width - x, depthScale, depthOfs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SSSE3
+//
+// Stores of 3 byte pixels write a full register of which only 12 (24 for
+// AVX2) bytes are valid, the rest is overwritten by the next iteration, so the
+// loops stop early enough for the last store to stay inside the row.
+// 3 byte pixel loads are bounded the same way.
+
+// 4 pixels of pixelStride 3 or 4 (at least 16 bytes readable) to 32 bit each.
+ADVANCEDFX_TARGET("ssse3")
+static inline __m128i Load4_SSSE3(const unsigned char* in, size_t pixelStride) {
+	__m128i v = _mm_loadu_si128((const __m128i*)in);
+	if (4 == pixelStride) return v;
+	return _mm_shuffle_epi8(v, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+}
+
+ADVANCEDFX_TARGET("ssse3")
+static inline size_t Shuffle4To3_SSSE3(const unsigned char* in, unsigned char* out, size_t width, __m128i shuffle) {
+	size_t x = 0;
+	for (; x + 6 <= width; x += 4) {
+		_mm_storeu_si128((__m128i*)(out + 3 * x), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 4 * x)), shuffle));
+	}
+	return x;
+}
+
+ADVANCEDFX_TARGET("ssse3")
+static void StripAlpha_SSSE3(const unsigned char* in, unsigned char* out, size_t width) {
+	size_t x = Shuffle4To3_SSSE3(in, out, width, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+	StripAlpha_Scalar(in + 4 * x, out + 3 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("ssse3")
+static void RgbaToBgr_SSSE3(const unsigned char* in, unsigned char* out, size_t width) {
+	size_t x = Shuffle4To3_SSSE3(in, out, width, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	RgbaToBgr_Scalar(in + 4 * x, out + 3 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("ssse3")
+static void RgbaToBgra_SSSE3(const unsigned char* in, unsigned char* out, size_t width) {
+	const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	size_t x = 0;
+	for (; x + 4 <= width; x += 4) {
+		_mm_storeu_si128((__m128i*)(out + 4 * x), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 4 * x)), shuffle));
+	}
+	RgbaToBgra_Scalar(in + 4 * x, out + 4 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("ssse3")
+static void Matte_SSSE3(const unsigned char* inEntBlack, size_t pixelStrideEntBlack, const unsigned char* inEntWhite, size_t pixelStrideEntWhite, unsigned char* out, size_t width) {
+	size_t x = 0;
+	if ((3 == pixelStrideEntBlack || 4 == pixelStrideEntBlack) && (3 == pixelStrideEntWhite || 4 == pixelStrideEntWhite)) {
+		for (; x + 10 <= width; x += 8) {
+			const unsigned char* black = inEntBlack + pixelStrideEntBlack * x;
+			const unsigned char* white = inEntWhite + pixelStrideEntWhite * x;
+			__m128i out0, out1;
+			Matte8_SSE2(
+				Load4_SSSE3(black, pixelStrideEntBlack), Load4_SSSE3(black + 4 * pixelStrideEntBlack, pixelStrideEntBlack),
+				Load4_SSSE3(white, pixelStrideEntWhite), Load4_SSSE3(white + 4 * pixelStrideEntWhite, pixelStrideEntWhite),
+				out0, out1);
+			_mm_storeu_si128((__m128i*)(out + 4 * x), out0);
+			_mm_storeu_si128((__m128i*)(out + 4 * x + 16), out1);
+		}
+	}
+	Matte_Scalar(inEntBlack + pixelStrideEntBlack * x, pixelStrideEntBlack, inEntWhite + pixelStrideEntWhite * x, pixelStrideEntWhite, out + 4 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("ssse3")
+static void AColorBRedAsAlpha_SSSE3(const unsigned char* inA, size_t pixelStrideA, const unsigned char* inB, size_t pixelStrideB, unsigned char* out, size_t width) {
+	size_t x = 0;
+	if ((3 == pixelStrideA || 4 == pixelStrideA) && (3 == pixelStrideB || 4 == pixelStrideB)) {
+		for (; x + 6 <= width; x += 4) {
+			_mm_storeu_si128((__m128i*)(out + 4 * x), AColorBRedAsAlpha4_SSE2(Load4_SSSE3(inA + pixelStrideA * x, pixelStrideA), Load4_SSSE3(inB + pixelStrideB * x, pixelStrideB)));
+		}
+	}
+	AColorBRedAsAlpha_Scalar(inA + pixelStrideA * x, pixelStrideA, inB + pixelStrideB * x, pixelStrideB, out + 4 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("ssse3")
+static void Depth24_SSSE3(const unsigned char* in, size_t pixelStride, float* out, size_t width, float depthScale, float depthOfs) {
+	const __m128 scale = _mm_set1_ps(depthScale);
+	const __m128 ofs = _mm_set1_ps(depthOfs);
+	size_t x = 0;
+	if (3 == pixelStride || 4 == pixelStride) {
+		for (; x + 6 <= width; x += 4) {
+			_mm_storeu_ps(out + x, Depth24_4_SSE2(Load4_SSSE3(in + pixelStride * x, pixelStride), scale, ofs));
+		}
+	}
+	Depth24_Scalar(in + pixelStride * x, pixelStride, out + x, width - x, depthScale, depthOfs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// AVX2
+//
+// 8 pixels at a time for 4 byte pixels, 3 byte pixel inputs use SSSE3.
+
+ADVANCEDFX_TARGET("avx2")
+static inline size_t Shuffle4To3_AVX2(const unsigned char* in, unsigned char* out, size_t width, __m256i shuffle) {
+	// pshufb works per 128 bit lane, so move the 12 valid bytes of each lane together:
+	const __m256i permute = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+	size_t x = 0;
+	for (; x + 11 <= width; x += 8) {
+		__m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(in + 4 * x)), shuffle);
+		_mm256_storeu_si256((__m256i*)(out + 3 * x), _mm256_permutevar8x32_epi32(v, permute));
+	}
+	return x;
+}
+
+ADVANCEDFX_TARGET("avx2")
+static void StripAlpha_AVX2(const unsigned char* in, unsigned char* out, size_t width) {
+	size_t x = Shuffle4To3_AVX2(in, out, width, _mm256_setr_epi8(
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+	StripAlpha_SSSE3(in + 4 * x, out + 3 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("avx2")
+static void RgbaToBgr_AVX2(const unsigned char* in, unsigned char* out, size_t width) {
+	size_t x = Shuffle4To3_AVX2(in, out, width, _mm256_setr_epi8(
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	RgbaToBgr_SSSE3(in + 4 * x, out + 3 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("avx2")
+static void RgbaToBgra_AVX2(const unsigned char* in, unsigned char* out, size_t width) {
+	const __m256i shuffle = _mm256_setr_epi8(
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	size_t x = 0;
+	for (; x + 8 <= width; x += 8) {
+		_mm256_storeu_si256((__m256i*)(out + 4 * x), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(in + 4 * x)), shuffle));
+	}
+	RgbaToBgra_SSSE3(in + 4 * x, out + 4 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("avx2")
+static void Matte_AVX2(const unsigned char* inEntBlack, size_t pixelStrideEntBlack, const unsigned char* inEntWhite, size_t pixelStrideEntWhite, unsigned char* out, size_t width) {
+	size_t x = 0;
+	if (4 == pixelStrideEntBlack && 4 == pixelStrideEntWhite) {
+		const __m256i mask = _mm256_set1_epi32(0xff);
+		for (; x + 16 <= width; x += 16) {
+			__m256i black0 = _mm256_loadu_si256((const __m256i*)(inEntBlack + 4 * x));
+			__m256i black1 = _mm256_loadu_si256((const __m256i*)(inEntBlack + 4 * x + 32));
+			__m256i white0 = _mm256_loadu_si256((const __m256i*)(inEntWhite + 4 * x));
+			__m256i white1 = _mm256_loadu_si256((const __m256i*)(inEntWhite + 4 * x + 32));
+
+			// Same as Matte8_SSE2, packs and unpacks work per lane, so the pixel order is restored by the unpacks.
+			__m256i bB = _mm256_packs_epi32(_mm256_and_si256(black0, mask), _mm256_and_si256(black1, mask));
+			__m256i bG = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(black0, 8), mask), _mm256_and_si256(_mm256_srli_epi32(black1, 8), mask));
+			__m256i bR = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(black0, 16), mask), _mm256_and_si256(_mm256_srli_epi32(black1, 16), mask));
+			__m256i wB = _mm256_packs_epi32(_mm256_and_si256(white0, mask), _mm256_and_si256(white1, mask));
+			__m256i wG = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(white0, 8), mask), _mm256_and_si256(_mm256_srli_epi32(white1, 8), mask));
+			__m256i wR = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(white0, 16), mask), _mm256_and_si256(_mm256_srli_epi32(white1, 16), mask));
+
+			__m256i oB = _mm256_srli_epi16(_mm256_add_epi16(bB, wB), 1);
+			__m256i oG = _mm256_srli_epi16(_mm256_add_epi16(bG, wG), 1);
+			__m256i oR = _mm256_srli_epi16(_mm256_add_epi16(bR, wR), 1);
+
+			__m256i sum = _mm256_add_epi16(_mm256_set1_epi16(3 * 255), _mm256_sub_epi16(_mm256_add_epi16(_mm256_add_epi16(bB, bG), bR), _mm256_add_epi16(_mm256_add_epi16(wB, wG), wR)));
+			__m256i alpha = _mm256_min_epi16(_mm256_srli_epi16(_mm256_mulhi_epu16(sum, _mm256_set1_epi16((short)0xaaab)), 1), _mm256_set1_epi16(255));
+
+			__m256i bg = _mm256_or_si256(oB, _mm256_slli_epi16(oG, 8));
+			__m256i ra = _mm256_or_si256(oR, _mm256_slli_epi16(alpha, 8));
+
+			_mm256_storeu_si256((__m256i*)(out + 4 * x), _mm256_unpacklo_epi16(bg, ra));
+			_mm256_storeu_si256((__m256i*)(out + 4 * x + 32), _mm256_unpackhi_epi16(bg, ra));
+		}
+	}
+	Matte_SSSE3(inEntBlack + pixelStrideEntBlack * x, pixelStrideEntBlack, inEntWhite + pixelStrideEntWhite * x, pixelStrideEntWhite, out + 4 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("avx2")
+static void AColorBRedAsAlpha_AVX2(const unsigned char* inA, size_t pixelStrideA, const unsigned char* inB, size_t pixelStrideB, unsigned char* out, size_t width) {
+	size_t x = 0;
+	if (4 == pixelStrideA && 4 == pixelStrideB) {
+		const __m256i mask = _mm256_set1_epi32(0x00ffffff);
+		for (; x + 8 <= width; x += 8) {
+			__m256i a = _mm256_loadu_si256((const __m256i*)(inA + 4 * x));
+			__m256i b = _mm256_loadu_si256((const __m256i*)(inB + 4 * x));
+			_mm256_storeu_si256((__m256i*)(out + 4 * x), _mm256_or_si256(_mm256_and_si256(a, mask), _mm256_slli_epi32(b, 24)));
+		}
+	}
+	AColorBRedAsAlpha_SSSE3(inA + pixelStrideA * x, pixelStrideA, inB + pixelStrideB * x, pixelStrideB, out + 4 * x, width - x);
+}
+
+ADVANCEDFX_TARGET("avx2")
+static void DepthF_AVX2(const float* in, float* out, size_t width, float depthScale, float depthOfs) {
+	// No FMA, to get the same results as the other kernels.
+	const __m256 scale = _mm256_set1_ps(depthScale);
+	const __m256 ofs = _mm256_set1_ps(depthOfs);
+	size_t x = 0;
+	for (; x + 8 <= width; x += 8) {
+		_mm256_storeu_ps(out + x, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in + x), scale), ofs));
+	}
+	DepthF_SSE2(in + x, out + x, width - x, depthScale, depthOfs);
+}
+
+ADVANCEDFX_TARGET("avx2")
+static void Depth24_AVX2(const unsigned char* in, size_t pixelStride, float* out, size_t width, float depthScale, float depthOfs) {
+	size_t x = 0;
+	if (4 == pixelStride) {
+		const __m256i mask = _mm256_set1_epi32(0xff);
+		const __m256 scale = _mm256_set1_ps(depthScale);
+		const __m256 ofs = _mm256_set1_ps(depthOfs);
+		for (; x + 8 <= width; x += 8) {
+			__m256i v = _mm256_loadu_si256((const __m256i*)(in + 4 * x));
+			__m256 b = _mm256_cvtepi32_ps(_mm256_and_si256(v, mask));
+			__m256 g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 8), mask));
+			__m256 r = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 16), mask));
+			__m256 depth = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(1.0f / 16777215.0f), r), _mm256_mul_ps(_mm256_set1_ps(256.0f / 16777215.0f), g)), _mm256_mul_ps(_mm256_set1_ps(65536.0f / 16777215.0f), b));
+			_mm256_storeu_ps(out + x, _mm256_add_ps(_mm256_mul_ps(depth, scale), ofs));
+		}
+	}
+	Depth24_SSSE3(in + pixelStride * x, pixelStride, out + x, width - x, depthScale, depthOfs);
+}
+
+#endif // ADVANCEDFX_IMAGETRANSFORMER_X86
+
+////////////////////////////////////////////////////////////////////////////////
+
+static const Kernels_s g_Kernels_Scalar = {
+	StripAlpha_Scalar,
+	RgbaToBgr_Scalar,
+	RgbaToBgra_Scalar,
+	Matte_Scalar,
+	AColorBRedAsAlpha_Scalar,
+	DepthF_Scalar,
+	Depth24_Scalar
+};
+
+#ifdef ADVANCEDFX_IMAGETRANSFORMER_X86
+
+static const Kernels_s g_Kernels_SSE2 = {
+	StripAlpha_Scalar,
+	RgbaToBgr_Scalar,
+	RgbaToBgra_SSE2,
+	Matte_SSE2,
+	AColorBRedAsAlpha_SSE2,
+	DepthF_SSE2,
+	Depth24_SSE2
+};
+
+static const Kernels_s g_Kernels_SSSE3 = {
+	StripAlpha_SSSE3,
+	RgbaToBgr_SSSE3,
+	RgbaToBgra_SSSE3,
+	Matte_SSSE3,
+	AColorBRedAsAlpha_SSSE3,
+	DepthF_SSE2,
+	Depth24_SSSE3
+};
+
+static const Kernels_s g_Kernels_AVX2 = {
+	StripAlpha_AVX2,
+	RgbaToBgr_AVX2,
+	RgbaToBgra_AVX2,
+	Matte_AVX2,
+	AColorBRedAsAlpha_AVX2,
+	DepthF_AVX2,
+	Depth24_AVX2
+};
+
+#endif
+
+const Kernels_s& GetKernels(CpuIsa isa) {
+	switch (isa) {
+#ifdef ADVANCEDFX_IMAGETRANSFORMER_X86
+	case CpuIsa::SSE2:
+		return g_Kernels_SSE2;
+	case CpuIsa::SSSE3:
+		return g_Kernels_SSSE3;
+	case CpuIsa::AVX2:
+		return g_Kernels_AVX2;
+#endif
+	default:
+		break;
+	}
+	return g_Kernels_Scalar;
+}
+
+const Kernels_s& GetKernels() {
+	static const Kernels_s& kernels = GetKernels(GetCpuIsa());
+	return kernels;
+}
+
+} // namespace ImageTransformer {
+} // namespace advancedfx
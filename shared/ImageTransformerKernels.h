@@ -0,0 +1,41 @@
+#pragma once
+
+#include "CpuIsa.h"
+
+#include <stddef.h>
+
+namespace advancedfx {
+namespace ImageTransformer {
+
+	/// <summary>Row kernels of the ImageTransformer transforms.</summary>
+	/// <remarks>Input pixel strides are 3 (BGR) or 4 (BGRA), outputs are tightly packed.</remarks>
+	struct Kernels_s {
+		/// <summary>BGRA to BGR.</summary>
+		void (*StripAlpha)(const unsigned char* in, unsigned char* out, size_t width);
+
+		/// <summary>RGBA to BGR.</summary>
+		void (*RgbaToBgr)(const unsigned char* in, unsigned char* out, size_t width);
+
+		/// <summary>RGBA to BGRA.</summary>
+		void (*RgbaToBgra)(const unsigned char* in, unsigned char* out, size_t width);
+
+		/// <summary>Entity on black and on white background to BGRA with matte as alpha.</summary>
+		void (*Matte)(const unsigned char* inEntBlack, size_t pixelStrideEntBlack, const unsigned char* inEntWhite, size_t pixelStrideEntWhite, unsigned char* out, size_t width);
+
+		/// <summary>Color from A, alpha from B's first channel, to BGRA.</summary>
+		void (*AColorBRedAsAlpha)(const unsigned char* inA, size_t pixelStrideA, const unsigned char* inB, size_t pixelStrideB, unsigned char* out, size_t width);
+
+		void (*DepthF)(const float* in, float* out, size_t width, float depthScale, float depthOfs);
+
+		/// <summary>24 bit depth encoded in BGR(A) to float.</summary>
+		void (*Depth24)(const unsigned char* in, size_t pixelStride, float* out, size_t width, float depthScale, float depthOfs);
+	};
+
+	/// <param name="isa">Must be supported, see GetCpuIsa. CpuIsa::Scalar is the reference.</param>
+	const Kernels_s& GetKernels(CpuIsa isa);
+
+	/// <returns>GetKernels(GetCpuIsa()).</returns>
+	const Kernels_s& GetKernels();
+
+} // namespace ImageTransformer {
+} // namespace advancedfx
@@ -19,7 +19,7 @@ void MirvCamIO_ConsoleCommand(advancedfx::ICommandArgs * args, CamImport * & ref
 			{
 				char const * cmd2 = args->ArgV(2);
 
-				if (0 == _stricmp("start", cmd2) && 4 <= argc)
+				if (0 == _stricmp("start", cmd2) && 4 <= argc && argc <= 5)
 				{
 					if (0 != refPCamExport)
 					{
@@ -27,11 +27,13 @@ void MirvCamIO_ConsoleCommand(advancedfx::ICommandArgs * args, CamImport * & ref
 						refPCamExport = 0;
 					}
 
+					bool binary = 5 == argc && 0 == _stricmp("binary", args->ArgV(4));
+
 					std::wstring fileName(L"");
 
 					if (UTF8StringToWideString(args->ArgV(3), fileName))
 					{
-						refPCamExport = new CamExport(fileName.c_str());
+						refPCamExport = new CamExport(fileName.c_str(), binary);
 					}
 					else
 						advancedfx::Warning("Error: Can not convert \"%s\" from UTF-8 to WideString.\n", args->ArgV(3));
@@ -54,13 +56,31 @@ void MirvCamIO_ConsoleCommand(advancedfx::ICommandArgs * args, CamImport * & ref
 			}
 
 			advancedfx::Message(
-				"%s export start <fileName> - Starts exporting to file <fileName>.\n"
+				"%s export start <fileName> [binary] - Starts exporting to file <fileName> (in binary format if binary is given).\n"
 				"%s export end - Stops exporting.\n"
 				, cmd0
 				, cmd0
 			);
 			return;
 		}
+		else if (0 == _stricmp("convert", cmd1) && 4 == argc)
+		{
+			CamImport camImport(args->ArgV(2), 0);
+
+			std::wstring outFileName(L"");
+			bool toBinary = !camImport.IsBinary();
+
+			if (camImport.IsBad())
+				advancedfx::Warning("Error importing CAM file \"%s\"\n", args->ArgV(2));
+			else if (!UTF8StringToWideString(args->ArgV(3), outFileName))
+				advancedfx::Warning("Error: Can not convert \"%s\" from UTF-8 to WideString.\n", args->ArgV(3));
+			else if (!camImport.Save(outFileName.c_str(), toBinary))
+				advancedfx::Warning("Error writing CAM file \"%s\"\n", args->ArgV(3));
+			else
+				advancedfx::Message("Converted to %s format.\n", toBinary ? "binary" : "text");
+
+			return;
+		}
 		else if (0 == _stricmp("import", cmd1))
 		{
 			if (3 <= argc)
@@ -89,7 +109,7 @@ void MirvCamIO_ConsoleCommand(advancedfx::ICommandArgs * args, CamImport * & ref
 			}
 
 			advancedfx::Message(
-				"%s import start <fileName> - Starts importing cam from file <fileName>.\n"
+				"%s import start <fileName> - Starts importing cam from file <fileName> (text or binary format).\n"
 				"%s import end - Stops importing.\n"
 				, cmd0
 				, cmd0
@@ -101,6 +121,8 @@ void MirvCamIO_ConsoleCommand(advancedfx::ICommandArgs * args, CamImport * & ref
 	advancedfx::Message(
 		"%s export [...] - Controls export of new camera motion data.\n"
 		"%s import [...] - Controls import of new camera motion data.\n"
+		"%s convert <inFileName> <outFileName> - Converts a cam file from text to binary format or vice versa (lossless).\n"
+		, cmd0
 		, cmd0
 		, cmd0
 	);
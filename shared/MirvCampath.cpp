@@ -6,6 +6,21 @@
 
 #include <sstream>
 #include <iomanip>
+#include <stdlib.h>
+#include <math.h>
+
+/// <summary>Parses a non-negative tolerance, unlike atof this rejects junk, NaN and infinity.</summary>
+static bool MirvCampath_ParseTolerance(char const * value, double & outValue)
+{
+	char * end = nullptr;
+	double result = strtod(value, &end);
+
+	if (end == value || '\0' != *end || !isfinite(result) || result < 0)
+		return false;
+
+	outValue = result;
+	return true;
+}
 
 void MirvCampath_PrintTimeFormated(double time, advancedfx::Con_Printf_t conMessage)
 {
@@ -41,6 +56,27 @@ void MirvCampath_ConCommand(advancedfx::ICommandArgs* args, advancedfx::Con_Prin
 	{
 		char const* subcmd = args->ArgV(1);
 
+		// Make edits undoable (a step is only recorded if the command actually changes the path):
+		static char const* const editSubcmds[] = { "add", "clear", "remove", "load", "edit", "offset", "hold", "constantSpeed", "simplify" };
+		for (char const* editSubcmd : editSubcmds)
+		{
+			if (!_stricmp(editSubcmd, subcmd))
+			{
+				camPath->UndoCheckpoint();
+				break;
+			}
+		}
+
+		// Drop the checkpoint again on every way out, in case the command didn't change anything (i.e. printed its help):
+		class CUndoCheckpointEnd
+		{
+		public:
+			CUndoCheckpointEnd(CamPath* camPath) : m_CamPath(camPath) {}
+			~CUndoCheckpointEnd() { m_CamPath->UndoCheckpointEnd(); }
+		private:
+			CamPath* m_CamPath;
+		} undoCheckpointEnd(camPath);
+
 		if (!_stricmp("add", subcmd) && 2 == argc)
 		{
 			SMirvCameraValue camera = mirvCamera->GetCamera();
@@ -333,6 +369,16 @@ void MirvCampath_ConCommand(advancedfx::ICommandArgs* args, advancedfx::Con_Prin
 
 			return;
 		}
+		else if (!_stricmp("undo", subcmd) && 2 == argc)
+		{
+			if (!camPath->Undo()) conWarning("Nothing to undo.\n");
+			return;
+		}
+		else if (!_stricmp("redo", subcmd) && 2 == argc)
+		{
+			if (!camPath->Redo()) conWarning("Nothing to redo.\n");
+			return;
+		}
 		else if (!_stricmp("save", subcmd) && 3 == argc)
 		{
 			std::wstring wideString;
@@ -345,6 +391,41 @@ void MirvCampath_ConCommand(advancedfx::ICommandArgs* args, advancedfx::Con_Prin
 
 			return;
 		}
+		else if (!_stricmp("saveBinary", subcmd) && 3 == argc)
+		{
+			std::wstring wideString;
+			bool bOk = UTF8StringToWideString(args->ArgV(2), wideString)
+				&& camPath->SaveBinary(wideString.c_str())
+				;
+
+			if (bOk) conMessage("Saving campath: %s.\n", "OK");
+			else conWarning("Saving campath: %s.\n", "ERROR");
+
+			return;
+		}
+		else if (!_stricmp("convert", subcmd) && 4 == argc)
+		{
+			std::wstring inFileName;
+			std::wstring outFileName;
+			bool bOk = UTF8StringToWideString(args->ArgV(2), inFileName)
+				&& UTF8StringToWideString(args->ArgV(3), outFileName)
+				;
+
+			bool bToBinary = bOk && !CamPath::IsBinaryFile(inFileName.c_str());
+
+			if (bOk)
+			{
+				CamPath tmpPath;
+				bOk = tmpPath.Load(inFileName.c_str())
+					&& (bToBinary ? tmpPath.SaveBinary(outFileName.c_str()) : tmpPath.Save(outFileName.c_str()))
+					;
+			}
+
+			if (bOk) conMessage("Converting campath to %s: %s.\n", bToBinary ? "binary" : "XML", "OK");
+			else conWarning("Converting campath: %s.\n", "ERROR");
+
+			return;
+		}
 		else if (!_stricmp("edit", subcmd))
 		{
 			if (3 <= argc)
@@ -1145,7 +1226,54 @@ void MirvCampath_ConCommand(advancedfx::ICommandArgs* args, advancedfx::Con_Prin
 				, camPath->GetHold() ? 1 : 0
 			);
 			return;			
-		}		
+		}
+		else if (0 == _stricmp("constantSpeed", subcmd))
+		{
+			if(3 == argc) {
+				bool value = 0 != atoi(args->ArgV(2));
+				camPath->SetConstantSpeed(value);
+				return;
+			}
+
+			conMessage(
+				"%s constantSpeed 0|1 - Whether to move along the path at constant speed (1) or follow the keyframe timing (0, default).\n"
+				"Current value: %i\n"
+				, args->ArgV(0)
+				, camPath->GetConstantSpeed() ? 1 : 0
+			);
+			return;
+		}
+		else if (0 == _stricmp("simplify", subcmd))
+		{
+			if (3 <= argc && argc <= 5)
+			{
+				double posTolerance = 0;
+				double angTolerance = 0.5;
+				bool bOk = MirvCampath_ParseTolerance(args->ArgV(2), posTolerance)
+					&& (argc < 4 || MirvCampath_ParseTolerance(args->ArgV(3), angTolerance));
+				double fovTolerance = angTolerance;
+				bOk = bOk && (argc < 5 || MirvCampath_ParseTolerance(args->ArgV(4), fovTolerance));
+
+				if (bOk)
+				{
+					size_t oldSize = camPath->GetSize();
+					size_t removed = camPath->Simplify(posTolerance, angTolerance, fovTolerance);
+					conMessage("Removed %u of %u keyframes.\n", (unsigned int)removed, (unsigned int)oldSize);
+					return;
+				}
+			}
+
+			conMessage(
+				"%s simplify <fTolerance> [<fAngleTolerance> [<fFovTolerance>]] - Removes keyframes [of the selection] that are not needed to stay within the tolerances.\n"
+				"Position deviation is in units, angle and fov deviation in degrees. The tolerances must be 0 or greater.\n"
+				"The angle tolerance defaults to 0.5 degrees and the fov tolerance to the angle tolerance.\n"
+				"Example:\n"
+				"%s simplify 0.5 - Useful to thin out imported / recorded paths.\n"
+				, args->ArgV(0)
+				, args->ArgV(0)
+			);
+			return;
+		}
 	}
 
 	conMessage("%s add - Adds current demotime and view as keyframe.\n", args->ArgV(0));
@@ -1154,11 +1282,17 @@ void MirvCampath_ConCommand(advancedfx::ICommandArgs* args, advancedfx::Con_Prin
 	conMessage("%s clear - Removes all [or all selected] keyframes.\n", args->ArgV(0));
 	conMessage("%s print - Prints detailed information.\n", args->ArgV(0));
 	conMessage("%s remove <id> - Removes a keyframe.\n", args->ArgV(0));
-	conMessage("%s load <fileName> - Loads the campath from the file (XML format).\n", args->ArgV(0));
+	conMessage("%s undo - Undoes the last edit.\n", args->ArgV(0));
+	conMessage("%s redo - Redoes the last undone edit.\n", args->ArgV(0));
+	conMessage("%s load <fileName> - Loads the campath from the file (XML or binary format).\n", args->ArgV(0));
 	conMessage("%s save <fileName> - Saves the campath to the file (XML format).\n", args->ArgV(0));
+	conMessage("%s saveBinary <fileName> - Saves the campath to the file (binary format, faster to load).\n", args->ArgV(0));
+	conMessage("%s convert <inFileName> <outFileName> - Converts a campath file from XML to binary format or vice versa.\n", args->ArgV(0));
 	conMessage("%s edit [...] - Edit properties of the path [or selected keyframes].\n", args->ArgV(0));
 	conMessage("%s select [...] - Keyframe selection.\n", args->ArgV(0));
 	conMessage("%s offset [...] - Offset campath.\n", args->ArgV(0));
 	conMessage("%s hold [...]\n", args->ArgV(0));
+	conMessage("%s constantSpeed [...]\n", args->ArgV(0));
+	conMessage("%s simplify [...] - Removes keyframes [of the selection] that are not needed to stay within a tolerance.\n", args->ArgV(0));
 	return;
 }
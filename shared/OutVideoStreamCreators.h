@@ -65,7 +65,7 @@ class CSamplingRecordingSettingsCreator
 	: public COutVideoStreamCreator
 {
 public:
-	CSamplingRecordingSettingsCreator(class COutVideoStreamCreator * outVideoStreamCreator, float frameRate, EasySamplerSettings::Method method, double frameDuration, double exposure, float frameStrength, CGrowingBufferPoolThreadSafe * pImageBufferPool)
+	CSamplingRecordingSettingsCreator(class COutVideoStreamCreator * outVideoStreamCreator, float frameRate, EasySamplerSettings::Method method, double frameDuration, double exposure, float frameStrength, CGrowingBufferPoolThreadSafe * pImageBufferPool, class CThreadPool * pThreadPool)
 		: m_OutVideoStreamCreator(outVideoStreamCreator)
 		, m_FrameRate(frameRate)
 		, m_Method(method)
@@ -73,13 +73,21 @@ public:
 		, m_Exposure(exposure)
 		, m_FrameStrength(frameStrength)
         , m_pImageBufferPool(pImageBufferPool)
+        , m_pThreadPool(pThreadPool)
 	{
 		outVideoStreamCreator->AddRef();
 	}
 
 	virtual TIOutVideoStream<true>* CreateOutVideoStream(const CImageFormat& imageFormat) override {
 		auto outVideoStream = m_OutVideoStreamCreator->CreateOutVideoStream(imageFormat);
-		auto result = new COutSamplingStream<true>(imageFormat, outVideoStream, m_FrameRate, m_Method, m_FrameDuration, m_Exposure, m_FrameStrength, m_pImageBufferPool);
+		if (outVideoStream && m_pThreadPool) {
+			// Write the sampled frames on their own thread, so sampling the next frames doesn't wait for the encoder / disk.
+			auto pipelineStream = new COutPipelineVideoStream(imageFormat, outVideoStream, 3);
+			pipelineStream->AddRef();
+			outVideoStream->Release();
+			outVideoStream = pipelineStream;
+		}
+		auto result = new COutSamplingStream<true>(imageFormat, outVideoStream, m_FrameRate, m_Method, m_FrameDuration, m_Exposure, m_FrameStrength, m_pImageBufferPool, m_pThreadPool);
 		result->AddRef();
 		if(outVideoStream) outVideoStream->Release();
 		return result;		
@@ -98,6 +106,7 @@ private:
 	double m_Exposure;
 	float m_FrameStrength;
     CGrowingBufferPoolThreadSafe * m_pImageBufferPool;
+    class CThreadPool * m_pThreadPool;
 };
 
 } // namespace advancedfx
@@ -665,7 +665,7 @@ advancedfx::COutVideoStreamCreator* CSamplingRecordingSettings::CreateOutVideoSt
 	{
 		if (advancedfx::COutVideoStreamCreator* outVideoStreamCreator = m_OutputSettings->CreateOutVideoStreamCreator(streams, stream, m_OutFps, pathSuffix))
 		{
-			auto result = new advancedfx::CSamplingRecordingSettingsCreator(outVideoStreamCreator, frameRate, m_Method, m_OutFps ? 1.0 / m_OutFps : 0.0, m_Exposure, m_FrameStrength, streams.GetImageBufferPool());
+			auto result = new advancedfx::CSamplingRecordingSettingsCreator(outVideoStreamCreator, frameRate, m_Method, m_OutFps ? 1.0 / m_OutFps : 0.0, m_Exposure, m_FrameStrength, streams.GetImageBufferPool(), streams.GetThreadPool());
 			result->AddRef();
 			return result;
 		}
@@ -24,6 +24,8 @@ public:
 	virtual bool GetStreamFolder(std::wstring& outFolder) const = 0;
 	virtual StreamCaptureType GetCaptureType() const = 0;
     virtual CGrowingBufferPoolThreadSafe * GetImageBufferPool() const = 0;
+    /// <returns>Can be nullptr.</returns>
+    virtual class CThreadPool * GetThreadPool() const = 0;
     virtual bool GetFormatBmpNotTga() const = 0;
 };
 
@@ -1,14 +1,58 @@
 #pragma once
 
-#include <queue>
+#include <deque>
 #include <vector>
 #include <atomic>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <stdint.h>
 
 namespace advancedfx {
 
+	/// <summary>Waits until a number of things (e.g. tasks queued on a CThreadPool) are done.</summary>
+	/// <remarks>Use this instead of spinning on an std::atomic_int counter, Wait() blocks when it takes longer.</remarks>
+	class CWaitGroup {
+	public:
+		CWaitGroup()
+			: m_Count(0)
+		{
+		}
+
+		void Add(int count = 1) {
+			m_Count += count;
+		}
+
+		void Done(int count = 1) {
+			// Under the lock, so Wait() can not return (and the wait group be destroyed) before we are done here.
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			if (count == m_Count.fetch_sub(count)) m_Cv.notify_all();
+		}
+
+		bool IsDone() const {
+			return 0 == m_Count;
+		}
+
+		void Wait() {
+			// Most waits are short (the last row tiles of a frame), so spin a bit first:
+			for (int i = 0; i < 1024 && 0 != m_Count; i++) std::this_thread::yield();
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			while (0 != m_Count) m_Cv.wait(lock);
+		}
+
+	private:
+		std::atomic_int m_Count;
+		std::mutex m_Mutex;
+		std::condition_variable m_Cv;
+	};
+
+	/// <summary>Work-stealing thread pool.</summary>
+	/// <remarks>
+	///   Each worker has its own queue, idle workers steal from the others.<br />
+	///   Tasks queued from outside of the pool go through a shared queue and are started in the order they were queued
+	///   (so a pool with 1 thread runs them in order), tasks queued by a worker go to that worker's queue.
+	/// </remarks>
 	class CThreadPool {
 	public:
 		class CTask {
@@ -28,10 +72,12 @@ namespace advancedfx {
 			return hardware_concurrency - 1;
 		}
 
-		CThreadPool(size_t thread_count) {
+		CThreadPool(size_t thread_count)
+			: m_Queues(thread_count)
+		{
 			m_Threads.resize(thread_count);
 			for (size_t i = 0; i < m_Threads.size(); i++) {
-				m_Threads[i] = std::thread(&CThreadPool::ThreadFunc, this);
+				m_Threads[i] = std::thread(&CThreadPool::ThreadFunc, this, i);
 			}
 		}
 
@@ -39,6 +85,7 @@ namespace advancedfx {
 			Shutdown();
 		}
 
+		/// <remarks>The task is deleted after it has been executed.</remarks>
 		void QueueTask(class CTask* task) {
 			if (m_Threads.size() == 0) {
 				task->Execute();
@@ -46,11 +93,16 @@ namespace advancedfx {
 				return;
 			}
 
-			std::unique_lock<std::mutex> lock(m_QueueMutex);
-			m_Queue.push(task);
-			m_QueueCv.notify_one();
+			CQueue& queue = GetQueue(GetWorkerIndex());
+			m_Pending++;
+			{
+				std::unique_lock<std::mutex> lock(queue.Mutex);
+				queue.Deque.push_back(Work_s(task, nullptr));
+			}
+			Notify(1);
 		}
 
+		/// <remarks>The tasks are deleted after they have been executed.</remarks>
 		void QueueTasks(const std::vector<class CTask*> & tasks) {
 			if (m_Threads.size() == 0) {
 				for (size_t i = 0; i < tasks.size(); i++) {
@@ -61,11 +113,69 @@ namespace advancedfx {
 				return;
 			}
 
-			std::unique_lock<std::mutex> lock(m_QueueMutex);
-			for (size_t i = 0; i < tasks.size(); i++) {
-				m_Queue.push(tasks[i]);
+			CQueue& queue = GetQueue(GetWorkerIndex());
+			m_Pending += tasks.size();
+			{
+				std::unique_lock<std::mutex> lock(queue.Mutex);
+				for (size_t i = 0; i < tasks.size(); i++) {
+					queue.Deque.push_back(Work_s(tasks[i], nullptr));
+				}
 			}
-			m_QueueCv.notify_one();
+			Notify(tasks.size());
+		}
+
+		/// <summary>
+		///   Calls fn(first, num) for chunks of grain items (the last one can be smaller) covering [0, count),
+		///   in parallel on the pool and the calling thread, and returns when all chunks are done.
+		/// </summary>
+		/// <remarks>
+		///   Nothing is allocated per chunk: the calling thread and up to GetThreadCount() helpers claim the chunks from a shared counter,
+		///   so faster threads simply do more chunks.<br />
+		///   Once all chunks are claimed the calling thread takes back the helpers that did not start yet and only waits for
+		///   the ones still doing chunks. It never runs other queued work, which could take much longer than the loop.
+		///   This can be nested: every helper waited for is doing chunks of this loop.
+		/// </remarks>
+		template<class TFn> void ParallelFor(size_t count, size_t grain, const TFn& fn) {
+			if (grain < 1) grain = 1;
+
+			size_t chunks = count / grain + (0 < count % grain ? 1 : 0);
+			size_t helpers = m_Threads.size() < chunks ? m_Threads.size() : (0 < chunks ? chunks - 1 : 0);
+
+			if (0 == helpers) {
+				for (size_t first = 0; first < count; first += grain) fn(first, grain < count - first ? grain : count - first);
+				return;
+			}
+
+			CParallelForJob<TFn> job(count, grain, fn);
+			job.WaitGroup.Add((int)helpers);
+
+			size_t workerIndex = GetWorkerIndex();
+			m_Pending += helpers;
+			if (workerIndex < m_Queues.size()) {
+				// From a worker: keep them local, the idle workers will steal them.
+				CQueue& queue = m_Queues[workerIndex];
+				std::unique_lock<std::mutex> lock(queue.Mutex);
+				for (size_t i = 0; i < helpers; i++) queue.Deque.push_back(Work_s(nullptr, &job));
+			}
+			else {
+				// From outside: one per worker, so they don't contend for a queue.
+				for (size_t i = 0; i < helpers; i++) {
+					CQueue& queue = m_Queues[i];
+					std::unique_lock<std::mutex> lock(queue.Mutex);
+					queue.Deque.push_back(Work_s(nullptr, &job));
+				}
+			}
+			Notify(helpers);
+
+			job.Run();
+
+			// Take back the helpers no worker has started, they would find no chunks left (see above for where they went):
+			size_t revoked = 0;
+			if (workerIndex < m_Queues.size()) revoked = Revoke(m_Queues[workerIndex], &job);
+			else for (size_t i = 0; i < helpers; i++) revoked += Revoke(m_Queues[i], &job);
+			if (0 < revoked) job.WaitGroup.Done((int)revoked);
+
+			job.WaitGroup.Wait();
 		}
 
 		size_t GetThreadCount() {
@@ -73,38 +183,198 @@ namespace advancedfx {
 		}
 
 	private:
-		std::mutex m_QueueMutex;
-		std::queue<CTask*> m_Queue;
-		std::condition_variable m_QueueCv;
+		class CJob {
+		public:
+			/// <summary>Does chunks until there are none left.</summary>
+			virtual void Run() = 0;
+
+			CWaitGroup WaitGroup;
+
+		protected:
+			~CJob() {
+			}
+		};
+
+		template<class TFn> class CParallelForJob : public CJob {
+		public:
+			CParallelForJob(size_t count, size_t grain, const TFn& fn)
+				: m_Next(0)
+				, m_Count(count)
+				, m_Grain(grain)
+				, m_Fn(fn)
+			{
+			}
+
+			virtual void Run() override {
+				for (size_t first = m_Next.fetch_add(m_Grain); first < m_Count; first = m_Next.fetch_add(m_Grain)) {
+					m_Fn(first, m_Grain < m_Count - first ? m_Grain : m_Count - first);
+				}
+			}
+
+		private:
+			std::atomic_size_t m_Next;
+			size_t m_Count;
+			size_t m_Grain;
+			const TFn& m_Fn;
+		};
+
+		struct Work_s {
+			Work_s() : Task(nullptr), Job(nullptr) {}
+			Work_s(CTask* task, CJob* job) : Task(task), Job(job) {}
+
+			CTask* Task;
+			CJob* Job;
+		};
+
+		struct CQueue {
+			std::mutex Mutex;
+			std::deque<Work_s> Deque;
+		};
+
+		struct CurrentWorker_s {
+			CThreadPool* Pool;
+			size_t Index;
+		};
+
+		/// <summary>One per worker, the owner takes from the back, thieves from the front.</summary>
+		std::vector<CQueue> m_Queues;
+
+		/// <summary>For work from outside the pool, first in first out.</summary>
+		CQueue m_SharedQueue;
+
+		/// <summary>Number of queued work items, raised before they are queued.</summary>
+		std::atomic_size_t m_Pending{ 0 };
+
+		std::mutex m_SleepMutex;
+		std::condition_variable m_SleepCv;
+		std::atomic_int m_Sleeping{ 0 };
 		bool m_Shutdown = false;
 
 		std::vector<std::thread> m_Threads;
 
-		void ThreadFunc() {
-			std::unique_lock<std::mutex> lock(m_QueueMutex);
-			while (!m_Shutdown || !m_Queue.empty()) {
-				if (!m_Queue.empty()) {
-					CTask* task = m_Queue.front();
-					m_Queue.pop();
-					if (!m_Queue.empty()) m_QueueCv.notify_one();
-					lock.unlock();
-					task->Execute();
-					delete task;
-					lock.lock();
+		static CurrentWorker_s& GetCurrentWorker() {
+			static thread_local CurrentWorker_s t_CurrentWorker = { nullptr, SIZE_MAX };
+			return t_CurrentWorker;
+		}
+
+		/// <returns>The index of the calling thread in this pool or SIZE_MAX if it's not one of ours.</returns>
+		size_t GetWorkerIndex() {
+			CurrentWorker_s& currentWorker = GetCurrentWorker();
+			return this == currentWorker.Pool ? currentWorker.Index : SIZE_MAX;
+		}
+
+		CQueue& GetQueue(size_t workerIndex) {
+			return workerIndex < m_Queues.size() ? m_Queues[workerIndex] : m_SharedQueue;
+		}
+
+		/// <summary>Wakes sleeping workers for count newly queued work items.</summary>
+		void Notify(size_t count) {
+			if (0 < m_Sleeping) {
+				std::unique_lock<std::mutex> lock(m_SleepMutex);
+				if (1 < count) m_SleepCv.notify_all();
+				else m_SleepCv.notify_one();
+			}
+		}
+
+		/// <param name="workerIndex">SIZE_MAX if not called from a worker</param>
+		bool Take(size_t workerIndex, Work_s& outWork) {
+			if (0 == m_Pending) return false;
+
+			if (workerIndex < m_Queues.size()) {
+				CQueue& queue = m_Queues[workerIndex];
+				std::unique_lock<std::mutex> lock(queue.Mutex);
+				if (!queue.Deque.empty()) {
+					outWork = queue.Deque.back();
+					queue.Deque.pop_back();
+					m_Pending--;
+					return true;
+				}
+			}
+
+			{
+				std::unique_lock<std::mutex> lock(m_SharedQueue.Mutex);
+				if (!m_SharedQueue.Deque.empty()) {
+					outWork = m_SharedQueue.Deque.front();
+					m_SharedQueue.Deque.pop_front();
+					m_Pending--;
+					return true;
 				}
-				else {
-					m_QueueCv.wait(lock);
+			}
+
+			// Steal:
+			size_t first = workerIndex < m_Queues.size() ? workerIndex + 1 : 0;
+			for (size_t i = 0; i < m_Queues.size(); i++) {
+				size_t victim = (first + i) % m_Queues.size();
+				if (victim == workerIndex) continue;
+				CQueue& queue = m_Queues[victim];
+				std::unique_lock<std::mutex> lock(queue.Mutex);
+				if (!queue.Deque.empty()) {
+					outWork = queue.Deque.front();
+					queue.Deque.pop_front();
+					m_Pending--;
+					return true;
 				}
 			}
+
+			return false;
+		}
+
+		/// <summary>Removes the helpers for job from queue that no worker has taken yet.</summary>
+		/// <returns>The number of removed helpers.</returns>
+		size_t Revoke(CQueue& queue, CJob* job) {
+			size_t revoked = 0;
+			{
+				std::unique_lock<std::mutex> lock(queue.Mutex);
+				for (auto it = queue.Deque.begin(); it != queue.Deque.end(); ) {
+					if (job == it->Job) {
+						it = queue.Deque.erase(it);
+						revoked++;
+					}
+					else ++it;
+				}
+			}
+			m_Pending -= revoked;
+			return revoked;
+		}
+
+		static void Run(const Work_s& work) {
+			if (work.Task) {
+				work.Task->Execute();
+				delete work.Task;
+			}
+			else {
+				work.Job->Run();
+				work.Job->WaitGroup.Done();
+			}
+		}
+
+		void ThreadFunc(size_t index) {
+			CurrentWorker_s& currentWorker = GetCurrentWorker();
+			currentWorker.Pool = this;
+			currentWorker.Index = index;
+
+			Work_s work;
+			while (true) {
+				if (Take(index, work)) {
+					Run(work);
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(m_SleepMutex);
+				m_Sleeping++;
+				while (!m_Shutdown && 0 == m_Pending) m_SleepCv.wait(lock);
+				m_Sleeping--;
+				if (m_Shutdown && 0 == m_Pending) break;
+			}
 		}
 
 		void Shutdown() {
 			if (m_Shutdown) return;
 
 			{
-				std::unique_lock<std::mutex> lock(m_QueueMutex);
+				std::unique_lock<std::mutex> lock(m_SleepMutex);
 				m_Shutdown = true;
-				m_QueueCv.notify_all();
+				m_SleepCv.notify_all();
 			}
 			for (size_t i = 0; i < m_Threads.size(); i++) {
 				m_Threads[i].join();
@@ -15,13 +15,30 @@ BvhExport::BvhExport(wchar_t const * fileName, char const * rootName, double fra
 	_wfopen_s(&m_pMotionFile, fileName, L"wb");
 
 	if (m_pMotionFile != NULL)
+	{
 		BeginContent(m_pMotionFile, rootName, frameTime, m_lMotionTPos);
+
+		FILE * pFile = m_pMotionFile;
+		m_Writer.reset(new advancedfx::CAsyncFrameWriter(
+			[](advancedfx::CAsyncFrameWriter::Record const & record, std::string & outBuffer) {
+				char pszT[1024];
+				int len = _snprintf_s(pszT, _TRUNCATE, "%f %f %f %f %f %f\n", record.Values[0], record.Values[1], record.Values[2], record.Values[3], record.Values[4], record.Values[5]);
+				if (0 < len) outBuffer.append(pszT, len);
+			},
+			[pFile](char const * data, size_t size) {
+				fwrite(data, 1, size, pFile);
+			}
+		));
+	}
 }
 
 BvhExport::~BvhExport()
 {
 	char pTmp[100];
 
+	// Writes all pending frames.
+	m_Writer.reset();
+
 	if (m_pMotionFile) {
 		fseek(m_pMotionFile, m_lMotionTPos, SEEK_SET);
 		_snprintf_s(pTmp, _TRUNCATE, "Frames: %11i", m_FrameCount);
@@ -50,11 +67,7 @@ void BvhExport::BeginContent(FILE *pFile, char const * pRootName, double frameTi
 }
 
 void BvhExport::WriteFrame(double Xposition, double Yposition, double Zposition, double Zrotation, double Xrotation, double Yrotation) {
-	char pszT[1024];
-
-	_snprintf_s(pszT, _TRUNCATE, "%f %f %f %f %f %f\n", Xposition, Yposition, Zposition, Zrotation, Xrotation, Yrotation);
-
-	if (m_pMotionFile) fputs(pszT, m_pMotionFile);
+	if (m_Writer) m_Writer->Push({ Xposition, Yposition, Zposition, Zrotation, Xrotation, Yrotation });
 
 	m_FrameCount++;
 }
@@ -1,8 +1,12 @@
 #pragma once
 
+#include "AsyncFrameWriter.h"
+
 #include <stdio.h>
 #include <windows.h>
 
+#include <memory>
+
 
 // BvhExport ///////////////////////////////////////////////////////////////////
 
@@ -15,6 +19,7 @@ public:
 	/// </summary> Closes the BVH file </summary>
 	~BvhExport();
 
+	/// <remarks>Formatting and writing happens on a background thread.</remarks>
 	void WriteFrame(
 		double Xposition, double Yposition, double Zposition,
 		double Zrotation, double Xrotation, double Yrotation
@@ -24,6 +29,7 @@ private:
 	unsigned int m_FrameCount;
 	FILE * m_pMotionFile;
 	long m_lMotionTPos;
+	std::unique_ptr<advancedfx::CAsyncFrameWriter> m_Writer;
 
 	void BeginContent(FILE *pFile ,char const * pRootName, double frameTime, long &ulTPos);
 
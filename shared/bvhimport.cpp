@@ -2,9 +2,15 @@
 
 #include "bvhimport.h"
 
+#include "ThreadPool.h"
+
 #include <stdio.h>
 #include <windows.h>
 
+#include <charconv>
+#include <math.h>
+#include <string.h>
+
 
 /// <remarks> If pz is 0, the function returns </remarks>
 char * CrLfZ2LfZ(char * opz) {
@@ -35,21 +41,40 @@ inline int myround(double x)
 	return x < 0 ? (int)(x -0.5) : (int)(x +0.5);
 }
 
+/// <summary>Parses a frame line, missing or invalid channels are 0 (same as reading them with atof).</summary>
+static void BvhImport_ParseFrame(char const * first, char const * last, int const channelcode[6], double * outFrame)
+{
+	for(int ichan = 0; ichan < 6; ichan++)
+	{
+		while(first < last && (' ' == *first || '\t' == *first)) first++;
+
+		char const * tokenFirst = first;
+		while(first < last && ' ' != *first && '\t' != *first) first++;
+
+		if(tokenFirst < first && '+' == *tokenFirst) tokenFirst++;
+
+		double fff = 0;
+		if(std::errc() != std::from_chars(tokenFirst, first, fff).ec)
+			fff = 0;
+
+		outFrame[channelcode[ichan]] = fff;
+	}
+}
 
 // BvhImport //////////////////////////////////////////////////////////////////
 
 BvhImport::BvhImport()
 {
 	m_Active = false;
+	m_Frames = 0;
 }
 
 void BvhImport::CloseMotionFile()
 {
-	if(m_Active)
-	{
-		m_Active = false;
-		fclose(m_File);
-	}
+	m_Active = false;
+	m_Frames = 0;
+	m_Motion.clear();
+	m_Motion.shrink_to_fit();
 }
 
 int BvhImport::DecodeBvhChannel(char * pszRemainder, char * & aoutNewRemainder)
@@ -85,73 +110,30 @@ bool BvhImport::CopyToCampath(double timeOfs, double fov, CamPath & camPath)
 	if(!m_Active)
 		return true;
 
-	// we start at the first frame
-	if(fseek(m_File,m_MotionFPos,SEEK_SET))
-	{
-		// read error
-		CloseMotionFile();
-		return false;
-	}
+	std::vector<std::pair<double, CamPathValue>> keys;
+	keys.reserve(m_Frames);
 
-	for(m_LastFrame = 0; m_LastFrame < m_Frames; ++m_LastFrame)
+	for(int iFrame = 0; iFrame < m_Frames; ++iFrame)
 	{
-		char * pc;
-
-		// read current frame:
-		pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-		if(!pc)
-		{
-			// read error
-			CloseMotionFile();
-			return false;
-		}
+		double const * frame = &m_Motion[6 * (size_t)iFrame];
 
-		// decode frame:
-		int ichan;
-		char tc = 0;
-		char * pc2;
-		double fff;
+		double Ty = (-frame[0]);
+		double Tz = (+frame[1]);
+		double Tx = (-frame[2]);
+		double Rz = (-frame[3]);
+		double Rx = (-frame[4]);
+		double Ry = (+frame[5]);
 
-		pc = ms_readbuff;
-		for(ichan = 0; ichan < 6; ichan++)
-		{
-			pc2 = strchr(pc,' ');
-			if(!pc2)
-				pc2 = strchr(pc,'\t');
-			if(!pc2)
-				pc2 = pc + strlen(pc);
-
-			tc = *pc2;
-			*pc2 = 0;
-
-			fff = 0;
-			fff = atof(pc);
-
-			m_Cache[channelcode[ichan]] = fff;
-
-			*pc2 = tc;
-			pc = pc2;
-
-			while(0 != *pc && (' ' == *pc || '\t' == *pc)) pc++;
-		}
-
-		double Ty = (-m_Cache[0]);
-		double Tz = (+m_Cache[1]);
-		double Tx = (-m_Cache[2]);
-		double Rz = (-m_Cache[3]);
-		double Rx = (-m_Cache[4]);
-		double Ry = (+m_Cache[5]);
-
-		camPath.Add(timeOfs +m_LastFrame * m_FrameTime, CamPathValue(Tx, Ty, Tz, Rx, Ry, Rz, fov));
+		keys.emplace_back(timeOfs +iFrame * m_FrameTime, CamPathValue(Tx, Ty, Tz, Rx, Ry, Rz, fov));
 	}
 
+	camPath.Add(keys);
+
 	return true;
 }
 
 bool BvhImport::GetCamPosition(double fTimeOfs, double outCamdata[6])
 {
-	char * pc;
-
 	if(!m_Active || !outCamdata)
 		return false; // not active
 
@@ -160,126 +142,38 @@ bool BvhImport::GetCamPosition(double fTimeOfs, double outCamdata[6])
 	if(iCurFrame < 0 || iCurFrame >= m_Frames)
 		return false; // out of range
 
-	if(	iCurFrame == m_LastFrame)
+	// interpolate between the frames around the time (clamped to the first / last frame):
+	double fFrame = fTimeOfs / m_FrameTime;
+	int iFrame = (int)floor(fFrame);
+	double t = fFrame - iFrame;
+	if(iFrame < 0)
 	{
-		// pEngfuncs->Con_DPrintf("Using cached cam motion frame: %i (%f)\n",iCurFrame,fTimeOfs);
-		memcpy(outCamdata,m_Cache,sizeof(m_Cache));
-		return true;
+		iFrame = 0;
+		t = 0;
 	}
-
-	if(0 == iCurFrame)
+	else if(iFrame >= m_Frames -1)
 	{
-		// we start at the first frame
-		if(fseek(m_File,m_MotionFPos,SEEK_SET))
-		{
-			// read error
-			CloseMotionFile();
-			return false;
-		}
-	} else {
-		// seek to frame position:
-		pc = 0;
-		
-		int iSeekFrames;
-		if(0 <= m_LastFrame)
-			iSeekFrames = iCurFrame - m_LastFrame -1;
-		else
-			iSeekFrames = iCurFrame;
-		
-		while(iSeekFrames)
-		{
-			if(0<iSeekFrames)
-			{
-				// seek forward
-				pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-				if(!pc)
-				{
-					// read error
-					CloseMotionFile();
-					return false;
-				}
-				iSeekFrames--;
-			}
-			else
-			{
-				// seek backward
-				char ac=0;
-				bool bReadErr = false;
-				int iReadBreaks = 2;
-
-				while(!bReadErr && 0<iReadBreaks)
-				{
-					if(!bReadErr)
-						bReadErr = 0 != fseek(m_File,-1,SEEK_CUR);
-
-					if(!bReadErr)
-						bReadErr = 1 != fread(&ac,sizeof(char),1,m_File);
-
-					bReadErr = bReadErr || ftell(m_File)<m_MotionFPos;
-
-					if('\n' == ac)
-						iReadBreaks--;
-
-					if(!bReadErr)
-						bReadErr = 0 != fseek(m_File,-1,SEEK_CUR);
-				}
-
-				bReadErr = bReadErr || 0 != fseek(m_File,+1,SEEK_CUR);
-
-				if(bReadErr)
-				{
-					// read error
-					CloseMotionFile();
-					return false;
-				}
-
-				iSeekFrames++;
-			}
-		}
+		iFrame = m_Frames -1;
+		t = 0;
 	}
 
-	// read current frame:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-	if(!pc)
+	double const * frame0 = &m_Motion[6 * (size_t)iFrame];
+	double const * frame1 = 0 < t ? frame0 + 6 : frame0;
+
+	for(int i = BC_Xposition; i <= BC_Zposition; i++)
 	{
-		// read error
-		CloseMotionFile();
-		return false;
+		outCamdata[i] = frame0[i] + t * (frame1[i] - frame0[i]);
 	}
 
-	m_LastFrame = iCurFrame;
-
-	// decode frame:
-	int ichan;
-	char tc = 0;
-	char * pc2;
-	double fff;
-
-	pc = ms_readbuff;
-	for(ichan = 0; ichan < 6; ichan++)
+	for(int i = BC_Zrotation; i <= BC_Yrotation; i++)
 	{
-		pc2 = strchr(pc,' ');
-		if(!pc2)
-			pc2 = strchr(pc,'\t');
-		if(!pc2)
-			pc2 = pc + strlen(pc);
-
-		tc = *pc2;
-		*pc2 = 0;
-
-		fff = 0;
-		fff = atof(pc);
-
-		m_Cache[channelcode[ichan]] = fff;
+		// take the shorter way around, relative to the nearer frame so we don't wrap at the frames:
+		double delta = frame1[i] - frame0[i];
+		delta -= 360.0 * floor((delta + 180.0) / 360.0);
 
-		*pc2 = tc;
-		pc = pc2;
-
-		while(0 != *pc && (' ' == *pc || '\t' == *pc)) pc++;
+		outCamdata[i] = t <= 0.5 ? frame0[i] + t * delta : frame1[i] - (1 - t) * delta;
 	}
 
-	// pEngfuncs->Con_DPrintf("Imported cam motion frame: %i (%f)\n",iCurFrame,fTimeOfs);
-	memcpy(outCamdata,m_Cache,sizeof(m_Cache));
 	return true;
 }
 
@@ -289,24 +183,25 @@ bool BvhImport::IsActive()
 	return m_Active;
 }
 
-bool BvhImport::LoadMotionFile(wchar_t const * fileName)
+bool BvhImport::LoadMotionFile(wchar_t const * fileName, advancedfx::CThreadPool * threadPool)
 {
+	char readbuff[1024];
 	char * pc;
 	char * pc2;
+	FILE * pFile;
 
-	if(m_Active)
-		CloseMotionFile();
+	CloseMotionFile();
 
-	_wfopen_s(&m_File, fileName, L"rb");
+	_wfopen_s(&pFile, fileName, L"rb");
 
-	if(!m_File)
+	if(!pFile)
 		return false;
 
 	// check if this could be a valid BVH file:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-	if(!pc || strcmp(ms_readbuff,"HIERARCHY\n"))
+	pc = CrLfZ2LfZ(fgets(readbuff,sizeof(readbuff)/sizeof(char),pFile));
+	if(!pc || strcmp(readbuff,"HIERARCHY\n"))
 	{
-		fclose(m_File);
+		fclose(pFile);
 		return false;
 	}
 
@@ -314,14 +209,14 @@ bool BvhImport::LoadMotionFile(wchar_t const * fileName)
 	pc2 = 0;
 	while(!pc2)
 	{
-		pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
+		pc = CrLfZ2LfZ(fgets(readbuff,sizeof(readbuff)/sizeof(char),pFile));
 		if(!pc)
 		{
-			fclose(m_File);
+			fclose(pFile);
 			return false;
 		}
 
-		pc2 = strstr(ms_readbuff,"CHANNELS 6 ");
+		pc2 = strstr(readbuff,"CHANNELS 6 ");
 	}
 
 	// determine channel assignment:
@@ -341,7 +236,7 @@ bool BvhImport::LoadMotionFile(wchar_t const * fileName)
 	{
 		if(channelcode[i]<0)
 		{
-			fclose(m_File);
+			fclose(pFile);
 			return false;
 		}
 	}
@@ -350,50 +245,101 @@ bool BvhImport::LoadMotionFile(wchar_t const * fileName)
 	pc2 = 0;
 	while(!pc2)
 	{
-		pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
+		pc = CrLfZ2LfZ(fgets(readbuff,sizeof(readbuff)/sizeof(char),pFile));
 		if(!pc)
 		{
-			fclose(m_File);
+			fclose(pFile);
 			return false;
 		}
 
-		pc2 = strstr(ms_readbuff,"MOTION\n");
+		pc2 = strstr(readbuff,"MOTION\n");
 	}
 
 	// read frames:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-	if(!pc || strcmp(ms_readbuff,"Frames:") <= 0)
+	pc = CrLfZ2LfZ(fgets(readbuff,sizeof(readbuff)/sizeof(char),pFile));
+	if(!pc || strcmp(readbuff,"Frames:") <= 0)
 	{
-		fclose(m_File);
+		fclose(pFile);
 		return false;
 	}
 	pc += strlen("Frames:");
-	m_Frames = atoi(pc);
+	int frames = atoi(pc);
 
 	// read frame time:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-	if(!pc || strcmp(ms_readbuff,"Frame Time:") <= 0)
+	pc = CrLfZ2LfZ(fgets(readbuff,sizeof(readbuff)/sizeof(char),pFile));
+	if(!pc || strcmp(readbuff,"Frame Time:") <= 0)
 	{
-		fclose(m_File);
+		fclose(pFile);
 		return false;
 	}
 	pc += strlen("Frame Time:");
 	m_FrameTime = atof(pc);
 	if(m_FrameTime <= 0)
 	{
-		fclose(m_File);
+		fclose(pFile);
+		return false;
+	}
+
+	bool bOk = ReadMotion(pFile, frames, threadPool);
+
+	fclose(pFile);
+
+	if(!bOk)
+	{
+		CloseMotionFile();
 		return false;
 	}
 
-	m_MotionFPos = ftell(m_File);
-	m_LastFrame = -1;
 	m_Active = true;
 
 	return true;
 }
 
+bool BvhImport::ReadMotion(FILE * pFile, int frames, advancedfx::CThreadPool * threadPool)
+{
+	// 64 bit offsets, long is 32 bit on Windows:
+	__int64 motionFPos = _ftelli64(pFile);
+	if(motionFPos < 0 || _fseeki64(pFile, 0, SEEK_END))
+		return false;
+
+	__int64 fileSize = _ftelli64(pFile);
+	if(fileSize < motionFPos || (unsigned __int64)(fileSize - motionFPos) > SIZE_MAX || _fseeki64(pFile, motionFPos, SEEK_SET))
+		return false;
+
+	std::vector<char> data((size_t)(fileSize - motionFPos));
+	if(!data.empty() && 1 != fread(data.data(), data.size(), 1, pFile))
+		return false;
+
+	// index the frame lines (a file that was not finished has less than announced):
+	std::vector<size_t> lineStarts;
+	lineStarts.reserve(0 < frames ? (size_t)frames +1 : 1);
+	lineStarts.push_back(0);
+	for(size_t pos = 0; (int)lineStarts.size() -1 < frames && pos < data.size(); )
+	{
+		char const * pLf = (char const *)memchr(data.data() + pos, '\n', data.size() - pos);
+		pos = pLf ? pLf - data.data() + 1 : data.size();
+		lineStarts.push_back(pos);
+	}
+
+	m_Frames = (int)lineStarts.size() -1;
+	m_Motion.resize(6 * (size_t)m_Frames);
+
+	// parse frames, in parallel if it's worth it:
+	auto parseFrames = [this, &data, &lineStarts](size_t firstFrame, size_t numFrames) {
+		for(size_t i = firstFrame; i < firstFrame + numFrames; i++)
+		{
+			BvhImport_ParseFrame(data.data() + lineStarts[i], data.data() + lineStarts[i + 1], channelcode, m_Motion.data() + 6 * i);
+		}
+	};
+
+	if(threadPool && 16384 <= m_Frames)
+		threadPool->ParallelFor((size_t)m_Frames, 4096, parseFrames);
+	else
+		parseFrames(0, (size_t)m_Frames);
+
+	return true;
+}
 
-char BvhImport::ms_readbuff[1024];
 
 BvhImport::~BvhImport()
 {
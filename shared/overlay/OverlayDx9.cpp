@@ -399,10 +399,15 @@ void OverlayDx9::Render() {
                 double x,y,z,rx,ry,rz; float fov;
                 Afx_GetLastCameraData(x,y,z,rx,ry,rz,fov);
                 double t = S1_ClientTime() - g_Hook_VClient_RenderView.m_CamPath.GetOffset();
+                g_Hook_VClient_RenderView.m_CamPath.UndoCheckpoint();
                 g_Hook_VClient_RenderView.m_CamPath.Add(t, CamPathValue(x,y,z, rx, ry, rz, fov));
             }
             ImGui::SameLine();
-            if (ImGui::Button("Clear")) g_Hook_VClient_RenderView.m_CamPath.Clear();
+            if (ImGui::Button("Clear")) { g_Hook_VClient_RenderView.m_CamPath.UndoCheckpoint(); g_Hook_VClient_RenderView.m_CamPath.Clear(); g_Hook_VClient_RenderView.m_CamPath.UndoCheckpointEnd(); }
+            ImGui::SameLine();
+            if (ImGui::Button("Undo")) g_Hook_VClient_RenderView.m_CamPath.Undo();
+            ImGui::SameLine();
+            if (ImGui::Button("Redo")) g_Hook_VClient_RenderView.m_CamPath.Redo();
             ImGui::SameLine();
             if (ImGui::Button("Goto Start")) {
                 if (g_Hook_VClient_RenderView.m_CamPath.GetSize() > 0) {
@@ -896,7 +901,9 @@ void OverlayDx9::Render() {
                                 bool prevDraw = g_CampathDrawer.Draw_get();
                                 if (doRemove) {
                                     g_CampathDrawer.Draw_set(false);
+                                    g_Hook_VClient_RenderView.m_CamPath.UndoCheckpoint();
                                     g_Hook_VClient_RenderView.m_CamPath.Remove(s_ctxMenuPending.time);
+                                    g_Hook_VClient_RenderView.m_CamPath.UndoCheckpointEnd();
                                     g_CampathDrawer.Draw_set(prevDraw);
                                     g_SequencerNeedsRefresh = true;
                                 }
@@ -921,6 +928,7 @@ void OverlayDx9::Render() {
                                     Afx_GetLastCameraData(cx, cy, cz, rX, rY, rZ, cfov);
                                     CamPathValue newVal(cx, cy, cz, rX, rY, rZ, cfov);
                                     g_CampathDrawer.Draw_set(false);
+                                    g_Hook_VClient_RenderView.m_CamPath.UndoCheckpoint();
                                     g_Hook_VClient_RenderView.m_CamPath.Remove(s_ctxMenuPending.time);
                                     g_Hook_VClient_RenderView.m_CamPath.Add(s_ctxMenuPending.time, newVal);
                                     g_CampathDrawer.Draw_set(prevDraw);
@@ -958,6 +966,7 @@ void OverlayDx9::Render() {
                             // Rebuild atomically with draw disabled and selection restored
                             bool prevDraw = g_CampathDrawer.Draw_get(); g_CampathDrawer.Draw_set(false);
                             bool prevEnabled = g_Hook_VClient_RenderView.m_CamPath.Enabled_get(); g_Hook_VClient_RenderView.m_CamPath.Enabled_set(false);
+                            g_Hook_VClient_RenderView.m_CamPath.UndoCheckpoint();
                             g_Hook_VClient_RenderView.m_CamPath.SelectNone();
                             g_Hook_VClient_RenderView.m_CamPath.Clear();
                             for (const auto& k : newKeys) g_Hook_VClient_RenderView.m_CamPath.Add(k.t, k.v);
@@ -1020,6 +1029,7 @@ void OverlayDx9::Render() {
                     double cx,cy,cz, rX,rY,rZ; float cfov; Afx_GetLastCameraData(cx,cy,cz,rX,rY,rZ,cfov);
                     CamPathValue nv(cx,cy,cz,rX,rY,rZ,cfov);
                     bool prevDraw = g_CampathDrawer.Draw_get(); g_CampathDrawer.Draw_set(false);
+                    g_Hook_VClient_RenderView.m_CamPath.UndoCheckpoint();
                     g_Hook_VClient_RenderView.m_CamPath.Add(tEval, nv);
                     g_CampathDrawer.Draw_set(prevDraw);
                     g_SequencerNeedsRefresh = true;
@@ -1264,8 +1274,8 @@ void OverlayDx9::Render() {
                             // Effective OUT slope at left key
                             double mOut;
                             if (isCustom) {
-                                unsigned char modeOut = (ch==0? vLeft.TxModeOut : ch==1? vLeft.TyModeOut : ch==2? vLeft.TzModeOut : ch==3? vLeft.TfovModeOut : (ch==4? vLeft.TRyModeOut : ch==5? vLeft.TRzModeOut : vLeft.TRxModeOut));
-                                if (modeOut == (unsigned char)CamPath::TM_FREE) mOut = (ch==0? vLeft.TxOut : ch==1? vLeft.TyOut : ch==2? vLeft.TzOut : ch==3? vLeft.TfovOut : (ch==4? vLeft.TRyOut : ch==5? vLeft.TRzOut : vLeft.TRxOut));
+                                unsigned char modeOut = vLeft.GetTangent(ch).ModeOut;
+                                if (modeOut == (unsigned char)CamPath::TM_FREE) mOut = vLeft.GetTangent(ch).Out;
                                 else if (modeOut == (unsigned char)CamPath::TM_FLAT) mOut = 0.0;
                                 else if (modeOut == (unsigned char)CamPath::TM_LINEAR) mOut = (y1 - y0) / h;
                                 else /* AUTO */ {
@@ -1282,8 +1292,8 @@ void OverlayDx9::Render() {
                             // Effective IN slope at right key
                             double mIn;
                             if (isCustom) {
-                                unsigned char modeIn = (ch==0? vRight.TxModeIn : ch==1? vRight.TyModeIn : ch==2? vRight.TzModeIn : ch==3? vRight.TfovModeIn : (ch==4? vRight.TRyModeIn : ch==5? vRight.TRzModeIn : vRight.TRxModeIn));
-                                if (modeIn == (unsigned char)CamPath::TM_FREE) mIn = (ch==0? vRight.TxIn : ch==1? vRight.TyIn : ch==2? vRight.TzIn : ch==3? vRight.TfovIn : (ch==4? vRight.TRyIn : ch==5? vRight.TRzIn : vRight.TRxIn));
+                                unsigned char modeIn = vRight.GetTangent(ch).ModeIn;
+                                if (modeIn == (unsigned char)CamPath::TM_FREE) mIn = vRight.GetTangent(ch).In;
                                 else if (modeIn == (unsigned char)CamPath::TM_FLAT) mIn = 0.0;
                                 else if (modeIn == (unsigned char)CamPath::TM_LINEAR) mIn = (y1 - y0) / h;
                                 else /* AUTO */ {
@@ -1300,10 +1310,10 @@ void OverlayDx9::Render() {
                             // Per-side weights
                             double wOut = 1.0, wIn = 1.0;
                             {
-                                unsigned char modeOut = (ch==0? vLeft.TxModeOut : ch==1? vLeft.TyModeOut : ch==2? vLeft.TzModeOut : ch==3? vLeft.TfovModeOut : (ch==4? vLeft.TRyModeOut : ch==5? vLeft.TRzModeOut : vLeft.TRxModeOut));
-                                unsigned char modeIn  = (ch==0? vRight.TxModeIn  : ch==1? vRight.TyModeIn  : ch==2? vRight.TzModeIn  : ch==3? vRight.TfovModeIn  : (ch==4? vRight.TRyModeIn : ch==5? vRight.TRzModeIn : vRight.TRxModeIn));
-                                if (modeOut == CamPath::TM_FREE) wOut = (ch==0? vLeft.TxWOut : ch==1? vLeft.TyWOut : ch==2? vLeft.TzWOut : ch==3? vLeft.TfovWOut : (ch==4? vLeft.TRyWOut : ch==5? vLeft.TRzWOut : vLeft.TRxWOut));
-                                if (modeIn  == CamPath::TM_FREE) wIn  = (ch==0? vRight.TxWIn  : ch==1? vRight.TyWIn  : ch==2? vRight.TzWIn  : ch==3? vRight.TfovWIn  : (ch==4? vRight.TRyWIn  : ch==5? vRight.TRzWIn  : vRight.TRxWIn ));
+                                unsigned char modeOut = vLeft.GetTangent(ch).ModeOut;
+                                unsigned char modeIn  = vRight.GetTangent(ch).ModeIn;
+                                if (modeOut == CamPath::TM_FREE) wOut = vLeft.GetTangent(ch).WOut;
+                                if (modeIn  == CamPath::TM_FREE) wIn  = vRight.GetTangent(ch).WIn;
                                 if (wOut < 0.0) wOut = 0.0; if (wIn < 0.0) wIn = 0.0;
                             }
 
@@ -1347,6 +1357,8 @@ void OverlayDx9::Render() {
                                 ImGui::SetCursorScreenPos(ImVec2(P1.x-6,P1.y-6));
                                 char id1[48]; snprintf(id1, sizeof(id1), "##h1b_%zu_ch%d", i, ch);
                                 ImGui::InvisibleButton(id1, ImVec2(12,12));
+                                if (ImGui::IsItemActivated()) g_Hook_VClient_RenderView.m_CamPath.UndoCheckpoint();
+                                if (ImGui::IsItemDeactivated()) g_Hook_VClient_RenderView.m_CamPath.UndoCheckpointEnd();
                                 if (ImGui::IsItemActive() && ImGui::IsMouseDragging(0)) {
                                     ImVec2 mp = ImGui::GetIO().MousePos;
                                     float newY = (std::max)(p0.y+g_CurvePadding, (std::min)(mp.y, p1.y-g_CurvePadding));
@@ -1407,6 +1419,8 @@ void OverlayDx9::Render() {
                                 ImGui::SetCursorScreenPos(ImVec2(P2.x-6,P2.y-6));
                                 char id2[48]; snprintf(id2, sizeof(id2), "##h2b_%zu_ch%d", i, ch);
                                 ImGui::InvisibleButton(id2, ImVec2(12,12));
+                                if (ImGui::IsItemActivated()) g_Hook_VClient_RenderView.m_CamPath.UndoCheckpoint();
+                                if (ImGui::IsItemDeactivated()) g_Hook_VClient_RenderView.m_CamPath.UndoCheckpointEnd();
                                 if (ImGui::IsItemActive() && ImGui::IsMouseDragging(0)) {
                                     ImVec2 mp = ImGui::GetIO().MousePos;
                                     float newY = (std::max)(p0.y+g_CurvePadding, (std::min)(mp.y, p1.y-g_CurvePadding));
@@ -1471,9 +1485,11 @@ void OverlayDx9::Render() {
                                 extern CCampathDrawer g_CampathDrawer;
                                 bool prevDraw = g_CampathDrawer.Draw_get();
                                 g_CampathDrawer.Draw_set(false);
+                                g_Hook_VClient_RenderView.m_CamPath.UndoCheckpoint();
                                 g_Hook_VClient_RenderView.m_CamPath.SelectNone();
                                 g_Hook_VClient_RenderView.m_CamPath.SelectAdd((size_t)g_CurveCtxKeyIndex, (size_t)g_CurveCtxKeyIndex);
                                 g_Hook_VClient_RenderView.m_CamPath.SetTangentMode(mapChToEnum(g_CurveCtxChannel), setIn, setOut, mode);
+                                g_Hook_VClient_RenderView.m_CamPath.UndoCheckpointEnd();
                                 g_CampathDrawer.Draw_set(prevDraw);
                                 g_SequencerNeedsRefresh = true;
                             };
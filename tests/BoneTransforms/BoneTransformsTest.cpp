@@ -0,0 +1,143 @@
+// BoneTransformsTest.cpp : Checks shared/BoneTransforms SIMD paths against the scalar reference.
+//
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <math.h>
+#include <string.h>
+#include <shared/BoneTransforms.h>
+
+using namespace std;
+using namespace advancedfx;
+
+static void RandomBone(mt19937 & random, float scale, float out[3][4])
+{
+	uniform_real_distribution<double> unit(-1, 1);
+
+	double x = unit(random), y = unit(random), z = unit(random), w = unit(random);
+	double len = sqrt(x * x + y * y + z * z + w * w);
+	x /= len; y /= len; z /= len; w /= len;
+
+	out[0][0] = (float)(scale * (1 - 2 * (y * y + z * z))); out[0][1] = (float)(scale * 2 * (x * y - z * w)); out[0][2] = (float)(scale * 2 * (x * z + y * w));
+	out[1][0] = (float)(scale * 2 * (x * y + z * w)); out[1][1] = (float)(scale * (1 - 2 * (x * x + z * z))); out[1][2] = (float)(scale * 2 * (y * z - x * w));
+	out[2][0] = (float)(scale * 2 * (x * z - y * w)); out[2][1] = (float)(scale * 2 * (y * z + x * w)); out[2][2] = (float)(scale * (1 - 2 * (x * x + y * y)));
+	out[0][3] = (float)(4096 * unit(random));
+	out[1][3] = (float)(4096 * unit(random));
+	out[2][3] = (float)(4096 * unit(random));
+}
+
+int main()
+{
+	const double epsilonRotation = 1e-4;
+	const double epsilonPosition = 1e-2;
+	const double epsilonQuaternion = 1e-5;
+
+	mt19937 random(1);
+	bool ok = true;
+
+	double maxRotation = 0, maxPosition = 0, maxQuaternion = 0;
+
+	// Different bone counts, to cover the remainders of the 4 wide paths:
+	for (int numBones = 1; numBones <= 128; ++numBones) {
+		for (int run = 0; run < 16; ++run) {
+			vector<float> bones(12 * numBones), outSimd(12 * numBones), outScalar(12 * numBones);
+			vector<int> parents(numBones);
+			float root[3][4];
+
+			RandomBone(random, 1, root);
+			for (int i = 0; i < numBones; ++i) {
+				RandomBone(random, 0 == run % 4 ? 1.0f : 0.5f + (float)(random() % 1000) / 1000, (float(*)[4])&bones[12 * i]);
+				parents[i] = 0 == i ? -1 : (int)(random() % (i + 1)) - 1;
+			}
+
+			float const (*pBones)[3][4] = (float const (*)[3][4])bones.data();
+
+			int failedSimd, failedScalar;
+			bool okSimd = BoneTransforms::ToParentSpace(numBones, parents.data(), root, pBones, (float (*)[3][4])outSimd.data(), &failedSimd);
+			bool okScalar = BoneTransforms::ToParentSpace_Scalar(numBones, parents.data(), root, pBones, (float (*)[3][4])outScalar.data(), &failedScalar);
+
+			if (!okSimd || !okScalar) {
+				cout << "ToParentSpace failed unexpectedly (bones " << numBones << ")." << endl;
+				ok = false;
+			}
+
+			for (int i = 0; i < 12 * numBones; ++i) {
+				double error = fabs(outSimd[i] - outScalar[i]);
+				if (3 == i % 4) { if (maxPosition < error) maxPosition = error; }
+				else if (maxRotation < error) maxRotation = error;
+			}
+
+			vector<float> quatSimd(4 * numBones), quatScalar(4 * numBones);
+			BoneTransforms::ToQuaternions(numBones, (float const (*)[3][4])outScalar.data(), (float (*)[4])quatSimd.data());
+			BoneTransforms::ToQuaternions_Scalar(numBones, (float const (*)[3][4])outScalar.data(), (float (*)[4])quatScalar.data());
+
+			for (int i = 0; i < 4 * numBones; ++i) {
+				double error = fabs(quatSimd[i] - quatScalar[i]);
+				if (maxQuaternion < error) maxQuaternion = error;
+			}
+		}
+	}
+
+	cout << "max error: rotation " << maxRotation << " position " << maxPosition << " quaternion " << maxQuaternion << endl;
+
+	if (epsilonRotation < maxRotation || epsilonPosition < maxPosition || epsilonQuaternion < maxQuaternion) {
+		cout << "FAILED: error above epsilon." << endl;
+		ok = false;
+	}
+
+	// Singular parent:
+	{
+		float root[3][4] = { { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 } };
+		float bones[5][3][4];
+		float out[5][3][4];
+		int parents[5] = { -1, 0, 0, 1, 2 };
+		for (int i = 0; i < 5; ++i) RandomBone(random, 1, bones[i]);
+
+		int failed;
+		if (BoneTransforms::ToParentSpace(5, parents, root, bones, out, &failed) || 0 != failed || 0 != memcmp(out[0], bones[0], sizeof(out[0]))) {
+			cout << "FAILED: singular parent not reported." << endl;
+			ok = false;
+		}
+	}
+
+	// Timing (32 models with 64 bones):
+	{
+		const int numBones = 64;
+		const int models = 32;
+		const int frames = 1000;
+
+		vector<float> bones(12 * numBones * models), out(12 * numBones * models), quats(4 * numBones * models);
+		vector<int> parents(numBones);
+		float root[3][4];
+
+		RandomBone(random, 1, root);
+		for (int i = 0; i < numBones * models; ++i) RandomBone(random, 1, (float(*)[4])&bones[12 * i]);
+		for (int i = 0; i < numBones; ++i) parents[i] = i - 1;
+
+		for (int pass = 0; pass < 2; ++pass) {
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			for (int frame = 0; frame < frames; ++frame) {
+				for (int model = 0; model < models; ++model) {
+					float const (*pBones)[3][4] = (float const (*)[3][4])&bones[12 * numBones * model];
+					float (*pOut)[3][4] = (float (*)[3][4])&out[12 * numBones * model];
+					float (*pQuats)[4] = (float (*)[4])&quats[4 * numBones * model];
+					if (0 == pass) {
+						BoneTransforms::ToParentSpace_Scalar(numBones, parents.data(), root, pBones, pOut);
+						BoneTransforms::ToQuaternions_Scalar(numBones, pOut, pQuats);
+					} else {
+						BoneTransforms::ToParentSpace(numBones, parents.data(), root, pBones, pOut);
+						BoneTransforms::ToQuaternions(numBones, pOut, pQuats);
+					}
+				}
+			}
+			double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / frames;
+			cout << (0 == pass ? "scalar: " : "simd: ") << us << " us per frame (" << models << " models x " << numBones << " bones)" << endl;
+		}
+	}
+
+	cout << (ok ? "OK" : "FAILED") << endl;
+
+	return ok ? 0 : 1;
+}
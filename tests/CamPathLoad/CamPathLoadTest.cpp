@@ -0,0 +1,100 @@
+// CamPathLoadTest.cpp : Checks that a large campath loads the same from XML and binary and benchmarks both loaders.
+//
+
+#include <iostream>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <shared/CamPath.h>
+
+using namespace std;
+
+static void MakePath(CamPath & path, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		double t = i / 128.0;
+		CamPathValue value(300 * sin(t * 0.3), 200 * cos(t * 0.17), 50 * sin(t * 0.05), 20 * sin(t * 0.2), t * 5, 0, 90 + 5 * sin(t * 0.1));
+		value.Selected = 0 == i % 7;
+		path.Add(t, value);
+	}
+	path.SetOffset(1.5);
+	path.SetHold(true);
+}
+
+static bool Same(CamPath & a, CamPath & b)
+{
+	if (a.GetSize() != b.GetSize() || a.GetOffset() != b.GetOffset() || a.GetHold() != b.GetHold()) return false;
+
+	for (CamPathIterator itA = a.GetBegin(), itB = b.GetBegin(); itA != a.GetEnd(); ++itA, ++itB) {
+		CamPathValue valueA = itA.GetValue();
+		CamPathValue valueB = itB.GetValue();
+
+		// XML stores about 6 significant digits:
+		double epsilon = 1e-4 * (1 + fabs(itA.GetTime()));
+		if (epsilon < fabs(itA.GetTime() - itB.GetTime())
+			|| epsilon < fabs(valueA.X - valueB.X) || epsilon < fabs(valueA.Y - valueB.Y) || epsilon < fabs(valueA.Z - valueB.Z)
+			|| 1e-4 < fabs(valueA.R.W - valueB.R.W) || 1e-4 < fabs(valueA.Fov - valueB.Fov)
+			|| valueA.Selected != valueB.Selected)
+			return false;
+	}
+
+	return true;
+}
+
+template<class TFn> static double TimeMs(const TFn& fn, int repeat) {
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int i = 0; i < repeat; i++) fn();
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / repeat;
+}
+
+int main(int argc, char* argv[])
+{
+	bool benchmark = 2 <= argc && 0 == strcmp(argv[1], "-benchmark");
+	const size_t count = benchmark ? 20000 : 2000;
+	const wchar_t * xmlFileName = L"CamPathLoadTest.xml";
+	const wchar_t * binaryFileName = L"CamPathLoadTest.campath";
+
+	bool ok = true;
+
+	CamPath original;
+	MakePath(original, count);
+
+	if (!original.Save(xmlFileName) || !original.SaveBinary(binaryFileName)) {
+		cout << "FAILED: could not save" << endl;
+		return 1;
+	}
+
+	CamPath fromXml;
+	CamPath fromBinary;
+	if (!fromXml.Load(xmlFileName) || !Same(original, fromXml)) {
+		cout << "FAILED: XML load" << endl;
+		ok = false;
+	}
+	if (!fromBinary.Load(binaryFileName) || !Same(original, fromBinary)) {
+		cout << "FAILED: binary load" << endl;
+		ok = false;
+	}
+
+	CamPath missing;
+	if (missing.Load(L"CamPathLoadTest.doesnotexist")) {
+		cout << "FAILED: loading a missing file succeeded" << endl;
+		ok = false;
+	}
+
+	if (benchmark) {
+		double xmlMs = TimeMs([&]() { CamPath path; path.Load(xmlFileName); }, 10);
+		double binaryMs = TimeMs([&]() { CamPath path; path.Load(binaryFileName); }, 10);
+		cout << "Load " << count << " keys: XML " << xmlMs << " ms, binary " << binaryMs << " ms" << endl;
+	}
+	else {
+		cout << "(run with -benchmark for throughput)" << endl;
+	}
+
+	_wremove(xmlFileName);
+	_wremove(binaryFileName);
+
+	cout << (ok ? "OK" : "FAILED") << endl;
+
+	return ok ? 0 : 1;
+}
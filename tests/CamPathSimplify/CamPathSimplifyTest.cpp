@@ -0,0 +1,97 @@
+// CamPathSimplifyTest.cpp : Checks that CamPath::Simplify stays within its tolerances and terminates for zero / tiny tolerances.
+//
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <stdlib.h>
+#include <shared/CamPath.h>
+
+using namespace std;
+
+static void MakePath(CamPath & path, CamPath::DoubleInterp doubleInterp, CamPath::QuaternionInterp quaternionInterp)
+{
+	path.PositionInterpMethod_set(doubleInterp);
+	path.RotationInterpMethod_set(quaternionInterp);
+	path.FovInterpMethod_set(doubleInterp);
+
+	for (int i = 0; i < 2000; i++) {
+		double t = i / 128.0;
+		path.Add(t, CamPathValue(300 * sin(t * 0.3), 200 * cos(t * 0.17), 50 * sin(t * 0.05), 20 * sin(t * 0.2), t * 5, 0, 90 + 5 * sin(t * 0.1)));
+	}
+}
+
+static bool TestSimplify(CamPath::DoubleInterp doubleInterp, CamPath::QuaternionInterp quaternionInterp, double posTolerance, double angTolerance, double fovTolerance)
+{
+	CamPath original;
+	CamPath path;
+	MakePath(original, doubleInterp, quaternionInterp);
+	MakePath(path, doubleInterp, quaternionInterp);
+
+	// Simplify used to spin forever on zero tolerances, don't hang the test run:
+	atomic_bool done(false);
+	thread watchdog([&done, posTolerance, angTolerance, fovTolerance]() {
+		for (int i = 0; i < 600 && !done; i++) this_thread::sleep_for(chrono::milliseconds(100));
+		if (!done) {
+			cout << "FAILED: Simplify(" << posTolerance << ", " << angTolerance << ", " << fovTolerance << ") does not return" << endl;
+			_Exit(1);
+		}
+	});
+	size_t removed = path.Simplify(posTolerance, angTolerance, fovTolerance);
+	done = true;
+	watchdog.join();
+
+	// Allow a bit for samples between the ones Simplify checks:
+	double maxPos = 0, maxAng = 0, maxFov = 0;
+	for (double t = 0; t < original.GetUpperBound(); t += 0.0011) {
+		CamPathValue a = original.Eval(t);
+		CamPathValue b = path.Eval(t);
+		maxPos = max(maxPos, sqrt((a.X - b.X) * (a.X - b.X) + (a.Y - b.Y) * (a.Y - b.Y) + (a.Z - b.Z) * (a.Z - b.Z)));
+		maxAng = max(maxAng, 2.0 * acos(min(1.0, fabs(DotProduct(a.R.Normalized(), b.R.Normalized())))) * 180.0 / M_PI);
+		maxFov = max(maxFov, fabs(a.Fov - b.Fov));
+	}
+
+	cout << "Simplify(" << posTolerance << ", " << angTolerance << ", " << fovTolerance << ") interp " << doubleInterp << "/" << quaternionInterp
+		<< ": removed " << removed << " of " << original.GetSize() << ", max deviation pos " << maxPos << " ang " << maxAng << " fov " << maxFov << endl;
+
+	if (original.GetSize() != path.GetSize() + removed) {
+		cout << "FAILED: removed count" << endl;
+		return false;
+	}
+
+	if (1.5 * posTolerance + 1e-3 < maxPos || 1.5 * angTolerance + 1e-3 < maxAng || 1.5 * fovTolerance + 1e-3 < maxFov) {
+		cout << "FAILED: out of tolerance" << endl;
+		return false;
+	}
+
+	if (0.1 <= posTolerance && 0.1 <= angTolerance && 0.1 <= fovTolerance && 0 == removed) {
+		cout << "FAILED: nothing removed" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main()
+{
+	bool ok = true;
+
+	const double tolerances[][3] = {
+		{ 0, 0, 0 },
+		{ 0.5, 0, 0.5 },
+		{ 0.5, 1e-9, 0.5 },
+		{ 0.5, 0.5, 0.5 },
+	};
+
+	for (auto const & tolerance : tolerances) {
+		ok = TestSimplify(CamPath::DI_DEFAULT, CamPath::QI_DEFAULT, tolerance[0], tolerance[1], tolerance[2]) && ok;
+		ok = TestSimplify(CamPath::DI_LINEAR, CamPath::QI_SLINEAR, tolerance[0], tolerance[1], tolerance[2]) && ok;
+	}
+
+	cout << (ok ? "OK" : "FAILED") << endl;
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,385 @@
+// EasySamplerTest.cpp : Checks the single pass EasyByteSampler / EasyFloatSampler, with and without thread pool, against the per sub-integral reference (Integrator_Fn).
+//
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <shared/RefCounted.h>
+#include <shared/GrowingBufferPool.h>
+#include <shared/EasySampler.h>
+#include <shared/ThreadPool.h>
+
+using namespace std;
+using namespace advancedfx;
+
+// Sampler as it was before Integrator_Add: every sub-integral accumulates both of its samples.
+class ReferenceByteSampler : public EasyByteSamplerImpl
+{
+public:
+	ReferenceByteSampler(EasySamplerSettings const & settings)
+	: EasyByteSamplerImpl(settings)
+	{
+	}
+
+	void Sample(const unsigned char * sample, double time)
+	{
+		m_CurSample = sample;
+
+		EasySamplerBase::Sample(time);
+
+		m_LastSample = EasySamplerSettings::ESM_Trapezoid == m_Settings.Method_get() ? sample : nullptr;
+		m_CurSample = nullptr;
+	}
+
+	vector<vector<unsigned char>> Frames;
+
+protected:
+	virtual void MakeFrame() override
+	{
+		Frames.emplace_back(m_Settings.ImageFormat_get().Bytes);
+		PrintFrame(Frames.back().data());
+		ClearFrame(m_Settings.FrameStrength_get());
+	}
+
+	virtual void SubSample(double timeA, double timeB, double subTimeA, double subTimeB) override
+	{
+		Integrator_Fn(this, m_LastSample, m_CurSample, timeA, timeB, subTimeA, subTimeB);
+	}
+
+private:
+	const unsigned char * m_CurSample = nullptr;
+	const unsigned char * m_LastSample = nullptr;
+};
+
+class ReferenceFloatSampler : public EasyFloatSamplerImpl
+{
+public:
+	ReferenceFloatSampler(EasySamplerSettings const & settings)
+	: EasyFloatSamplerImpl(settings)
+	{
+	}
+
+	void Sample(const float * sample, double time)
+	{
+		m_CurSample = sample;
+
+		EasySamplerBase::Sample(time);
+
+		m_LastSample = EasySamplerSettings::ESM_Trapezoid == m_Settings.Method_get() ? sample : nullptr;
+		m_CurSample = nullptr;
+	}
+
+	vector<vector<float>> Frames;
+
+protected:
+	virtual void MakeFrame() override
+	{
+		Frames.emplace_back(m_Settings.ImageFormat_get().Bytes / sizeof(float));
+		PrintFrame(Frames.back().data());
+		ClearFrame(m_Settings.FrameStrength_get());
+	}
+
+	virtual void SubSample(double timeA, double timeB, double subTimeA, double subTimeB) override
+	{
+		Integrator_Fn(this, m_LastSample, m_CurSample, timeA, timeB, subTimeA, subTimeB);
+	}
+
+private:
+	const float * m_CurSample = nullptr;
+	const float * m_LastSample = nullptr;
+};
+
+class FramePrinter : public IFramePrinter<false>
+{
+public:
+	vector<vector<unsigned char>> Frames;
+
+	virtual void PrintSampledFrame(TImageBuffer<false> * pImageBuffer) override
+	{
+		const unsigned char * data = (const unsigned char *)pImageBuffer->GetImageBufferData();
+		Frames.emplace_back(data, data + pImageBuffer->GetImageBufferFormat()->Bytes);
+	}
+};
+
+struct Case_s {
+	const char * Name;
+	EasySamplerSettings::Method Method;
+	double FrameDuration;
+	double Exposure;
+	float FrameStrength;
+	bool RandomTimes;
+	bool ClosedShutter;
+	/// <summary>0: samples every FrameDuration / 4, otherwise at this rate and passed to the settings.</summary>
+	double SampleDuration;
+	EasySamplerSettings::Accumulator ByteAccumulator;
+};
+
+static bool IsDyadic(double value)
+{
+	return value * 4096 == floor(value * 4096);
+}
+
+static TImageBuffer<false> * NewSample(CGrowingBufferPool & pool, const CImageFormat & format, mt19937 & random)
+{
+	TImageBuffer<false> * pImageBuffer = new TImageBuffer<false>(&pool);
+	pImageBuffer->AddRef();
+	pImageBuffer->GrowAlloc(format);
+
+	if (ImageFormat::ZFloat == format.Format) {
+		// Multiples of 1/256, so that the sums are exact too with dyadic times:
+		for (int y = 0; y < format.Height; ++y) {
+			float * row = (float *)((unsigned char *)pImageBuffer->GetImageBufferData() + y * format.Pitch);
+			for (int x = 0; x < format.Width; ++x) row[x] = (float)(random() & 0xff) / 256;
+		}
+	}
+	else {
+		unsigned char * data = (unsigned char *)pImageBuffer->GetImageBufferData();
+		for (size_t i = 0; i < format.Bytes; ++i) data[i] = (unsigned char)(random() & 0xff);
+	}
+
+	return pImageBuffer;
+}
+
+static bool Test(const Case_s & c, const CImageFormat & format, CThreadPool * threadPool, mt19937 & random)
+{
+	EasySamplerSettings settings(format, c.Method, c.FrameDuration, 0, c.Exposure, c.FrameStrength, c.SampleDuration);
+	// Without the sample duration the reference always accumulates in float:
+	EasySamplerSettings referenceSettings(format, c.Method, c.FrameDuration, 0, c.Exposure, c.FrameStrength);
+
+	if (settings.ByteAccumulator_get() != c.ByteAccumulator) {
+		cout << "FAILED: " << c.Name << ": accumulator " << settings.ByteAccumulator_get() << " instead of " << c.ByteAccumulator << endl;
+		return false;
+	}
+
+	CGrowingBufferPool pool;
+	FramePrinter printer;
+	bool isFloat = ImageFormat::ZFloat == format.Format;
+
+	EasyByteSampler<false> * byteSampler = isFloat ? nullptr : new EasyByteSampler<false>(settings, &printer, &pool, threadPool);
+	EasyFloatSampler<false> * floatSampler = isFloat ? new EasyFloatSampler<false>(settings, &printer, &pool, threadPool) : nullptr;
+	ReferenceByteSampler * byteReference = isFloat ? nullptr : new ReferenceByteSampler(referenceSettings);
+	ReferenceFloatSampler * floatReference = isFloat ? new ReferenceFloatSampler(referenceSettings) : nullptr;
+
+	// The reference keeps raw pointers, so the samples are alive for the whole test (and reused, to keep cases with many samples per frame fast):
+	vector<TImageBuffer<false> *> samples;
+	for (int i = 0; i < 8; ++i) samples.push_back(NewSample(pool, format, random));
+
+	uniform_real_distribution<double> jitter(0.25, 1.75);
+	double step = c.SampleDuration ? c.SampleDuration : c.FrameDuration / 4;
+	double time = 0;
+	while (time < 16 * c.FrameDuration) {
+		TImageBuffer<false> * pSample = c.ClosedShutter && 0 == random() % 7 ? nullptr : samples[random() % samples.size()];
+
+		if (isFloat) {
+			floatSampler->Sample(pSample, time);
+			floatReference->Sample(pSample ? (const float *)pSample->GetImageBufferData() : nullptr, time);
+		}
+		else {
+			byteSampler->Sample(pSample, time);
+			byteReference->Sample(pSample ? (const unsigned char *)pSample->GetImageBufferData() : nullptr, time);
+		}
+
+		time += step * (c.RandomTimes ? jitter(random) : 1);
+	}
+
+	delete byteSampler;
+	delete floatSampler;
+
+	bool ok = true;
+	size_t numFrames = isFloat ? floatReference->Frames.size() : byteReference->Frames.size();
+
+	if (numFrames != printer.Frames.size() || numFrames < 8) {
+		cout << "FAILED: " << c.Name << ": " << printer.Frames.size() << " frames instead of " << numFrames << endl;
+		ok = false;
+	}
+
+	int maxError = 0;
+	double maxErrorFloat = 0;
+	for (size_t i = 0; ok && i < numFrames; ++i) {
+		if (isFloat) {
+			const float * a = (const float *)printer.Frames[i].data();
+			const vector<float> & b = floatReference->Frames[i];
+			for (size_t j = 0; j < b.size(); ++j) {
+				double error = fabs(a[j] - b[j]);
+				if (maxErrorFloat < error) maxErrorFloat = error;
+			}
+		}
+		else {
+			// The padding of the rows is not written:
+			const vector<unsigned char> & a = printer.Frames[i];
+			const vector<unsigned char> & b = byteReference->Frames[i];
+			for (int y = 0; y < format.Height; ++y) {
+				for (size_t j = y * format.Pitch; j < y * format.Pitch + format.Width * format.GetPixelStride(); ++j) {
+					int error = abs((int)a[j] - (int)b[j]);
+					if (maxError < error) maxError = error;
+				}
+			}
+		}
+	}
+
+	// With dyadic times all weights and sums are exact, otherwise only the float rounding differs,
+	// by at most one epsilon per accumulated sample (see EasySamplerBase::Integrator_Add):
+	bool exact = !c.RandomTimes && IsDyadic(c.FrameDuration) && IsDyadic(step) && IsDyadic(c.Exposure * c.FrameDuration);
+	double maxSamplesPerFrame = ceil(c.FrameDuration / (step * (c.RandomTimes ? 0.25 : 1))) + 2;
+	// (The samples are below 1, so are the frames.)
+	double maxFloatError = maxSamplesPerFrame * FLT_EPSILON;
+	int maxByteError = 1;
+	if (EasySamplerSettings::ESA_Float != settings.ByteAccumulator_get()) {
+		// Plus the fixed point weights: each is off by less than one unit, which is 1 / 2^bits of a sample.
+		maxByteError += (int)ceil(255.0 / (1 << settings.FixedPointBits_get()));
+	}
+	if (exact ? (0 != maxError || 0 != maxErrorFloat) : (maxByteError < maxError || maxFloatError < maxErrorFloat)) {
+		cout << "FAILED: " << c.Name << (isFloat ? " (float" : " (byte") << (threadPool ? ", thread pool)" : ")") << ": max error " << (isFloat ? maxErrorFloat : maxError) << endl;
+		ok = false;
+	}
+
+	delete byteReference;
+	delete floatReference;
+
+	for (TImageBuffer<false> * pSample : samples) pSample->Release();
+
+	return ok;
+}
+
+// ESA_Fixed16 must leave at least 4 fraction bits, above that ESA_Fixed32 is used:
+static bool TestAccumulatorChoice()
+{
+	bool ok = true;
+
+	for (int samples = 1; samples <= 300; ++samples) {
+		EasySamplerSettings settings(CImageFormat(ImageFormat::BGRA, 1, 1), EasySamplerSettings::ESM_Rectangle, samples / 64.0, 0, 1.0, 1.0f, 1 / 64.0);
+		EasySamplerSettings::Accumulator expected = samples <= 16 ? EasySamplerSettings::ESA_Fixed16 : EasySamplerSettings::ESA_Fixed32;
+
+		if (expected != settings.ByteAccumulator_get() || settings.FixedPointBits_get() < 4) {
+			cout << "FAILED: " << samples << " samples per frame: accumulator " << settings.ByteAccumulator_get() << " with " << settings.FixedPointBits_get() << " fraction bits" << endl;
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+static void Benchmark(const CImageFormat & format)
+{
+	const int frames = 30;
+	const int samplesPerFrame = 8;
+
+	CGrowingBufferPool pool;
+	FramePrinter printer;
+	mt19937 random(1);
+
+	vector<TImageBuffer<false> *> samples;
+	for (int i = 0; i < 2; ++i) samples.push_back(NewSample(pool, format, random));
+
+	auto trapezoid = [&](bool reference, CThreadPool * threadPool) {
+		EasySamplerSettings settings(format, EasySamplerSettings::ESM_Trapezoid, 1.0, 0, 1.0, 1.0f);
+		EasyByteSampler<false> sampler(settings, &printer, &pool, threadPool);
+		ReferenceByteSampler referenceSampler(settings);
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int i = 0; i < frames * samplesPerFrame; ++i) {
+			double time = (double)i / samplesPerFrame;
+			if (reference) referenceSampler.Sample((const unsigned char *)samples[i & 1]->GetImageBufferData(), time);
+			else sampler.Sample(samples[i & 1], time);
+		}
+		double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / (frames * samplesPerFrame);
+		printer.Frames.clear();
+		return ms;
+	};
+
+	cout << "per sub-integral: " << trapezoid(true, nullptr) << " ms per sample (" << format.Width << "x" << format.Height << " BGRA, trapezoid)" << endl;
+	double singlePassMs = trapezoid(false, nullptr);
+	cout << "single pass: " << singlePassMs << " ms per sample (" << format.Width << "x" << format.Height << " BGRA, trapezoid)" << endl;
+
+	// 1, 2, 4, ... pool threads up to the default (at least 1), the calling thread helps too:
+	size_t maxThreads = 1 < CThreadPool::GetDefaultThreadCount() ? CThreadPool::GetDefaultThreadCount() : 1;
+	for (size_t threads = 1; threads <= maxThreads; threads = threads < maxThreads && maxThreads < 2 * threads ? maxThreads : 2 * threads) {
+		CThreadPool threadPool(threads);
+		double ms = trapezoid(false, &threadPool);
+		cout << "single pass, thread pool (" << threads << " + 1 threads): " << ms << " ms per sample (" << format.Width << "x" << format.Height << " BGRA, trapezoid), speedup " << singlePassMs / ms << endl;
+	}
+
+	// Rectangle, float vs. fixed point accumulator (8 samples per frame fit 16 bit):
+	for (int pass = 0; pass < 2; ++pass) {
+		EasySamplerSettings settings(format, EasySamplerSettings::ESM_Rectangle, 1.0, 0, 1.0, 1.0f, 1 == pass ? 1.0 / samplesPerFrame : 0);
+		EasyByteSampler<false> sampler(settings, &printer, &pool);
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int i = 0; i < frames * samplesPerFrame; ++i) {
+			sampler.Sample(samples[i & 1], (double)i / samplesPerFrame);
+		}
+		double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / (frames * samplesPerFrame);
+		cout << (EasySamplerSettings::ESA_Float == settings.ByteAccumulator_get() ? "float accumulator: " : "fixed point accumulator: ") << ms << " ms per sample (" << format.Width << "x" << format.Height << " BGRA, rectangle)" << endl;
+		printer.Frames.clear();
+	}
+
+	for (TImageBuffer<false> * pSample : samples) pSample->Release();
+}
+
+int main(int argc, char* argv[])
+{
+	mt19937 random(1);
+	bool ok = true;
+
+	const Case_s cases[] = {
+		{ "rectangle", EasySamplerSettings::ESM_Rectangle, 0.25, 1.0, 1.0f, false, false, 0, EasySamplerSettings::ESA_Float },
+		{ "trapezoid", EasySamplerSettings::ESM_Trapezoid, 0.25, 1.0, 1.0f, false, false, 0, EasySamplerSettings::ESA_Float },
+		{ "trapezoid, exposure 0.5, strength 0.5", EasySamplerSettings::ESM_Trapezoid, 0.25, 0.5, 0.5f, false, false, 0, EasySamplerSettings::ESA_Float },
+		{ "rectangle, random times", EasySamplerSettings::ESM_Rectangle, 1.0 / 30, 1.0, 1.0f, true, false, 0, EasySamplerSettings::ESA_Float },
+		{ "trapezoid, random times", EasySamplerSettings::ESM_Trapezoid, 1.0 / 30, 1.0, 1.0f, true, false, 0, EasySamplerSettings::ESA_Float },
+		{ "trapezoid, random times, exposure 0.7, strength 0.9", EasySamplerSettings::ESM_Trapezoid, 1.0 / 30, 0.7, 0.9f, true, false, 0, EasySamplerSettings::ESA_Float },
+		{ "trapezoid, random times, closed shutter", EasySamplerSettings::ESM_Trapezoid, 1.0 / 30, 0.8, 1.0f, true, true, 0, EasySamplerSettings::ESA_Float },
+		{ "rectangle, random times, closed shutter", EasySamplerSettings::ESM_Rectangle, 1.0 / 30, 0.8, 1.0f, true, true, 0, EasySamplerSettings::ESA_Float },
+		{ "rectangle, 16 bit fixed point", EasySamplerSettings::ESM_Rectangle, 0.25, 1.0, 1.0f, false, false, 0.25 / 4, EasySamplerSettings::ESA_Fixed16 },
+		{ "rectangle, random times, 16 bit fixed point", EasySamplerSettings::ESM_Rectangle, 1.0 / 30, 1.0, 1.0f, true, false, 1.0 / 120, EasySamplerSettings::ESA_Fixed16 },
+		{ "rectangle, random times, closed shutter, 16 bit fixed point", EasySamplerSettings::ESM_Rectangle, 1.0 / 30, 0.6, 1.0f, true, true, 1.0 / 240, EasySamplerSettings::ESA_Fixed16 },
+		{ "rectangle, 32 bit fixed point", EasySamplerSettings::ESM_Rectangle, 0.25, 1.0, 1.0f, false, false, 0.25 / 512, EasySamplerSettings::ESA_Fixed32 },
+		{ "rectangle, random times, 32 bit fixed point", EasySamplerSettings::ESM_Rectangle, 1.0 / 30, 1.0, 1.0f, true, false, 1.0 / 9000, EasySamplerSettings::ESA_Fixed32 },
+		{ "rectangle, random times, 16 samples, 16 bit fixed point", EasySamplerSettings::ESM_Rectangle, 1.0 / 30, 1.0, 1.0f, true, false, 1.0 / 480, EasySamplerSettings::ESA_Fixed16 },
+		{ "rectangle, random times, 17 samples, 32 bit fixed point", EasySamplerSettings::ESM_Rectangle, 1.0 / 30, 1.0, 1.0f, true, false, 1.0 / 510, EasySamplerSettings::ESA_Fixed32 },
+		{ "trapezoid, non-dyadic times", EasySamplerSettings::ESM_Trapezoid, 1.0 / 30, 0.7, 0.9f, false, false, 1.0 / 90, EasySamplerSettings::ESA_Float },
+		{ "trapezoid, sample duration (float)", EasySamplerSettings::ESM_Trapezoid, 0.25, 1.0, 1.0f, false, false, 0.25 / 4, EasySamplerSettings::ESA_Float },
+		{ "rectangle, strength 0.5, sample duration (float)", EasySamplerSettings::ESM_Rectangle, 0.25, 1.0, 0.5f, false, false, 0.25 / 4, EasySamplerSettings::ESA_Float },
+	};
+
+	const CImageFormat formats[] = {
+		CImageFormat(ImageFormat::BGRA, 13, 7),
+		CImageFormat(ImageFormat::BGR, 9, 5, 32),
+		CImageFormat(ImageFormat::ZFloat, 11, 3),
+		// Big enough to be split into row tiles:
+		CImageFormat(ImageFormat::BGRA, 257, 131),
+		CImageFormat(ImageFormat::ZFloat, 263, 509),
+	};
+
+	ok = TestAccumulatorChoice() && ok;
+
+	CThreadPool threadPool(3);
+
+	for (const CImageFormat & format : formats) {
+		for (const Case_s & c : cases) {
+			bool caseOk = Test(c, format, nullptr, random);
+			ok = ok && caseOk;
+			caseOk = Test(c, format, &threadPool, random);
+			ok = ok && caseOk;
+		}
+	}
+
+	bool benchmark = 2 <= argc && 0 == strcmp(argv[1], "-benchmark");
+	if (benchmark) {
+		cout << thread::hardware_concurrency() << " hardware threads" << endl;
+		Benchmark(CImageFormat(ImageFormat::BGRA, 1920, 1080));
+		Benchmark(CImageFormat(ImageFormat::BGRA, 3840, 2160));
+	}
+	else {
+		cout << "(run with -benchmark for throughput)" << endl;
+	}
+
+	cout << (ok ? "OK" : "FAILED") << endl;
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+// EasySamplerKernelsTest.cpp : Checks shared/EasySamplerKernels SIMD kernels against the scalar reference and measures their throughput.
+//
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <math.h>
+#include <string.h>
+#include <shared/EasySamplerKernels.h>
+
+using namespace std;
+using namespace advancedfx;
+using namespace advancedfx::EasySampler;
+
+static bool CompareFloats(const vector<float>& a, const vector<float>& b, double& maxError) {
+	bool ok = a.size() == b.size();
+	for (size_t i = 0; ok && i < a.size(); ++i) {
+		double error = fabs(a[i] - b[i]) / (1 + fabs(b[i]));
+		if (maxError < error) maxError = error;
+		if (error > 1e-6) ok = false;
+	}
+	return ok;
+}
+
+static bool Test(CpuIsa isa, mt19937& random) {
+	const Kernels_s& ref = GetKernels(CpuIsa::Scalar);
+	const Kernels_s& simd = GetKernels(isa);
+	bool ok = true;
+	double maxError = 0;
+
+	uniform_int_distribution<int> byteDist(0, 255);
+	uniform_real_distribution<float> floatDist(0, 1);
+
+	// Different counts, to cover the tails of the 16 / 32 wide paths:
+	for (size_t count = 0; count <= 100; ++count) {
+		for (int run = 0; run < 8; ++run) {
+			// Exact sized, so the sanitizer catches accesses past the row:
+			vector<unsigned char> bytesA(count), bytesB(count);
+			vector<float> floatsA(count), floatsB(count), frame(count);
+			for (auto& v : bytesA) v = (unsigned char)byteDist(random);
+			for (auto& v : bytesB) v = (unsigned char)byteDist(random);
+			for (auto& v : floatsA) v = floatDist(random);
+			for (auto& v : floatsB) v = floatDist(random);
+			for (auto& v : frame) v = 255.0f * floatDist(random);
+			float w = floatDist(random);
+			float w2 = floatDist(random);
+
+			auto check = [&](const char* kernel, bool same) {
+				if (!same) {
+					cout << "FAILED: " << GetCpuIsaName(isa) << " " << kernel << " (count " << count << ")" << endl;
+					ok = false;
+				}
+			};
+
+			{
+				vector<float> a(frame), b(frame);
+				ref.ByteFn_1(a.data(), bytesA.data(), count);
+				simd.ByteFn_1(b.data(), bytesA.data(), count);
+				check("ByteFn_1", CompareFloats(b, a, maxError));
+			}
+			{
+				vector<float> a(frame), b(frame);
+				ref.ByteFn_2(a.data(), bytesA.data(), count, w);
+				simd.ByteFn_2(b.data(), bytesA.data(), count, w);
+				check("ByteFn_2", CompareFloats(b, a, maxError));
+			}
+			{
+				vector<float> a(frame), b(frame);
+				ref.ByteFn_3(a.data(), bytesA.data(), w, bytesB.data(), w2, count);
+				simd.ByteFn_3(b.data(), bytesA.data(), w, bytesB.data(), w2, count);
+				check("ByteFn_3", CompareFloats(b, a, maxError));
+			}
+			{
+				vector<float> a(frame), b(frame);
+				ref.ByteFn_4(a.data(), bytesA.data(), bytesB.data(), count, w);
+				simd.ByteFn_4(b.data(), bytesA.data(), bytesB.data(), count, w);
+				check("ByteFn_4", CompareFloats(b, a, maxError));
+			}
+			{
+				// Includes values outside [0, 255] to check the clamping:
+				float scale = 0 == run ? 1.5f : (1 == run ? -1.0f : 1.0f);
+				vector<unsigned char> a(count), b(count);
+				ref.BytePrint(a.data(), frame.data(), count, scale);
+				simd.BytePrint(b.data(), frame.data(), count, scale);
+				check("BytePrint", 0 == count || 0 == memcmp(a.data(), b.data(), count));
+			}
+			{
+				vector<float> a(frame), b(frame);
+				ref.FloatFn_1(a.data(), floatsA.data(), count);
+				simd.FloatFn_1(b.data(), floatsA.data(), count);
+				check("FloatFn_1", CompareFloats(b, a, maxError));
+			}
+			{
+				vector<float> a(frame), b(frame);
+				ref.FloatFn_2(a.data(), floatsA.data(), count, w);
+				simd.FloatFn_2(b.data(), floatsA.data(), count, w);
+				check("FloatFn_2", CompareFloats(b, a, maxError));
+			}
+			{
+				vector<float> a(frame), b(frame);
+				ref.FloatFn_3(a.data(), floatsA.data(), w, floatsB.data(), w2, count);
+				simd.FloatFn_3(b.data(), floatsA.data(), w, floatsB.data(), w2, count);
+				check("FloatFn_3", CompareFloats(b, a, maxError));
+			}
+			{
+				vector<float> a(frame), b(frame);
+				ref.FloatFn_4(a.data(), floatsA.data(), floatsB.data(), count, w);
+				simd.FloatFn_4(b.data(), floatsA.data(), floatsB.data(), count, w);
+				check("FloatFn_4", CompareFloats(b, a, maxError));
+			}
+			{
+				vector<float> a(count), b(count);
+				ref.FloatPrint(a.data(), frame.data(), count, w);
+				simd.FloatPrint(b.data(), frame.data(), count, w);
+				check("FloatPrint", CompareFloats(b, a, maxError));
+			}
+			{
+				vector<float> a(frame), b(frame);
+				ref.Scale(a.data(), count, w);
+				simd.Scale(b.data(), count, w);
+				check("Scale", CompareFloats(b, a, maxError));
+			}
+
+			// Fixed point, the results must be the same:
+			{
+				unsigned int q = 1 + random() % 128, q2 = 1 + random() % 128;
+				vector<unsigned short> frame16(count);
+				for (auto& v : frame16) v = (unsigned short)(random() % 256);
+				vector<unsigned short> a(frame16), b(frame16);
+				ref.ByteFn_2_U16(a.data(), bytesA.data(), count, q);
+				simd.ByteFn_2_U16(b.data(), bytesA.data(), count, q);
+				check("ByteFn_2_U16", a == b);
+				ref.ByteFn_3_U16(a.data(), bytesA.data(), q, bytesB.data(), q2, count);
+				simd.ByteFn_3_U16(b.data(), bytesA.data(), q, bytesB.data(), q2, count);
+				check("ByteFn_3_U16", a == b);
+				vector<unsigned char> da(count), db(count);
+				float w16 = 1.0f / (1 + random() % 512);
+				ref.BytePrint_U16(da.data(), a.data(), count, w16);
+				simd.BytePrint_U16(db.data(), a.data(), count, w16);
+				check("BytePrint_U16", da == db);
+			}
+			{
+				unsigned int q = random() % 0x10000, q2 = random() % 0x10000;
+				vector<unsigned int> frame32(count);
+				for (auto& v : frame32) v = (unsigned int)(random() % 0x1000000);
+				vector<unsigned int> a(frame32), b(frame32);
+				ref.ByteFn_2_U32(a.data(), bytesA.data(), count, q);
+				simd.ByteFn_2_U32(b.data(), bytesA.data(), count, q);
+				check("ByteFn_2_U32", a == b);
+				ref.ByteFn_3_U32(a.data(), bytesA.data(), q, bytesB.data(), q2, count);
+				simd.ByteFn_3_U32(b.data(), bytesA.data(), q, bytesB.data(), q2, count);
+				check("ByteFn_3_U32", a == b);
+				vector<unsigned char> da(count), db(count);
+				float w32 = 1.0f / (1 + random() % 0x40000);
+				ref.BytePrint_U32(da.data(), a.data(), count, w32);
+				simd.BytePrint_U32(db.data(), a.data(), count, w32);
+				check("BytePrint_U32", da == db);
+			}
+		}
+	}
+
+	cout << GetCpuIsaName(isa) << ": max relative error " << maxError << endl;
+
+	return ok;
+}
+
+static void Benchmark(CpuIsa isa) {
+	const Kernels_s& k = GetKernels(isa);
+	// 1920x1080 BGRA:
+	const size_t count = 1920 * 1080 * 4;
+	const int frames = 20;
+
+	vector<unsigned char> bytesA(count, 0x5a), bytesB(count, 0xa5), bytesOut(count);
+	vector<float> floatsA(count, 0.25f), floatsB(count, 0.5f), frame(count, 0.0f), floatsOut(count);
+
+	auto run = [&](const char* kernel, size_t bytesPerValue, auto fn) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int i = 0; i < frames; ++i) fn();
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / frames;
+		cout << "  " << kernel << ": " << seconds * 1000 << " ms, " << (bytesPerValue * count) / seconds / 1e9 << " GB/s" << endl;
+	};
+
+	cout << GetCpuIsaName(isa) << " (1920x1080 BGRA / " << count << " values, bytes read + written):" << endl;
+	run("ByteFn_1", 1 + 4 + 4, [&]() { k.ByteFn_1(frame.data(), bytesA.data(), count); });
+	run("ByteFn_2", 1 + 4 + 4, [&]() { k.ByteFn_2(frame.data(), bytesA.data(), count, 0.5f); });
+	run("ByteFn_3", 1 + 1 + 4 + 4, [&]() { k.ByteFn_3(frame.data(), bytesA.data(), 0.25f, bytesB.data(), 0.75f, count); });
+	run("ByteFn_4", 1 + 1 + 4 + 4, [&]() { k.ByteFn_4(frame.data(), bytesA.data(), bytesB.data(), count, 0.5f); });
+	run("BytePrint", 4 + 1, [&]() { k.BytePrint(bytesOut.data(), frame.data(), count, 1.0f / frames); });
+	run("FloatFn_1", 4 + 4 + 4, [&]() { k.FloatFn_1(frame.data(), floatsA.data(), count); });
+	run("FloatFn_2", 4 + 4 + 4, [&]() { k.FloatFn_2(frame.data(), floatsA.data(), count, 0.5f); });
+	run("FloatFn_3", 4 + 4 + 4 + 4, [&]() { k.FloatFn_3(frame.data(), floatsA.data(), 0.25f, floatsB.data(), 0.75f, count); });
+	run("FloatFn_4", 4 + 4 + 4 + 4, [&]() { k.FloatFn_4(frame.data(), floatsA.data(), floatsB.data(), count, 0.5f); });
+	run("FloatPrint", 4 + 4, [&]() { k.FloatPrint(floatsOut.data(), frame.data(), count, 0.5f); });
+	run("Scale", 4 + 4, [&]() { k.Scale(frame.data(), count, 0.5f); });
+
+	vector<unsigned short> frame16(count, 0);
+	vector<unsigned int> frame32(count, 0);
+	run("ByteFn_2_U16", 1 + 2 + 2, [&]() { k.ByteFn_2_U16(frame16.data(), bytesA.data(), count, 1); });
+	run("ByteFn_3_U16", 1 + 1 + 2 + 2, [&]() { k.ByteFn_3_U16(frame16.data(), bytesA.data(), 1, bytesB.data(), 1, count); });
+	run("BytePrint_U16", 2 + 1, [&]() { k.BytePrint_U16(bytesOut.data(), frame16.data(), count, 1.0f / frames); });
+	run("ByteFn_2_U32", 1 + 4 + 4, [&]() { k.ByteFn_2_U32(frame32.data(), bytesA.data(), count, 256); });
+	run("ByteFn_3_U32", 1 + 1 + 4 + 4, [&]() { k.ByteFn_3_U32(frame32.data(), bytesA.data(), 256, bytesB.data(), 256, count); });
+	run("BytePrint_U32", 4 + 1, [&]() { k.BytePrint_U32(bytesOut.data(), frame32.data(), count, 1.0f / frames); });
+}
+
+int main(int argc, char* argv[])
+{
+	CpuIsa cpuIsa = GetCpuIsa();
+	cout << "CPU: " << GetCpuIsaName(cpuIsa) << endl;
+
+	mt19937 random(1);
+	bool ok = true;
+
+	for (int isa = (int)CpuIsa::SSE2; isa <= (int)cpuIsa; ++isa) {
+		if (CpuIsa::SSSE3 == (CpuIsa)isa) continue; // Same kernels as SSE2.
+		bool isaOk = Test((CpuIsa)isa, random);
+		ok = ok && isaOk;
+	}
+
+	bool benchmark = 2 <= argc && 0 == strcmp(argv[1], "-benchmark");
+	if (benchmark) {
+		for (int isa = (int)CpuIsa::Scalar; isa <= (int)cpuIsa; ++isa) {
+			if (CpuIsa::SSSE3 == (CpuIsa)isa) continue;
+			Benchmark((CpuIsa)isa);
+		}
+	}
+	else {
+		cout << "(run with -benchmark for throughput)" << endl;
+	}
+
+	cout << (ok ? "OK" : "FAILED") << endl;
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+// FramePipelineTest.cpp : Checks CFramePipeline (serial stages in frame order, max in flight, Push blocking, Flush) and benchmarks overlapping a slow writer with the producer.
+//
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <random>
+#include <string.h>
+#include <shared/ThreadPool.h>
+#include <shared/FramePipeline.h>
+
+using namespace std;
+using namespace advancedfx;
+
+class CTestFrame : public CFramePipeline::CFrame {
+public:
+	CTestFrame(atomic_int& alive)
+		: m_Alive(alive)
+	{
+		m_Alive++;
+	}
+
+	virtual ~CTestFrame() override {
+		m_Alive--;
+	}
+
+	int Delay = 0;
+
+private:
+	atomic_int& m_Alive;
+};
+
+static void Work(int delay) {
+	if (0 < delay) this_thread::sleep_for(chrono::microseconds(delay));
+}
+
+static bool TestOrder(CThreadPool* pool, const char* name) {
+	const size_t frames = 200;
+	const size_t maxInFlight = 5;
+
+	atomic_int alive(0);
+	atomic_int inside(0);
+	atomic_int maxInside(0);
+	atomic_int serialBusy1(0);
+	atomic_int serialBusy2(0);
+	atomic_bool serialOk(true);
+	vector<size_t> parallelDone;
+	vector<size_t> serialDone1;
+	vector<size_t> serialDone2;
+	std::mutex parallelDoneMutex;
+
+	{
+		CFramePipeline pipeline(pool, maxInFlight);
+
+		pipeline.AddParallelStage([&](CFramePipeline::CFrame* frame) {
+			int now = ++inside;
+			for (int seen = maxInside; seen < now && !maxInside.compare_exchange_weak(seen, now);) {}
+			Work(static_cast<CTestFrame*>(frame)->Delay);
+			std::unique_lock<std::mutex> lock(parallelDoneMutex);
+			parallelDone.push_back(frame->GetFrameNumber());
+		});
+		pipeline.AddSerialStage([&](CFramePipeline::CFrame* frame) {
+			if (1 != ++serialBusy1) serialOk = false;
+			Work(static_cast<CTestFrame*>(frame)->Delay / 4);
+			serialDone1.push_back(frame->GetFrameNumber());
+			serialBusy1--;
+		});
+		pipeline.AddParallelStage([&](CFramePipeline::CFrame* frame) {
+			Work(static_cast<CTestFrame*>(frame)->Delay);
+		});
+		pipeline.AddSerialStage([&](CFramePipeline::CFrame* frame) {
+			if (1 != ++serialBusy2) serialOk = false;
+			serialDone2.push_back(frame->GetFrameNumber());
+			serialBusy2--;
+			inside--;
+		});
+
+		// Every 4th frame is slow, so the later ones overtake it in the parallel stages:
+		std::mt19937 random(1);
+		for (size_t i = 0; i < frames; i++) {
+			CTestFrame* frame = new CTestFrame(alive);
+			frame->Delay = 0 == i % 4 ? 2000 : (int)(random() % 200);
+			pipeline.Push(frame);
+		}
+
+		pipeline.Flush();
+
+		if (0 != alive || serialDone2.size() != frames) {
+			cout << "FAILED: Flush (" << name << "): " << serialDone2.size() << " of " << frames << " done, " << alive << " frames alive" << endl;
+			return false;
+		}
+
+		// Can be used again after a flush:
+		pipeline.Push(new CTestFrame(alive));
+	}
+
+	if (0 != alive || serialDone2.size() != frames + 1) {
+		cout << "FAILED: destructor (" << name << "): " << serialDone2.size() << " of " << frames + 1 << " done, " << alive << " frames alive" << endl;
+		return false;
+	}
+
+	bool ok = serialOk;
+	for (size_t i = 0; i < serialDone2.size(); i++) ok = ok && i == serialDone1[i] && i == serialDone2[i];
+	if (!ok) {
+		cout << "FAILED: serial stages out of order or concurrent (" << name << ")" << endl;
+		return false;
+	}
+
+	if ((size_t)maxInside > maxInFlight) {
+		cout << "FAILED: " << maxInside << " frames in flight, max is " << maxInFlight << " (" << name << ")" << endl;
+		return false;
+	}
+
+	// With more than one thread the parallel stage should really have run out of order:
+	bool inOrder = true;
+	for (size_t i = 0; i < parallelDone.size(); i++) inOrder = inOrder && i == parallelDone[i];
+	if (pool && 1 < pool->GetThreadCount() && inOrder) {
+		cout << "FAILED: parallel stage ran in order (" << name << ")" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+static bool TestBlocking() {
+	CThreadPool pool(3);
+	CFramePipeline pipeline(&pool, 2);
+	atomic_int alive(0);
+	atomic_bool release(false);
+	atomic_int pushed(0);
+
+	pipeline.AddSerialStage([&](CFramePipeline::CFrame*) {
+		while (!release) this_thread::sleep_for(chrono::milliseconds(1));
+	});
+
+	thread producer([&]() {
+		for (int i = 0; i < 5; i++) {
+			pipeline.Push(new CTestFrame(alive));
+			pushed++;
+		}
+	});
+
+	this_thread::sleep_for(chrono::milliseconds(100));
+	int pushedWhileBlocked = pushed;
+	release = true;
+	producer.join();
+	pipeline.Flush();
+
+	if (2 != pushedWhileBlocked || 5 != pushed || 0 != alive) {
+		cout << "FAILED: Push blocking: " << pushedWhileBlocked << " pushed while blocked (expected 2), " << pushed << " pushed, " << alive << " frames alive" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+// Producer does the sampling, the serial stage stands in for the encoder / disk.
+static void Benchmark() {
+	const int frames = 100;
+	const int produceUs = 2000;
+	const int writeUs = 2000;
+
+	for (int pass = 0; pass < 2; pass++) {
+		CThreadPool pool(2);
+		atomic_int alive(0);
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		{
+			CFramePipeline pipeline(0 == pass ? nullptr : &pool, 3);
+			pipeline.AddSerialStage([&](CFramePipeline::CFrame*) {
+				Work(writeUs);
+			});
+			for (int i = 0; i < frames; i++) {
+				Work(produceUs);
+				pipeline.Push(new CTestFrame(alive));
+			}
+		}
+		double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / frames;
+		cout << (0 == pass ? "inline writer: " : "pipelined writer: ") << ms << " ms per frame (" << produceUs / 1000.0 << " ms produce, " << writeUs / 1000.0 << " ms write)" << endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	bool ok = true;
+
+	ok = TestOrder(nullptr, "no pool") && ok;
+	for (size_t threads : { 0, 1, 3, 8 }) {
+		CThreadPool pool(threads);
+		string name = to_string(threads) + " threads";
+		ok = TestOrder(&pool, name.c_str()) && ok;
+	}
+	ok = TestBlocking() && ok;
+
+	bool benchmark = 2 <= argc && 0 == strcmp(argv[1], "-benchmark");
+	if (benchmark) {
+		Benchmark();
+	}
+	else {
+		cout << "(run with -benchmark for throughput)" << endl;
+	}
+
+	cout << (ok ? "OK" : "FAILED") << endl;
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+// ImageTransformerKernelsTest.cpp : Checks shared/ImageTransformerKernels SIMD kernels against the scalar reference and measures their throughput.
+//
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <math.h>
+#include <string.h>
+#include <shared/ImageTransformerKernels.h>
+
+using namespace std;
+using namespace advancedfx;
+using namespace advancedfx::ImageTransformer;
+
+// Outputs get guard bytes behind them, to catch kernels writing past the row.
+static const size_t c_Guard = 64;
+static const unsigned char c_GuardValue = 0xcd;
+
+static bool CheckGuard(const vector<unsigned char>& out, size_t size) {
+	for (size_t i = size; i < out.size(); ++i) {
+		if (c_GuardValue != out[i]) return false;
+	}
+	return true;
+}
+
+static bool CompareFloats(const vector<unsigned char>& a, const vector<unsigned char>& b, size_t count) {
+	const float* fa = (const float*)a.data();
+	const float* fb = (const float*)b.data();
+	for (size_t i = 0; i < count; ++i) {
+		if (fabs(fa[i] - fb[i]) > 1e-6 * (1 + fabs(fb[i]))) return false;
+	}
+	return true;
+}
+
+static bool Test(CpuIsa isa, mt19937& random) {
+	const Kernels_s& ref = GetKernels(CpuIsa::Scalar);
+	const Kernels_s& simd = GetKernels(isa);
+	const char* name = GetCpuIsaName(isa);
+	bool ok = true;
+
+	uniform_int_distribution<int> byteDist(0, 255);
+
+	// Different widths, to cover the tails of the 4 / 8 / 16 wide paths:
+	for (size_t width = 0; width <= 100; ++width) {
+		for (int run = 0; run < 8; ++run) {
+			vector<unsigned char> inA(4 * width), inB(4 * width);
+			for (auto& v : inA) v = (unsigned char)byteDist(random);
+			for (auto& v : inB) v = (unsigned char)byteDist(random);
+			if (1 == run) {
+				// Extremes of the matte alpha sum:
+				for (size_t i = 0; i < 4 * width; ++i) { inA[i] = 255; inB[i] = 0; }
+			}
+			else if (2 == run) {
+				for (size_t i = 0; i < 4 * width; ++i) { inA[i] = 0; inB[i] = 255; }
+			}
+
+			vector<float> inF(width);
+			for (auto& v : inF) v = (float)byteDist(random) / 255.0f;
+
+			// Exact sized copies, so the sanitizer catches reads past the row:
+			vector<unsigned char> inA3(inA.begin(), inA.begin() + 3 * width), inB3(inB.begin(), inB.begin() + 3 * width);
+
+			auto outBuffer = [width]() { return vector<unsigned char>(4 * sizeof(float) * width + c_Guard, c_GuardValue); };
+
+			struct Case_s { const char* Kernel; vector<unsigned char> Ref; vector<unsigned char> Simd; size_t Size; bool IsFloat; };
+			vector<Case_s> cases;
+
+			{
+				Case_s c = { "StripAlpha", outBuffer(), outBuffer(), 3 * width, false };
+				ref.StripAlpha(inA.data(), c.Ref.data(), width);
+				simd.StripAlpha(inA.data(), c.Simd.data(), width);
+				cases.push_back(move(c));
+			}
+			{
+				Case_s c = { "RgbaToBgr", outBuffer(), outBuffer(), 3 * width, false };
+				ref.RgbaToBgr(inA.data(), c.Ref.data(), width);
+				simd.RgbaToBgr(inA.data(), c.Simd.data(), width);
+				cases.push_back(move(c));
+			}
+			{
+				Case_s c = { "RgbaToBgra", outBuffer(), outBuffer(), 4 * width, false };
+				ref.RgbaToBgra(inA.data(), c.Ref.data(), width);
+				simd.RgbaToBgra(inA.data(), c.Simd.data(), width);
+				cases.push_back(move(c));
+			}
+			for (size_t strideA = 3; strideA <= 4; ++strideA) {
+				for (size_t strideB = 3; strideB <= 4; ++strideB) {
+					const unsigned char* pA = 3 == strideA ? inA3.data() : inA.data();
+					const unsigned char* pB = 3 == strideB ? inB3.data() : inB.data();
+					{
+						Case_s c = { "Matte", outBuffer(), outBuffer(), 4 * width, false };
+						ref.Matte(pA, strideA, pB, strideB, c.Ref.data(), width);
+						simd.Matte(pA, strideA, pB, strideB, c.Simd.data(), width);
+						cases.push_back(move(c));
+					}
+					{
+						Case_s c = { "AColorBRedAsAlpha", outBuffer(), outBuffer(), 4 * width, false };
+						ref.AColorBRedAsAlpha(pA, strideA, pB, strideB, c.Ref.data(), width);
+						simd.AColorBRedAsAlpha(pA, strideA, pB, strideB, c.Simd.data(), width);
+						cases.push_back(move(c));
+					}
+				}
+				{
+					const unsigned char* pA = 3 == strideA ? inA3.data() : inA.data();
+					Case_s c = { "Depth24", outBuffer(), outBuffer(), sizeof(float) * width, true };
+					ref.Depth24(pA, strideA, (float*)c.Ref.data(), width, 2.5f, -0.5f);
+					simd.Depth24(pA, strideA, (float*)c.Simd.data(), width, 2.5f, -0.5f);
+					cases.push_back(move(c));
+				}
+			}
+			{
+				Case_s c = { "DepthF", outBuffer(), outBuffer(), sizeof(float) * width, true };
+				ref.DepthF(inF.data(), (float*)c.Ref.data(), width, 3.0f, 0.25f);
+				simd.DepthF(inF.data(), (float*)c.Simd.data(), width, 3.0f, 0.25f);
+				cases.push_back(move(c));
+			}
+
+			for (auto& c : cases) {
+				bool same = c.IsFloat ? CompareFloats(c.Simd, c.Ref, width) : 0 == memcmp(c.Simd.data(), c.Ref.data(), c.Size);
+				if (!same || !CheckGuard(c.Simd, c.Size)) {
+					cout << "FAILED: " << name << " " << c.Kernel << " (width " << width << ")" << (same ? ": wrote past row." : ": differs from scalar.") << endl;
+					ok = false;
+				}
+			}
+		}
+	}
+
+	return ok;
+}
+
+static void Benchmark(CpuIsa isa) {
+	const Kernels_s& k = GetKernels(isa);
+	const size_t width = 3840;
+	const size_t height = 2160;
+	const int frames = 20;
+
+	vector<unsigned char> inA(4 * width * height, 0x5a), inB(4 * width * height, 0xa5), out(4 * width * height);
+	vector<float> inF(width * height, 0.5f);
+
+	auto run = [&](const char* kernel, size_t bytesPerPixel, auto fn) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame) {
+			for (size_t y = 0; y < height; ++y) fn(y);
+		}
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / frames;
+		cout << "  " << kernel << ": " << seconds * 1000 << " ms per frame, " << (bytesPerPixel * width * height) / seconds / (1024 * 1024 * 1024) << " GiB/s" << endl;
+	};
+
+	cout << GetCpuIsaName(isa) << " (" << width << "x" << height << ", in + out bytes):" << endl;
+	run("StripAlpha", 4 + 3, [&](size_t y) { k.StripAlpha(&inA[4 * width * y], &out[3 * width * y], width); });
+	run("RgbaToBgr", 4 + 3, [&](size_t y) { k.RgbaToBgr(&inA[4 * width * y], &out[3 * width * y], width); });
+	run("RgbaToBgra", 4 + 4, [&](size_t y) { k.RgbaToBgra(&inA[4 * width * y], &out[4 * width * y], width); });
+	run("Matte (BGRA)", 4 + 4 + 4, [&](size_t y) { k.Matte(&inA[4 * width * y], 4, &inB[4 * width * y], 4, &out[4 * width * y], width); });
+	run("Matte (BGR)", 3 + 3 + 4, [&](size_t y) { k.Matte(&inA[3 * width * y], 3, &inB[3 * width * y], 3, &out[4 * width * y], width); });
+	run("AColorBRedAsAlpha (BGRA)", 4 + 4 + 4, [&](size_t y) { k.AColorBRedAsAlpha(&inA[4 * width * y], 4, &inB[4 * width * y], 4, &out[4 * width * y], width); });
+	run("AColorBRedAsAlpha (BGR)", 3 + 3 + 4, [&](size_t y) { k.AColorBRedAsAlpha(&inA[3 * width * y], 3, &inB[3 * width * y], 3, &out[4 * width * y], width); });
+	run("DepthF", 4 + 4, [&](size_t y) { k.DepthF(&inF[width * y], (float*)&out[4 * width * y], width, 2.0f, 1.0f); });
+	run("Depth24 (BGRA)", 4 + 4, [&](size_t y) { k.Depth24(&inA[4 * width * y], 4, (float*)&out[4 * width * y], width, 2.0f, 1.0f); });
+	run("Depth24 (BGR)", 3 + 4, [&](size_t y) { k.Depth24(&inA[3 * width * y], 3, (float*)&out[4 * width * y], width, 2.0f, 1.0f); });
+}
+
+int main(int argc, char* argv[])
+{
+	CpuIsa cpuIsa = GetCpuIsa();
+	cout << "CPU: " << GetCpuIsaName(cpuIsa) << endl;
+
+	mt19937 random(1);
+	bool ok = true;
+
+	for (int isa = (int)CpuIsa::SSE2; isa <= (int)cpuIsa; ++isa) {
+		bool isaOk = Test((CpuIsa)isa, random);
+		cout << GetCpuIsaName((CpuIsa)isa) << ": " << (isaOk ? "OK" : "FAILED") << endl;
+		ok = ok && isaOk;
+	}
+
+	bool benchmark = 2 <= argc && 0 == strcmp(argv[1], "-benchmark");
+	if (benchmark) {
+		for (int isa = (int)CpuIsa::Scalar; isa <= (int)cpuIsa; ++isa) {
+			Benchmark((CpuIsa)isa);
+		}
+	}
+	else {
+		cout << "(run with -benchmark for throughput)" << endl;
+	}
+
+	cout << (ok ? "OK" : "FAILED") << endl;
+
+	return ok ? 0 : 1;
+}
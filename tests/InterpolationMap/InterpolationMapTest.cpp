@@ -0,0 +1,179 @@
+// InterpolationMapTest.cpp : Checks CInterpolationMap against std::map and benchmarks insert, lookup, iteration and cursor walks against it.
+//
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <string.h>
+#include <shared/AfxMath.h>
+
+using namespace std;
+using namespace Afx::Math;
+
+// About the size of a CamPathValue.
+struct Value_s {
+	double V[8];
+};
+
+static Value_s MakeValue(double key) {
+	Value_s result;
+	for (int i = 0; i < 8; i++) result.V[i] = key + i;
+	return result;
+}
+
+static bool Same(const CInterpolationMap<Value_s>& a, const map<double, Value_s>& b) {
+	if (a.size() != b.size()) return false;
+
+	auto itB = b.begin();
+	for (auto itA = a.begin(); itA != a.end(); ++itA, ++itB) {
+		if (itA->first != itB->first || itA->second.V[0] != itB->second.V[0]) return false;
+	}
+
+	return true;
+}
+
+static bool TestAgainstMap() {
+	mt19937 random(1);
+	uniform_int_distribution<int> keys(0, 999);
+	CInterpolationMap<Value_s> interpolationMap;
+	map<double, Value_s> stdMap;
+
+	for (int i = 0; i < 20000; i++) {
+		double key = keys(random) / 4.0;
+		switch (random() % 5) {
+		case 0:
+		case 1:
+			interpolationMap[key] = MakeValue(key + i);
+			stdMap[key] = MakeValue(key + i);
+			break;
+		case 2:
+			interpolationMap.erase(key);
+			stdMap.erase(key);
+			break;
+		case 3: {
+			auto itA = interpolationMap.find(key);
+			auto itB = stdMap.find(key);
+			if ((itA == interpolationMap.end()) != (itB == stdMap.end()) || (itA != interpolationMap.end() && itA->second.V[0] != itB->second.V[0])) {
+				cout << "FAILED: find(" << key << ")" << endl;
+				return false;
+			}
+			break;
+		}
+		case 4: {
+			// Walk forward from the key, like playback does:
+			for (double t = key; t < key + 5; t += 0.1) {
+				auto itA = interpolationMap.cursor_upper_bound(t);
+				auto itB = stdMap.upper_bound(t);
+				if ((itA == interpolationMap.end()) != (itB == stdMap.end()) || (itA != interpolationMap.end() && itA->first != itB->first)
+					|| interpolationMap.upper_bound(t) != itA || interpolationMap.lower_bound(t) - interpolationMap.begin() != distance(stdMap.begin(), stdMap.lower_bound(t))) {
+					cout << "FAILED: cursor_upper_bound(" << t << ")" << endl;
+					return false;
+				}
+			}
+			break;
+		}
+		}
+
+		if (0 == i % 1000 && !Same(interpolationMap, stdMap)) {
+			cout << "FAILED: contents differ after " << i << " operations" << endl;
+			return false;
+		}
+	}
+
+	if (!Same(interpolationMap, stdMap)) {
+		cout << "FAILED: contents differ" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+template<class TFn> static double TimeMs(const TFn& fn, int repeat) {
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int i = 0; i < repeat; i++) fn();
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / repeat;
+}
+
+template<class TMap> static typename TMap::const_iterator CursorUpperBound(const TMap& m, double key);
+
+template<> CInterpolationMap<Value_s>::const_iterator CursorUpperBound(const CInterpolationMap<Value_s>& m, double key) {
+	return m.cursor_upper_bound(key);
+}
+
+template<> map<double, Value_s>::const_iterator CursorUpperBound(const map<double, Value_s>& m, double key) {
+	return m.upper_bound(key);
+}
+
+template<class TMap> static void Benchmark(const char* name, size_t count) {
+	vector<double> shuffled(count);
+	for (size_t i = 0; i < count; i++) shuffled[i] = (double)i;
+	shuffle(shuffled.begin(), shuffled.end(), mt19937(1));
+
+	volatile double sink = 0;
+
+	double insertOrdered = TimeMs([&]() {
+		TMap m;
+		for (size_t i = 0; i < count; i++) m[(double)i] = MakeValue((double)i);
+		sink = sink + m.size();
+	}, 10);
+
+	double insertRandom = TimeMs([&]() {
+		TMap m;
+		for (size_t i = 0; i < count; i++) m[shuffled[i]] = MakeValue(shuffled[i]);
+		sink = sink + m.size();
+	}, 10);
+
+	TMap m;
+	for (size_t i = 0; i < count; i++) m[(double)i] = MakeValue((double)i);
+	const TMap& cm = m;
+
+	double lookup = TimeMs([&]() {
+		double sum = 0;
+		for (size_t i = 0; i < count; i++) sum += cm.find(shuffled[i])->second.V[1];
+		sink = sink + sum;
+	}, 10);
+
+	double iterate = TimeMs([&]() {
+		double sum = 0;
+		for (auto it = cm.begin(); it != cm.end(); ++it) sum += it->second.V[1];
+		sink = sink + sum;
+	}, 100);
+
+	// 8 evaluations per key interval, front to back, like playback:
+	double walk = TimeMs([&]() {
+		double sum = 0;
+		for (double t = 0; t < count - 1; t += 0.125) sum += CursorUpperBound(cm, t)->first;
+		sink = sink + sum;
+	}, 10);
+
+	double seek = TimeMs([&]() {
+		double sum = 0;
+		for (size_t i = 0; i < count; i++) sum += CursorUpperBound(cm, shuffled[i] + 0.5)->first;
+		sink = sink + sum;
+	}, 10);
+
+	cout << name << " (" << count << " keys): insert ordered " << insertOrdered << " ms, insert random " << insertRandom << " ms, find " << lookup << " ms, iterate " << iterate << " ms, walk " << walk << " ms (" << 8 * count << " lookups), random seeks " << seek << " ms" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	bool ok = TestAgainstMap();
+
+	bool benchmark = 2 <= argc && 0 == strcmp(argv[1], "-benchmark");
+	if (benchmark) {
+		for (size_t count : { 1000, 20000 }) {
+			Benchmark<map<double, Value_s>>("std::map", count);
+			Benchmark<CInterpolationMap<Value_s>>("CInterpolationMap", count);
+		}
+	}
+	else {
+		cout << "(run with -benchmark for throughput)" << endl;
+	}
+
+	cout << (ok ? "OK" : "FAILED") << endl;
+
+	return ok ? 0 : 1;
+}
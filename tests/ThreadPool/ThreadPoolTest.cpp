@@ -0,0 +1,459 @@
+// ThreadPoolTest.cpp : Checks the work-stealing CThreadPool (task order, ParallelFor coverage, nesting, no foreign work in ParallelFor, CWaitGroup) and benchmarks it against the single queue pool it replaced.
+//
+
+#include <iostream>
+#include <chrono>
+#include <queue>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <string.h>
+#include <shared/ThreadPool.h>
+
+using namespace std;
+using namespace advancedfx;
+
+// The pool as it was before: one queue behind one mutex.
+class CQueueThreadPool {
+public:
+	class CTask {
+	public:
+		virtual ~CTask() {
+		}
+
+		virtual void Execute() = 0;
+	};
+
+	CQueueThreadPool(size_t thread_count) {
+		m_Threads.resize(thread_count);
+		for (size_t i = 0; i < m_Threads.size(); i++) {
+			m_Threads[i] = std::thread(&CQueueThreadPool::ThreadFunc, this);
+		}
+	}
+
+	~CQueueThreadPool() {
+		{
+			std::unique_lock<std::mutex> lock(m_QueueMutex);
+			m_Shutdown = true;
+			m_QueueCv.notify_all();
+		}
+		for (size_t i = 0; i < m_Threads.size(); i++) {
+			m_Threads[i].join();
+		}
+	}
+
+	void QueueTasks(const std::vector<class CTask*> & tasks) {
+		if (m_Threads.size() == 0) {
+			for (size_t i = 0; i < tasks.size(); i++) {
+				CTask* task = tasks[i];
+				task->Execute();
+				delete task;
+			}
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(m_QueueMutex);
+		for (size_t i = 0; i < tasks.size(); i++) {
+			m_Queue.push(tasks[i]);
+		}
+		m_QueueCv.notify_one();
+	}
+
+private:
+	std::mutex m_QueueMutex;
+	std::queue<CTask*> m_Queue;
+	std::condition_variable m_QueueCv;
+	bool m_Shutdown = false;
+
+	std::vector<std::thread> m_Threads;
+
+	void ThreadFunc() {
+		std::unique_lock<std::mutex> lock(m_QueueMutex);
+		while (!m_Shutdown || !m_Queue.empty()) {
+			if (!m_Queue.empty()) {
+				CTask* task = m_Queue.front();
+				m_Queue.pop();
+				if (!m_Queue.empty()) m_QueueCv.notify_one();
+				lock.unlock();
+				task->Execute();
+				delete task;
+				lock.lock();
+			}
+			else {
+				m_QueueCv.wait(lock);
+			}
+		}
+	}
+};
+
+class CRecordTask : public CThreadPool::CTask {
+public:
+	CRecordTask(vector<int>& record, int value, CWaitGroup& waitGroup)
+		: m_Record(record)
+		, m_Value(value)
+		, m_WaitGroup(waitGroup)
+	{
+	}
+
+	virtual void Execute() override {
+		m_Record.push_back(m_Value);
+		m_WaitGroup.Done();
+	}
+
+private:
+	vector<int>& m_Record;
+	int m_Value;
+	CWaitGroup& m_WaitGroup;
+};
+
+class CCountTask : public CThreadPool::CTask {
+public:
+	CCountTask(atomic_int& count, CWaitGroup* waitGroup)
+		: m_Count(count)
+		, m_WaitGroup(waitGroup)
+	{
+	}
+
+	virtual void Execute() override {
+		m_Count++;
+		if (m_WaitGroup) m_WaitGroup->Done();
+	}
+
+private:
+	atomic_int& m_Count;
+	CWaitGroup* m_WaitGroup;
+};
+
+// Queues more tasks from a worker.
+class CSpawnTask : public CThreadPool::CTask {
+public:
+	CSpawnTask(CThreadPool& pool, atomic_int& count, CWaitGroup& waitGroup, int depth)
+		: m_Pool(pool)
+		, m_Count(count)
+		, m_WaitGroup(waitGroup)
+		, m_Depth(depth)
+	{
+	}
+
+	virtual void Execute() override {
+		m_Count++;
+		if (0 < m_Depth) {
+			m_WaitGroup.Add(2);
+			m_Pool.QueueTask(new CSpawnTask(m_Pool, m_Count, m_WaitGroup, m_Depth - 1));
+			m_Pool.QueueTask(new CSpawnTask(m_Pool, m_Count, m_WaitGroup, m_Depth - 1));
+		}
+		m_WaitGroup.Done();
+	}
+
+private:
+	CThreadPool& m_Pool;
+	atomic_int& m_Count;
+	CWaitGroup& m_WaitGroup;
+	int m_Depth;
+};
+
+static bool TestOrder() {
+	// CAfxGameRecord relies on a pool with 1 thread running the tasks in order.
+	CThreadPool pool(1);
+	vector<int> record;
+	CWaitGroup waitGroup;
+
+	waitGroup.Add(1000);
+	for (int i = 0; i < 500; i++) pool.QueueTask(new CRecordTask(record, i, waitGroup));
+	vector<CThreadPool::CTask*> tasks;
+	for (int i = 500; i < 1000; i++) tasks.push_back(new CRecordTask(record, i, waitGroup));
+	pool.QueueTasks(tasks);
+	waitGroup.Wait();
+
+	for (int i = 0; i < 1000; i++) {
+		if (record[i] != i) {
+			cout << "FAILED: order: " << record[i] << " at " << i << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool TestTasks(size_t threads) {
+	atomic_int count(0);
+
+	{
+		// The destructor runs the remaining tasks:
+		CThreadPool pool(threads);
+		vector<CThreadPool::CTask*> tasks;
+		for (int i = 0; i < 10000; i++) tasks.push_back(new CCountTask(count, nullptr));
+		pool.QueueTasks(tasks);
+	}
+
+	if (10000 != count) {
+		cout << "FAILED: tasks (" << threads << " threads): " << count << " instead of 10000 executed" << endl;
+		return false;
+	}
+
+	count = 0;
+	CThreadPool pool(threads);
+	CWaitGroup waitGroup;
+	waitGroup.Add(1);
+	pool.QueueTask(new CSpawnTask(pool, count, waitGroup, 10));
+	waitGroup.Wait();
+
+	if ((1 << 11) - 1 != count) {
+		cout << "FAILED: tasks queued by tasks (" << threads << " threads): " << count << " instead of " << (1 << 11) - 1 << " executed" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+static bool TestParallelFor(size_t threads) {
+	CThreadPool pool(threads);
+
+	const size_t counts[] = { 0, 1, 2, 15, 16, 17, 1000, 2160 };
+	const size_t grains[] = { 0, 1, 7, 16, 5000 };
+
+	for (size_t count : counts) {
+		for (size_t grain : grains) {
+			vector<atomic_int> hits(count);
+			for (size_t i = 0; i < count; i++) hits[i] = 0;
+			atomic_int calls(0);
+			bool chunksOk = true;
+
+			pool.ParallelFor(count, grain, [&](size_t first, size_t num) {
+				calls++;
+				if (0 == num || count < first + num || (1 < grain && grain < num)) chunksOk = false;
+				for (size_t i = first; i < first + num; i++) hits[i]++;
+			});
+
+			bool ok = chunksOk;
+			for (size_t i = 0; i < count; i++) ok = ok && 1 == hits[i];
+			if (!ok) {
+				cout << "FAILED: ParallelFor(" << count << ", " << grain << ") (" << threads << " threads)" << endl;
+				return false;
+			}
+		}
+	}
+
+	// Nested, from the workers too, more than there are threads:
+	vector<atomic_int> hits(64 * 64);
+	for (size_t i = 0; i < hits.size(); i++) hits[i] = 0;
+	pool.ParallelFor(64, 1, [&](size_t first, size_t num) {
+		for (size_t y = first; y < first + num; y++) {
+			pool.ParallelFor(64, 3, [&](size_t firstX, size_t numX) {
+				for (size_t x = firstX; x < firstX + numX; x++) hits[y * 64 + x]++;
+			});
+		}
+	});
+	for (size_t i = 0; i < hits.size(); i++) {
+		if (1 != hits[i]) {
+			cout << "FAILED: nested ParallelFor (" << threads << " threads)" << endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+class CBlockTask : public CThreadPool::CTask {
+public:
+	CBlockTask(atomic_bool& started, atomic_bool& release)
+		: m_Started(started)
+		, m_Release(release)
+	{
+	}
+
+	virtual void Execute() override {
+		m_Started = true;
+		while (!m_Release) this_thread::yield();
+	}
+
+private:
+	atomic_bool& m_Started;
+	atomic_bool& m_Release;
+};
+
+class CThreadIdTask : public CThreadPool::CTask {
+public:
+	CThreadIdTask(thread::id& threadId, CWaitGroup& waitGroup)
+		: m_ThreadId(threadId)
+		, m_WaitGroup(waitGroup)
+	{
+	}
+
+	virtual void Execute() override {
+		m_ThreadId = this_thread::get_id();
+		m_WaitGroup.Done();
+	}
+
+private:
+	thread::id& m_ThreadId;
+	CWaitGroup& m_WaitGroup;
+};
+
+static bool TestParallelForOwnWorkOnly() {
+	// The only worker is blocked, so ParallelFor does all chunks itself and must not run the other queued task meanwhile:
+	CThreadPool pool(1);
+	atomic_bool started(false);
+	atomic_bool release(false);
+	thread::id threadId;
+	CWaitGroup waitGroup;
+
+	pool.QueueTask(new CBlockTask(started, release));
+	while (!started) this_thread::yield();
+	waitGroup.Add(1);
+	pool.QueueTask(new CThreadIdTask(threadId, waitGroup));
+
+	atomic_int calls(0);
+	pool.ParallelFor(16, 1, [&](size_t, size_t) {
+		calls++;
+	});
+
+	release = true;
+	waitGroup.Wait();
+
+	if (16 != calls || this_thread::get_id() == threadId) {
+		cout << "FAILED: ParallelFor ran " << calls << " chunks" << (this_thread::get_id() == threadId ? " and a foreign task" : "") << endl;
+		return false;
+	}
+
+	return true;
+}
+
+static bool TestWaitGroup() {
+	CThreadPool pool(3);
+	atomic_int count(0);
+
+	for (int round = 0; round < 1000; round++) {
+		CWaitGroup waitGroup;
+		waitGroup.Add(4);
+		for (int i = 0; i < 4; i++) pool.QueueTask(new CCountTask(count, &waitGroup));
+		waitGroup.Wait();
+
+		if (4 * (round + 1) != count) {
+			cout << "FAILED: CWaitGroup: " << count << " done after round " << round << endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// A row of the work, roughly what ImageTransformer does with a BGRA 3840 pixels row.
+static void Row(const unsigned char* in, unsigned char* out, size_t width) {
+	for (size_t x = 0; x < width; x++) {
+		out[3 * x + 0] = in[4 * x + 2];
+		out[3 * x + 1] = in[4 * x + 1];
+		out[3 * x + 2] = in[4 * x + 0];
+	}
+}
+
+class CQueueRowTask : public CQueueThreadPool::CTask {
+public:
+	CQueueRowTask(atomic_int& task_counter, const unsigned char* in, unsigned char* out, size_t width)
+		: task_counter(task_counter)
+		, in(in)
+		, out(out)
+		, width(width)
+	{
+		task_counter++;
+	}
+
+	virtual ~CQueueRowTask() {
+		task_counter--;
+	}
+
+	virtual void Execute() override {
+		Row(in, out, width);
+	}
+
+private:
+	atomic_int& task_counter;
+	const unsigned char* in;
+	unsigned char* out;
+	size_t width;
+};
+
+static void Benchmark() {
+	const size_t width = 3840;
+	const size_t height = 2160;
+	const int frames = 50;
+	size_t threads = CThreadPool::GetDefaultThreadCount();
+	if (threads < 3) threads = 3; // Still shows the queueing overhead on small machines.
+
+	vector<unsigned char> in(width * height * 4, 1);
+	vector<unsigned char> out(width * height * 3);
+
+	for (int pass = 0; pass < 2; pass++) {
+		CQueueThreadPool queuePool(threads);
+		CThreadPool pool(threads);
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; frame++) {
+			if (0 == pass) {
+				// One heap allocated task per row, spin on the counter:
+				atomic_int task_counter(0);
+				vector<CQueueThreadPool::CTask*> tasks(height);
+				for (size_t y = 0; y < height; y++) tasks[y] = new CQueueRowTask(task_counter, &in[y * width * 4], &out[y * width * 3], width);
+				queuePool.QueueTasks(tasks);
+				while (0 < task_counter) {}
+			}
+			else {
+				pool.ParallelFor(height, 16, [&](size_t first, size_t num) {
+					for (size_t y = first; y < first + num; y++) Row(&in[y * width * 4], &out[y * width * 3], width);
+				});
+			}
+		}
+		double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / frames;
+		cout << (0 == pass ? "single queue, task per row: " : "work-stealing, ParallelFor: ") << ms << " ms per frame (" << width << "x" << height << ", " << threads << " threads)" << endl;
+	}
+
+	// Overhead only, many small parallel loops:
+	for (int pass = 0; pass < 2; pass++) {
+		CQueueThreadPool queuePool(threads);
+		CThreadPool pool(threads);
+		atomic_int count(0);
+		const int loops = 2000;
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int loop = 0; loop < loops; loop++) {
+			if (0 == pass) {
+				atomic_int task_counter(0);
+				vector<CQueueThreadPool::CTask*> tasks(64);
+				for (size_t i = 0; i < tasks.size(); i++) tasks[i] = new CQueueRowTask(task_counter, &in[0], &out[0], 1);
+				queuePool.QueueTasks(tasks);
+				while (0 < task_counter) {}
+			}
+			else {
+				pool.ParallelFor(64, 1, [&](size_t, size_t) {
+					Row(&in[0], &out[0], 1);
+				});
+			}
+		}
+		double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / loops;
+		cout << (0 == pass ? "single queue, 64 tasks: " : "work-stealing, ParallelFor(64, 1): ") << us << " us per loop" << endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	bool ok = true;
+
+	ok = TestOrder() && ok;
+	for (size_t threads : { 0, 1, 3, 8 }) {
+		ok = TestTasks(threads) && ok;
+		ok = TestParallelFor(threads) && ok;
+	}
+	ok = TestParallelForOwnWorkOnly() && ok;
+	ok = TestWaitGroup() && ok;
+
+	bool benchmark = 2 <= argc && 0 == strcmp(argv[1], "-benchmark");
+	if (benchmark) {
+		Benchmark();
+	}
+	else {
+		cout << "(run with -benchmark for throughput)" << endl;
+	}
+
+	cout << (ok ? "OK" : "FAILED") << endl;
+
+	return ok ? 0 : 1;
+}
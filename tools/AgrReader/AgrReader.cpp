@@ -0,0 +1,593 @@
+#include "AgrReader.h"
+
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace advancedfx {
+
+static char const c_UnexpectedEnd[] = "Unexpected end of data.";
+
+static void AgrReader_ToMatrix(double x, double y, double z, double w, double px, double py, double pz, float * outMatrix)
+{
+	outMatrix[0] = (float)(1 - 2 * (y * y + z * z));
+	outMatrix[1] = (float)(2 * (x * y - z * w));
+	outMatrix[2] = (float)(2 * (x * z + y * w));
+	outMatrix[3] = (float)px;
+
+	outMatrix[4] = (float)(2 * (x * y + z * w));
+	outMatrix[5] = (float)(1 - 2 * (x * x + z * z));
+	outMatrix[6] = (float)(2 * (y * z - x * w));
+	outMatrix[7] = (float)py;
+
+	outMatrix[8] = (float)(2 * (x * z - y * w));
+	outMatrix[9] = (float)(2 * (y * z + x * w));
+	outMatrix[10] = (float)(1 - 2 * (x * x + y * y));
+	outMatrix[11] = (float)pz;
+}
+
+CAgrReader::CAgrReader()
+#ifdef _WIN32
+: m_FileHandle(INVALID_HANDLE_VALUE)
+, m_MappingHandle(NULL)
+#else
+: m_FileHandle(-1)
+#endif
+, m_Data(nullptr)
+, m_Size(0)
+{
+	Close();
+}
+
+CAgrReader::~CAgrReader()
+{
+	Close();
+}
+
+bool CAgrReader::Open(char const * fileName)
+{
+	Close();
+
+#ifdef _WIN32
+	m_FileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (INVALID_HANDLE_VALUE == m_FileHandle) return Fail("Could not open file.");
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_FileHandle, &size)) return Fail("Could not get file size.");
+	m_Size = (size_t)size.QuadPart;
+
+	if (m_Size) {
+		m_MappingHandle = CreateFileMappingA(m_FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (NULL == m_MappingHandle) return Fail("Could not map file.");
+
+		m_Data = (unsigned char const *)MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (nullptr == m_Data) return Fail("Could not map file.");
+	}
+#else
+	m_FileHandle = open(fileName, O_RDONLY);
+	if (-1 == m_FileHandle) return Fail("Could not open file.");
+
+	struct stat st;
+	if (0 != fstat(m_FileHandle, &st)) return Fail("Could not get file size.");
+	m_Size = (size_t)st.st_size;
+
+	if (m_Size) {
+		void * data = mmap(nullptr, m_Size, PROT_READ, MAP_SHARED, m_FileHandle, 0);
+		if (MAP_FAILED == data) return Fail("Could not map file.");
+		m_Data = (unsigned char const *)data;
+	}
+#endif
+
+	if (!ReadHeader()) return false;
+
+	if (m_Compact && ReadFooter()) {
+		m_HasFooter = true;
+	} else {
+		m_Error.clear();
+		if (!Scan()) return false;
+	}
+
+	return true;
+}
+
+void CAgrReader::Close()
+{
+#ifdef _WIN32
+	if (m_Data) UnmapViewOfFile(m_Data);
+	if (NULL != m_MappingHandle) CloseHandle(m_MappingHandle);
+	if (INVALID_HANDLE_VALUE != m_FileHandle) CloseHandle(m_FileHandle);
+	m_MappingHandle = NULL;
+	m_FileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (m_Data) munmap((void *)m_Data, m_Size);
+	if (-1 != m_FileHandle) close(m_FileHandle);
+	m_FileHandle = -1;
+#endif
+	m_Data = nullptr;
+	m_Size = 0;
+
+	m_HeaderSize = 0;
+	m_Version = 0;
+	m_HasFooter = false;
+	m_Compact = false;
+	m_PositionStep = 1;
+	m_RotationBits = 0;
+	m_KeyFrameInterval = 1;
+
+	m_Dictionary.clear();
+	m_DictionaryKeys.clear();
+	m_FrameOffsets.clear();
+	m_FramesEnd = 0;
+
+	m_Pos = nullptr;
+	m_End = nullptr;
+	m_Scanning = false;
+
+	m_Frame = -1;
+	m_FrameTime = 0;
+
+	memset(&m_Entity, 0, sizeof(m_Entity));
+	m_Bones = nullptr;
+	m_EntityBones = nullptr;
+	m_Deleted = 0;
+	m_Hidden.clear();
+	memset(&m_Cam, 0, sizeof(m_Cam));
+
+	m_States.clear();
+}
+
+bool CAgrReader::Fail(char const * error)
+{
+	m_Error = error;
+	return false;
+}
+
+bool CAgrReader::ReadHeader()
+{
+	m_Pos = m_Data;
+	m_End = m_Data + m_Size;
+
+	char const * magic;
+	if (!ReadString(&magic)) return Fail("Invalid header.");
+
+	if (0 == strcmp(magic, "afxGameRecord2")) m_Compact = true;
+	else if (0 != strcmp(magic, "afxGameRecord")) return Fail("Not an afxGameRecord file.");
+
+	if (!Read(m_Version)) return Fail("Invalid header.");
+
+	if (m_Compact) {
+		if (!Read(m_PositionStep) || !Read(m_RotationBits) || !Read(m_KeyFrameInterval)) return Fail("Invalid header.");
+		if (!(0 < m_PositionStep) || m_RotationBits < 2 || 30 < m_RotationBits || m_KeyFrameInterval < 1) return Fail("Invalid compact settings.");
+	}
+
+	m_HeaderSize = m_Pos - m_Data;
+
+	return true;
+}
+
+bool CAgrReader::ReadFooter()
+{
+	uint64_t footerOffset;
+	size_t headerSize = m_HeaderSize;
+
+	if (m_Size < headerSize + sizeof(footerOffset) + 8 || 0 != memcmp(m_Data + m_Size - 8, "afxFoot", 8)) return false;
+	memcpy(&footerOffset, m_Data + m_Size - 8 - sizeof(footerOffset), sizeof(footerOffset));
+	if (footerOffset < headerSize || m_Size - 8 - sizeof(footerOffset) < footerOffset) return Fail("Invalid footer offset.");
+
+	m_Pos = m_Data + footerOffset;
+	m_End = m_Data + m_Size - 8 - sizeof(footerOffset);
+
+	int keyIndex;
+	if (!Read(keyIndex)) return false;
+	if (-1 == keyIndex) {
+		char const * key;
+		if (!ReadString(&key)) return false;
+		if (0 != strcmp(key, "afxFooter")) return Fail("Invalid footer.");
+	}
+
+	int frameCount;
+	if (!Read(frameCount) || frameCount < 0 || (size_t)(m_End - m_Pos) / sizeof(uint64_t) < (size_t)frameCount) return Fail("Invalid footer.");
+	m_FrameOffsets.resize(frameCount);
+	if (!ReadBytes(m_FrameOffsets.data(), m_FrameOffsets.size() * sizeof(uint64_t))) return false;
+
+	for (size_t i = 0; i < m_FrameOffsets.size(); ++i) {
+		if (m_FrameOffsets[i] < headerSize || footerOffset <= m_FrameOffsets[i] || (0 < i && m_FrameOffsets[i] <= m_FrameOffsets[i - 1])) return Fail("Invalid frame offset in footer.");
+	}
+
+	int dictionaryCount;
+	if (!Read(dictionaryCount) || dictionaryCount < 0) return Fail("Invalid footer.");
+	for (int i = 0; i < dictionaryCount; ++i) {
+		char const * value;
+		if (!ReadString(&value)) return false;
+		m_Dictionary.emplace_back(value);
+		m_DictionaryKeys.push_back(ToKey(value));
+	}
+
+	if (0 <= keyIndex && (dictionaryCount <= keyIndex || Key_Footer != m_DictionaryKeys[keyIndex])) return Fail("Invalid footer.");
+
+	m_FramesEnd = footerOffset;
+
+	return true;
+}
+
+bool CAgrReader::Scan()
+{
+	m_Dictionary.clear();
+	m_DictionaryKeys.clear();
+	m_FrameOffsets.clear();
+
+	m_Pos = m_Data + m_HeaderSize;
+	m_End = m_Data + m_Size;
+	m_Scanning = true;
+
+	unsigned char const * pos = m_Pos;
+	bool ok = true;
+
+	while (ok && m_Pos < m_End) {
+		Key_e key;
+		ok = ReadKey(key);
+		if (!ok) break;
+
+		if (Key_Frame == key) {
+			float frameTime;
+			int hiddenOffset;
+			ok = Read(frameTime) && Read(hiddenOffset);
+			if (ok) m_FrameOffsets.push_back(pos - m_Data);
+		}
+		else if (Key_Footer == key) {
+			// Footer without (valid) trailer, the file was probably cut.
+			break;
+		}
+		else if (Key_FrameEnd != key) {
+			Element_e element;
+			ok = ReadElement(key, element);
+		}
+
+		if (ok) pos = m_Pos;
+	}
+
+	m_Scanning = false;
+
+	if (!ok && m_Error != c_UnexpectedEnd) return false;
+
+	// Everything after the last complete element is ignored, recording might not have been ended properly:
+	m_FramesEnd = pos - m_Data;
+	m_Error.clear();
+
+	return true;
+}
+
+bool CAgrReader::SeekFrame(int frame)
+{
+	if (frame < 0 || GetFrameCount() <= frame) return Fail("Frame out of range.");
+
+	int first = frame;
+
+	if (m_Compact) {
+		first = frame - frame % m_KeyFrameInterval;
+
+		if (first <= m_Frame && m_Frame < frame) {
+			// Continue from the current frame.
+			if (!SkipFrame()) return false;
+			first = m_Frame + 1;
+		}
+
+		for (int i = first; i < frame; ++i) {
+			if (!BeginFrame(i) || !SkipFrame()) return false;
+		}
+	}
+
+	return BeginFrame(frame);
+}
+
+bool CAgrReader::BeginFrame(int frame)
+{
+	m_Frame = -1;
+	m_Pos = m_Data + m_FrameOffsets[frame];
+	m_End = m_Data + (frame + 1 < GetFrameCount() ? m_FrameOffsets[frame + 1] : m_FramesEnd);
+
+	// The first frame is a key frame too, so any state from before is cleared.
+	if (m_Compact && 0 == frame % m_KeyFrameInterval) m_States.clear();
+
+	Key_e key;
+	int hiddenOffset;
+	if (!ReadKey(key) || Key_Frame != key || !Read(m_FrameTime) || !Read(hiddenOffset)) return Fail("Invalid frame.");
+
+	m_Frame = frame;
+
+	return true;
+}
+
+bool CAgrReader::SkipFrame()
+{
+	Element_e element;
+	while (NextElement(element));
+
+	return m_Pos == m_End;
+}
+
+bool CAgrReader::NextElement(Element_e & outElement)
+{
+	while (m_Pos < m_End) {
+		Key_e key;
+		if (!ReadKey(key)) return false;
+
+		if (Key_FrameEnd == key) continue;
+
+		return ReadElement(key, outElement);
+	}
+
+	return false;
+}
+
+bool CAgrReader::ReadElement(Key_e key, Element_e & outElement)
+{
+	switch (key) {
+	case Key_Entity:
+		outElement = Element_Entity;
+		return ReadEntity();
+	case Key_Deleted:
+		outElement = Element_Deleted;
+		if (!Read(m_Deleted)) return false;
+		m_States.erase(m_Deleted);
+		return true;
+	case Key_Hidden:
+		{
+			outElement = Element_Hidden;
+			int count;
+			if (!Read(count) || count < 0 || (size_t)(m_End - m_Pos) / sizeof(int) < (size_t)count) return Fail("Invalid afxHidden.");
+			m_Hidden.resize(count);
+			if (!ReadBytes(m_Hidden.data(), m_Hidden.size() * sizeof(int))) return false;
+			for (size_t i = 0; i < m_Hidden.size(); ++i) m_States.erase(m_Hidden[i]);
+		}
+		return true;
+	case Key_Cam:
+		outElement = Element_Cam;
+		return ReadFloats(m_Cam.Origin, 3) && ReadFloats(m_Cam.Angles, 3) && Read(m_Cam.Fov);
+	default:
+		break;
+	}
+
+	return Fail("Unknown element.");
+}
+
+bool CAgrReader::ReadEntity()
+{
+	memset(&m_Entity, 0, sizeof(m_Entity));
+	m_Bones = nullptr;
+	m_EntityBones = nullptr;
+
+	if (!Read(m_Entity.Handle)) return false;
+
+	while (true) {
+		Key_e key;
+		if (!ReadKey(key)) return false;
+
+		switch (key) {
+		case Key_BaseEntity:
+			{
+				m_Entity.HasBaseEntity = true;
+				Key_e modelKey;
+				if (!ReadKey(modelKey, &m_Entity.Model) || !ReadBool(m_Entity.Visible) || !ReadFloats(&m_Entity.Transform[0][0], 12)) return false;
+			}
+			break;
+		case Key_BaseAnimating:
+			{
+				m_Entity.HasBaseAnimating = true;
+				bool hasBones;
+				if (!ReadBool(hasBones)) return false;
+				if (hasBones && !ReadBones()) return false;
+			}
+			break;
+		case Key_Camera:
+			m_Entity.HasCamera = true;
+			if (!ReadBool(m_Entity.ThirdPerson) || !ReadFloats(m_Entity.Origin, 3) || !ReadFloats(m_Entity.Angles, 3) || !Read(m_Entity.Fov)) return false;
+			break;
+		case Key_End:
+			return ReadBool(m_Entity.ViewModel);
+		default:
+			return Fail("Unknown entity_state element.");
+		}
+	}
+}
+
+bool CAgrReader::ReadBones()
+{
+	int count;
+	if (!Read(count) || count < 0) return Fail("Invalid bone count.");
+
+	if (!m_Compact) {
+		if ((size_t)(m_End - m_Pos) / (12 * sizeof(float)) < (size_t)count) return Fail(c_UnexpectedEnd);
+		m_Bones = m_Pos;
+		m_Pos += (size_t)count * 12 * sizeof(float);
+		m_Entity.BoneCount = count;
+		return true;
+	}
+
+	if ((size_t)(m_End - m_Pos) < (size_t)count) return Fail(c_UnexpectedEnd);
+
+	std::vector<int> * pBones = nullptr;
+
+	if (!m_Scanning) {
+		pBones = &m_States[m_Entity.Handle];
+		if (pBones->size() != (size_t)count * c_BoneValues) pBones->assign((size_t)count * c_BoneValues, 0);
+	}
+
+	for (int i = 0; i < count; ++i) {
+		unsigned char flags;
+		if (!Read(flags)) return false;
+
+		int * values = pBones ? &(*pBones)[(size_t)i * c_BoneValues] : nullptr;
+		if (values) values[3] = flags & 3;
+
+		for (int j = 0; j < 6; ++j) {
+			if (flags & (1 << (2 + j))) {
+				int delta;
+				if (!ReadVarInt(delta)) return false;
+				if (values) {
+					int index = j < 3 ? j : j + 1;
+					values[index] = (int)((unsigned int)values[index] + (unsigned int)delta);
+				}
+			}
+		}
+	}
+
+	m_EntityBones = pBones;
+	m_Entity.BoneCount = count;
+
+	return true;
+}
+
+bool CAgrReader::GetBones(std::vector<float> & outBones) const
+{
+	outBones.resize((size_t)m_Entity.BoneCount * 12);
+
+	if (!m_Compact) {
+		if (m_Entity.BoneCount) memcpy(outBones.data(), m_Bones, outBones.size() * sizeof(float));
+		return true;
+	}
+
+	if (nullptr == m_EntityBones || m_EntityBones->size() != (size_t)m_Entity.BoneCount * c_BoneValues) return false;
+
+	double rotationScale = 1.0 / (sqrt(2.0) * ((1 << (m_RotationBits - 1)) - 1));
+
+	for (int i = 0; i < m_Entity.BoneCount; ++i) {
+		int const * values = &(*m_EntityBones)[(size_t)i * c_BoneValues];
+
+		double q[4];
+		double sum = 0;
+		for (int j = 0, k = 4; j < 4; ++j) {
+			if (j == values[3]) continue;
+			q[j] = values[k++] * rotationScale;
+			sum += q[j] * q[j];
+		}
+		q[values[3]] = sqrt(sum < 1 ? 1 - sum : 0);
+
+		AgrReader_ToMatrix(q[0], q[1], q[2], q[3],
+			values[0] * (double)m_PositionStep, values[1] * (double)m_PositionStep, values[2] * (double)m_PositionStep,
+			&outBones[(size_t)i * 12]);
+	}
+
+	return true;
+}
+
+bool CAgrReader::ReadKey(Key_e & outKey, char const ** outString)
+{
+	int index;
+	if (!Read(index)) return false;
+
+	if (-1 == index) {
+		char const * value;
+		if (!ReadString(&value)) return false;
+
+		if (m_Scanning) {
+			// Only the scan builds the dictionary, otherwise it's known from the footer / scan already.
+			m_Dictionary.emplace_back(value);
+			m_DictionaryKeys.push_back(ToKey(value));
+			outKey = m_DictionaryKeys.back();
+		}
+		else outKey = ToKey(value);
+
+		if (outString) *outString = value;
+		return true;
+	}
+
+	if (index < 0 || (int)m_Dictionary.size() <= index) return Fail("Invalid dictionary index.");
+
+	outKey = m_DictionaryKeys[index];
+	if (outString) *outString = m_Dictionary[index].c_str();
+
+	return true;
+}
+
+bool CAgrReader::ReadString(char const ** outString)
+{
+	unsigned char const * end = (unsigned char const *)memchr(m_Pos, 0, m_End - m_Pos);
+	if (nullptr == end) return Fail(c_UnexpectedEnd);
+
+	*outString = (char const *)m_Pos;
+	m_Pos = end + 1;
+
+	return true;
+}
+
+bool CAgrReader::ReadBytes(void * outData, size_t size)
+{
+	if ((size_t)(m_End - m_Pos) < size) return Fail(c_UnexpectedEnd);
+
+	memcpy(outData, m_Pos, size);
+	m_Pos += size;
+
+	return true;
+}
+
+bool CAgrReader::ReadVarInt(int & outValue)
+{
+	unsigned int value = 0;
+
+	for (int shift = 0; shift < 35; shift += 7) {
+		if (m_End <= m_Pos) return Fail(c_UnexpectedEnd);
+
+		unsigned char byte = *m_Pos++;
+		value |= (unsigned int)(byte & 0x7f) << shift;
+
+		if (0 == (byte & 0x80)) {
+			// zig-zag:
+			outValue = (int)((value >> 1) ^ (0u - (value & 1)));
+			return true;
+		}
+	}
+
+	return Fail("Invalid varint.");
+}
+
+bool CAgrReader::ReadBool(bool & outValue)
+{
+	unsigned char value;
+	if (!Read(value)) return false;
+
+	outValue = 0 != value;
+
+	return true;
+}
+
+bool CAgrReader::ReadFloats(float * outValues, size_t count)
+{
+	return ReadBytes(outValues, count * sizeof(float));
+}
+
+CAgrReader::Key_e CAgrReader::ToKey(char const * value)
+{
+	static const struct {
+		char const * Value;
+		Key_e Key;
+	} keys[] = {
+		{ "afxFrame", Key_Frame },
+		{ "afxFrameEnd", Key_FrameEnd },
+		{ "afxFooter", Key_Footer },
+		{ "entity_state", Key_Entity },
+		{ "deleted", Key_Deleted },
+		{ "afxHidden", Key_Hidden },
+		{ "afxCam", Key_Cam },
+		{ "baseentity", Key_BaseEntity },
+		{ "baseanimating", Key_BaseAnimating },
+		{ "camera", Key_Camera },
+		{ "/", Key_End }
+	};
+
+	for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i) {
+		if (0 == strcmp(keys[i].Value, value)) return keys[i].Key;
+	}
+
+	return Key_Unknown;
+}
+
+} // namespace advancedfx
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace advancedfx {
+
+/// <summary>Reads afxGameRecord / afxGameRecord2 files (format see shared/AfxGameRecord.cpp).</summary>
+/// <remarks>
+/// The file is memory mapped. Files with a footer are opened without touching the frames,
+/// others are scanned once on Open to find the frames and build the dictionary.<br />
+/// Compact files leave out unchanged entity states, consumers keep the last state then.
+/// </remarks>
+class CAgrReader
+{
+public:
+	enum Element_e {
+		Element_Entity,
+		Element_Deleted,
+		Element_Hidden,
+		Element_Cam
+	};
+
+	struct Entity_s {
+		int Handle;
+
+		bool HasBaseEntity;
+		char const * Model;
+		bool Visible;
+		float Transform[3][4];
+
+		bool HasBaseAnimating;
+		/// <summary>0 if no bones, see GetBones.</summary>
+		int BoneCount;
+
+		bool HasCamera;
+		bool ThirdPerson;
+		float Origin[3];
+		float Angles[3];
+		float Fov;
+
+		bool ViewModel;
+	};
+
+	struct Cam_s {
+		float Origin[3];
+		float Angles[3];
+		float Fov;
+	};
+
+	CAgrReader();
+	~CAgrReader();
+
+	bool Open(char const * fileName);
+	void Close();
+
+	/// <returns>Description of the last error.</returns>
+	char const * GetError() const { return m_Error.c_str(); }
+
+	size_t GetFileSize() const { return m_Size; }
+	int GetVersion() const { return m_Version; }
+	bool GetHasFooter() const { return m_HasFooter; }
+
+	bool GetCompact() const { return m_Compact; }
+	float GetPositionStep() const { return m_PositionStep; }
+	int GetRotationBits() const { return m_RotationBits; }
+	int GetKeyFrameInterval() const { return m_KeyFrameInterval; }
+
+	int GetFrameCount() const { return (int)m_FrameOffsets.size(); }
+	std::vector<std::string> const & GetDictionary() const { return m_Dictionary; }
+
+	/// <summary>Moves to the start of a frame, NextElement returns its elements then.</summary>
+	/// <remarks>Compact files: decodes from the key frame before on (unless it can continue from the current frame).</remarks>
+	bool SeekFrame(int frame);
+
+	bool NextFrame() { return SeekFrame(m_Frame + 1); }
+
+	/// <returns>Current frame or -1.</returns>
+	int GetFrame() const { return m_Frame; }
+	float GetFrameTime() const { return m_FrameTime; }
+
+	/// <summary>Moves to the next element of the current frame.</summary>
+	/// <returns>false at the end of the frame or on error (see GetError).</returns>
+	bool NextElement(Element_e & outElement);
+
+	/// <remarks>Valid if the current element is Element_Entity.</remarks>
+	Entity_s const & GetEntity() const { return m_Entity; }
+
+	/// <summary>Decodes the current entity's bones.</summary>
+	/// <param name="outBones">BoneCount 3x4 matrices (12 floats each), relative to the parent bone.</param>
+	bool GetBones(std::vector<float> & outBones) const;
+
+	/// <remarks>Valid if the current element is Element_Deleted.</remarks>
+	int GetDeleted() const { return m_Deleted; }
+
+	/// <remarks>Valid if the current element is Element_Hidden.</remarks>
+	std::vector<int> const & GetHidden() const { return m_Hidden; }
+
+	/// <remarks>Valid if the current element is Element_Cam.</remarks>
+	Cam_s const & GetCam() const { return m_Cam; }
+
+private:
+	enum Key_e {
+		Key_Unknown,
+		Key_Frame,
+		Key_FrameEnd,
+		Key_Footer,
+		Key_Entity,
+		Key_Deleted,
+		Key_Hidden,
+		Key_Cam,
+		Key_BaseEntity,
+		Key_BaseAnimating,
+		Key_Camera,
+		Key_End
+	};
+
+	static const int c_BoneValues = 7;
+
+	std::string m_Error;
+
+#ifdef _WIN32
+	void * m_FileHandle;
+	void * m_MappingHandle;
+#else
+	int m_FileHandle;
+#endif
+	unsigned char const * m_Data;
+	size_t m_Size;
+
+	size_t m_HeaderSize;
+	int m_Version;
+	bool m_HasFooter;
+	bool m_Compact;
+	float m_PositionStep;
+	int m_RotationBits;
+	int m_KeyFrameInterval;
+
+	std::vector<std::string> m_Dictionary;
+	std::vector<Key_e> m_DictionaryKeys;
+	std::vector<uint64_t> m_FrameOffsets;
+	uint64_t m_FramesEnd;
+
+	unsigned char const * m_Pos;
+	unsigned char const * m_End;
+	bool m_Scanning;
+
+	int m_Frame;
+	float m_FrameTime;
+
+	Entity_s m_Entity;
+	unsigned char const * m_Bones;
+	std::vector<int> * m_EntityBones;
+	int m_Deleted;
+	std::vector<int> m_Hidden;
+	Cam_s m_Cam;
+
+	// Compact encoding: quantized bones per entity, c_BoneValues per bone.
+	std::map<int, std::vector<int>> m_States;
+
+	bool Fail(char const * error);
+
+	bool ReadHeader();
+	bool ReadFooter();
+	bool Scan();
+
+	bool BeginFrame(int frame);
+	bool SkipFrame();
+
+	bool ReadElement(Key_e key, Element_e & outElement);
+	bool ReadEntity();
+	bool ReadBones();
+
+	bool ReadKey(Key_e & outKey, char const ** outString = nullptr);
+	bool ReadString(char const ** outString);
+	bool ReadBytes(void * outData, size_t size);
+	bool ReadVarInt(int & outValue);
+
+	template<typename T> bool Read(T & outValue) {
+		return ReadBytes(&outValue, sizeof(outValue));
+	}
+
+	bool ReadBool(bool & outValue);
+	bool ReadFloats(float * outValues, size_t count);
+
+	static Key_e ToKey(char const * value);
+};
+
+} // namespace advancedfx
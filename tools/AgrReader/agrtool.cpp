@@ -0,0 +1,330 @@
+#include "AgrReader.h"
+
+#include "AfxGameRecord.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace advancedfx;
+
+static void PrintUsage()
+{
+	printf(
+		"agrtool info <file> - Print header and frame count.\n"
+		"agrtool frame <file> <n> - Print the elements of frame n.\n"
+		"agrtool bench <file> [sizeMB] [plain|compact] - Write a synthetic record of about sizeMB (default 2048) to file and measure reading it.\n"
+	);
+}
+
+static bool PrintInfo(CAgrReader & reader)
+{
+	printf("File size: %llu bytes\n", (unsigned long long)reader.GetFileSize());
+	printf("Version: %i\n", reader.GetVersion());
+	if (reader.GetCompact()) {
+		printf("Compact: PositionStep %f, RotationBits %i, KeyFrameInterval %i\n", reader.GetPositionStep(), reader.GetRotationBits(), reader.GetKeyFrameInterval());
+	}
+	printf("Footer: %s\n", reader.GetHasFooter() ? "yes" : "no (scanned)");
+	printf("Frames: %i\n", reader.GetFrameCount());
+	printf("Dictionary: %i entries\n", (int)reader.GetDictionary().size());
+
+	return true;
+}
+
+static bool PrintFrame(CAgrReader & reader, int frame)
+{
+	if (!reader.SeekFrame(frame)) return false;
+
+	printf("Frame %i: time %f\n", frame, reader.GetFrameTime());
+
+	std::vector<float> bones;
+	CAgrReader::Element_e element;
+
+	while (reader.NextElement(element)) {
+		switch (element) {
+		case CAgrReader::Element_Entity:
+			{
+				CAgrReader::Entity_s const & entity = reader.GetEntity();
+				printf("entity_state %i", entity.Handle);
+				if (entity.HasBaseEntity) printf(" model \"%s\" visible %i origin (%f, %f, %f)", entity.Model, entity.Visible ? 1 : 0, entity.Transform[0][3], entity.Transform[1][3], entity.Transform[2][3]);
+				if (entity.HasBaseAnimating) {
+					printf(" bones %i", entity.BoneCount);
+					if (0 < entity.BoneCount && reader.GetBones(bones)) printf(" bone[0] (%f, %f, %f)", bones[3], bones[7], bones[11]);
+				}
+				if (entity.HasCamera) printf(" camera thirdperson %i origin (%f, %f, %f) angles (%f, %f, %f) fov %f", entity.ThirdPerson ? 1 : 0, entity.Origin[0], entity.Origin[1], entity.Origin[2], entity.Angles[0], entity.Angles[1], entity.Angles[2], entity.Fov);
+				printf(" viewmodel %i\n", entity.ViewModel ? 1 : 0);
+			}
+			break;
+		case CAgrReader::Element_Deleted:
+			printf("deleted %i\n", reader.GetDeleted());
+			break;
+		case CAgrReader::Element_Hidden:
+			printf("afxHidden");
+			for (int handle : reader.GetHidden()) printf(" %i", handle);
+			printf("\n");
+			break;
+		case CAgrReader::Element_Cam:
+			{
+				CAgrReader::Cam_s const & cam = reader.GetCam();
+				printf("afxCam origin (%f, %f, %f) angles (%f, %f, %f) fov %f\n", cam.Origin[0], cam.Origin[1], cam.Origin[2], cam.Angles[0], cam.Angles[1], cam.Angles[2], cam.Fov);
+			}
+			break;
+		}
+	}
+
+	return '\0' == *reader.GetError();
+}
+
+// Synthetic record /////////////////////////////////////////////////////////////
+
+static const int c_BenchEntities = 48;
+static const int c_BenchBones = 64;
+
+static void Bench_Bone(int entity, int frame, int bone, float outMatrix[3][4])
+{
+	// Every third entity is static, the others animate (some bones faster than others).
+	double a = 0 == entity % 3 ? 0 : frame * 0.01 * (1 + bone % 4) + entity;
+	double b = bone * 0.7 + entity * 0.3;
+
+	double x = sin(b) * 0.5 + sin(a) * 0.3, y = cos(b) * 0.4, z = sin(a + b) * 0.2, w = 1.0;
+	double len = sqrt(x * x + y * y + z * z + w * w);
+	x /= len; y /= len; z /= len; w /= len;
+
+	outMatrix[0][0] = (float)(1 - 2 * (y * y + z * z)); outMatrix[0][1] = (float)(2 * (x * y - z * w)); outMatrix[0][2] = (float)(2 * (x * z + y * w));
+	outMatrix[1][0] = (float)(2 * (x * y + z * w)); outMatrix[1][1] = (float)(1 - 2 * (x * x + z * z)); outMatrix[1][2] = (float)(2 * (y * z - x * w));
+	outMatrix[2][0] = (float)(2 * (x * z - y * w)); outMatrix[2][1] = (float)(2 * (y * z + x * w)); outMatrix[2][2] = (float)(1 - 2 * (x * x + y * y));
+	outMatrix[0][3] = (float)(bone * 2.5 + sin(a) * 4);
+	outMatrix[1][3] = (float)(cos(b) * 3);
+	outMatrix[2][3] = (float)(entity + cos(a) * 2);
+}
+
+static int Bench_Handle(int entity, int frame)
+{
+	// Entity 0 gets deleted and replaced every 1000 frames.
+	return 0 == entity ? 1000 + frame / 1000 : entity;
+}
+
+static bool Bench_Hidden(int entity, int frame)
+{
+	return 1 == entity && 190 <= frame % 200;
+}
+
+static bool Bench_Write(char const * fileName, unsigned long long size, bool compact, int & outFrames)
+{
+	std::filesystem::path path(fileName);
+
+	CAfxGameRecord record;
+	CAfxGameRecord::CompactSettings_s compactSettings;
+
+	if (!record.StartRecording(path.wstring().c_str(), 6, compact ? &compactSettings : nullptr)) return false;
+
+	static float bones[c_BenchBones][3][4];
+	char model[64];
+
+	int frame = 0;
+
+	for (;; ++frame) {
+		if (0 == frame % 256 && size <= std::filesystem::file_size(path)) break;
+
+		record.BeginFrame(1.0f / 64);
+
+		record.WriteDictionary("afxCam");
+		record.Write((float)frame);
+		record.Write(0.0f);
+		record.Write(64.0f);
+		record.Write(0.0f);
+		record.Write((float)(frame % 360));
+		record.Write(0.0f);
+		record.Write(90.0f);
+
+		if (0 < frame && 0 == frame % 1000) {
+			int handle = Bench_Handle(0, frame - 1);
+			record.WriteDictionary("deleted");
+			record.Write(handle);
+			record.ForgetEntity(handle);
+		}
+
+		for (int entity = 0; entity < c_BenchEntities; ++entity) {
+			int handle = Bench_Handle(entity, frame);
+
+			if (Bench_Hidden(entity, frame)) {
+				if (!Bench_Hidden(entity, frame - 1)) record.MarkHidden(handle);
+				continue;
+			}
+
+			for (int bone = 0; bone < c_BenchBones; ++bone) Bench_Bone(entity, frame, bone, bones[bone]);
+
+			snprintf(model, sizeof(model), "models/player/bench%i.mdl", entity % 8);
+
+			record.BeginEntity(handle);
+			record.WriteDictionary("entity_state");
+			record.Write(handle);
+			record.WriteDictionary("baseentity");
+			record.WriteDictionary(model);
+			record.Write(true);
+			for (int i = 0; i < 3; ++i) {
+				for (int j = 0; j < 4; ++j) record.Write(i == j ? 1.0f : 3 == j && 0 == i ? (float)(entity * 10) : 0.0f);
+			}
+			record.WriteDictionary("baseanimating");
+			record.Write(true);
+			record.WriteBones(c_BenchBones, bones);
+			record.WriteDictionary("/");
+			record.Write(false);
+			record.EndEntity();
+		}
+
+		record.EndFrame();
+	}
+
+	record.EndRecording();
+
+	outFrames = frame;
+
+	return true;
+}
+
+static double Bench_Seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool Bench(CAgrReader & reader, char const * fileName, unsigned long long sizeMB, bool compact)
+{
+	typedef std::chrono::steady_clock clock;
+
+	int writtenFrames;
+
+	printf("Writing %s record of about %llu MB ...\n", compact ? "compact" : "plain", sizeMB);
+	clock::time_point start = clock::now();
+	if (!Bench_Write(fileName, sizeMB * 1024 * 1024, compact, writtenFrames)) {
+		printf("Could not write %s.\n", fileName);
+		return false;
+	}
+	double seconds = Bench_Seconds(start);
+	double mb = std::filesystem::file_size(fileName) / (1024.0 * 1024.0);
+	printf("Write: %i frames, %.1f MB in %.2f s (%.1f MB/s)\n", writtenFrames, mb, seconds, mb / seconds);
+
+	start = clock::now();
+	if (!reader.Open(fileName)) return false;
+	printf("Open: %.3f ms (%s)\n", Bench_Seconds(start) * 1000, reader.GetHasFooter() ? "footer" : "scan");
+
+	if (reader.GetFrameCount() != writtenFrames) {
+		printf("%i frames read, %i written.\n", reader.GetFrameCount(), writtenFrames);
+		return false;
+	}
+
+	// Sequential, bones skipped:
+	{
+		unsigned long long entities = 0;
+		start = clock::now();
+		for (int frame = 0; frame < reader.GetFrameCount(); ++frame) {
+			if (!reader.SeekFrame(frame)) return false;
+			CAgrReader::Element_e element;
+			while (reader.NextElement(element)) {
+				if (CAgrReader::Element_Entity == element) ++entities;
+			}
+			if ('\0' != *reader.GetError()) return false;
+		}
+		seconds = Bench_Seconds(start);
+		printf("Sequential: %.2f s (%.1f MB/s, %.0f frames/s, %llu entity states)\n", seconds, mb / seconds, reader.GetFrameCount() / seconds, entities);
+	}
+
+	// Sequential, bones decoded and compared with the source:
+	{
+		std::vector<float> bones;
+		float expected[3][4];
+		double maxPositionError = 0, maxRotationError = 0;
+
+		start = clock::now();
+		for (int frame = 0; frame < reader.GetFrameCount(); ++frame) {
+			if (!reader.SeekFrame(frame)) return false;
+			CAgrReader::Element_e element;
+			while (reader.NextElement(element)) {
+				if (CAgrReader::Element_Entity != element) continue;
+				if (!reader.GetBones(bones)) return false;
+
+				// Compare a few frames only, to not measure Bench_Bone:
+				if (0 != frame % 97) continue;
+				int entity = reader.GetEntity().Handle < 1000 ? reader.GetEntity().Handle : 0;
+				for (int bone = 0; bone < c_BenchBones; ++bone) {
+					Bench_Bone(entity, frame, bone, expected);
+					for (int i = 0; i < 3; ++i) {
+						for (int j = 0; j < 4; ++j) {
+							double error = fabs(bones[bone * 12 + i * 4 + j] - expected[i][j]);
+							if (3 == j) { if (maxPositionError < error) maxPositionError = error; }
+							else if (maxRotationError < error) maxRotationError = error;
+						}
+					}
+				}
+			}
+			if ('\0' != *reader.GetError()) return false;
+		}
+		seconds = Bench_Seconds(start);
+		printf("Sequential with bones: %.2f s (%.1f MB/s, %.0f frames/s), max error: position %g, rotation matrix %g\n", seconds, mb / seconds, reader.GetFrameCount() / seconds, maxPositionError, maxRotationError);
+	}
+
+	// Random access:
+	{
+		std::mt19937 random(1);
+		std::uniform_int_distribution<int> distribution(0, reader.GetFrameCount() - 1);
+		const int seeks = 1000;
+
+		start = clock::now();
+		for (int i = 0; i < seeks; ++i) {
+			if (!reader.SeekFrame(distribution(random))) return false;
+			CAgrReader::Element_e element;
+			while (reader.NextElement(element));
+			if ('\0' != *reader.GetError()) return false;
+		}
+		seconds = Bench_Seconds(start);
+		printf("Random access: %.3f ms per frame (%i seeks)\n", seconds * 1000 / seeks, seeks);
+	}
+
+	return true;
+}
+
+int main(int argc, char * argv[])
+{
+	if (3 <= argc && 0 == strcmp(argv[1], "bench")) {
+		unsigned long long sizeMB = 4 <= argc ? strtoull(argv[3], nullptr, 10) : 2048;
+		bool compact = 5 <= argc && 0 == strcmp(argv[4], "compact");
+
+		CAgrReader reader;
+		if (!Bench(reader, argv[2], sizeMB, compact)) {
+			printf("Error: %s\n", reader.GetError());
+			return 1;
+		}
+		return 0;
+	}
+
+	if (3 <= argc && (0 == strcmp(argv[1], "info") || 0 == strcmp(argv[1], "frame"))) {
+		CAgrReader reader;
+
+		bool ok = reader.Open(argv[2]);
+
+		if (ok) {
+			if (0 == strcmp(argv[1], "info")) ok = PrintInfo(reader);
+			else if (4 <= argc) ok = PrintFrame(reader, atoi(argv[3]));
+			else {
+				PrintUsage();
+				return 1;
+			}
+		}
+
+		if (!ok) {
+			printf("Error: %s\n", reader.GetError());
+			return 1;
+		}
+		return 0;
+	}
+
+	PrintUsage();
+	return 1;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Lets agrtool build shared/AfxGameRecord.cpp (for the benchmark) outside the hook projects.
+
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <filesystem>
+
+inline int _wfopen_s(FILE ** outFile, wchar_t const * fileName, wchar_t const * mode)
+{
+	std::string strMode;
+	for (; *mode; ++mode) strMode += (char)*mode;
+
+	*outFile = fopen(std::filesystem::path(fileName).string().c_str(), strMode.c_str());
+
+	return *outFile ? 0 : 1;
+}
+#endif